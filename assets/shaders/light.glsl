@@ -1,39 +1,31 @@
 #vertex
 
 out vec4 frag_color;
-out vec2 world_pos;
-
-/*
-uniform vec4 u_light_origin;
-uniform float u_light_radius;
-*/
+out vec2 light_offset;
 
 void main()
 {
     set_position();
 
     frag_color = a_color;
-    world_pos = a_world_pos;
+
+    // Position relative to the light origin, in multiples of the light radius
+    light_offset = a_uv;
 }
 
 #fragment
 
 in vec4 frag_color;
-in vec2 world_pos;
+in vec2 light_offset;
 
 out vec4 final_color;
 
-uniform vec4 u_light_origin;
-uniform float u_light_radius;
-
 void main()
 {
     // TODO: it would be more efficient to use a stencil buffer to clip
     // a circle around the light origin
     // TODO: improve the look of this
-    float dist = distance(u_light_origin.xy, world_pos);
-    vec2 light_origin = u_light_origin.xy;
-    float d = sqrt(dist / u_light_radius);
+    float d = sqrt(length(light_offset));
 
     final_color = frag_color;
     final_color.a *= 1.0f - d;
@@ -3,16 +3,27 @@
 
 #include "base/string8.h"
 
-static inline u64 hash_string(String string)
+#define HASH_INITIAL_VALUE 0xcbf29ce484222325
+
+// Continues an existing hash, pass HASH_INITIAL_VALUE to start a new one
+static inline u64 hash_bytes(u64 hash, const void *data, ssize size)
 {
-    u64 result = 0xcbf29ce484222325;
+    const byte *bytes = data;
+    u64 result = hash;
 
-    for (ssize i = 0; i < string.length; ++i) {
-        result = result ^ (u64)string.data[i];
+    for (ssize i = 0; i < size; ++i) {
+        result = result ^ (u64)bytes[i];
         result = result * 0x100000001b3;
     }
 
     return result;
 }
 
+static inline u64 hash_string(String string)
+{
+    u64 result = hash_bytes(HASH_INITIAL_VALUE, string.data, string.length);
+
+    return result;
+}
+
 #endif //HASH_H
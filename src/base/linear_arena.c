@@ -121,6 +121,7 @@ void *alloc_bytes(LinearArena *arena, ssize byte_count, ssize alignment)
 
 void *la_allocate(void *context, ssize count, ssize item_size, ssize alignment)
 {
+    ASSERT(context);
     ASSERT(is_pow2(alignment));
     ASSERT(count > 0);
     ASSERT(item_size > 0);
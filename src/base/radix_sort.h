@@ -0,0 +1,93 @@
+#ifndef RADIX_SORT_H
+#define RADIX_SORT_H
+
+#include <string.h>
+
+#include "base/linear_arena.h"
+#include "base/utils.h"
+
+/*
+  Stable LSD radix sort of an array of structs by a u64 member, one byte of the key at a
+  time. The counts for every byte are gathered in a single pass up front and the items are
+  moved back and forth between the array and one scratch array of the same size. Passes
+  where all keys share the same byte are skipped since they wouldn't move anything.
+
+  Usage: radix_sort(entries, entry_count, key, scratch);
+ */
+
+#define RADIX_SORT_DIGIT_COUNT  (SIZEOF(u64))
+#define RADIX_SORT_BUCKET_COUNT 256
+
+#define radix_sort(items, count, key_member, scratch)                   \
+    do {                                                                \
+        ASSERT(SIZEOF((items)->key_member) == SIZEOF(u64));             \
+        impl_radix_sort((items), (count), SIZEOF(*(items)),             \
+            (ssize)((byte *)&(items)->key_member - (byte *)(items)),   \
+            ALIGNOF(*(items)), (scratch));                              \
+    } while (0)
+
+static inline u64 impl_radix_sort_get_key(const byte *item, ssize key_offset)
+{
+    u64 result = 0;
+    memcpy(&result, item + key_offset, sizeof(result));
+
+    return result;
+}
+
+// Inlined so that the item size is known when copying items around
+static inline void impl_radix_sort(void *items, ssize count, ssize item_size, ssize key_offset,
+    ssize alignment, LinearArena *scratch)
+{
+    if (count <= 1) {
+        return;
+    }
+
+    ssize offsets[RADIX_SORT_DIGIT_COUNT][RADIX_SORT_BUCKET_COUNT] = {0};
+
+    for (ssize i = 0; i < count; ++i) {
+        u64 key = impl_radix_sort_get_key((byte *)items + i * item_size, key_offset);
+
+        for (s32 digit = 0; digit < RADIX_SORT_DIGIT_COUNT; ++digit) {
+            ++offsets[digit][(key >> (digit * 8)) & 0xff];
+        }
+    }
+
+    byte *source = items;
+    byte *destination = la_allocate(scratch, count, item_size, alignment);
+
+    for (s32 digit = 0; digit < RADIX_SORT_DIGIT_COUNT; ++digit) {
+        ssize *digit_offsets = offsets[digit];
+        s32 shift = digit * 8;
+
+        u64 first_bucket = (impl_radix_sort_get_key(source, key_offset) >> shift) & 0xff;
+
+        if (digit_offsets[first_bucket] == count) {
+            continue;
+        }
+
+        ssize total = 0;
+
+        for (ssize bucket = 0; bucket < RADIX_SORT_BUCKET_COUNT; ++bucket) {
+            ssize bucket_count = digit_offsets[bucket];
+            digit_offsets[bucket] = total;
+            total += bucket_count;
+        }
+
+        for (ssize i = 0; i < count; ++i) {
+            const byte *item = source + i * item_size;
+            u64 bucket = (impl_radix_sort_get_key(item, key_offset) >> shift) & 0xff;
+
+            memcpy(destination + digit_offsets[bucket]++ * item_size, item, (usize)item_size);
+        }
+
+        byte *tmp = source;
+        source = destination;
+        destination = tmp;
+    }
+
+    if (source != items) {
+        memcpy(items, source, (usize)(count * item_size));
+    }
+}
+
+#endif //RADIX_SORT_H
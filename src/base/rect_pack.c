@@ -0,0 +1,86 @@
+#include "rect_pack.h"
+
+typedef struct {
+    s32 page;
+    s32 shelf_y;
+    s32 shelf_height;
+    s32 cursor_x;
+} RectPackState;
+
+static b32 rect_pack_goes_before(Vector2i a, Vector2i b)
+{
+    b32 result = (a.y > b.y) || ((a.y == b.y) && (a.x > b.x));
+
+    return result;
+}
+
+// Insertion sort keeps rectangles of equal size in their original order
+static void rect_pack_sort_indices(const Vector2i *sizes, ssize *indices, ssize count)
+{
+    for (ssize i = 1; i < count; ++i) {
+        ssize index = indices[i];
+        ssize j = i;
+
+        while ((j > 0) && rect_pack_goes_before(sizes[index], sizes[indices[j - 1]])) {
+            indices[j] = indices[j - 1];
+            --j;
+        }
+
+        indices[j] = index;
+    }
+}
+
+s32 rect_pack(const Vector2i *sizes, ssize count, Vector2i page_size, s32 padding,
+    PackedRect *results, LinearArena *scratch)
+{
+    ASSERT(padding >= 0);
+    ASSERT((page_size.x > 0) && (page_size.y > 0));
+
+    ssize *indices = la_allocate_array(scratch, ssize, MAX(count, 1));
+
+    for (ssize i = 0; i < count; ++i) {
+        indices[i] = i;
+    }
+
+    rect_pack_sort_indices(sizes, indices, count);
+
+    RectPackState state = {.page = -1};
+
+    for (ssize i = 0; i < count; ++i) {
+        ssize index = indices[i];
+        Vector2i padded_size = v2i(sizes[index].x + padding * 2, sizes[index].y + padding * 2);
+
+        if ((padded_size.x > page_size.x) || (padded_size.y > page_size.y)) {
+            results[index].position = v2i(0, 0);
+            results[index].page = RECT_PACK_NO_PAGE;
+
+            continue;
+        }
+
+        if ((state.page == -1) || (state.cursor_x + padded_size.x > page_size.x)) {
+            // Start a new shelf below the current one
+            state.shelf_y += state.shelf_height;
+            state.shelf_height = 0;
+            state.cursor_x = 0;
+        }
+
+        if ((state.page == -1) || (state.shelf_y + padded_size.y > page_size.y)) {
+            ++state.page;
+            state.shelf_y = 0;
+            state.shelf_height = 0;
+            state.cursor_x = 0;
+        }
+
+        // Rectangles are sorted by height, so the first one on a shelf is the tallest
+        state.shelf_height = MAX(state.shelf_height, padded_size.y);
+
+        results[index].position = v2i(state.cursor_x + padding, state.shelf_y + padding);
+        results[index].page = state.page;
+
+        state.cursor_x += padded_size.x;
+    }
+
+    s32 result = state.page + 1;
+
+    return result;
+}
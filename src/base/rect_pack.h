@@ -0,0 +1,24 @@
+#ifndef RECT_PACK_H
+#define RECT_PACK_H
+
+#include "base/linear_arena.h"
+#include "base/vector.h"
+
+/*
+  Shelf packer for texture atlases. Rectangles are placed tallest first into rows across as
+  many pages as needed, with padding on every side of each rectangle so that neighbours
+  can't bleed into each other when sampled.
+ */
+
+#define RECT_PACK_NO_PAGE -1
+
+typedef struct {
+    Vector2i position; // Top left of the rectangle itself, padding excluded
+    s32      page;     // RECT_PACK_NO_PAGE if the rectangle can't fit on a page
+} PackedRect;
+
+// Returns the number of pages used. Results are in the same order as sizes.
+s32 rect_pack(const Vector2i *sizes, ssize count, Vector2i page_size, s32 padding,
+              PackedRect *results, LinearArena *scratch);
+
+#endif //RECT_PACK_H
@@ -103,6 +103,13 @@ static inline b32 rect_is_valid(Rectangle rect)
     return result;
 }
 
+static inline b32 rect_eq(Rectangle a, Rectangle b)
+{
+    b32 result = v2_eq(a.position, b.position) && v2_eq(a.size, b.size);
+
+    return result;
+}
+
 static inline b32 rect_intersects(Rectangle a, Rectangle b)
 {
     b32 result =
@@ -2,8 +2,12 @@
 #define TRIANGLE_H
 
 #include "list.h"
+#include "rectangle.h"
 #include "vertex.h"
 
+// Clipping a triangle against each side of a rectangle adds at most one point per side
+#define CLIPPED_TRIANGLE_MAX_POINTS 7
+
 typedef struct {
     Vector2 a;
     Vector2 b;
@@ -28,6 +32,12 @@ typedef struct {
     ssize count;
 } TriangleFan;
 
+// Convex polygon with the same winding order as the triangle it was clipped from
+typedef struct {
+    Vector2 points[CLIPPED_TRIANGLE_MAX_POINTS];
+    s32     count;
+} ClippedTriangle;
+
 // https://stackoverflow.com/a/2049593
 static inline b32 triangle_contains_point(Triangle triangle, Vector2 point)
 {
@@ -54,4 +64,59 @@ static inline TriangleVertices triangle_get_vertices(Triangle triangle, RGBA32 c
     return result;
 }
 
+// Signed distance inside of an axis aligned bound, axis 0 is x and 1 is y
+static inline f32 distance_inside_bound(Vector2 point, s32 axis, f32 bound, f32 inside_sign)
+{
+    f32 coordinate = (axis == 0) ? point.x : point.y;
+    f32 result = inside_sign * (coordinate - bound);
+
+    return result;
+}
+
+static inline s32 clip_polygon_to_bound(const Vector2 *points, s32 count, Vector2 *result,
+    s32 axis, f32 bound, f32 inside_sign)
+{
+    s32 result_count = 0;
+
+    for (s32 i = 0; i < count; ++i) {
+        Vector2 curr = points[i];
+        Vector2 next = points[(i + 1) % count];
+
+        f32 curr_dist = distance_inside_bound(curr, axis, bound, inside_sign);
+        f32 next_dist = distance_inside_bound(next, axis, bound, inside_sign);
+
+        if (curr_dist >= 0.0f) {
+            result[result_count++] = curr;
+        }
+
+        // Points on the bound are kept as they are, so triangles touching it don't leave
+        // degenerate slivers behind
+        if (((curr_dist > 0.0f) && (next_dist < 0.0f)) || ((curr_dist < 0.0f) && (next_dist > 0.0f))) {
+            f32 t = curr_dist / (curr_dist - next_dist);
+            result[result_count++] = v2_add(curr, v2_mul_s(v2_sub(next, curr), t));
+        }
+    }
+
+    return result_count;
+}
+
+// Sutherland-Hodgman, the result has no points if the triangle is outside the rectangle
+static inline ClippedTriangle triangle_clip_to_rect(Triangle triangle, Rectangle rect)
+{
+    ClippedTriangle result = {{triangle.a, triangle.b, triangle.c}, 3};
+    Vector2 scratch[CLIPPED_TRIANGLE_MAX_POINTS];
+
+    Vector2 min = rect.position;
+    Vector2 max = v2_add(rect.position, rect.size);
+
+    s32 count = clip_polygon_to_bound(result.points, result.count, scratch, 0, min.x, 1.0f);
+    count = clip_polygon_to_bound(scratch, count, result.points, 0, max.x, -1.0f);
+    count = clip_polygon_to_bound(result.points, count, scratch, 1, min.y, 1.0f);
+    count = clip_polygon_to_bound(scratch, count, result.points, 1, max.y, -1.0f);
+
+    result.count = count;
+
+    return result;
+}
+
 #endif //TRIANGLE_H
@@ -186,6 +186,15 @@ static inline s32 v2i_dist_sq(Vector2i a, Vector2i b)
     return result;
 }
 
+static inline Vector2 v2_lerp(Vector2 a, Vector2 b, f32 t)
+{
+    f32 new_x = interpolate(a.x, b.x, t);
+    f32 new_y = interpolate(a.y, b.y, t);
+
+    Vector2 result = v2(new_x, new_y);
+    return result;
+}
+
 static inline Vector2 v2_interpolate(Vector2 a, Vector2 b, f32 t)
 {
     f32 new_x = interpolate_sin(a.x, b.x, t);
@@ -5,7 +5,9 @@
 #include "entity/entity_system.h"
 #include "magic.h"
 #include "stats.h"
+#include "world/line_of_sight.h"
 #include "world/world.h"
+#include "world/world_query.h"
 
 #define AI_CHASE_DISTANCE 250.0f
 #define AI_ATTACK_DISTANCE 200.0f
@@ -52,27 +54,97 @@ static void transition_to_ai_state(World *world, Entity *entity, AIComponent *ai
     }
 }
 
-static void update_ai_state_idle(World *world, Entity *entity, AIComponent *ai, PhysicsComponent *self_physics)
+typedef struct {
+    Entity           *entity;
+    AIComponent      *ai;
+    PhysicsComponent *physics;
+    b32               found_target;
+} IdleAgent;
+
+// Idle agents pick the first target in alive order that is close enough and in line of sight.
+// Targets are visited one at a time so that all agents looking at the same target are answered
+// by one batched line of sight query.
+void ai_acquire_targets(World *world, LinearArena *frame_arena)
 {
-    // TODO: get entities in area around ourselves instead of checking everyone
+    // TODO: get entities in area around the agents instead of checking everyone
+    IdleAgent *agents = la_allocate_array(frame_arena, IdleAgent, MAX(world->alive_entity_count, 1));
+    ssize agent_count = 0;
+
+    for (ssize i = 0; i < world->alive_entity_count; ++i) {
+	Entity *entity = es_get_entity(&world->entity_system, world->alive_entity_ids[i]);
+	AIComponent *ai = es_get_component(entity, AIComponent);
+	PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
+
+	if (ai && physics && (ai->current_state.kind == AI_STATE_IDLE)) {
+	    agents[agent_count++] = (IdleAgent){entity, ai, physics, false};
+	}
+    }
+
+    if (agent_count == 0) {
+	return;
+    }
+
+    ssize *candidates = la_allocate_array(frame_arena, ssize, agent_count);
+    Vector2 *origins = la_allocate_array(frame_arena, Vector2, agent_count);
+    b32 *visible = la_allocate_array(frame_arena, b32, agent_count);
 
     for (ssize i = 0; i < world->alive_entity_count; ++i) {
 	EntityID other_id = world->alive_entity_ids[i];
 	Entity *other = es_get_entity(&world->entity_system, other_id);
-        PhysicsComponent *other_physics = es_get_component(other, PhysicsComponent);
+	PhysicsComponent *other_physics = es_get_component(other, PhysicsComponent);
+
+	if (!other_physics) {
+	    continue;
+	}
+
+	ssize candidate_count = 0;
 
- 	if (other_physics && is_valid_attack_target(entity, other)) {
-	    f32 distance = v2_dist(other_physics->position, self_physics->position);
+	for (ssize j = 0; j < agent_count; ++j) {
+	    IdleAgent *agent = &agents[j];
 
-	    if (distance < AI_CHASE_DISTANCE) {
-		transition_to_ai_state(world, entity, ai, self_physics, ai_state_chasing(other_id));
-		break;
+	    if (!agent->found_target && is_valid_attack_target(agent->entity, other)
+		&& (v2_dist(other_physics->position, agent->physics->position) < AI_CHASE_DISTANCE)) {
+		candidates[candidate_count] = j;
+		origins[candidate_count] = agent->physics->position;
+		++candidate_count;
+	    }
+	}
+
+	los_cache_has_line_of_sight_batch(&world->line_of_sight_cache, origins, candidate_count,
+	    other_id, other, &world->tilemap, visible);
+
+	for (ssize j = 0; j < candidate_count; ++j) {
+	    if (visible[j]) {
+		IdleAgent *agent = &agents[candidates[j]];
+
+		transition_to_ai_state(world, agent->entity, agent->ai, agent->physics,
+		    ai_state_chasing(other_id));
+		agent->found_target = true;
 	    }
 	}
     }
 }
 
-static void update_ai_state_chasing(World *world, Entity *entity, AIComponent *ai, PhysicsComponent *self_physics)
+// The spell is cast from the entity position, so anything standing in front of the target
+// or a wall in between would take the hit instead
+static b32 has_clear_attack_line(World *world, Entity *entity, PhysicsComponent *self_physics,
+    EntityID target_id, Vector2 target_position, LinearArena *frame_arena)
+{
+    WorldCastParams params = {
+        .max_hits = 1,
+        .ignored_entity = es_get_id_of_entity(&world->entity_system, entity),
+    };
+
+    WorldCastResult cast = world_ray_cast(world, self_physics->position, target_position, params,
+        frame_arena);
+
+    b32 result = (cast.hit_count > 0) && entity_id_equal(cast.hits[0].entity_id, target_id);
+
+    return result;
+}
+
+static void update_ai_state_chasing(World *world, Entity *entity, AIComponent *ai, PhysicsComponent *self_physics,
+    LinearArena *frame_arena)
 {
     ASSERT(ai->current_state.kind == AI_STATE_CHASING);
 
@@ -84,8 +156,11 @@ static void update_ai_state_chasing(World *world, Entity *entity, AIComponent *a
 	transition_to_ai_state(world, entity, ai, self_physics, ai_state_idle());
     } else {
 	f32 distance = v2_dist(self_physics->position, target_physics->position);
+	EntityID target_id = ai->current_state.as.chasing.target;
 
-	if (distance < AI_ATTACK_DISTANCE) {
+	if ((distance < AI_ATTACK_DISTANCE)
+	    && has_clear_attack_line(world, entity, self_physics, target_id, target_physics->position,
+		frame_arena)) {
 	    SpellCasterComponent *caster = es_get_component(entity, SpellCasterComponent);
 	    ASSERT(caster);
 	    ASSERT(caster->spell_count > 0);
@@ -106,7 +181,7 @@ static void update_ai_state_chasing(World *world, Entity *entity, AIComponent *a
     }
 }
 
-void entity_update_ai(World *world, Entity *entity, AIComponent *ai)
+void entity_update_ai(World *world, Entity *entity, AIComponent *ai, LinearArena *frame_arena)
 {
     PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
 
@@ -119,11 +194,11 @@ void entity_update_ai(World *world, Entity *entity, AIComponent *ai)
 
     switch (ai->current_state.kind) {
 	case AI_STATE_IDLE: {
-	    update_ai_state_idle(world, entity, ai, physics);
+	    // Targets are looked for by ai_acquire_targets
 	} break;
 
 	case AI_STATE_CHASING: {
-	    update_ai_state_chasing(world, entity, ai, physics);
+	    update_ai_state_chasing(world, entity, ai, physics, frame_arena);
 	} break;
     }
 }
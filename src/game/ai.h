@@ -6,6 +6,7 @@
 struct World;
 struct Entity;
 struct AIComponent;
+struct LinearArena;
 
 typedef enum {
     AI_STATE_IDLE,
@@ -22,6 +23,8 @@ typedef struct {
     } as;
 } AIState;
 
-void entity_update_ai(struct World *world, struct Entity *entity, struct AIComponent *ai);
+void ai_acquire_targets(struct World *world, struct LinearArena *frame_arena);
+void entity_update_ai(struct World *world, struct Entity *entity, struct AIComponent *ai,
+    struct LinearArena *frame_arena);
 
 #endif //AI_H
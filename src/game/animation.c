@@ -131,7 +131,7 @@ void anim_update_instance(World *world, Entity *entity, PhysicsComponent *physic
 }
 
 void anim_render_instance(AnimationInstance *anim_instance, PhysicsComponent *owner_physics,
-    RenderBatch *rb, LinearArena *scratch)
+    RenderBatch *rb)
 {
     AnimationFrame current_frame = anim_get_current_frame(anim_instance);
 
@@ -139,7 +139,7 @@ void anim_render_instance(AnimationInstance *anim_instance, PhysicsComponent *ow
 	current_frame.sprite.rotation_behaviour);
 
     Rectangle sprite_rect = { owner_physics->position, current_frame.sprite.size };
-    draw_sprite(rb, scratch, current_frame.sprite.texture, sprite_rect, sprite_mods,
+    draw_sprite(rb, current_frame.sprite.texture, sprite_rect, sprite_mods,
 	shader_handle(TEXTURE_SHADER), RENDER_LAYER_ENTITIES);
 }
 
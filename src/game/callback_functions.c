@@ -19,5 +19,5 @@ void callback_spawn_particles(CallbackUserData user_data, EventData event_data,
     Chunk *chunk = get_chunk_at_position(&event_data.world->map_chunks, self_physics->position);
     ASSERT(chunk);
 
-    spawn_particles_in_chunk(chunk, self_bounds, setup->config, setup->total_particle_count);
+    spawn_particles_in_chunk(&event_data.world->particle_pool, chunk, self_bounds, setup->config, setup->total_particle_count);
 }
@@ -6,20 +6,91 @@
 #include "collision/collision_policy.h"
 #include "collision/trigger.h"
 
-// Entities that are in the same collision group won't collide with eachother
+#define COLLISION_GROUP_MASK_ALL ((CollisionGroupMask)-1)
+
+// Each collider belongs to a single collision group and keeps a mask of the groups it
+// ignores. A pair of entities is only considered for collision if neither of them ignores
+// the group of the other one. Since components are zero initialized, a collider will by
+// default be in COLLISION_GROUP_NONE and collide with everything.
 typedef enum {
     COLLISION_GROUP_NONE,
     COLLISION_GROUP_PROJECTILES,
+    COLLISION_GROUP_PLAYERS,
+    COLLISION_GROUP_ENEMIES,
+    COLLISION_GROUP_COUNT,
 } CollisionGroup;
 
+typedef u32 CollisionGroupMask;
+
+typedef struct {
+    CollisionGroup     group;
+    CollisionGroupMask ignored_groups;
+} CollisionFilter;
+
 typedef struct ColliderComponent {
     // TODO: offset from pos
     Vector2 size;
     CollisionPolicy per_faction_collision_policies[FACTION_COUNT];
     CollisionPolicy tilemap_collision_policy;
-    CollisionGroup collision_group;
+    CollisionFilter collision_filter;
 } ColliderComponent;
 
+static inline CollisionGroupMask collision_group_bit(CollisionGroup group)
+{
+    ASSERT(group >= 0);
+    ASSERT(group < COLLISION_GROUP_COUNT);
+
+    CollisionGroupMask result = (CollisionGroupMask)1 << group;
+
+    return result;
+}
+
+// Filter for entities that should never show up in collision queries, eg. entities
+// without a collider
+static inline CollisionFilter collision_filter_ignore_all(void)
+{
+    CollisionFilter result = {0};
+    result.group = COLLISION_GROUP_NONE;
+    result.ignored_groups = COLLISION_GROUP_MASK_ALL;
+
+    return result;
+}
+
+static inline b32 collision_filters_equal(CollisionFilter a, CollisionFilter b)
+{
+    b32 result = (a.group == b.group) && (a.ignored_groups == b.ignored_groups);
+
+    return result;
+}
+
+static inline b32 collision_filters_can_interact(CollisionFilter a, CollisionFilter b)
+{
+    b32 result = !has_flag(a.ignored_groups, collision_group_bit(b.group))
+        && !has_flag(b.ignored_groups, collision_group_bit(a.group));
+
+    return result;
+}
+
+static inline void set_collision_group(ColliderComponent *collider, CollisionGroup group)
+{
+    ASSERT(group >= 0);
+    ASSERT(group < COLLISION_GROUP_COUNT);
+
+    collider->collision_filter.group = group;
+}
+
+static inline void set_collision_group_ignored(ColliderComponent *collider, CollisionGroup group,
+    b32 ignored)
+{
+    CollisionGroupMask bit = collision_group_bit(group);
+
+    if (ignored) {
+        collider->collision_filter.ignored_groups |= bit;
+    } else {
+        unset_flag(collider->collision_filter.ignored_groups, bit);
+    }
+}
+
 static inline void set_collision_policy_vs_tilemaps(ColliderComponent *collider, CollisionPolicy policy)
 {
     collider->tilemap_collision_policy = policy;
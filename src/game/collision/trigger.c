@@ -37,6 +37,65 @@ static TriggerCooldown *find_trigger_cooldown(TriggerCooldownTable *table, Entit
     return current;
 }
 
+static TriggerCooldownNodeList *get_entity_cooldown_list(TriggerCooldownTable *table, EntityID id)
+{
+    ASSERT(id.index >= 0);
+    ASSERT(id.index < MAX_ENTITIES);
+
+    TriggerCooldownNodeList *result = &table->per_entity_cooldowns[id.index];
+
+    return result;
+}
+
+static TriggerCooldownNodeList *get_timer_wheel_slot(TriggerTimerWheel *wheel, u64 tick)
+{
+    ssize index = mod_index(tick, TRIGGER_TIMER_WHEEL_SLOT_COUNT);
+    TriggerCooldownNodeList *result = &wheel->slots[index];
+
+    return result;
+}
+
+static void schedule_trigger_cooldown_expiry(TriggerCooldownTable *table, TriggerCooldown *cooldown)
+{
+    TriggerTimerWheel *wheel = &table->timer_wheel;
+
+    f32 duration = cooldown->retrigger_behaviour.as.duration_in_seconds;
+    f32 ticks_until_expiry = ceilf((duration + wheel->time_since_last_tick) / TRIGGER_TIMER_WHEEL_TICK);
+
+    // Always expire at the earliest on the next tick, the current slot has already been processed
+    u64 tick_count = (u64)MAX(ticks_until_expiry, 1.0f);
+    cooldown->expiry_tick = wheel->current_tick + tick_count;
+
+    list_push_back(get_timer_wheel_slot(wheel, cooldown->expiry_tick), &cooldown->expiry_node);
+}
+
+static void free_trigger_cooldown(TriggerCooldownTable *table, TriggerCooldown *cooldown)
+{
+    ssize index = trigger_cooldown_hashed_index(table, cooldown->owning_entity, cooldown->collided_entity);
+    list_remove(&table->table[index], cooldown);
+
+    list_remove(get_entity_cooldown_list(table, cooldown->owning_entity), &cooldown->owning_entity_node);
+    list_remove(get_entity_cooldown_list(table, cooldown->collided_entity), &cooldown->collided_entity_node);
+
+    switch (cooldown->retrigger_behaviour.kind) {
+        case RETRIGGER_AFTER_DURATION: {
+            list_remove(get_timer_wheel_slot(&table->timer_wheel, cooldown->expiry_tick),
+                &cooldown->expiry_node);
+        } break;
+
+        case RETRIGGER_AFTER_NON_CONTACT: {
+            list_remove(&table->non_contact_cooldowns, &cooldown->expiry_node);
+        } break;
+
+        case RETRIGGER_NEVER: {
+        } break;
+
+        INVALID_DEFAULT_CASE;
+    }
+
+    list_push_back(&table->free_node_list, cooldown);
+}
+
 // TODO: allow setting multiple components
 void add_trigger_cooldown(TriggerCooldownTable *table, EntityID self, EntityID other,
     ComponentID component, RetriggerBehaviour retrigger_behaviour, LinearArena *arena)
@@ -59,47 +118,95 @@ void add_trigger_cooldown(TriggerCooldownTable *table, EntityID self, EntityID o
 	cooldown->retrigger_behaviour = retrigger_behaviour;
 	cooldown->owning_component = component;
 
+        cooldown->owning_entity_node.cooldown = cooldown;
+        cooldown->collided_entity_node.cooldown = cooldown;
+        cooldown->expiry_node.cooldown = cooldown;
+
         ssize index = trigger_cooldown_hashed_index(table, self, other);
         list_push_back(&table->table[index], cooldown);
+
+        list_push_back(get_entity_cooldown_list(table, self), &cooldown->owning_entity_node);
+        list_push_back(get_entity_cooldown_list(table, other), &cooldown->collided_entity_node);
+
+        if (retrigger_behaviour.kind == RETRIGGER_AFTER_DURATION) {
+            schedule_trigger_cooldown_expiry(table, cooldown);
+        } else if (retrigger_behaviour.kind == RETRIGGER_AFTER_NON_CONTACT) {
+            list_push_back(&table->non_contact_cooldowns, &cooldown->expiry_node);
+        }
     }
 }
-void update_trigger_cooldowns(World *world, f32 dt)
+
+void advance_trigger_cooldown_timers(TriggerCooldownTable *table, f32 dt)
 {
-    for (ssize i = 0; i < ARRAY_COUNT(world->trigger_cooldowns.table); ++i) {
-        TriggerCooldownList *cd_list = &world->trigger_cooldowns.table[i];
+    ASSERT(dt >= 0.0f);
 
-        for (TriggerCooldown *curr_cd = list_head(cd_list); curr_cd;) {
-            TriggerCooldown *next_cd = curr_cd->next;
+    TriggerTimerWheel *wheel = &table->timer_wheel;
+    wheel->time_since_last_tick += dt;
 
-            Entity *owning = es_get_entity(&world->entity_system, curr_cd->owning_entity);
-            Entity *other = es_get_entity(&world->entity_system, curr_cd->collided_entity);
-            ASSERT(owning);
-            ASSERT(other);
+    f32 elapsed_ticks = floorf(wheel->time_since_last_tick / TRIGGER_TIMER_WHEEL_TICK);
+    wheel->time_since_last_tick -= elapsed_ticks * TRIGGER_TIMER_WHEEL_TICK;
 
-            EntityID owning_id = curr_cd->owning_entity;
-            EntityID other_id = curr_cd->collided_entity;
+    u64 target_tick = wheel->current_tick + (u64)elapsed_ticks;
 
-	    RetriggerBehaviour retrigger_behaviour = curr_cd->retrigger_behaviour;
-            ASSERT(retrigger_behaviour.kind != RETRIGGER_WHENEVER
-		  && "A trigger that can retrigger whenever shouldn't be found in cooldown list");
+    // If more ticks than there are slots elapsed, every slot needs to be visited once but
+    // there is no point in visiting any of them twice
+    u64 first_tick = wheel->current_tick + 1;
 
-	    if (retrigger_behaviour.kind == RETRIGGER_AFTER_DURATION) {
-		curr_cd->retrigger_behaviour.as.duration_in_seconds -= dt;
-	    }
+    if ((target_tick - wheel->current_tick) > TRIGGER_TIMER_WHEEL_SLOT_COUNT) {
+        first_tick = target_tick - TRIGGER_TIMER_WHEEL_SLOT_COUNT + 1;
+    }
 
-            b32 should_remove = (owning->is_inactive || other->is_inactive)
-                || ((retrigger_behaviour.kind == RETRIGGER_AFTER_NON_CONTACT)
-                    && !entities_intersected_this_frame(world, owning_id, other_id))
-		|| ((retrigger_behaviour.kind == RETRIGGER_AFTER_DURATION)
-		    && curr_cd->retrigger_behaviour.as.duration_in_seconds <= 0.0f);
+    for (u64 tick = first_tick; tick <= target_tick; ++tick) {
+        TriggerCooldownNodeList *slot = get_timer_wheel_slot(wheel, tick);
 
-            if (should_remove) {
-                list_remove(cd_list, curr_cd);
-                list_push_back(&world->trigger_cooldowns.free_node_list, curr_cd);
+        for (TriggerCooldownNode *node = list_head(slot); node;) {
+            TriggerCooldownNode *next = list_next(node);
+
+            // Cooldowns longer than a full revolution of the wheel share slots with
+            // ones that expire sooner
+            if (node->cooldown->expiry_tick <= target_tick) {
+                free_trigger_cooldown(table, node->cooldown);
             }
 
-            curr_cd = next_cd;
+            node = next;
+        }
+    }
+
+    wheel->current_tick = target_tick;
+}
+
+void update_trigger_cooldowns(World *world, f32 dt)
+{
+    TriggerCooldownTable *table = &world->trigger_cooldowns;
+
+    advance_trigger_cooldown_timers(table, dt);
+
+    // Cooldowns that end when the entities stop touching have to be checked each frame,
+    // all other kinds are either freed by the timer wheel or when either entity is removed
+    for (TriggerCooldownNode *node = list_head(&table->non_contact_cooldowns); node;) {
+        TriggerCooldownNode *next = list_next(node);
+        TriggerCooldown *cooldown = node->cooldown;
+
+        ASSERT(cooldown->retrigger_behaviour.kind == RETRIGGER_AFTER_NON_CONTACT);
+
+        if (!entities_intersected_this_frame(world, cooldown->owning_entity, cooldown->collided_entity)) {
+            free_trigger_cooldown(table, cooldown);
         }
+
+        node = next;
+    }
+}
+
+void remove_trigger_cooldowns_of_entity(TriggerCooldownTable *table, EntityID entity)
+{
+    TriggerCooldownNodeList *list = get_entity_cooldown_list(table, entity);
+
+    while (!list_is_empty(list)) {
+        TriggerCooldown *cooldown = list_head(list)->cooldown;
+        ASSERT(entity_id_equal(cooldown->owning_entity, entity)
+            || entity_id_equal(cooldown->collided_entity, entity));
+
+        free_trigger_cooldown(table, cooldown);
     }
 }
 
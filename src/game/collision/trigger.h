@@ -37,10 +37,39 @@ typedef struct {
     } as;
 } RetriggerBehaviour;
 
+#define TRIGGER_COOLDOWN_TABLE_SIZE     512 // TODO: dynamically sized
+#define TRIGGER_TIMER_WHEEL_SLOT_COUNT  256
+#define TRIGGER_TIMER_WHEEL_TICK        (1.0f / 60.0f)
+
+struct TriggerCooldown;
+
+// Cooldowns are linked into several lists at once, so each list gets its own node
+// that points back to the owning cooldown
+typedef struct TriggerCooldownNode {
+    struct TriggerCooldownNode *next;
+    struct TriggerCooldownNode *prev;
+    struct TriggerCooldown     *cooldown;
+} TriggerCooldownNode;
+
+typedef struct {
+    TriggerCooldownNode *head;
+    TriggerCooldownNode *tail;
+} TriggerCooldownNodeList;
+
 typedef struct TriggerCooldown {
     struct TriggerCooldown *next;
     struct TriggerCooldown *prev;
 
+    // Links into the per entity lists of both entities, used for freeing all
+    // cooldowns of an entity when it is removed
+    TriggerCooldownNode owning_entity_node;
+    TriggerCooldownNode collided_entity_node;
+
+    // Either a timer wheel slot (RETRIGGER_AFTER_DURATION) or the list of cooldowns
+    // that need to be checked for contact each frame (RETRIGGER_AFTER_NON_CONTACT)
+    TriggerCooldownNode expiry_node;
+    u64 expiry_tick;
+
     EntityID owning_entity; // TODO: use ordered entity pair here
     EntityID collided_entity;
     ComponentID owning_component;
@@ -54,13 +83,25 @@ typedef struct {
 } TriggerCooldownList;
 
 typedef struct {
-    TriggerCooldownList  table[512]; // TODO: dynamically sized
-    TriggerCooldownList  free_node_list;
+    TriggerCooldownNodeList slots[TRIGGER_TIMER_WHEEL_SLOT_COUNT];
+    u64 current_tick;
+    f32 time_since_last_tick;
+} TriggerTimerWheel;
+
+typedef struct {
+    TriggerCooldownList      table[TRIGGER_COOLDOWN_TABLE_SIZE];
+    TriggerCooldownList      free_node_list;
+
+    TriggerCooldownNodeList  per_entity_cooldowns[MAX_ENTITIES];
+    TriggerCooldownNodeList  non_contact_cooldowns;
+    TriggerTimerWheel        timer_wheel;
 } TriggerCooldownTable;
 
 void add_trigger_cooldown(TriggerCooldownTable *table, EntityID self, EntityID other,
     ComponentID component, RetriggerBehaviour retrigger_behaviour, struct LinearArena *arena);
 void update_trigger_cooldowns(struct World *world, f32 dt);
+void advance_trigger_cooldown_timers(TriggerCooldownTable *table, f32 dt);
+void remove_trigger_cooldowns_of_entity(TriggerCooldownTable *table, EntityID entity);
 b32 trigger_is_on_cooldown(TriggerCooldownTable *table, EntityID a, EntityID b, ComponentID component);
 
 static inline RetriggerBehaviour retrigger_whenever(void)
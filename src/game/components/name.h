@@ -1,6 +1,8 @@
 #ifndef NAME_H
 #define NAME_H
 
+#include <string.h>
+
 #include "base/string8.h"
 #include "base/utils.h"
 
@@ -41,13 +41,19 @@ static s32 calculate_particles_to_spawn_this_frame(ParticleSpawner *ps, f32 dt)
     return result;
 }
 
-void spawn_particles_in_chunk(Chunk *chunk, Rectangle spawn_area, ParticleSpawnerConfig config, s32 particle_count)
+void spawn_particles_in_chunk(ParticlePool *pool, Chunk *chunk, Rectangle spawn_area, ParticleSpawnerConfig config, s32 particle_count)
 {
     ASSERT(config.particle_size > 0.0f);
     ASSERT(config.particle_speed > 0.0f);
     ASSERT(config.particles_per_second > 0);
     ASSERT(config.particle_color.a > 0);
 
+    // New particles start at the current tick, so the chunk has to be at the state right
+    // before the current tick is simulated
+    if ((pool->tick > 0) && (chunk->particles_tick + 1 < pool->tick)) {
+        catch_up_chunk_particles(pool, chunk, pool->tick - 1);
+    }
+
     ParticleBuffer *particle_buffer = has_flag(config.flags, PS_FLAG_EMITS_LIGHT)
         ? &chunk->particle_buffers.light_emitting_particles
         : &chunk->particle_buffers.normal_particles;
@@ -77,7 +83,9 @@ void spawn_particles_in_chunk(Chunk *chunk, Rectangle spawn_area, ParticleSpawne
             .size = config.particle_size,
         };
 
-        ring_push_overwrite(particle_buffer, &new_particle);
+        if (!particle_buffer_push(pool, particle_buffer, new_particle)) {
+            break;
+        }
     }
 }
 
@@ -90,7 +98,7 @@ void update_particle_spawner(World *world, Entity *entity, ParticleSpawner *ps,
     Chunk *entity_chunk = get_chunk_at_position(&world->map_chunks, physics->position);
     ASSERT(entity_chunk);
 
-    spawn_particles_in_chunk(entity_chunk, entity_bounds, ps->config, particles_to_spawn);
+    spawn_particles_in_chunk(&world->particle_pool, entity_chunk, entity_bounds, ps->config, particles_to_spawn);
 
     if (particle_spawner_is_finished(ps)
         && !has_flag(ps->config.flags, PS_FLAG_WHEN_DONE_REMOVE_ENTITY)) {
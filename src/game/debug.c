@@ -36,7 +36,7 @@ void debug_render_quad_tree(QuadTreeNode *tree, RenderBatch *rb, LinearArena *ar
 	ASSERT(depth < ARRAY_COUNT(colors));
 
 	RGBA32 color = colors[depth];
-	draw_outlined_rectangle(rb, arena, tree->area, color, 4.0f, shader_handle(SHAPE_SHADER), 0);
+	draw_outlined_rectangle(rb, tree->area, color, 4.0f, shader_handle(SHAPE_SHADER), 0);
     }
 }
 
@@ -152,10 +152,48 @@ void debug_ui(UIState *ui, Game *game, LinearArena *scratch, const FrameData *fr
     String world_arena_str = dbg_arena_usage_string(str_lit("World arena"), world_arena_memory_usage, scratch);
 
     ssize qt_nodes = qt_get_node_count(&game->world.quad_tree);
-    String node_string = format(scratch, "Quad tree nodes: %ld", qt_nodes);
+    ssize resting_qt_nodes = qt_get_node_count(&game->world.resting_quad_tree);
+    String node_string = format(scratch, "Quad tree nodes (moving/resting): %ld/%ld",
+        qt_nodes, resting_qt_nodes);
 
     String entity_string = format(scratch, "Alive entity count: %d", game->world.alive_entity_count);
 
+    BroadphaseStats broadphase_stats = game->world.broadphase_stats;
+    String broadphase_str = format(scratch, "Broadphase pairs tested/culled: %ld/%ld",
+        broadphase_stats.pairs_tested, broadphase_stats.pairs_culled);
+    String resting_str = format(scratch, "Resting entities: %ld, relocations done/skipped: %ld/%ld",
+        broadphase_stats.resting_entities, broadphase_stats.relocations,
+        broadphase_stats.relocations_skipped);
+    String visibility_cache_str = format(scratch, "Visibility cache hits/misses: %ld/%ld",
+        game->world.visibility_cache.hits, game->world.visibility_cache.misses);
+    String line_of_sight_str = format(scratch, "Line of sight cache hits/misses: %ld/%ld",
+        game->world.line_of_sight_cache.hits, game->world.line_of_sight_cache.misses);
+    String render_batch_str = str_lit("Render entries per batch:");
+
+    for (ssize i = 0; i < game->debug_state.render_batch_count; ++i) {
+        String count_str = format(scratch, " %ld", game->debug_state.render_batch_entry_counts[i]);
+        render_batch_str = str_concat(render_batch_str, count_str, la_allocator(scratch));
+    }
+
+    ParticlePool *particle_pool = &game->world.particle_pool;
+    String particle_str = format(scratch,
+        "Particles live/dropped/rebinned: %ld/%ld/%ld, chunks fast-forwarded: %ld",
+        particle_pool->live_particles, particle_pool->dropped_particles,
+        particle_pool->rebinned_particles, particle_pool->fast_forwarded_chunks);
+    LightRenderStats light_stats = game->world.light_stats;
+    String light_str = format(scratch, "Lights drawn/culled/over budget/downgraded: %ld/%ld/%ld/%ld",
+        light_stats.drawn, light_stats.culled, light_stats.over_budget, light_stats.downgraded);
+    String lightmap_str = format(scratch, "Lightmap bakes pending/finished: %ld/%ld",
+        game->world.lightmaps.pending_bakes, game->world.lightmaps.finished_bakes);
+    RenderCullStats cull_stats = game->world.cull_stats;
+    String cull_str = format(scratch, "Drawn/culled chunks: %ld/%ld, entities: %ld/%ld, commands: %ld/%ld",
+        cull_stats.chunks_drawn, cull_stats.chunks_culled, cull_stats.entities_drawn,
+        cull_stats.entities_culled, cull_stats.commands_drawn, cull_stats.commands_culled);
+    RenderStats render_stats = game->debug_state.render_stats;
+    String render_stats_str = format(scratch,
+        "Draw calls: %ld, vertices: %ld, state flushes/saved by atlas: %ld/%ld", render_stats.draw_calls,
+        render_stats.vertices, render_stats.state_flushes, render_stats.atlas_flushes_saved);
+
     f32 timestep = game->debug_state.timestep_modifier;
     String timestep_value_str = {0};
 
@@ -168,9 +206,13 @@ void debug_ui(UIState *ui, Game *game, LinearArena *scratch, const FrameData *fr
     String timestep_str = format(scratch, "Timestep modifier: "FMT_STR,
         FMT_STR_ARG(timestep_value_str));
 
+    String simulation_str = format(scratch, "Simulation steps this frame: %ld, dropped: %ld",
+        game->debug_state.simulation_steps_last_frame, game->debug_state.dropped_simulation_steps);
+
     ui_text(ui, frame_time_str);
     ui_text(ui, fps_str);
     ui_text(ui, timestep_str);
+    ui_text(ui, simulation_str);
 
     ui_spacing(ui, 8);
 
@@ -179,6 +221,16 @@ void debug_ui(UIState *ui, Game *game, LinearArena *scratch, const FrameData *fr
     ui_text(ui, world_arena_str);
     ui_text(ui, node_string);
     ui_text(ui, entity_string);
+    ui_text(ui, broadphase_str);
+    ui_text(ui, resting_str);
+    ui_text(ui, visibility_cache_str);
+    ui_text(ui, light_str);
+    ui_text(ui, line_of_sight_str);
+    ui_text(ui, particle_str);
+    ui_text(ui, render_batch_str);
+    ui_text(ui, lightmap_str);
+    ui_text(ui, cull_str);
+    ui_text(ui, render_stats_str);
 
     ui_spacing(ui, 8);
 
@@ -191,6 +243,7 @@ void debug_ui(UIState *ui, Game *game, LinearArena *scratch, const FrameData *fr
     ui_checkbox(ui, str_lit("Render camera bounds"),     &game->debug_state.render_camera_bounds);
     ui_checkbox(ui, str_lit("Render chunks"),            &game->debug_state.render_chunks);
     ui_checkbox(ui, str_lit("Render chain links"),       &game->debug_state.render_chain_links);
+    ui_checkbox(ui, str_lit("Shadowcast lights"),        &game->world.light_settings.force_shadowcast);
 
     ui_spacing(ui, 8);
 
@@ -305,7 +358,7 @@ void debug_update(Game *game, const FrameData *frame_data)
     game->debug_state.timestep_modifier = CLAMP(speed_modifier, 0.0f, 5.0f);
 }
 
-void debug_render_chunks(struct Game *game, struct RenderBatch *rb, struct LinearArena *arena)
+void debug_render_chunks(struct Game *game, struct RenderBatch *rb)
 {
 #if 1
     Chunks *chunks = &game->world.map_chunks;
@@ -336,7 +389,7 @@ void debug_render_chunks(struct Game *game, struct RenderBatch *rb, struct Linea
             /*     layer = 1; */
             /* } */
 
-            draw_outlined_rectangle(rb, arena, rect, color, 4.0f,
+            draw_outlined_rectangle(rb, rect, color, 4.0f,
                 shader_handle(SHAPE_SHADER), layer);
         }
     }
@@ -348,7 +401,7 @@ void debug_render_chunks(struct Game *game, struct RenderBatch *rb, struct Linea
     Vector2 dims = {256, 256};
     Rectangle area = {v2_sub(mouse_pos, dims), v2_mul_s(dims, 2.0f)};
 
-    draw_rectangle(rb, arena, area, rgba32(0, 0.5f, 1.0f, 0.4f),
+    draw_rectangle(rb, area, rgba32(0, 0.5f, 1.0f, 0.4f),
         shader_handle(SHAPE_SHADER), 0);
 
     Chunks *chunks = &game->world.map_chunks;
@@ -385,7 +438,7 @@ void debug_render_chunks(struct Game *game, struct RenderBatch *rb, struct Linea
 
             }
             if (found) {
-                draw_outlined_rectangle(rb, arena, rect, RGBA32_BLUE, 4.0f,
+                draw_outlined_rectangle(rb, rect, RGBA32_BLUE, 4.0f,
                     shader_handle(SHAPE_SHADER), layer);
             }
         }
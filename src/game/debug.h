@@ -5,6 +5,7 @@
 
 #include "camera.h"
 #include "ui/ui_core.h"
+#include "renderer/frontend/render_stats.h"
 
 struct Game;
 struct GameMemory;
@@ -14,6 +15,8 @@ struct RenderBatch;
 struct LinearArena;
 struct Chunk;
 
+#define DEBUG_MAX_RENDER_BATCHES 16
+
 typedef struct DebugState {
     UIState debug_ui;
 
@@ -29,6 +32,15 @@ typedef struct DebugState {
     f32 average_fps;
     f32 timestep_modifier;
 
+    ssize simulation_steps_last_frame;
+    ssize dropped_simulation_steps;
+
+    // Entries recorded into each render batch last frame, stencil passes included
+    ssize render_batch_entry_counts[DEBUG_MAX_RENDER_BATCHES];
+    ssize render_batch_count;
+
+    RenderStats render_stats; // From the last time the render frame being recorded was executed
+
     // TODO: asset memory usage
     ssize scratch_arena_memory_usage;
     ssize permanent_arena_memory_usage;
@@ -52,7 +64,7 @@ void debug_update(struct Game *game, const struct FrameData *frame_data);
 void debug_ui(UIState *ui, struct Game *game, struct LinearArena *scratch, const struct FrameData *frame_data);
 void debug_render_quad_tree(struct QuadTreeNode *tree, struct RenderBatch *rb, LinearArena *arena,
     ssize depth);
-void debug_render_chunks(struct Game *game, struct RenderBatch *rb, struct LinearArena *arena);
+void debug_render_chunks(struct Game *game, struct RenderBatch *rb);
 
 
 #endif //DEBUG_H
@@ -4,6 +4,7 @@
 #include "base/typedefs.h"
 
 #define NULL_ENTITY_ID ((EntityID){0})
+#define MAX_ENTITIES 32
 
 typedef s32 EntityIndex;
 typedef s32 EntityGeneration;
@@ -3,10 +3,9 @@
 
 #include "base/ring_buffer.h"
 #include "entity.h"
+#include "entity_id.h"
 #include "generational_id.h"
 
-#define MAX_ENTITIES 32
-
 /*
   TODO:
   - Don't return EntityWithID from es_create_entity since id is easily available now
@@ -34,6 +34,23 @@ static void set_global_state(Game *game)
     anim_initialize();
 }
 
+b32 player_try_pick_up_item(EntitySystem *es, Entity *player, Entity *hovered_entity, const Input *input)
+{
+    b32 result = false;
+
+    if (hovered_entity && input_is_key_pressed(input, MOUSE_RIGHT)) {
+        Inventory *inv = es_get_component(player, Inventory);
+        InventoryStorable *storable = es_get_component(hovered_entity, InventoryStorable);
+        ASSERT(inv);
+        ASSERT(storable);
+
+        append_item_to_inventory(es, inv, storable);
+        result = true;
+    }
+
+    return result;
+}
+
 static void update_player(World *world, const FrameData *frame_data,
     GameUIState *game_ui, Camera active_camera)
 {
@@ -45,15 +62,7 @@ static void update_player(World *world, const FrameData *frame_data,
     camera_set_target(&world->camera, camera_target);
 
     Entity *hovered_entity = es_try_get_entity(&world->entity_system, game_ui->hovered_entity);
-
-    if (hovered_entity && input_is_key_pressed(&frame_data->input, MOUSE_RIGHT)) {
-        Inventory *inv = es_get_component(player, Inventory);
-        InventoryStorable *storable = es_get_component(hovered_entity, InventoryStorable);
-        ASSERT(inv);
-        ASSERT(storable);
-
-        append_item_to_inventory(&world->entity_system, inv, storable);
-    }
+    player_try_pick_up_item(&world->entity_system, player, hovered_entity, &frame_data->input);
 
     if (player->state.kind != ENTITY_STATE_ATTACKING) {
 #if 0
@@ -189,16 +198,17 @@ static void render_ui(Game *game, RenderBatches rbs, FrameData *frame_data,
 
     if (game->debug_state.quad_tree_overlay) {
         debug_render_quad_tree(&game->world.quad_tree.root, rbs.worldspace_ui_rb, frame_arena, 0);
+        debug_render_quad_tree(&game->world.resting_quad_tree.root, rbs.worldspace_ui_rb, frame_arena, 0);
     }
 
     if (game->debug_state.render_origin) {
-        draw_rectangle(rbs.worldspace_ui_rb, frame_arena, (Rectangle){{0, 0}, {8, 8}}, RGBA32_RED,
+        draw_rectangle(rbs.worldspace_ui_rb, (Rectangle){{0, 0}, {8, 8}}, RGBA32_RED,
 	    shader_handle(SHAPE_SHADER), 3);
     }
 
     // TODO: move more debug rendering to debug file
     if (game->debug_state.render_chunks) {
-        debug_render_chunks(game, rbs.worldspace_ui_rb, frame_arena);
+        debug_render_chunks(game, rbs.worldspace_ui_rb);
     }
 }
 
@@ -237,7 +247,7 @@ static void update_ui(Game *game, FrameData *frame_data,
     );
 
     Rectangle hovered_rect = {hovered_coords, {1, 1}};
-    EntityIDList hovered_entities = qt_get_entities_in_area(&game->world.quad_tree,
+    EntityIDList hovered_entities = world_get_entities_in_area(&game->world,
 	hovered_rect, frame_arena);
 
     if (!list_is_empty(&hovered_entities)) {
@@ -256,16 +266,32 @@ static void update_ui(Game *game, FrameData *frame_data,
 }
 
 static void game_render(Game *game, RenderBatchList *rb_list, FrameData *frame_data,
-    LinearArena *frame_arena)
+    PlatformCode platform_code, LinearArena *frame_arena)
 {
     RenderBatches rbs = create_render_batches(game, rb_list, frame_data, frame_arena);
 
-    world_render(&game->world, rbs, frame_data, frame_arena, &game->debug_state);
+    world_render(&game->world, rbs, frame_data, platform_code, frame_arena, &game->debug_state);
 
     render_ui(game, rbs, frame_data, frame_arena);
 
+    DebugState *debug_state = &game->debug_state;
+    debug_state->render_batch_count = 0;
+
     for (RenderBatch *batch = list_head(rb_list); batch; batch = list_next(batch)) {
         sort_render_entries(batch, frame_arena);
+
+        // The batches are executed on the render thread while the next frame is being updated
+        copy_referenced_render_data(batch);
+
+        if (debug_state->render_batch_count < DEBUG_MAX_RENDER_BATCHES) {
+            ssize entry_count = batch->entry_count;
+
+            if (batch->stencil_batch) {
+                entry_count += batch->stencil_batch->entry_count;
+            }
+
+            debug_state->render_batch_entry_counts[debug_state->render_batch_count++] = entry_count;
+        }
     }
 }
 
@@ -288,25 +314,52 @@ static void game_update(Game *game, FrameData *frame_data, PlatformCode platform
     // NOTE: normal camera is always updated too even if debug camera is active
     camera_update(&game->world.camera, frame_data->dt);
 
-    frame_data->dt *= game->debug_state.timestep_modifier;
-
     b32 game_paused = game->debug_state.timestep_modifier == 0.0f;
     b32 frame_advance_key_pressed = input_is_key_pressed(&frame_data->input, KEY_K);
-    b32 should_update = !game_paused || frame_advance_key_pressed;
 
-    if (should_update) {
-        if (game_paused) {
-            // When advancing by a single frame, set the dt to a reasonable default value
-            frame_data->dt = 0.016f;
+    ssize step_count = 0;
+
+    if (game_paused) {
+        // When advancing by a single frame, run exactly one simulation step
+        step_count = frame_advance_key_pressed ? 1 : 0;
+    } else {
+        game->simulation_time_accumulator += frame_data->dt * game->debug_state.timestep_modifier;
+        step_count = (ssize)(game->simulation_time_accumulator / SIMULATION_TIMESTEP);
+
+        if (step_count > MAX_SIMULATION_STEPS_PER_FRAME) {
+            game->debug_state.dropped_simulation_steps += step_count - MAX_SIMULATION_STEPS_PER_FRAME;
+            step_count = MAX_SIMULATION_STEPS_PER_FRAME;
         }
 
-        update_player(&game->world, frame_data, &game->game_ui, *active_camera);
-        world_update(&game->world, frame_data, frame_arena);
+        game->simulation_time_accumulator = fmodf(game->simulation_time_accumulator, SIMULATION_TIMESTEP);
     }
+
+    input_latch_edges(&game->simulation_input, &frame_data->input);
+
+    FrameData tick_data = *frame_data;
+    tick_data.dt = SIMULATION_TIMESTEP;
+    tick_data.input = game->simulation_input;
+
+    for (ssize i = 0; i < step_count; ++i) {
+        update_player(&game->world, &tick_data, &game->game_ui, *active_camera);
+        world_update(&game->world, &tick_data, frame_arena);
+
+        // Only the first step sees presses and releases
+        input_clear_edges(&tick_data.input);
+    }
+
+    if (step_count > 0) {
+        input_clear_edges(&game->simulation_input);
+    }
+
+    world_update_lightmaps(&game->world, platform_code, frame_arena);
+
+    game->debug_state.simulation_steps_last_frame = step_count;
+    game->world.render_interpolation = game->simulation_time_accumulator / SIMULATION_TIMESTEP;
 }
 
 void game_update_and_render(Game *game, PlatformCode platform_code, RenderBatchList *rbs,
-    FrameData frame_data, GameMemory *game_memory)
+    FrameData frame_data, RenderStats render_stats, GameMemory *game_memory)
 {
 #if HOT_RELOAD
     // NOTE: these global pointers are set every frame in case we have hot reloaded
@@ -317,8 +370,10 @@ void game_update_and_render(Game *game, PlatformCode platform_code, RenderBatchL
         DEBUG_BREAK;
     }
 
+    game->debug_state.render_stats = render_stats;
+
     game_update(game, &frame_data, platform_code, &game_memory->temporary_memory);
-    game_render(game, rbs, &frame_data, &game_memory->temporary_memory);
+    game_render(game, rbs, &frame_data, platform_code, &game_memory->temporary_memory);
 
     // NOTE: These stats are set at end of frame since debug UI is drawn before the arenas
     // have had time to be used during the frame. This means that the stats have 1 frame delay
@@ -349,3 +404,9 @@ void game_initialize(Game *game, GameMemory *game_memory)
     ui_core_initialize(&game->debug_state.debug_ui, default_ui_style, &game_memory->permanent_memory);
     ui_core_initialize(&game->game_ui.backend_state, default_ui_style, &game_memory->permanent_memory);
 }
+
+void game_prepare_for_reload(Game *game, PlatformCode platform_code)
+{
+    // Bake jobs run code from this library
+    lightmaps_wait_for_bakes(&game->world.lightmaps, platform_code);
+}
@@ -21,6 +21,13 @@
 #define FRAME_ARENA_SIZE GAME_MEMORY_SIZE / 2
 #define FREE_LIST_ARENA_SIZE PERMANENT_ARENA_SIZE / 4
 
+// The simulation always advances in steps of this size, independent of frame rate
+#define SIMULATION_TICK_RATE 60
+#define SIMULATION_TIMESTEP (1.0f / (f32)SIMULATION_TICK_RATE)
+
+// Any time beyond this is dropped after a long frame instead of catching up
+#define MAX_SIMULATION_STEPS_PER_FRAME 4
+
 struct RenderBatchList;
 
 typedef struct Game {
@@ -29,6 +36,9 @@ typedef struct Game {
     DebugState debug_state;
     RNGState rng_state;
     GameUIState game_ui;
+
+    f32 simulation_time_accumulator;
+    Input simulation_input; // Key edges are kept here until a simulation step has seen them
 } Game;
 
 typedef struct GameMemory {
@@ -43,7 +53,11 @@ typedef struct GameMemory {
 } GameMemory;
 
 void game_update_and_render(Game *game_state, PlatformCode platform_code, struct RenderBatchList *rbs,
-    FrameData frame_data, GameMemory *game_memory);
+    FrameData frame_data, RenderStats render_stats, GameMemory *game_memory);
 void game_initialize(Game *game_state, GameMemory *game_memory);
+void game_prepare_for_reload(Game *game_state, PlatformCode platform_code); // Called before the game library is unloaded
+
+// Called once per simulation step, so the input should only contain presses that no step has seen yet
+b32  player_try_pick_up_item(EntitySystem *es, Entity *player, Entity *hovered_entity, const Input *input);
 
 #endif //GAME_H
@@ -52,7 +52,7 @@ void hitsplats_render(World *world, RenderBatch *rb, LinearArena *frame_arena)
 	color.a = alpha;
 
 	draw_text(
-	    rb, frame_arena, damage_str, hitsplat->position, color, 28,
+	    rb, damage_str, hitsplat->position, color, 28,
 	    shader_handle(TEXTURE_SHADER), font_handle(DEFAULT_FONT), 5);
     }
 }
@@ -1,14 +1,16 @@
-#define _GNU_SOURCE
-#include <stdlib.h>
+#include <string.h>
 
 #include "light.h"
 #include "base/linear_arena.h"
 #include "base/line.h"
 #include "base/list.h"
 #include "base/polygon.h"
+#include "base/radix_sort.h"
 #include "base/vector.h"
 #include "world/tilemap.h"
+#include "world/edge_raycast.h"
 #include "world/line_of_sight.h"
+#include "world/shadowcasting.h"
 #include "world/world.h"
 #include "base/utils.h"
 #include "renderer/frontend/render_batch.h"
@@ -18,12 +20,9 @@
 #define RAYS_PER_CORNER 3
 #define RAY_OFFSET_FROM_CORNER 0.00001f
 
-#define LIGHT_SHADER_ORIGIN_UNIFORM_NAME str_lit("u_light_origin")
-#define LIGHT_SHADER_RADIUS_UNIFORM_NAME str_lit("u_light_radius")
-
 typedef struct {
     Vector2 intersection_point;
-    f32 ray_angle;
+    u64 sort_key; // Bits of the pseudo angle
 } RayHit;
 
 typedef struct {
@@ -32,78 +31,48 @@ typedef struct {
 } RayHits;
 
 // TODO: all these functions should be in the line of sight file
-int sort_points_cmp(const void *a, const void *b, void *data)
+static u64 get_ray_hit_sort_key(Vector2 ray_direction)
 {
-    (void)data;
-
-    RayHit hit_a = *(RayHit *)a;
-    RayHit hit_b = *(RayHit *)b;
+    // Pseudo angles are never negative, so their bits sort in the same order as the values
+    f32 angle = pseudo_angle(ray_direction);
 
-    f32 angle_a = hit_a.ray_angle;
-    f32 angle_b = hit_b.ray_angle;
-
-    if (angle_a < angle_b) {
-        return -1;
-    } else if (angle_a > angle_b) {
-        return 1;
-    }
+    u32 bits = 0;
+    memcpy(&bits, &angle, sizeof(bits));
 
-    return 0;
+    return bits;
 }
 
-static void cast_rays_towards_corner(RayHits *hit_array, Vector2 origin, Vector2 target, EdgePool *edges)
+static void cast_rays_towards_corner(RayHits *hit_array, Vector2 origin, Vector2 target, const EdgeSoA *edges)
 {
-    Vector2 target_direction = v2_norm(v2_sub(target, origin));
-    f32 target_angle = atan2f(target_direction.y, target_direction.x);
-
-    for (ssize i = 0; i < RAYS_PER_CORNER; ++i) {
-	f32 angle_offset = -RAY_OFFSET_FROM_CORNER + RAY_OFFSET_FROM_CORNER * (f32)i;
-	f32 ray_angle = target_angle + angle_offset;
-
-	Vector2 ray_direction = {cosf(ray_angle), sinf(ray_angle)};
+    Vector2 target_direction = v2_sub(target, origin);
 
-        Vector2 closest_hit = {0};
-        f32 closest_hit_dist_sq = INFINITY;
-
-        for (ssize j = 0; j < edges->count; ++j) {
-            EdgeLine edge = edges->items[j];
+    if (v2_is_zero(target_direction)) {
+        return;
+    }
 
-            b32 should_raycast = true;
+    target_direction = v2_norm(target_direction);
 
-            // For vertical wall edges, we want them to be lit if we're visually in front of them
-            if (edge.direction == CARDINAL_DIR_WEST) {
-                // Raycast against west wall if either above it, or in front of it and to the right
-                should_raycast = (origin.y >= edge.line.end.y) || (origin.x >= edge.line.end.x);
-            } else if (edge.direction == CARDINAL_DIR_EAST) {
-                // Raycast against east wall if either above it, or in front of it and to the left
-                should_raycast = (origin.y >= edge.line.end.y) || (origin.x <= edge.line.end.x);
-            }
+    for (ssize i = 0; i < RAYS_PER_CORNER; ++i) {
+        // The offsets are small enough that cos is exactly 1 and sin is the angle itself
+        f32 angle_offset = -RAY_OFFSET_FROM_CORNER + RAY_OFFSET_FROM_CORNER * (f32)i;
 
-            if (should_raycast) {
-                LineIntersection intersection = ray_vs_line_intersection(origin, ray_direction, edge.line);
+        Vector2 ray_direction = {
+            target_direction.x - target_direction.y * angle_offset,
+            target_direction.y + target_direction.x * angle_offset
+        };
 
-                if (intersection.are_intersecting) {
-                    f32 dist_sq = v2_dist_sq(origin, intersection.intersection_point);
+        f32 t = edge_raycast_closest_hit(edges, origin, ray_direction);
 
-                    if (dist_sq < closest_hit_dist_sq) {
-                        closest_hit_dist_sq = dist_sq;
-                        closest_hit = intersection.intersection_point;
-                    }
-                }
-            }
-        }
-
-        if (!isinf(closest_hit_dist_sq)) {
-            RayHit hit = {closest_hit, ray_angle};
+        if (!isinf(t)) {
+            RayHit hit = {v2_add(origin, v2_mul_s(ray_direction, t)), get_ray_hit_sort_key(ray_direction)};
             hit_array->items[hit_array->count++] = hit;
         }
     }
 }
 
-TriangleFan get_visibility_polygon(Vector2 origin, Tilemap *tilemap, LinearArena *arena)
+static TriangleFan build_visibility_polygon(Vector2 origin, EdgePool edge_pool, LinearArena *arena)
 {
-    Allocator alloc = la_allocator(arena);
-    EdgePool edge_pool = tilemap_get_edge_list(tilemap, alloc);
+    EdgeSoA edges = edge_soa_create_for_origin(edge_pool, origin, arena);
 
     RayHits ray_hits = {0};
     ray_hits.items = la_allocate_array(arena, RayHit, edge_pool.count * 2 * RAYS_PER_CORNER);
@@ -111,12 +80,12 @@ TriangleFan get_visibility_polygon(Vector2 origin, Tilemap *tilemap, LinearArena
     for (ssize i = 0; i < edge_pool.count; ++i) {
 	 EdgeLine edge = edge_pool.items[i];
 
-	cast_rays_towards_corner(&ray_hits, origin, edge.line.start, &edge_pool);
-	cast_rays_towards_corner(&ray_hits, origin, edge.line.end, &edge_pool);
+	cast_rays_towards_corner(&ray_hits, origin, edge.line.start, &edges);
+	cast_rays_towards_corner(&ray_hits, origin, edge.line.end, &edges);
     }
 
     // Sort the ray hits in clockwise order around player to allow connecting them in triangle fan
-    qsort_r(ray_hits.items, (usize)ray_hits.count, sizeof(*ray_hits.items), sort_points_cmp, 0);
+    radix_sort(ray_hits.items, ray_hits.count, sort_key, arena);
 
     TriangleFan result = {0};
     result.center = origin;
@@ -133,11 +102,416 @@ TriangleFan get_visibility_polygon(Vector2 origin, Tilemap *tilemap, LinearArena
     return result;
 }
 
-void render_light_source(struct World *world, struct RenderBatch *rb, Vector2 origin, LightSource light,
-    f32 intensity, struct LinearArena *arena)
+TriangleFan get_visibility_polygon(Vector2 origin, Tilemap *tilemap, LinearArena *arena)
 {
-    RenderEntry *entry = 0;
+    Allocator alloc = la_allocator(arena);
+    EdgePool edge_pool = tilemap_get_edge_list(tilemap, alloc);
+
+    TriangleFan result = build_visibility_polygon(origin, edge_pool, arena);
+
+    return result;
+}
+
+// Wall edges are axis aligned, so clipping only needs to clamp the axis the edge runs along.
+// Clipped endpoints become corners that rays are cast towards, which keeps walls that cross
+// the bounds from being cut off diagonally in the final polygon.
+static b32 clip_edge_to_rect(EdgeLine *edge, Rectangle rect)
+{
+    Vector2 min = rect.position;
+    Vector2 max = v2_add(rect.position, rect.size);
+
+    Vector2 *start = &edge->line.start;
+    Vector2 *end = &edge->line.end;
+
+    if (start->y == end->y) {
+        if ((start->y < min.y) || (start->y > max.y)) {
+            return false;
+        }
+
+        start->x = CLAMP(start->x, min.x, max.x);
+        end->x = CLAMP(end->x, min.x, max.x);
+
+        return start->x != end->x;
+    } else {
+        ASSERT(start->x == end->x);
+
+        if ((start->x < min.x) || (start->x > max.x)) {
+            return false;
+        }
+
+        start->y = CLAMP(start->y, min.y, max.y);
+        end->y = CLAMP(end->y, min.y, max.y);
+
+        return start->y != end->y;
+    }
+}
+
+TriangleFan get_shadowcast_visibility_polygon(Vector2 origin, f32 radius, Tilemap *tilemap,
+    LinearArena *arena)
+{
+    EdgePool visible_edges = shadowcast_get_visible_edges(tilemap, origin, radius, arena);
+
+    // Rays that don't hit any nearby wall end up on a square around the light radius
+    Vector2 top_left = v2_add(origin, v2(-radius, radius));
+    Vector2 top_right = v2_add(origin, v2(radius, radius));
+    Vector2 bottom_right = v2_add(origin, v2(radius, -radius));
+    Vector2 bottom_left = v2_add(origin, v2(-radius, -radius));
+
+    EdgeLine bounds[] = {
+        {{top_left, top_right}, CARDINAL_DIR_NORTH},
+        {{top_right, bottom_right}, CARDINAL_DIR_NORTH},
+        {{bottom_right, bottom_left}, CARDINAL_DIR_NORTH},
+        {{bottom_left, top_left}, CARDINAL_DIR_NORTH},
+    };
+
+    EdgePool edge_pool = {0};
+    edge_pool.capacity = visible_edges.count + ARRAY_COUNT(bounds);
+    edge_pool.items = la_allocate_array(arena, EdgeLine, edge_pool.capacity);
+
+    Rectangle light_bounds = {bottom_left, {radius * 2.0f, radius * 2.0f}};
+
+    for (ssize i = 0; i < visible_edges.count; ++i) {
+        EdgeLine edge = visible_edges.items[i];
+
+        if (clip_edge_to_rect(&edge, light_bounds)) {
+            edge_pool.items[edge_pool.count++] = edge;
+        }
+    }
+
+    for (ssize i = 0; i < ARRAY_COUNT(bounds); ++i) {
+        edge_pool.items[edge_pool.count++] = bounds[i];
+    }
+
+    TriangleFan result = build_visibility_polygon(origin, edge_pool, arena);
+
+    return result;
+}
+
+void visibility_cache_initialize(VisibilityPolygonCache *cache, Allocator allocator)
+{
+    *cache = zero_struct(VisibilityPolygonCache);
+    cache->allocator = allocator;
+
+    for (ssize i = 0; i < ARRAY_COUNT(cache->job_scratch); ++i) {
+        cache->job_scratch[i] = la_create(default_allocator, VISIBILITY_JOB_SCRATCH_SIZE);
+    }
+}
+
+void visibility_cache_destroy(VisibilityPolygonCache *cache)
+{
+    for (ssize i = 0; i < ARRAY_COUNT(cache->entries); ++i) {
+        VisibilityCacheEntry *entry = &cache->entries[i];
+
+        if (entry->fan.items) {
+            deallocate(cache->allocator, entry->fan.items);
+        }
+    }
+
+    for (ssize i = 0; i < ARRAY_COUNT(cache->job_scratch); ++i) {
+        la_destroy(&cache->job_scratch[i]);
+    }
+
+    *cache = zero_struct(VisibilityPolygonCache);
+}
+
+static Vector2i quantize_light_origin(Vector2 origin)
+{
+    Vector2i result = {
+        (s32)floorf(origin.x / VISIBILITY_CACHE_ORIGIN_QUANTUM),
+        (s32)floorf(origin.y / VISIBILITY_CACHE_ORIGIN_QUANTUM)
+    };
+
+    return result;
+}
+
+static b32 cache_entry_matches(const VisibilityCacheEntry *entry, EntityID light_entity,
+    Vector2i quantized_origin, const LightSource *light, const Tilemap *tilemap)
+{
+    b32 result = entry->is_valid
+        && entity_id_equal(entry->light_entity, light_entity)
+        && v2i_eq(entry->quantized_origin, quantized_origin)
+        && (entry->radius == light->radius)
+        && (entry->tilemap_version == tilemap->version)
+        && (entry->visibility_backend == light->visibility_backend);
+
+    return result;
+}
+
+// Edge raycasting uses the precomputed tilemap edges, since building the edge list writes to
+// the tiles and isn't safe to do from several threads at once
+static TriangleFan generate_visibility_polygon(Vector2 origin, const LightSource *light,
+    Tilemap *tilemap, EdgePool tilemap_edges, LinearArena *arena)
+{
+    TriangleFan result = {0};
+
+    switch (light->visibility_backend) {
+        case LIGHT_VISIBILITY_EDGE_RAYCAST: {
+            result = build_visibility_polygon(origin, tilemap_edges, arena);
+        } break;
+
+        case LIGHT_VISIBILITY_SHADOWCAST: {
+            result = get_shadowcast_visibility_polygon(origin, light->radius, tilemap, arena);
+        } break;
+
+        INVALID_DEFAULT_CASE;
+    }
+
+    return result;
+}
+
+static void store_in_cache_entry(VisibilityPolygonCache *cache, VisibilityCacheEntry *entry,
+    EntityID light_entity, Vector2i quantized_origin, const LightSource *light,
+    const Tilemap *tilemap, TriangleFan fan)
+{
+    if (fan.count > entry->capacity) {
+        if (entry->fan.items) {
+            deallocate(cache->allocator, entry->fan.items);
+        }
+
+        entry->fan.items = allocate_array(cache->allocator, TriangleFanElement, fan.count);
+        entry->capacity = fan.count;
+    }
+
+    if (fan.count > 0) {
+        memcpy(entry->fan.items, fan.items, (usize)fan.count * sizeof(*fan.items));
+    }
 
+    entry->fan.center = fan.center;
+    entry->fan.count = fan.count;
+
+    entry->is_valid = true;
+    entry->light_entity = light_entity;
+    entry->quantized_origin = quantized_origin;
+    entry->radius = light->radius;
+    entry->tilemap_version = tilemap->version;
+    entry->visibility_backend = light->visibility_backend;
+    entry->generated_this_frame = false;
+}
+
+TriangleFan visibility_cache_get_polygon(VisibilityPolygonCache *cache, EntityID light_entity,
+    Vector2 origin, const LightSource *light, Tilemap *tilemap, LinearArena *scratch)
+{
+    ASSERT(light_entity.index >= 0);
+    ASSERT(light_entity.index < ARRAY_COUNT(cache->entries));
+
+    VisibilityCacheEntry *entry = &cache->entries[light_entity.index];
+    Vector2i quantized_origin = quantize_light_origin(origin);
+
+    if (cache_entry_matches(entry, light_entity, quantized_origin, light, tilemap)) {
+        if (entry->generated_this_frame) {
+            entry->generated_this_frame = false;
+        } else {
+            ++cache->hits;
+        }
+    } else {
+        ++cache->misses;
+
+        EdgePool tilemap_edges = {0};
+
+        if (light->visibility_backend == LIGHT_VISIBILITY_EDGE_RAYCAST) {
+            tilemap_edges = tilemap_get_edge_list(tilemap, la_allocator(scratch));
+        }
+
+        TriangleFan fan = generate_visibility_polygon(origin, light, tilemap, tilemap_edges, scratch);
+        store_in_cache_entry(cache, entry, light_entity, quantized_origin, light, tilemap, fan);
+    }
+
+    TriangleFan result = entry->fan;
+
+    return result;
+}
+
+typedef struct {
+    const VisibilityRequest *requests;
+    TriangleFan             *results;
+    ssize                    count;
+
+    Tilemap                 *tilemap;
+    EdgePool                 tilemap_edges;
+    LinearArena             *arena;
+} VisibilityJob;
+
+static void visibility_job(void *data)
+{
+    VisibilityJob *job = data;
+    la_reset(job->arena);
+
+    for (ssize i = 0; i < job->count; ++i) {
+        const VisibilityRequest *request = &job->requests[i];
+
+        job->results[i] = generate_visibility_polygon(request->origin, &request->light,
+            job->tilemap, job->tilemap_edges, job->arena);
+    }
+}
+
+// Generates the polygons of every requested light that misses the cache on worker threads, and
+// stores them in the cache. The tilemap must not change until this returns.
+void visibility_cache_generate_polygons(VisibilityPolygonCache *cache,
+    const VisibilityRequest *requests, ssize request_count, Tilemap *tilemap,
+    PlatformCode platform_code, LinearArena *scratch)
+{
+    VisibilityRequest *misses = la_allocate_array(scratch, VisibilityRequest, MAX(request_count, 1));
+    ssize miss_count = 0;
+    b32 needs_tilemap_edges = false;
+
+    for (ssize i = 0; i < request_count; ++i) {
+        const VisibilityRequest *request = &requests[i];
+        ASSERT(request->light_entity.index >= 0);
+        ASSERT(request->light_entity.index < ARRAY_COUNT(cache->entries));
+        ASSERT(request->light.kind == LIGHT_RAYCASTED);
+
+        VisibilityCacheEntry *entry = &cache->entries[request->light_entity.index];
+
+        Vector2i quantized_origin = quantize_light_origin(request->origin);
+
+        if (!cache_entry_matches(entry, request->light_entity, quantized_origin, &request->light, tilemap)) {
+            misses[miss_count++] = *request;
+
+            if (request->light.visibility_backend == LIGHT_VISIBILITY_EDGE_RAYCAST) {
+                needs_tilemap_edges = true;
+            }
+        }
+    }
+
+    if (miss_count == 0) {
+        return;
+    }
+
+    EdgePool tilemap_edges = {0};
+
+    if (needs_tilemap_edges) {
+        tilemap_edges = tilemap_get_edge_list(tilemap, la_allocator(scratch));
+    }
+
+    TriangleFan *results = la_allocate_array(scratch, TriangleFan, miss_count);
+
+    ssize job_count = MIN(miss_count, VISIBILITY_JOB_COUNT);
+    VisibilityJob *jobs = la_allocate_array(scratch, VisibilityJob, job_count);
+    JobCounter counter = {0};
+
+    for (ssize i = 0; i < job_count; ++i) {
+        // Spread the lights as evenly as possible
+        ssize first = (miss_count * i) / job_count;
+        ssize end = (miss_count * (i + 1)) / job_count;
+
+        VisibilityJob *job = &jobs[i];
+        job->requests = misses + first;
+        job->results = results + first;
+        job->count = end - first;
+        job->tilemap = tilemap;
+        job->tilemap_edges = tilemap_edges;
+        job->arena = &cache->job_scratch[i];
+
+        platform_code.submit_job(visibility_job, job, &counter);
+    }
+
+    platform_code.wait_for_jobs(&counter);
+
+    // Storing is done here since the cache allocator can't be used from several threads
+    for (ssize i = 0; i < miss_count; ++i) {
+        const VisibilityRequest *request = &misses[i];
+        VisibilityCacheEntry *entry = &cache->entries[request->light_entity.index];
+
+        store_in_cache_entry(cache, entry, request->light_entity,
+            quantize_light_origin(request->origin), &request->light, tilemap, results[i]);
+        entry->generated_this_frame = true;
+
+        ++cache->misses;
+    }
+}
+
+typedef struct {
+    u64   key;
+    ssize light_index;
+} LightSortEntry;
+
+// Coverage is never negative, so its bits sort in the same order as the values. They are
+// flipped to put the largest coverage first, ties keep their original order.
+static u64 get_light_coverage_sort_key(const LightCandidate *light)
+{
+    u32 bits = 0;
+    memcpy(&bits, &light->screen_coverage, sizeof(bits));
+
+    u64 result = ~bits;
+
+    return result;
+}
+
+static void sort_lights_by_coverage(LightCandidate *lights, ssize count, LinearArena *scratch)
+{
+    LightSortEntry *entries = la_allocate_array(scratch, LightSortEntry, count);
+
+    for (ssize i = 0; i < count; ++i) {
+        entries[i].key = get_light_coverage_sort_key(&lights[i]);
+        entries[i].light_index = i;
+    }
+
+    radix_sort(entries, count, key, scratch);
+
+    LightCandidate *unsorted = la_copy_array(scratch, lights, count);
+
+    for (ssize i = 0; i < count; ++i) {
+        lights[i] = unsorted[entries[i].light_index];
+    }
+}
+
+// Removes lights that don't touch the visible area, draws raycasted lights that are small on
+// screen as regular circles and keeps at most the budgeted amount of lights, preferring the
+// ones covering the most of the screen. Returns the new light count.
+ssize select_lights_to_render(LightCandidate *lights, ssize count, Rectangle visible_area,
+    f32 world_to_screen_scale, LightRenderSettings settings, LightRenderStats *stats,
+    LinearArena *scratch)
+{
+    ssize visible_count = 0;
+
+    stats->candidates += count;
+
+    for (ssize i = 0; i < count; ++i) {
+        LightCandidate light = lights[i];
+
+        f32 radius = light.light.radius;
+        Rectangle bounds = {
+            v2_sub(light.origin, v2(radius, radius)),
+            v2(radius * 2.0f, radius * 2.0f)
+        };
+
+        if (!rect_intersects(bounds, visible_area)) {
+            ++stats->culled;
+            continue;
+        }
+
+        Rectangle covered_area = rect_overlap_area(bounds, visible_area);
+        light.screen_coverage = covered_area.size.x * covered_area.size.y
+            * world_to_screen_scale * world_to_screen_scale;
+
+        f32 screen_radius = radius * world_to_screen_scale;
+
+        if ((light.light.kind == LIGHT_RAYCASTED) && (screen_radius < settings.min_raycasted_screen_radius)) {
+            light.light.kind = LIGHT_REGULAR;
+            ++stats->downgraded;
+        }
+
+        if (settings.force_shadowcast) {
+            light.light.visibility_backend = LIGHT_VISIBILITY_SHADOWCAST;
+        }
+
+        lights[visible_count++] = light;
+    }
+
+    sort_lights_by_coverage(lights, visible_count, scratch);
+
+    ssize result = MIN(visible_count, MAX(settings.max_lights_per_frame, 0));
+    stats->over_budget += visible_count - result;
+    stats->drawn += result;
+
+    return result;
+}
+
+// Lights are clipped to the clip areas if there are any
+void render_light_source(struct World *world, struct RenderBatch *rb, EntityID light_entity,
+    Vector2 origin, LightSource light, f32 intensity, const Rectangle *clip_areas,
+    ssize clip_area_count, struct LinearArena *arena)
+{
     ASSERT(light.color.a > 0.0f);
 
     RGBA32 color = light.color;
@@ -153,23 +527,22 @@ void render_light_source(struct World *world, struct RenderBatch *rb, Vector2 or
 
     color.a = MAX(0.0f, color.a);
 
-    switch (light.kind) {
-        case LIGHT_REGULAR: {
-            entry = draw_circle(rb, arena, origin, color, light.radius,
-                shader_handle(LIGHT_SHADER), 0);
-        } break;
+    ASSERT((light.kind == LIGHT_REGULAR) || (light.kind == LIGHT_RAYCASTED));
 
-        case LIGHT_RAYCASTED: {
-            TriangleFan fan = get_visibility_polygon(origin, &world->tilemap, arena);
-            entry = draw_triangle_fan(rb, arena, fan, color,
-                shader_handle(LIGHT_SHADER), 0);
-        } break;
+    // Regular lights have no triangles, so they light the whole circle
+    TriangleFan fan = {0};
 
-        INVALID_DEFAULT_CASE;
+    if (light.kind == LIGHT_RAYCASTED) {
+        fan = visibility_cache_get_polygon(&world->visibility_cache, light_entity, origin, &light,
+            &world->tilemap, arena);
     }
 
-    Vector4 extended_pos = {origin.x, origin.y, 0.0f, 0.0f};
-    set_vec4_uniform(entry, arena, LIGHT_SHADER_ORIGIN_UNIFORM_NAME, extended_pos);
+    if (clip_area_count == 0) {
+        draw_raycasted_light(rb, origin, light.radius, fan, color, shader_handle(LIGHT_SHADER), 0);
+    }
 
-    set_f32_uniform(entry, arena, LIGHT_SHADER_RADIUS_UNIFORM_NAME, light.radius);
+    for (ssize i = 0; i < clip_area_count; ++i) {
+        draw_clipped_light(rb, origin, light.radius, fan, clip_areas[i], color,
+            shader_handle(LIGHT_SHADER), 0);
+    }
 }
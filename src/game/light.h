@@ -1,13 +1,28 @@
 #ifndef LIGHT_H
 #define LIGHT_H
 
+#include "base/allocator.h"
+#include "base/linear_arena.h"
 #include "base/list.h"
 #include "base/rectangle.h"
 #include "base/polygon.h"
 #include "base/rgba.h"
+#include "entity/entity_id.h"
+#include "platform/platform.h"
 
 #define LIGHT_DEFAULT_FADE_OUT_TIME 0.15f
 
+// Light origins closer than this are considered the same when looking up cached polygons
+#define VISIBILITY_CACHE_ORIGIN_QUANTUM 1.0f
+
+// Polygons missing from the cache are generated by at most this many jobs, each with its own
+// scratch arena
+#define VISIBILITY_JOB_COUNT         8
+#define VISIBILITY_JOB_SCRATCH_SIZE  KB(256)
+
+#define LIGHT_DEFAULT_BUDGET                   64
+#define LIGHT_DEFAULT_MIN_RAYCAST_SCREEN_RADIUS 48.0f
+
 /*
   TODO:
   - Maybe return edge list as copy and then sort by closest to light source
@@ -24,19 +39,101 @@ typedef enum {
     LIGHT_RAYCASTED,
 } LightKind;
 
+// How the visibility polygon of a LIGHT_RAYCASTED light is generated
+typedef enum {
+    LIGHT_VISIBILITY_EDGE_RAYCAST, // Rays towards the corners of every wall edge in the tilemap
+    LIGHT_VISIBILITY_SHADOWCAST,   // Rays towards edges found by shadowcasting within the radius
+} LightVisibilityBackend;
+
 typedef struct {
     LightKind kind;
+    LightVisibilityBackend visibility_backend;
     f32 radius;
     RGBA32 color;
 
     b32 fading_out;
     f32 fade_duration; // If set to 0, will default to LIGHT_DEFAULT_FADE_OUT_TIME
     f32 time_elapsed;
+
+    b32 is_static; // Never moves or changes, so it can be baked into the chunk lightmaps
 } LightSource;
 
+typedef struct {
+    b32         is_valid;
+    EntityID    light_entity; // Slots are reused, so the generation has to match as well
+    Vector2i    quantized_origin;
+    f32         radius;
+    u64         tilemap_version;
+    LightVisibilityBackend visibility_backend;
+
+    TriangleFan fan;
+    ssize       capacity;
+
+    b32         generated_this_frame; // Already counted as a miss, so the next lookup isn't a hit
+} VisibilityCacheEntry;
+
+typedef struct {
+    VisibilityCacheEntry entries[MAX_ENTITIES]; // Indexed by index of the light emitting entity
+    Allocator            allocator;
+
+    // Allocated from the default allocator since they may grow while on a worker thread
+    LinearArena          job_scratch[VISIBILITY_JOB_COUNT];
+
+    // Reset every frame
+    ssize                hits;
+    ssize                misses;
+} VisibilityPolygonCache;
+
+typedef struct {
+    EntityID     light_entity;
+    Vector2      origin;
+    LightSource  light;
+} VisibilityRequest;
+
+typedef struct {
+    ssize max_lights_per_frame;        // Lights covering the least of the screen are dropped first
+    f32   min_raycasted_screen_radius; // Smaller raycasted lights are drawn as LIGHT_REGULAR circles
+    b32   force_shadowcast;            // Raycasted lights use LIGHT_VISIBILITY_SHADOWCAST regardless
+} LightRenderSettings;
+
+typedef struct {
+    EntityID     entity;
+    Vector2      origin;
+    LightSource  light;
+    f32          screen_coverage; // Pixels on screen covered by the bounding square of the light
+
+    // Static lights are only drawn inside the chunks whose lightmaps aren't baked yet
+    const Rectangle *clip_areas;
+    ssize            clip_area_count;
+} LightCandidate;
+
+// Reset every frame
+typedef struct {
+    ssize candidates;
+    ssize culled;
+    ssize over_budget;
+    ssize downgraded;
+    ssize drawn;
+} LightRenderStats;
+
 TriangleFan   get_visibility_polygon(Vector2 origin, struct Tilemap *tilemap, struct LinearArena *arena);
-void          render_light_source(struct World *world, struct RenderBatch *rb, Vector2 origin,
-				  LightSource light, f32 intensity, struct LinearArena *arena);
+TriangleFan   get_shadowcast_visibility_polygon(Vector2 origin, f32 radius, struct Tilemap *tilemap,
+				  struct LinearArena *arena);
+void          render_light_source(struct World *world, struct RenderBatch *rb, EntityID light_entity,
+				  Vector2 origin, LightSource light, f32 intensity, const Rectangle *clip_areas,
+				  ssize clip_area_count, struct LinearArena *arena);
+
+void          visibility_cache_initialize(VisibilityPolygonCache *cache, Allocator allocator);
+void          visibility_cache_destroy(VisibilityPolygonCache *cache);
+TriangleFan   visibility_cache_get_polygon(VisibilityPolygonCache *cache, EntityID light_entity,
+				  Vector2 origin, const LightSource *light, struct Tilemap *tilemap,
+				  struct LinearArena *scratch);
+void          visibility_cache_generate_polygons(VisibilityPolygonCache *cache,
+				  const VisibilityRequest *requests, ssize request_count, struct Tilemap *tilemap,
+				  PlatformCode platform_code, struct LinearArena *scratch);
+ssize         select_lights_to_render(LightCandidate *lights, ssize count, Rectangle visible_area,
+				  f32 world_to_screen_scale, LightRenderSettings settings, LightRenderStats *stats,
+				  struct LinearArena *scratch);
 
 static inline Vector2 get_light_origin_position(Rectangle entity_bounds)
 {
@@ -100,7 +100,7 @@ Spell g_spells[SPELL_COUNT];
 static Entity *try_get_chain_target(World *world, Entity *self, ChainComponent *self_chain,
     Vector2 position, Rectangle search_area, Entity *chained_off_entity, LinearArena *frame_arena)
 {
-    EntityIDList nearby_entities = qt_get_entities_in_area(&world->quad_tree,
+    EntityIDList nearby_entities = world_get_entities_in_area(world,
         search_area, frame_arena);
 
     // TODO: break out getting closest entity into function
@@ -123,7 +123,9 @@ static Entity *try_get_chain_target(World *world, Entity *self, ChainComponent *
 	    if (!has_chained_off_entity(&world->entity_system, self_chain, curr_entity->id)) {
 		f32 dist = v2_dist(curr_entity_physics->position, position);
 
-		if (dist < closest_entity_dist) {
+		if ((dist < closest_entity_dist)
+		    && los_cache_has_line_of_sight(&world->line_of_sight_cache, position, curr->id,
+			curr_entity, &world->tilemap)) {
 		    closest_entity = curr_entity;
 		    closest_entity_dist = dist;
 		}
@@ -227,7 +229,8 @@ static void create_spell_entity(World *world, const Spell *spell, Entity *caster
     Entity *spell_entity = spell_entity_with_id.entity;
 
     ColliderComponent *spell_collider = es_get_or_add_component(spell_entity, ColliderComponent);
-    spell_collider->collision_group = COLLISION_GROUP_PROJECTILES;
+    set_collision_group(spell_collider, COLLISION_GROUP_PROJECTILES);
+    set_collision_group_ignored(spell_collider, COLLISION_GROUP_PROJECTILES, true);
 
     PhysicsComponent *physics = es_get_or_add_component(spell_entity, PhysicsComponent);
 
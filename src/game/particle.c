@@ -1,3 +1,10 @@
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE__)
+#  include <xmmintrin.h>
+#endif
+
 #include "particle.h"
 #include "components/component.h"
 #include "entity/entity_system.h"
@@ -7,37 +14,356 @@
 #include "renderer/frontend/render_batch.h"
 #include "asset_table.h"
 
-static void update_particle_buffer(ParticleBuffer *buffer, f32 dt)
+void particle_pool_initialize(ParticlePool *pool, Allocator allocator, ssize max_particles)
+{
+    ASSERT(max_particles > 0);
+
+    *pool = zero_struct(ParticlePool);
+    pool->allocator = allocator;
+    pool->max_particles = max_particles;
+}
+
+void particle_pool_begin_tick(ParticlePool *pool, f32 dt)
+{
+    ++pool->tick;
+    pool->tick_dt = dt;
+}
+
+void particle_buffer_destroy(ParticlePool *pool, ParticleBuffer *buffer)
+{
+    // The position x array is at the start of the allocation
+    if (buffer->position_x) {
+        deallocate(pool->allocator, buffer->position_x);
+    }
+
+    pool->live_particles -= buffer->count;
+    ASSERT(pool->live_particles >= 0);
+
+    *buffer = zero_struct(ParticleBuffer);
+}
+
+void particle_buffers_destroy(ParticlePool *pool, ParticleBuffers *buffers)
+{
+    particle_buffer_destroy(pool, &buffers->normal_particles);
+    particle_buffer_destroy(pool, &buffers->light_emitting_particles);
+}
+
+static void grow_particle_buffer(ParticlePool *pool, ParticleBuffer *buffer)
+{
+    ssize new_capacity = MAX(PARTICLE_BUFFER_MIN_CAPACITY, buffer->capacity * 2);
+    ssize bytes_per_particle = 7 * SIZEOF(f32) + SIZEOF(RGBA32);
+
+    byte *memory = allocate_aligned(pool->allocator, new_capacity, bytes_per_particle, ALIGNOF(RGBA32));
+    ASSERT(memory);
+
+    ParticleBuffer grown = {0};
+    grown.position_x = (f32 *)memory;
+    grown.position_y = grown.position_x + new_capacity;
+    grown.velocity_x = grown.position_y + new_capacity;
+    grown.velocity_y = grown.velocity_x + new_capacity;
+    grown.timer = grown.velocity_y + new_capacity;
+    grown.lifetime = grown.timer + new_capacity;
+    grown.size = grown.lifetime + new_capacity;
+    grown.color = (RGBA32 *)(grown.size + new_capacity);
+    grown.count = buffer->count;
+    grown.capacity = new_capacity;
+
+    if (buffer->count > 0) {
+        usize float_bytes = (usize)buffer->count * sizeof(f32);
+
+        memcpy(grown.position_x, buffer->position_x, float_bytes);
+        memcpy(grown.position_y, buffer->position_y, float_bytes);
+        memcpy(grown.velocity_x, buffer->velocity_x, float_bytes);
+        memcpy(grown.velocity_y, buffer->velocity_y, float_bytes);
+        memcpy(grown.timer, buffer->timer, float_bytes);
+        memcpy(grown.lifetime, buffer->lifetime, float_bytes);
+        memcpy(grown.size, buffer->size, float_bytes);
+        memcpy(grown.color, buffer->color, (usize)buffer->count * sizeof(RGBA32));
+    }
+
+    if (buffer->position_x) {
+        deallocate(pool->allocator, buffer->position_x);
+    }
+
+    *buffer = grown;
+}
+
+static void set_particle(ParticleBuffer *buffer, ssize index, Particle particle)
+{
+    buffer->position_x[index] = particle.position.x;
+    buffer->position_y[index] = particle.position.y;
+    buffer->velocity_x[index] = particle.velocity.x;
+    buffer->velocity_y[index] = particle.velocity.y;
+    buffer->timer[index] = particle.timer;
+    buffer->lifetime[index] = particle.lifetime;
+    buffer->size[index] = particle.size;
+    buffer->color[index] = particle.color;
+}
+
+static void move_particle(ParticleBuffer *buffer, ssize to, ssize from)
+{
+    buffer->position_x[to] = buffer->position_x[from];
+    buffer->position_y[to] = buffer->position_y[from];
+    buffer->velocity_x[to] = buffer->velocity_x[from];
+    buffer->velocity_y[to] = buffer->velocity_y[from];
+    buffer->timer[to] = buffer->timer[from];
+    buffer->lifetime[to] = buffer->lifetime[from];
+    buffer->size[to] = buffer->size[from];
+    buffer->color[to] = buffer->color[from];
+}
+
+// Returns false if the pool is full, in which case the particle is dropped
+b32 particle_buffer_push(ParticlePool *pool, ParticleBuffer *buffer, Particle particle)
+{
+    if (pool->live_particles >= pool->max_particles) {
+        ++pool->dropped_particles;
+        return false;
+    }
+
+    if (buffer->count == buffer->capacity) {
+        grow_particle_buffer(pool, buffer);
+    }
+
+    set_particle(buffer, buffer->count++, particle);
+    ++pool->live_particles;
+
+    return true;
+}
+
+Particle particle_buffer_get(const ParticleBuffer *buffer, ssize index)
 {
-    for (ssize i = 0; i < ring_length(buffer); ++i) {
-        Particle *p = ring_at(buffer, i);
+    ASSERT(index >= 0);
+    ASSERT(index < buffer->count);
+
+    Particle result = {
+        .position = {buffer->position_x[index], buffer->position_y[index]},
+        .velocity = {buffer->velocity_x[index], buffer->velocity_y[index]},
+        .timer = buffer->timer[index],
+        .lifetime = buffer->lifetime[index],
+        .color = buffer->color[index],
+        .size = buffer->size[index],
+    };
+
+    return result;
+}
+
+static void integrate_particles(ParticleBuffer *buffer, f32 dt)
+{
+    ssize i = 0;
+
+#if defined(__SSE__)
+    __m128 dt_4 = _mm_set1_ps(dt);
+    __m128 gravity_4 = _mm_set1_ps(PARTICLE_GRAVITY);
+    __m128 drag_4 = _mm_set1_ps(-PARTICLE_DRAG);
 
-        if (p->timer > p->lifetime) {
-            ring_swap_remove(buffer, i);
+    ssize simd_count = buffer->count - (buffer->count % 4);
+
+    for (; i < simd_count; i += 4) {
+        __m128 timer = _mm_loadu_ps(buffer->timer + i);
+        __m128 px = _mm_loadu_ps(buffer->position_x + i);
+        __m128 py = _mm_loadu_ps(buffer->position_y + i);
+        __m128 vx = _mm_loadu_ps(buffer->velocity_x + i);
+        __m128 vy = _mm_loadu_ps(buffer->velocity_y + i);
+
+        timer = _mm_add_ps(timer, dt_4);
+        px = _mm_add_ps(px, _mm_mul_ps(vx, dt_4));
+        py = _mm_add_ps(py, _mm_mul_ps(vy, dt_4));
+        vy = _mm_add_ps(vy, gravity_4);
+        vx = _mm_add_ps(vx, _mm_mul_ps(vx, drag_4));
+        vy = _mm_add_ps(vy, _mm_mul_ps(vy, drag_4));
+
+        _mm_storeu_ps(buffer->timer + i, timer);
+        _mm_storeu_ps(buffer->position_x + i, px);
+        _mm_storeu_ps(buffer->position_y + i, py);
+        _mm_storeu_ps(buffer->velocity_x + i, vx);
+        _mm_storeu_ps(buffer->velocity_y + i, vy);
+    }
+#endif
+
+    // Same operations in the same order as above, so the remainder gives identical results.
+    // Without SSE every particle goes through here.
+    for (; i < buffer->count; ++i) {
+        buffer->timer[i] += dt;
+        buffer->position_x[i] += buffer->velocity_x[i] * dt;
+        buffer->position_y[i] += buffer->velocity_y[i] * dt;
+        buffer->velocity_y[i] += PARTICLE_GRAVITY;
+        buffer->velocity_x[i] += buffer->velocity_x[i] * -PARTICLE_DRAG;
+        buffer->velocity_y[i] += buffer->velocity_y[i] * -PARTICLE_DRAG;
+    }
+}
+
+// Removes particles that have expired, or will have after the given amount of time, while
+// keeping the order of the remaining ones
+static void compact_particles(ParticlePool *pool, ParticleBuffer *buffer, f32 time_ahead)
+{
+    ssize alive_count = 0;
+
+    for (ssize i = 0; i < buffer->count; ++i) {
+        if ((buffer->timer[i] + time_ahead) > buffer->lifetime[i]) {
+            continue;
         }
 
-        p->timer += dt;
-        p->position = v2_add(p->position, v2_mul_s(p->velocity, dt));
-        p->velocity = v2_add(p->velocity, v2(0, -1.0f));
-        p->velocity = v2_add(p->velocity, v2_mul_s(p->velocity, -0.009f));
+        if (alive_count != i) {
+            move_particle(buffer, alive_count, i);
+        }
+
+        ++alive_count;
     }
+
+    pool->live_particles -= buffer->count - alive_count;
+    buffer->count = alive_count;
+}
+
+void update_particle_buffer(ParticlePool *pool, ParticleBuffer *buffer, f32 dt)
+{
+    integrate_particles(buffer, dt);
+    compact_particles(pool, buffer, 0.0f);
 }
 
-void update_particle_buffers(ParticleBuffers *buffers, f32 dt)
+void update_particle_buffers(ParticlePool *pool, ParticleBuffers *buffers, f32 dt)
+{
+    update_particle_buffer(pool, &buffers->normal_particles, dt);
+    update_particle_buffer(pool, &buffers->light_emitting_particles, dt);
+}
+
+/*
+  Advances the particles by several fixed steps at once. Each step does
+
+    position += velocity * dt
+    velocity.y += gravity
+    velocity *= k, where k = 1 - drag
+
+  so after n steps the x velocity is v0 * k^n, and the y velocity approaches the terminal
+  velocity v_t = gravity * k / (1 - k) as v_t + (v0 - v_t) * k^n. The positions are the
+  sums of the velocities over the steps, which are geometric series. The results match
+  stepping one tick at a time up to floating point rounding.
+ */
+void fast_forward_particle_buffer(ParticlePool *pool, ParticleBuffer *buffer, s64 steps, f32 dt)
 {
-    update_particle_buffer(&buffers->normal_particles, dt);
-    update_particle_buffer(&buffers->light_emitting_particles, dt);
+    ASSERT(steps > 0);
+    ASSERT(PARTICLE_DRAG > 0.0f);
+
+    f32 elapsed = (f32)steps * dt;
+
+    // The timers only grow, so everything that expires along the way can be removed up front
+    compact_particles(pool, buffer, elapsed);
+
+    if (buffer->count == 0) {
+        return;
+    }
+
+    f32 k = 1.0f - PARTICLE_DRAG;
+    f32 k_pow_n = powf(k, (f32)steps);
+    f32 velocity_sum_factor = (1.0f - k_pow_n) / (1.0f - k);
+    f32 terminal_velocity_y = PARTICLE_GRAVITY * k / (1.0f - k);
+
+    for (ssize i = 0; i < buffer->count; ++i) {
+        f32 vx = buffer->velocity_x[i];
+        f32 vy_offset = buffer->velocity_y[i] - terminal_velocity_y;
+
+        buffer->timer[i] += elapsed;
+
+        buffer->position_x[i] += dt * vx * velocity_sum_factor;
+        buffer->position_y[i] += dt * ((f32)steps * terminal_velocity_y + vy_offset * velocity_sum_factor);
+
+        buffer->velocity_x[i] = vx * k_pow_n;
+        buffer->velocity_y[i] = terminal_velocity_y + vy_offset * k_pow_n;
+    }
 }
 
-void render_particle_buffers(ParticleBuffers *buffers, RenderBatches rbs, struct LinearArena *arena)
+// Particles of chunks outside the update area aren't touched until they are needed again,
+// at which point all the missed ticks are done at once
+void catch_up_chunk_particles(ParticlePool *pool, Chunk *chunk, u64 target_tick)
 {
-    if (ring_length(&buffers->normal_particles) > 0) {
-        draw_particles(rbs.world_rb, arena, &buffers->normal_particles,
+    ASSERT(chunk->particles_tick <= target_tick);
+
+    s64 steps = (s64)(target_tick - chunk->particles_tick);
+    ParticleBuffers *buffers = &chunk->particle_buffers;
+
+    if (steps == 1) {
+        update_particle_buffers(pool, buffers, pool->tick_dt);
+    } else if (steps > 1) {
+        fast_forward_particle_buffer(pool, &buffers->normal_particles, steps, pool->tick_dt);
+        fast_forward_particle_buffer(pool, &buffers->light_emitting_particles, steps, pool->tick_dt);
+
+        ++pool->fast_forwarded_chunks;
+    }
+
+    chunk->particles_tick = target_tick;
+}
+
+static ParticleBuffer *get_matching_buffer(ParticleBuffers *buffers, ParticleBuffers *other,
+    ParticleBuffer *other_buffer)
+{
+    ParticleBuffer *result = (other_buffer == &other->normal_particles)
+        ? &buffers->normal_particles
+        : &buffers->light_emitting_particles;
+
+    return result;
+}
+
+static void rebin_particle_buffer(ParticlePool *pool, Chunks *chunks, Chunk *chunk,
+    ParticleBuffer *buffer)
+{
+    ssize kept_count = 0;
+
+    for (ssize i = 0; i < buffer->count; ++i) {
+        Vector2 position = {buffer->position_x[i], buffer->position_y[i]};
+        Chunk *owner = get_chunk_at_position(chunks, position);
+
+        if (owner == chunk) {
+            if (kept_count != i) {
+                move_particle(buffer, kept_count, i);
+            }
+
+            ++kept_count;
+            continue;
+        }
+
+        // Removed from this buffer before pushing, so moving never hits the pool limit
+        Particle particle = particle_buffer_get(buffer, i);
+        --pool->live_particles;
+
+        if (owner) {
+            // Keeps the owner from advancing the particle again later
+            if (owner->particles_tick < chunk->particles_tick) {
+                catch_up_chunk_particles(pool, owner, chunk->particles_tick);
+            }
+
+            ParticleBuffer *destination = get_matching_buffer(&owner->particle_buffers,
+                &chunk->particle_buffers, buffer);
+            particle_buffer_push(pool, destination, particle);
+
+            ++pool->rebinned_particles;
+        } else {
+            // Left the map
+            ++pool->dropped_particles;
+        }
+    }
+
+    buffer->count = kept_count;
+}
+
+// Moves particles that have drifted out of the chunk into the chunk they are now in,
+// so that chunk culling stays correct
+void rebin_chunk_particles(ParticlePool *pool, Chunks *chunks, Chunk *chunk)
+{
+    rebin_particle_buffer(pool, chunks, chunk, &chunk->particle_buffers.normal_particles);
+    rebin_particle_buffer(pool, chunks, chunk, &chunk->particle_buffers.light_emitting_particles);
+}
+
+void render_particles(ParticleBuffers *buffers, RenderBatches rbs)
+{
+    if (buffers->normal_particles.count > 0) {
+        draw_particles(rbs.world_rb, &buffers->normal_particles,
             shader_handle(SHAPE_SHADER), RENDER_LAYER_PARTICLES);
     }
+}
 
-    if (ring_length(&buffers->light_emitting_particles) > 0) {
-        draw_particles(rbs.lighting_rb, arena, &buffers->light_emitting_particles,
+void render_light_emitting_particles(ParticleBuffers *buffers, RenderBatches rbs)
+{
+    if (buffers->light_emitting_particles.count > 0) {
+        draw_particles(rbs.lighting_rb, &buffers->light_emitting_particles,
             shader_handle(SHAPE_SHADER), RENDER_LAYER_PARTICLES);
     }
 }
@@ -1,7 +1,7 @@
 #ifndef PARTICLE_H
 #define PARTICLE_H
 
-#include "base/ring_buffer.h"
+#include "base/allocator.h"
 #include "base/typedefs.h"
 #include "base/vector.h"
 #include "base/rgba.h"
@@ -9,13 +9,22 @@
 #include "light.h"
 #include "renderer/frontend/render_target.h"
 
+// Buffers start at this capacity and double whenever they fill up
+#define PARTICLE_BUFFER_MIN_CAPACITY         64
+#define PARTICLE_POOL_DEFAULT_MAX_PARTICLES  (1 << 17)
+
+#define PARTICLE_GRAVITY          -1.0f
+#define PARTICLE_DRAG             0.009f
+
 struct Entity;
 struct LinearArena;
 struct RenderBatch;
 struct World;
 struct PhysicsComponent;
+struct Chunk;
+struct Chunks;
 
-// TODO: reduce the size of this
+// A single particle, only used when spawning. Buffers store each field in its own array.
 typedef struct Particle {
     Vector2 position;
     Vector2 velocity;
@@ -25,14 +34,58 @@ typedef struct Particle {
     f32 size;
 } Particle;
 
-DEFINE_STATIC_RING_BUFFER(Particle, ParticleBuffer, 1024);
+// Live particles are always packed at the start of the arrays, so updates run over
+// contiguous spans several particles at a time. All arrays live in one allocation from
+// the particle pool.
+typedef struct ParticleBuffer {
+    f32    *position_x;
+    f32    *position_y;
+    f32    *velocity_x;
+    f32    *velocity_y;
+    f32    *timer;
+    f32    *lifetime;
+    f32    *size;
+    RGBA32 *color;
+
+    ssize   count;
+    ssize   capacity;
+} ParticleBuffer;
 
 typedef struct {
     ParticleBuffer normal_particles;
     ParticleBuffer light_emitting_particles;
 } ParticleBuffers;
 
-void update_particle_buffers(ParticleBuffers *buffer, f32 dt);
-void render_particle_buffers(ParticleBuffers *buffer, RenderBatches rbs, struct LinearArena *arena);
+// Shared by the particle buffers of every chunk. Buffers grow on demand, and particles are
+// only dropped once the total across all buffers reaches max_particles.
+typedef struct {
+    Allocator allocator;
+    ssize     max_particles;
+    ssize     live_particles;
+
+    // Chunks outside the update area are left behind and fast-forwarded to this tick once
+    // they are needed again
+    u64       tick;
+    f32       tick_dt;
+
+    // Totals since the pool was created
+    ssize     dropped_particles;
+    ssize     rebinned_particles;
+    ssize     fast_forwarded_chunks;
+} ParticlePool;
+
+void     particle_pool_initialize(ParticlePool *pool, Allocator allocator, ssize max_particles);
+void     particle_pool_begin_tick(ParticlePool *pool, f32 dt);
+void     particle_buffers_destroy(ParticlePool *pool, ParticleBuffers *buffers);
+void     particle_buffer_destroy(ParticlePool *pool, ParticleBuffer *buffer);
+b32      particle_buffer_push(ParticlePool *pool, ParticleBuffer *buffer, Particle particle);
+Particle particle_buffer_get(const ParticleBuffer *buffer, ssize index);
+void     update_particle_buffer(ParticlePool *pool, ParticleBuffer *buffer, f32 dt);
+void     update_particle_buffers(ParticlePool *pool, ParticleBuffers *buffers, f32 dt);
+void     fast_forward_particle_buffer(ParticlePool *pool, ParticleBuffer *buffer, s64 steps, f32 dt);
+void     catch_up_chunk_particles(ParticlePool *pool, struct Chunk *chunk, u64 target_tick);
+void     rebin_chunk_particles(ParticlePool *pool, struct Chunks *chunks, struct Chunk *chunk);
+void     render_particles(ParticleBuffers *buffers, RenderBatches rbs);
+void     render_light_emitting_particles(ParticleBuffers *buffers, RenderBatches rbs);
 
 #endif //PARTICLE_H
@@ -338,8 +338,6 @@ static void render_widget(UIState *ui, Widget *widget, RenderBatch *rb, ssize de
     Rectangle widget_rect = widget_get_clipped_bounding_box(widget, parent_bounds, clipping);
 
     if (!widget_has_flag(widget, WIDGET_HIDDEN)) {
-        LinearArena *arena = get_frame_arena(ui);
-
         if (widget_has_flag(widget, WIDGET_COLORED)) {
             RGBA32 color = widget->color;
 
@@ -351,7 +349,7 @@ static void render_widget(UIState *ui, Widget *widget, RenderBatch *rb, ssize de
                 color = RGBA32_RED;
             }
 
-            draw_rectangle(rb, &ui->current_frame_widgets.arena, widget_rect, color,
+            draw_rectangle(rb, widget_rect, color,
 		shader_handle(SHAPE_SHADER), (RenderLayer)depth);
         }
 
@@ -366,7 +364,7 @@ static void render_widget(UIState *ui, Widget *widget, RenderBatch *rb, ssize de
 	    // NOTE: Characters after ## are hashed but not rendered
 	    String visible_substring = get_visible_widget_text(widget->text.string);
 
-            draw_clipped_text(rb, arena, visible_substring, text_position,
+            draw_clipped_text(rb, visible_substring, text_position,
 		parent_bounds, widget->color, widget->text.size,
                 shader_handle(TEXTURE_SHADER), widget->text.font, (RenderLayer)depth);
         }
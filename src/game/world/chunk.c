@@ -1,14 +1,12 @@
 #include "chunk.h"
 #include "base/linear_arena.h"
-#include "base/ring_buffer.h"
 #include "base/utils.h"
 #include "world/tilemap.h"
 #include "world/world.h"
 
 static void initialize_chunk(Chunk *chunk)
 {
-    ring_initialize_static(&chunk->particle_buffers.normal_particles);
-    ring_initialize_static(&chunk->particle_buffers.light_emitting_particles);
+    chunk->particle_buffers = zero_struct(ParticleBuffers);
 }
 
 Chunks create_chunks_for_tilemap(Tilemap *tilemap, LinearArena *arena)
@@ -94,3 +92,146 @@ ChunkPtrArray get_chunks_in_area(Chunks *chunks, Rectangle area, LinearArena *ar
 
     return result;
 }
+
+Vector2i get_chunk_base_tile_coords(Chunks *chunks, Chunk *chunk)
+{
+    ssize index = chunk - chunks->chunks;
+    ASSERT(index >= 0);
+    ASSERT(index < chunks->chunk_count);
+
+    s32 chunk_x = (s32)(index % chunks->chunk_grid_dims.x);
+    s32 chunk_y = (s32)(index / chunks->chunk_grid_dims.x);
+
+    Vector2i result = v2i_add(chunks->chunk_grid_base_tile_coords,
+        v2i(chunk_x * CHUNK_SIZE_IN_TILES, chunk_y * CHUNK_SIZE_IN_TILES));
+
+    return result;
+}
+
+b32 chunk_tile_geometry_is_stale(Chunk *chunk, Tilemap *tilemap)
+{
+    ChunkTileGeometry *geometry = &chunk->tile_geometry;
+    b32 result = !geometry->is_built || (geometry->tilemap_version != tilemap->version);
+
+    return result;
+}
+
+static void push_static_quad(StaticQuads *quads, RectangleVertices vertices)
+{
+    Vertex *quad = quads->vertices + quads->quad_count * 4;
+    quad[0] = vertices.top_left;
+    quad[1] = vertices.top_right;
+    quad[2] = vertices.bottom_right;
+    quad[3] = vertices.bottom_left;
+
+    ++quads->quad_count;
+}
+
+void build_chunk_tile_geometry(Chunks *chunks, Chunk *chunk, Tilemap *tilemap, Allocator allocator)
+{
+    destroy_chunk_tile_geometry(chunk, allocator);
+
+    Vector2i base_tile = get_chunk_base_tile_coords(chunks, chunk);
+    ssize floor_count = 0;
+    ssize wall_count = 0;
+
+    for (s32 y = 0; y < CHUNK_SIZE_IN_TILES; ++y) {
+        for (s32 x = 0; x < CHUNK_SIZE_IN_TILES; ++x) {
+            Tile *tile = tilemap_get_tile(tilemap, v2i_add(base_tile, v2i(x, y)));
+
+            if (tile && (tile->type == TILE_FLOOR)) {
+                ++floor_count;
+            } else if (tile && (tile->type == TILE_WALL)) {
+                ++wall_count;
+            }
+        }
+    }
+
+    ChunkTileGeometry *geometry = &chunk->tile_geometry;
+    ssize quad_count = floor_count + wall_count * 2;
+
+    if (quad_count > 0) {
+        Vertex *vertices = allocate_array(allocator, Vertex, quad_count * 4);
+
+        geometry->floors.vertices = vertices;
+        geometry->wall_bases.vertices = geometry->floors.vertices + floor_count * 4;
+        geometry->wall_tops.vertices = geometry->wall_bases.vertices + wall_count * 4;
+    }
+
+    if (wall_count > 0) {
+        geometry->wall_top_infos = allocate_array(allocator, WallTopInfo, wall_count);
+    }
+
+    for (s32 y = 0; y < CHUNK_SIZE_IN_TILES; ++y) {
+        for (s32 x = 0; x < CHUNK_SIZE_IN_TILES; ++x) {
+            Vector2i tile_coords = v2i_add(base_tile, v2i(x, y));
+            Tile *tile = tilemap_get_tile(tilemap, tile_coords);
+
+            if (!tile) {
+                continue;
+            }
+
+            Rectangle tile_rect = {
+                .position = tile_to_world_coords(tile_coords),
+                .size = { (f32)TILE_SIZE, (f32)TILE_SIZE }
+            };
+
+            if (tile->type == TILE_FLOOR) {
+                push_static_quad(&geometry->floors, rect_get_vertices(tile_rect, RGBA32_WHITE, Y_IS_UP));
+            } else if (tile->type == TILE_WALL) {
+                // Walls are two tiles tall, the top half covers the tile above
+                tile_rect.size.y += TILE_SIZE;
+
+                Rectangle bottom_segment = {
+                    tile_rect.position,
+                    {tile_rect.size.x, tile_rect.size.y / 2}
+                };
+
+                Rectangle top_segment = {
+                    v2_add(bottom_segment.position, v2(0, bottom_segment.size.y)),
+                    bottom_segment.size
+                };
+
+                ClippedRectangleVertices bottom = rect_get_clipped_vertices(tile_rect, bottom_segment,
+                    RGBA32_WHITE, Y_IS_UP);
+                ClippedRectangleVertices top = rect_get_clipped_vertices(tile_rect, top_segment,
+                    RGBA32_WHITE, Y_IS_UP);
+                ASSERT(bottom.is_visible && top.is_visible);
+
+                Tile *tile_above = tilemap_get_tile(tilemap, v2i(tile_coords.x, tile_coords.y + 1));
+
+                WallTopInfo *info = &geometry->wall_top_infos[geometry->wall_tops.quad_count];
+                info->top_segment = top_segment;
+                info->base_y = tile_rect.position.y;
+                info->can_walk_behind = tile_above && (tile_above->type == TILE_FLOOR);
+
+                push_static_quad(&geometry->wall_bases, bottom.vertices);
+                push_static_quad(&geometry->wall_tops, top.vertices);
+            } else {
+                ASSERT(0);
+            }
+        }
+    }
+
+    ASSERT(geometry->floors.quad_count == floor_count);
+    ASSERT(geometry->wall_tops.quad_count == wall_count);
+
+    geometry->tilemap_version = tilemap->version;
+    geometry->is_built = true;
+}
+
+void destroy_chunk_tile_geometry(Chunk *chunk, Allocator allocator)
+{
+    ChunkTileGeometry *geometry = &chunk->tile_geometry;
+
+    // All quads share the allocation of the floors
+    if (geometry->floors.vertices) {
+        deallocate(allocator, geometry->floors.vertices);
+    }
+
+    if (geometry->wall_top_infos) {
+        deallocate(allocator, geometry->wall_top_infos);
+    }
+
+    *geometry = zero_struct(ChunkTileGeometry);
+}
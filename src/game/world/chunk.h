@@ -1,8 +1,10 @@
 #ifndef CHUNK_H
 #define CHUNK_H
 
+#include "base/allocator.h"
 #include "base/rectangle.h"
 #include "base/ring_buffer.h"
+#include "base/vertex.h"
 #include "particle.h"
 
 #define CHUNK_SIZE_IN_TILES 8
@@ -10,8 +12,33 @@
 struct LinearArena;
 struct Tilemap;
 
+typedef struct {
+    Vertex *vertices; // Four per quad
+    ssize   quad_count;
+} StaticQuads;
+
+typedef struct {
+    Rectangle top_segment;
+    f32       base_y;          // Entities above this are behind the wall
+    b32       can_walk_behind; // Only if there is floor above the wall
+} WallTopInfo;
+
+// Quads of the floors and walls in a chunk, for a Y_IS_UP batch. Built once and reused until
+// the tilemap changes. Anything that changes from frame to frame, like walls turning
+// transparent, is drawn as an overlay on top of these.
+typedef struct {
+    StaticQuads  floors;
+    StaticQuads  wall_bases;
+    StaticQuads  wall_tops;
+    WallTopInfo *wall_top_infos; // One per wall top quad
+    u64          tilemap_version;
+    b32          is_built;
+} ChunkTileGeometry;
+
 typedef struct Chunk {
-    ParticleBuffers particle_buffers;
+    ParticleBuffers   particle_buffers;
+    u64               particles_tick; // Simulation tick that the particles have been advanced to
+    ChunkTileGeometry tile_geometry;
 } Chunk;
 
 typedef struct Chunks {
@@ -29,5 +56,10 @@ typedef struct ChunkPtrArray {
 Chunks           create_chunks_for_tilemap(struct Tilemap *tilemap, struct LinearArena *arena);
 Chunk           *get_chunk_at_position(Chunks *chunks, Vector2 position);
 ChunkPtrArray    get_chunks_in_area(Chunks *chunks, Rectangle area, struct LinearArena *arena);
+Vector2i         get_chunk_base_tile_coords(Chunks *chunks, Chunk *chunk);
+b32              chunk_tile_geometry_is_stale(Chunk *chunk, struct Tilemap *tilemap);
+void             build_chunk_tile_geometry(Chunks *chunks, Chunk *chunk, struct Tilemap *tilemap,
+                                           Allocator allocator);
+void             destroy_chunk_tile_geometry(Chunk *chunk, Allocator allocator);
 
 #endif //CHUNK_H
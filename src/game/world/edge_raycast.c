@@ -0,0 +1,167 @@
+#include "edge_raycast.h"
+#include "base/utils.h"
+
+#if EDGE_RAYCAST_AVX2
+#  include <immintrin.h>
+#endif
+
+// For vertical wall edges, we want them to be lit if we're visually in front of them
+static b32 edge_is_raycast_from_origin(EdgeLine edge, Vector2 origin)
+{
+    b32 result = true;
+
+    if (edge.direction == CARDINAL_DIR_WEST) {
+        // Raycast against west wall if either above it, or in front of it and to the right
+        result = (origin.y >= edge.line.end.y) || (origin.x >= edge.line.end.x);
+    } else if (edge.direction == CARDINAL_DIR_EAST) {
+        // Raycast against east wall if either above it, or in front of it and to the left
+        result = (origin.y >= edge.line.end.y) || (origin.x <= edge.line.end.x);
+    }
+
+    return result;
+}
+
+// Only the edges that rays from origin should be tested against are stored
+EdgeSoA edge_soa_create_for_origin(EdgePool edges, Vector2 origin, LinearArena *arena)
+{
+    ssize padded_capacity = align(MAX(edges.count, 1), EDGE_RAYCAST_LANE_COUNT);
+
+    EdgeSoA result = {0};
+    result.start_x = la_allocate_array(arena, f32, padded_capacity);
+    result.start_y = la_allocate_array(arena, f32, padded_capacity);
+    result.dir_x = la_allocate_array(arena, f32, padded_capacity);
+    result.dir_y = la_allocate_array(arena, f32, padded_capacity);
+
+    for (ssize i = 0; i < edges.count; ++i) {
+        EdgeLine edge = edges.items[i];
+
+        if (edge_is_raycast_from_origin(edge, origin)) {
+            result.start_x[result.count] = edge.line.start.x;
+            result.start_y[result.count] = edge.line.start.y;
+            result.dir_x[result.count] = edge.line.end.x - edge.line.start.x;
+            result.dir_y[result.count] = edge.line.end.y - edge.line.start.y;
+
+            ++result.count;
+        }
+    }
+
+    // The arena is zeroed, so the padding edges already have zero length and are never hit
+    result.padded_count = align(result.count, EDGE_RAYCAST_LANE_COUNT);
+
+    return result;
+}
+
+// Returns the distance along dir to the closest edge in front of origin, in multiples of
+// the length of dir, or INFINITY if no edge is hit
+f32 edge_raycast_closest_hit_scalar(const EdgeSoA *edges, Vector2 origin, Vector2 dir)
+{
+    f32 result = INFINITY;
+
+    for (ssize i = 0; i < edges->padded_count; ++i) {
+        f32 line_dx = edges->dir_x[i];
+        f32 line_dy = edges->dir_y[i];
+        f32 rel_x = edges->start_x[i] - origin.x;
+        f32 rel_y = edges->start_y[i] - origin.y;
+
+        f32 denominator = line_dx * dir.y - line_dy * dir.x;
+
+        // If the directions are parallel, there can be no intersection
+        if (denominator == 0.0f) {
+            continue;
+        }
+
+        f32 t_line = (dir.x * rel_y - dir.y * rel_x) / denominator;
+        f32 t_ray = (rel_y * line_dx - rel_x * line_dy) / denominator;
+
+        b32 intersecting = (t_ray > 0.0f) && (t_line > 0.0f) && (t_line < 1.0f);
+
+        if (intersecting) {
+            result = MIN(result, t_ray);
+        }
+    }
+
+    return result;
+}
+
+#if EDGE_RAYCAST_AVX2
+
+__attribute__((target("avx2")))
+f32 edge_raycast_closest_hit_avx2(const EdgeSoA *edges, Vector2 origin, Vector2 dir)
+{
+    __m256 origin_x = _mm256_set1_ps(origin.x);
+    __m256 origin_y = _mm256_set1_ps(origin.y);
+    __m256 ray_dx = _mm256_set1_ps(dir.x);
+    __m256 ray_dy = _mm256_set1_ps(dir.y);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 one = _mm256_set1_ps(1.0f);
+    __m256 infinity = _mm256_set1_ps(INFINITY);
+
+    __m256 closest = infinity;
+
+    for (ssize i = 0; i < edges->padded_count; i += EDGE_RAYCAST_LANE_COUNT) {
+        __m256 line_dx = _mm256_loadu_ps(edges->dir_x + i);
+        __m256 line_dy = _mm256_loadu_ps(edges->dir_y + i);
+        __m256 rel_x = _mm256_sub_ps(_mm256_loadu_ps(edges->start_x + i), origin_x);
+        __m256 rel_y = _mm256_sub_ps(_mm256_loadu_ps(edges->start_y + i), origin_y);
+
+        __m256 denominator = _mm256_sub_ps(_mm256_mul_ps(line_dx, ray_dy), _mm256_mul_ps(line_dy, ray_dx));
+
+        __m256 t_line = _mm256_div_ps(
+            _mm256_sub_ps(_mm256_mul_ps(ray_dx, rel_y), _mm256_mul_ps(ray_dy, rel_x)), denominator);
+        __m256 t_ray = _mm256_div_ps(
+            _mm256_sub_ps(_mm256_mul_ps(rel_y, line_dx), _mm256_mul_ps(rel_x, line_dy)), denominator);
+
+        // Ordered comparisons are false for the NaNs that parallel edges produce
+        __m256 intersecting = _mm256_and_ps(
+            _mm256_and_ps(_mm256_cmp_ps(denominator, zero, _CMP_NEQ_OQ),
+                _mm256_cmp_ps(t_ray, zero, _CMP_GT_OQ)),
+            _mm256_and_ps(_mm256_cmp_ps(t_line, zero, _CMP_GT_OQ),
+                _mm256_cmp_ps(t_line, one, _CMP_LT_OQ)));
+
+        __m256 candidates = _mm256_blendv_ps(infinity, t_ray, intersecting);
+        closest = _mm256_min_ps(closest, candidates);
+    }
+
+    f32 lanes[EDGE_RAYCAST_LANE_COUNT];
+    _mm256_storeu_ps(lanes, closest);
+
+    f32 result = INFINITY;
+
+    for (ssize i = 0; i < ARRAY_COUNT(lanes); ++i) {
+        result = MIN(result, lanes[i]);
+    }
+
+    return result;
+}
+
+#endif
+
+b32 edge_raycast_has_avx2(void)
+{
+#if defined(__AVX2__)
+    b32 result = true;
+#elif EDGE_RAYCAST_AVX2
+    b32 result = __builtin_cpu_supports("avx2") != 0;
+#else
+    b32 result = false;
+#endif
+
+    return result;
+}
+
+f32 edge_raycast_closest_hit(const EdgeSoA *edges, Vector2 origin, Vector2 dir)
+{
+    f32 result = 0.0f;
+
+#if EDGE_RAYCAST_AVX2
+    if (edge_raycast_has_avx2()) {
+        result = edge_raycast_closest_hit_avx2(edges, origin, dir);
+    } else {
+        result = edge_raycast_closest_hit_scalar(edges, origin, dir);
+    }
+#else
+    result = edge_raycast_closest_hit_scalar(edges, origin, dir);
+#endif
+
+    return result;
+}
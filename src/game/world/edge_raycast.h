@@ -0,0 +1,63 @@
+#ifndef EDGE_RAYCAST_H
+#define EDGE_RAYCAST_H
+
+#include "base/linear_arena.h"
+#include "base/vector.h"
+#include "tilemap.h"
+
+/*
+  Ray casting against wall edges for visibility polygons. Edges are stored as separate
+  arrays per component so that eight of them can be intersected at once with AVX2, with
+  a scalar path used when the CPU doesn't support it. Both paths do the same floating
+  point operations in the same order and give identical results.
+
+  The AVX2 path is always used when building for AVX2. Other x86 builds compile it with
+  a target attribute and check for support at runtime, and other architectures only
+  have the scalar path.
+ */
+
+#if defined(__AVX2__) || (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#  define EDGE_RAYCAST_AVX2 1
+#else
+#  define EDGE_RAYCAST_AVX2 0
+#endif
+
+#define EDGE_RAYCAST_LANE_COUNT 8
+
+typedef struct {
+    f32   *start_x;
+    f32   *start_y;
+    f32   *dir_x;
+    f32   *dir_y;
+    ssize  count;
+    ssize  padded_count; // Multiple of EDGE_RAYCAST_LANE_COUNT, padding edges have zero length
+} EdgeSoA;
+
+EdgeSoA edge_soa_create_for_origin(EdgePool edges, Vector2 origin, LinearArena *arena);
+f32     edge_raycast_closest_hit(const EdgeSoA *edges, Vector2 origin, Vector2 dir);
+f32     edge_raycast_closest_hit_scalar(const EdgeSoA *edges, Vector2 origin, Vector2 dir);
+b32     edge_raycast_has_avx2(void);
+
+#if EDGE_RAYCAST_AVX2
+f32     edge_raycast_closest_hit_avx2(const EdgeSoA *edges, Vector2 origin, Vector2 dir);
+#endif
+
+// Increases monotonically with the angle of dir in [0, 2pi), but is much cheaper than atan2.
+// Never negative, so the bits can be used directly as a sort key.
+static inline f32 pseudo_angle(Vector2 dir)
+{
+    f32 result = dir.y / (abs_f32(dir.x) + abs_f32(dir.y));
+
+    if (dir.x < 0.0f) {
+        result = 2.0f - result;
+    } else if (dir.y < 0.0f) {
+        result = 4.0f + result;
+    }
+
+    // Turns -0 into +0, which would otherwise sort after every other angle
+    result += 0.0f;
+
+    return result;
+}
+
+#endif //EDGE_RAYCAST_H
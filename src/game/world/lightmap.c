@@ -0,0 +1,379 @@
+#include <string.h>
+
+#include "lightmap.h"
+#include "base/hash.h"
+#include "base/linear_arena.h"
+#include "base/maths.h"
+#include "base/utils.h"
+#include "renderer/frontend/render_batch.h"
+#include "asset_table.h"
+#include "tilemap.h"
+#include "world.h"
+
+#define LIGHTMAP_CHANNELS 4
+
+static b32 light_reaches_area(BakedLight light, Rectangle area)
+{
+    Vector2 closest = {
+        CLAMP(light.origin.x, area.position.x, area.position.x + area.size.x),
+        CLAMP(light.origin.y, area.position.y, area.position.y + area.size.y)
+    };
+
+    b32 result = v2_dist_sq(closest, light.origin) < (light.radius * light.radius);
+
+    return result;
+}
+
+// Whole tiles covering the area
+static void get_tile_range(Rectangle area, Vector2i *min_tile, Vector2i *max_tile)
+{
+    *min_tile = v2i((s32)floorf(area.position.x / (f32)TILE_SIZE),
+        (s32)floorf(area.position.y / (f32)TILE_SIZE));
+    *max_tile = v2i((s32)floorf((area.position.x + area.size.x) / (f32)TILE_SIZE),
+        (s32)floorf((area.position.y + area.size.y) / (f32)TILE_SIZE));
+}
+
+static b32 tile_blocks_baked_light(Tilemap *tilemap, Vector2i coords)
+{
+    Tile *tile = tilemap_get_tile(tilemap, coords);
+    b32 result = !tile || (tile->type == TILE_WALL);
+
+    return result;
+}
+
+// Tiles are read from the chunk area grown by the largest radius of the lights that
+// reach it, since those are the only tiles that can cast shadows into the chunk
+static Rectangle get_tile_area_for_bake(Rectangle chunk_area, BakedLight *lights, ssize light_count)
+{
+    f32 max_radius = 0.0f;
+
+    for (ssize i = 0; i < light_count; ++i) {
+        max_radius = MAX(max_radius, lights[i].radius);
+    }
+
+    Rectangle result = {
+        v2_sub(chunk_area.position, v2(max_radius, max_radius)),
+        v2_add(chunk_area.size, v2(2.0f * max_radius, 2.0f * max_radius))
+    };
+
+    return result;
+}
+
+static u64 hash_tiles_in_area(Tilemap *tilemap, Rectangle area)
+{
+    Vector2i min_tile, max_tile;
+    get_tile_range(area, &min_tile, &max_tile);
+
+    u64 result = HASH_INITIAL_VALUE;
+
+    for (s32 y = min_tile.y; y <= max_tile.y; ++y) {
+        for (s32 x = min_tile.x; x <= max_tile.x; ++x) {
+            b32 blocks = tile_blocks_baked_light(tilemap, v2i(x, y));
+            result = hash_bytes(result, &blocks, sizeof(blocks));
+        }
+    }
+
+    return result;
+}
+
+static u64 get_bake_input_hash(ChunkLightmap *lightmap, Tilemap *tilemap, BakedLight *lights,
+    ssize light_count)
+{
+    if (light_count == 0) {
+        return 0;
+    }
+
+    Rectangle tile_area = get_tile_area_for_bake(lightmap->area, lights, light_count);
+    b32 tiles_changed = (lightmap->tile_hash_version != tilemap->version)
+        || !rect_eq(lightmap->tile_hash_area, tile_area);
+
+    if (tiles_changed) {
+        lightmap->tile_hash = hash_tiles_in_area(tilemap, tile_area);
+        lightmap->tile_hash_version = tilemap->version;
+        lightmap->tile_hash_area = tile_area;
+    }
+
+    u64 result = hash_bytes(lightmap->tile_hash, lights, light_count * SIZEOF(*lights));
+
+    return result;
+}
+
+static LightmapBake *create_bake(ChunkLightmap *lightmap, Tilemap *tilemap, BakedLight *lights,
+    ssize light_count, u64 input_hash, Allocator allocator)
+{
+    LightmapBake *bake = allocate_item(allocator, LightmapBake);
+    bake->area = lightmap->area;
+    bake->input_hash = input_hash;
+
+    Rectangle tile_area = get_tile_area_for_bake(lightmap->area, lights, light_count);
+    Vector2i min_tile, max_tile;
+    get_tile_range(tile_area, &min_tile, &max_tile);
+
+    bake->wall_grid_base = min_tile;
+    bake->wall_grid_dims = v2i(max_tile.x - min_tile.x + 1, max_tile.y - min_tile.y + 1);
+    bake->walls = allocate_array(allocator, b32, bake->wall_grid_dims.x * bake->wall_grid_dims.y);
+
+    for (s32 y = 0; y < bake->wall_grid_dims.y; ++y) {
+        for (s32 x = 0; x < bake->wall_grid_dims.x; ++x) {
+            Vector2i coords = v2i(min_tile.x + x, min_tile.y + y);
+            bake->walls[y * bake->wall_grid_dims.x + x] = tile_blocks_baked_light(tilemap, coords);
+        }
+    }
+
+    bake->lights = allocate_array(allocator, BakedLight, light_count);
+    bake->light_count = light_count;
+    memcpy(bake->lights, lights, (usize)light_count * sizeof(*lights));
+
+    bake->image.width = LIGHTMAP_SIZE_IN_TEXELS;
+    bake->image.height = LIGHTMAP_SIZE_IN_TEXELS;
+    bake->image.channels = LIGHTMAP_CHANNELS;
+    bake->image.data = allocate_array(allocator, byte,
+        LIGHTMAP_SIZE_IN_TEXELS * LIGHTMAP_SIZE_IN_TEXELS * LIGHTMAP_CHANNELS);
+
+    return bake;
+}
+
+static void destroy_bake(LightmapBake *bake, Allocator allocator)
+{
+    deallocate(allocator, bake->image.data);
+    deallocate(allocator, bake->lights);
+    deallocate(allocator, bake->walls);
+    deallocate(allocator, bake);
+}
+
+// Tiles outside of the snapshot count as walls, just like missing tiles do
+static b32 bake_tile_blocks_light(const LightmapBake *bake, s32 tile_x, s32 tile_y)
+{
+    s32 x = tile_x - bake->wall_grid_base.x;
+    s32 y = tile_y - bake->wall_grid_base.y;
+
+    b32 in_bounds = (x >= 0) && (y >= 0)
+        && (x < bake->wall_grid_dims.x) && (y < bake->wall_grid_dims.y);
+
+    b32 result = !in_bounds || bake->walls[y * bake->wall_grid_dims.x + x];
+
+    return result;
+}
+
+// Walks the tiles between the points. The tile containing the target never blocks, so that
+// walls facing the light are lit.
+static b32 bake_has_line_of_sight(const LightmapBake *bake, Vector2 from, Vector2 to)
+{
+    TileWalk walk = tile_walk_begin(from, v2_sub(to, from));
+
+    s32 target_x = (s32)floorf(to.x / (f32)TILE_SIZE);
+    s32 target_y = (s32)floorf(to.y / (f32)TILE_SIZE);
+
+    for (;;) {
+        if ((walk.tile.x == target_x) && (walk.tile.y == target_y)) {
+            return true;
+        }
+
+        if (bake_tile_blocks_light(bake, walk.tile.x, walk.tile.y)) {
+            return false;
+        }
+
+        tile_walk_next(&walk);
+
+        if (walk.fraction > 1.0f) {
+            // Rounding kept us from landing exactly in the target tile
+            return true;
+        }
+    }
+}
+
+static byte texel_channel_to_byte(f32 value)
+{
+    byte result = (byte)(CLAMP(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+
+    return result;
+}
+
+// Job entry point, data is a LightmapBake. Uses the same falloff as the light shader so that
+// baked and dynamic lights look the same.
+void lightmap_bake(void *data)
+{
+    LightmapBake *bake = data;
+    f32 texel_size = bake->area.size.x / (f32)LIGHTMAP_SIZE_IN_TEXELS;
+
+    for (s32 row = 0; row < LIGHTMAP_SIZE_IN_TEXELS; ++row) {
+        for (s32 col = 0; col < LIGHTMAP_SIZE_IN_TEXELS; ++col) {
+            // First row of the image is the top of the chunk
+            Vector2 texel_center = {
+                bake->area.position.x + ((f32)col + 0.5f) * texel_size,
+                bake->area.position.y + bake->area.size.y - ((f32)row + 0.5f) * texel_size
+            };
+
+            f32 r = 0.0f;
+            f32 g = 0.0f;
+            f32 b = 0.0f;
+
+            for (ssize i = 0; i < bake->light_count; ++i) {
+                BakedLight light = bake->lights[i];
+                f32 dist = v2_dist(light.origin, texel_center);
+
+                if (dist >= light.radius) {
+                    continue;
+                }
+
+                if (light.casts_shadows && !bake_has_line_of_sight(bake, light.origin, texel_center)) {
+                    continue;
+                }
+
+                f32 intensity = light.color.a * (1.0f - sqrt_f32(dist / light.radius));
+
+                r += light.color.r * intensity;
+                g += light.color.g * intensity;
+                b += light.color.b * intensity;
+            }
+
+            byte *texel = bake->image.data + (row * LIGHTMAP_SIZE_IN_TEXELS + col) * LIGHTMAP_CHANNELS;
+            texel[0] = texel_channel_to_byte(r);
+            texel[1] = texel_channel_to_byte(g);
+            texel[2] = texel_channel_to_byte(b);
+            texel[3] = 255;
+        }
+    }
+}
+
+void lightmaps_initialize(Lightmaps *lightmaps, const Chunks *chunks, Allocator allocator,
+    LinearArena *arena)
+{
+    lightmaps->lightmaps = la_allocate_array(arena, ChunkLightmap, chunks->chunk_count);
+    lightmaps->count = chunks->chunk_count;
+    lightmaps->allocator = allocator;
+
+    f32 chunk_world_size = (f32)(CHUNK_SIZE_IN_TILES * TILE_SIZE);
+    Vector2 base = tile_to_world_coords(chunks->chunk_grid_base_tile_coords);
+
+    for (s32 y = 0; y < chunks->chunk_grid_dims.y; ++y) {
+        for (s32 x = 0; x < chunks->chunk_grid_dims.x; ++x) {
+            ChunkLightmap *lightmap = &lightmaps->lightmaps[x + y * chunks->chunk_grid_dims.x];
+
+            lightmap->area.position = v2_add(base, v2((f32)x * chunk_world_size, (f32)y * chunk_world_size));
+            lightmap->area.size = v2(chunk_world_size, chunk_world_size);
+            lightmap->texture = NULL_TEXTURE;
+        }
+    }
+}
+
+// Finished bakes are still picked up by the next update
+void lightmaps_wait_for_bakes(Lightmaps *lightmaps, PlatformCode platform_code)
+{
+    for (ssize i = 0; i < lightmaps->count; ++i) {
+        ChunkLightmap *lightmap = &lightmaps->lightmaps[i];
+
+        if (lightmap->pending_bake) {
+            platform_code.wait_for_jobs(&lightmap->bake_counter);
+        }
+    }
+}
+
+void lightmaps_destroy(Lightmaps *lightmaps, PlatformCode platform_code)
+{
+    lightmaps_wait_for_bakes(lightmaps, platform_code);
+
+    // TODO: free the textures once assets can be unloaded
+    for (ssize i = 0; i < lightmaps->count; ++i) {
+        ChunkLightmap *lightmap = &lightmaps->lightmaps[i];
+
+        if (lightmap->pending_bake) {
+            destroy_bake(lightmap->pending_bake, lightmaps->allocator);
+            lightmap->pending_bake = 0;
+        }
+    }
+}
+
+static void finish_bake(ChunkLightmap *lightmap, PlatformCode platform_code, Allocator allocator)
+{
+    LightmapBake *bake = lightmap->pending_bake;
+
+    if (lightmap->texture.id == NULL_ASSET_ID) {
+        lightmap->texture = platform_code.create_texture(bake->image);
+    } else {
+        platform_code.update_texture(lightmap->texture, bake->image);
+    }
+
+    lightmap->baked_hash = bake->input_hash;
+    lightmap->is_lit = true;
+    lightmap->pending_bake = 0;
+
+    destroy_bake(bake, allocator);
+}
+
+void lightmaps_update(Lightmaps *lightmaps, Tilemap *tilemap, const BakedLight *lights,
+    ssize light_count, PlatformCode platform_code, LinearArena *scratch)
+{
+    lightmaps->pending_bakes = 0;
+
+    for (ssize i = 0; i < lightmaps->count; ++i) {
+        ChunkLightmap *lightmap = &lightmaps->lightmaps[i];
+
+        if (lightmap->pending_bake && job_counter_is_done(&lightmap->bake_counter)) {
+            finish_bake(lightmap, platform_code, lightmaps->allocator);
+            ++lightmaps->finished_bakes;
+        }
+
+        BakedLight *reaching_lights = la_allocate_array(scratch, BakedLight, MAX(light_count, 1));
+        ssize reaching_count = 0;
+
+        for (ssize j = 0; j < light_count; ++j) {
+            if (light_reaches_area(lights[j], lightmap->area)) {
+                reaching_lights[reaching_count++] = lights[j];
+            }
+        }
+
+        u64 input_hash = get_bake_input_hash(lightmap, tilemap, reaching_lights, reaching_count);
+
+        lightmap->is_baked = !lightmap->pending_bake && (input_hash == lightmap->baked_hash);
+
+        if (lightmap->pending_bake) {
+            // Newer inputs are picked up once the current bake is done
+            ++lightmaps->pending_bakes;
+        } else if (input_hash != lightmap->baked_hash) {
+            if (reaching_count == 0) {
+                lightmap->is_lit = false;
+                lightmap->is_baked = true;
+                lightmap->baked_hash = input_hash;
+            } else {
+                lightmap->pending_bake = create_bake(lightmap, tilemap, reaching_lights, reaching_count,
+                    input_hash, lightmaps->allocator);
+                platform_code.submit_job(lightmap_bake, lightmap->pending_bake, &lightmap->bake_counter);
+
+                ++lightmaps->pending_bakes;
+            }
+        }
+    }
+}
+
+// Chunks with a pending bake are skipped, the static lights reaching them are drawn
+// dynamically instead
+void lightmaps_render(Lightmaps *lightmaps, RenderBatch *rb, Rectangle visible_area)
+{
+    for (ssize i = 0; i < lightmaps->count; ++i) {
+        ChunkLightmap *lightmap = &lightmaps->lightmaps[i];
+
+        if (lightmap->is_baked && lightmap->is_lit && rect_intersects(lightmap->area, visible_area)) {
+            draw_sprite(rb, lightmap->texture, lightmap->area, (SpriteModifiers){0},
+                shader_handle(TEXTURE_SHADER), 0);
+        }
+    }
+}
+
+// Areas of the chunks overlapping the area whose lightmaps aren't drawn, returns how many
+// were written to the result
+ssize lightmaps_get_unbaked_areas(Lightmaps *lightmaps, Rectangle area, Rectangle *result,
+    ssize max_count)
+{
+    ssize result_count = 0;
+
+    for (ssize i = 0; (i < lightmaps->count) && (result_count < max_count); ++i) {
+        ChunkLightmap *lightmap = &lightmaps->lightmaps[i];
+
+        if (!lightmap->is_baked && rect_intersects(lightmap->area, area)) {
+            result[result_count++] = lightmap->area;
+        }
+    }
+
+    return result_count;
+}
@@ -0,0 +1,93 @@
+#ifndef LIGHTMAP_H
+#define LIGHTMAP_H
+
+#include "base/allocator.h"
+#include "base/image.h"
+#include "base/rectangle.h"
+#include "base/rgba.h"
+#include "platform/platform.h"
+#include "chunk.h"
+
+#define LIGHTMAP_TEXELS_PER_TILE 16
+#define LIGHTMAP_SIZE_IN_TEXELS  (CHUNK_SIZE_IN_TILES * LIGHTMAP_TEXELS_PER_TILE)
+
+/*
+  Static lights are baked on the CPU into one lightmap per chunk, which is then drawn
+  as a single textured quad instead of rasterizing the lights every frame. Bakes run
+  as background jobs on a snapshot of the tiles around the chunk, and are only redone
+  when the lights touching the chunk or the tiles they can reach change. While the bake
+  of a chunk is pending, the static lights reaching it are drawn dynamically, clipped to
+  that chunk, and every other chunk keeps drawing its lightmap.
+
+  The bake job lives in the game library, so the platform layer waits for pending bakes
+  through game_prepare_for_reload before the library is unloaded.
+
+  TODO:
+  - Lights that are partially static (eg. flickering torches)
+ */
+
+struct Tilemap;
+struct LinearArena;
+struct RenderBatch;
+
+typedef struct {
+    Vector2 origin;
+    f32     radius;
+    RGBA32  color;
+    b32     casts_shadows;
+} BakedLight;
+
+// Everything a bake job needs, copied from the world so that it never touches live state
+typedef struct {
+    Rectangle   area;
+
+    // Tiles that block light in the area reachable by the lights, indexed from the
+    // bottom left tile
+    Vector2i    wall_grid_base;
+    Vector2i    wall_grid_dims;
+    b32        *walls;
+
+    BakedLight *lights;
+    ssize       light_count;
+
+    u64         input_hash;
+    Image       image; // Written by the job
+} LightmapBake;
+
+typedef struct {
+    Rectangle      area;
+    TextureHandle  texture;
+    b32            is_lit;      // False if no static lights reached the chunk when it was baked
+    b32            is_baked;    // Up to date with the current static lights and tiles
+    u64            baked_hash;  // Input hash that the texture was baked from
+
+    // Hashing the tiles is only redone if the tilemap or the area they are read from changes
+    u64            tile_hash;
+    u64            tile_hash_version;
+    Rectangle      tile_hash_area;
+
+    LightmapBake  *pending_bake;
+    JobCounter     bake_counter;
+} ChunkLightmap;
+
+typedef struct {
+    ChunkLightmap *lightmaps; // Same order as the chunks they belong to
+    ssize          count;
+    Allocator      allocator;
+
+    ssize          pending_bakes;
+    ssize          finished_bakes;
+} Lightmaps;
+
+void lightmaps_initialize(Lightmaps *lightmaps, const Chunks *chunks, Allocator allocator,
+    struct LinearArena *arena);
+void lightmaps_destroy(Lightmaps *lightmaps, PlatformCode platform_code);
+void lightmaps_wait_for_bakes(Lightmaps *lightmaps, PlatformCode platform_code);
+void lightmaps_update(Lightmaps *lightmaps, struct Tilemap *tilemap, const BakedLight *lights,
+    ssize light_count, PlatformCode platform_code, struct LinearArena *scratch);
+void lightmaps_render(Lightmaps *lightmaps, struct RenderBatch *rb, Rectangle visible_area);
+ssize lightmaps_get_unbaked_areas(Lightmaps *lightmaps, Rectangle area, Rectangle *result,
+    ssize max_count);
+void lightmap_bake(void *data);
+
+#endif //LIGHTMAP_H
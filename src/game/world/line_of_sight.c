@@ -1,4 +1,5 @@
 #include "line_of_sight.h"
+#include "base/hash.h"
 #include "base/line.h"
 #include "base/maths.h"
 #include "base/rectangle.h"
@@ -9,152 +10,181 @@
 #include "tilemap.h"
 #include "world.h"
 
-typedef enum {
-    SIDE_NORTH_SOUTH,
-    SIDE_WEST_EAST,
-} WallSide;
-
-// https://lodev.org/cgtutor/raycasting.html
-Vector2 find_first_wall_in_direction(Tilemap *tilemap, Vector2 origin, Vector2 dir)
+// Gives up once the ray is further than max_distance from the origin
+WallHit find_first_wall_in_direction(Tilemap *tilemap, Vector2 origin, Vector2 dir, f32 max_distance)
 {
-    // The current ray position
-    f64 pos_x = (f64)origin.x;
-    f64 pos_y = (f64)origin.y;
+    WallHit result = {false, origin};
 
-    // The current integral map position
-    s32 map_x = (s32)pos_x;
-    s32 map_y = (s32)pos_y;
+    if (v2_is_zero(dir)) {
+        return result;
+    }
 
-    // The current step direction
-    s32 step_x = 0;
-    s32 step_y = 0;
+    dir = v2_norm(dir);
 
-    // The length from one x or y side to next one
-    f64 delta_dist_x = (dir.x == 0.0f) ? 1e30 : fabs(1.0 / (f64)dir.x);
-    f64 delta_dist_y = (dir.y == 0.0f) ? 1e30 : fabs(1.0 / (f64)dir.y);
+    // Walking along a unit direction makes the fractions distances in world units
+    TileWalk walk = tile_walk_begin(origin, dir);
 
-    b32 wall_hit = false;
-    WallSide side = 0;
+    // Missing tiles count as walls, so unbounded rays still stop at the edge of the map
+    for (;;) {
+        tile_walk_next(&walk);
 
-    // The current length of the ray to next x or y side
-    f64 side_dist_x = 0.0;
-    f64 side_dist_y = 0.0;
+        if (walk.fraction >= max_distance) {
+            result.position = v2_add(origin, v2_mul_s(dir, max_distance));
+            break;
+        }
 
-    if (dir.x < 0.0f) {
-	step_x = -1;
-	side_dist_x = (pos_x - map_x) * delta_dist_x;
-    } else {
-	step_x = 1;
-	side_dist_x = (map_x + 1.0 - pos_x) * delta_dist_x;
-    }
+        Tile *tile = tilemap_get_tile(tilemap, walk.tile);
 
-    if (dir.y < 0) {
-	step_y = -1;
-	side_dist_y = (pos_y - map_y) * delta_dist_y;
-    } else {
-	step_y = 1;
-	side_dist_y = (map_y + 1.0 - pos_y) * delta_dist_y;
+        if (!tile || (tile->type == TILE_WALL)) {
+            result.hit_wall = true;
+            result.position = v2_add(origin, v2_mul_s(dir, walk.fraction));
+            break;
+        }
     }
 
-    while (!wall_hit) {
-	if (side_dist_x < side_dist_y) {
-	    side_dist_x += delta_dist_x;
-	    map_x += step_x;
-	    side = SIDE_WEST_EAST;
-	} else {
-	    side_dist_y += delta_dist_y;
-	    map_y += step_y;
-	    side = SIDE_NORTH_SOUTH;
-	}
-
-	Vector2i map_coords = world_to_tile_coords(v2((f32)map_x, (f32)map_y));
-	Tile *tile = tilemap_get_tile(tilemap, map_coords);
-
-	if (!tile || (tile->type == TILE_WALL)) {
-	    wall_hit = true;
-	}
-    }
+    return result;
+}
 
-    f32 fraction_x = 0.0f;
-    f32 fraction_y = 0.0f;
+// TODO: better name
+Vector2 find_first_wall_on_path(Vector2 origin, Vector2 target, Tilemap *tilemap)
+{
+    WallHit hit = find_first_wall_in_direction(tilemap, origin, v2_sub(target, origin),
+        v2_dist(origin, target));
 
-    // If we hit a vertical line there will be no x fraction, and if we hit a horizontal
-    // line there will be no y fraction
-    if ((side == SIDE_NORTH_SOUTH) && (dir.x != 0.0f)) {
-	fraction_x = fraction((f32)side_dist_x);
-    } else if (dir.y != 0.0f) {
-	fraction_y = fraction((f32)side_dist_y);
-    }
+    Vector2 result = hit.hit_wall ? hit.position : target;
 
-    Vector2 result = {
-	(f32)map_x + fraction_x,
-	(f32)map_y + fraction_y,
-    };
+    return result;
+}
 
+static b32 has_line_of_sight_to_point(Vector2 origin, Vector2 point, Tilemap *tilemap)
+{
+    WallHit hit = find_first_wall_in_direction(tilemap, origin, v2_sub(point, origin),
+        v2_dist(origin, point));
+
+    b32 result = !hit.hit_wall;
     return result;
 }
 
-// TODO: better name
-// TODO: instead provide max distance?
-Vector2 find_first_wall_on_path(Vector2 origin, Vector2 target, Tilemap *tilemap)
+static b32 has_line_of_sight_to_bounds(Vector2 origin, Rectangle bounds, Tilemap *tilemap)
 {
-    Vector2 direction = v2_norm(v2_sub(target, origin));
-    Vector2 first_wall = find_first_wall_in_direction(tilemap, origin, direction);
+    b32 result = false;
 
-    Vector2 result = {0};
+    Vector2 vertices[] = {
+        rect_center(bounds),
+        rect_top_left(bounds),
+        rect_top_right(bounds),
+        rect_bottom_right(bounds),
+        rect_bottom_left(bounds),
+    };
 
-    if (v2_dist_sq(origin, first_wall) < v2_dist_sq(origin, target)) {
-        result = first_wall;
-    } else {
-        result = target;
+    // Check if any of the rectangle corners or the center of the other entity are visible.
+    // This isn't exactly correct and may return false even in somme edge cases where the entity is
+    // obviously visible, but this should be a good enough approximation for now.
+    // The center is tried first since it's the most likely to be visible.
+    for (s32 i = 0; i < ARRAY_COUNT(vertices); ++i) {
+        if (has_line_of_sight_to_point(origin, vertices[i], tilemap)) {
+            result = true;
+            break;
+        }
     }
 
     return result;
 }
 
-static b32 has_line_of_sight_to_point(Vector2 origin, Vector2 point, Tilemap *tilemap)
+void los_cache_begin_frame(LineOfSightCache *cache)
+{
+    ++cache->frame;
+
+    cache->hits = 0;
+    cache->misses = 0;
+}
+
+static LineOfSightCacheEntry *los_cache_find_slot(LineOfSightCache *cache, Vector2i source_tile,
+    EntityID target_id)
 {
-    // TODO: implement this in a better way by finding first wall but aborting if exceeding distance
-    Vector2 dir = v2_sub(point, origin);
-    Vector2 intersection = find_first_wall_in_direction(tilemap, origin, dir);
+    ASSERT(cache->frame != 0);
+
+    u64 hash = HASH_INITIAL_VALUE;
+    hash = hash_bytes(hash, &source_tile.x, SIZEOF(source_tile.x));
+    hash = hash_bytes(hash, &source_tile.y, SIZEOF(source_tile.y));
+    hash = hash_bytes(hash, &target_id.index, SIZEOF(target_id.index));
+    hash = hash_bytes(hash, &target_id.generation, SIZEOF(target_id.generation));
+
+    LineOfSightCacheEntry *result = 0;
+
+    // Returns either the matching entry or a free one, or null if the probe length ran out
+    for (u64 i = 0; i < LINE_OF_SIGHT_CACHE_MAX_PROBES; ++i) {
+        LineOfSightCacheEntry *entry = &cache->entries[mod_index(hash + i, LINE_OF_SIGHT_CACHE_SIZE)];
+
+        b32 is_free = entry->frame != cache->frame;
+        b32 is_match = !is_free && v2i_eq(entry->source_tile, source_tile)
+            && entity_id_equal(entry->target, target_id);
 
-    f32 dist_to_point = v2_dist_sq(origin, point);
-    f32 dist_to_intersection = v2_dist_sq(origin, intersection);
+        if (is_free || is_match) {
+            result = entry;
+            break;
+        }
+    }
 
-    b32 result = (dist_to_point <= dist_to_intersection) ;
     return result;
 }
 
-b32 has_line_of_sight_to_entity(PhysicsComponent *self_physics, Entity *other, Tilemap *tilemap)
+static b32 los_cache_lookup(LineOfSightCache *cache, Vector2 origin, EntityID target_id,
+    Rectangle target_bounds, Tilemap *tilemap)
 {
+    Vector2i source_tile = world_to_tile_coords(origin);
+    LineOfSightCacheEntry *entry = los_cache_find_slot(cache, source_tile, target_id);
+
     b32 result = false;
 
-    PhysicsComponent *other_physics = es_get_component(other, PhysicsComponent);
-
-    if (other_physics) {
-        // TODO: maybe origin should be center of entity bounds or something
-        Vector2 origin = self_physics->position;
-        Rectangle other_bounds = world_get_entity_bounding_box(other, other_physics);
-
-        Vector2 other_vertices[] = {
-            rect_top_left(other_bounds),
-            rect_top_right(other_bounds),
-            rect_bottom_right(other_bounds),
-            rect_bottom_left(other_bounds),
-            rect_center(other_bounds),
-        };
-
-        // Check if any of the rectangle corners or the center of the other entity are visible.
-        // This isn't exactly correct and may return false even in somme edge cases where the entity is
-        // obviously visible, but this should be a good enough approximation for now.
-        for (s32 i = 0; i < ARRAY_COUNT(other_vertices); ++i) {
-            if (has_line_of_sight_to_point(origin, other_vertices[i], tilemap)) {
-                result = true;
-                break;
-            }
+    if (entry && (entry->frame == cache->frame)) {
+        result = entry->has_line_of_sight;
+        ++cache->hits;
+    } else {
+        Vector2 tile_center = v2_add(tile_to_world_coords(source_tile),
+            v2((f32)TILE_SIZE / 2.0f, (f32)TILE_SIZE / 2.0f));
+
+        result = has_line_of_sight_to_bounds(tile_center, target_bounds, tilemap);
+        ++cache->misses;
+
+        if (entry) {
+            entry->source_tile = source_tile;
+            entry->target = target_id;
+            entry->frame = cache->frame;
+            entry->has_line_of_sight = result;
         }
     }
 
+    return result;
+}
+
+b32 los_cache_has_line_of_sight(LineOfSightCache *cache, Vector2 origin, EntityID target_id,
+    Entity *target, Tilemap *tilemap)
+{
+    b32 result = false;
+    los_cache_has_line_of_sight_batch(cache, &origin, 1, target_id, target, tilemap, &result);
 
     return result;
 }
+
+// Many agents usually look for the same target, so its bounds are only looked up once and
+// agents sharing a tile share the result
+void los_cache_has_line_of_sight_batch(LineOfSightCache *cache, const Vector2 *origins,
+    ssize origin_count, EntityID target_id, Entity *target, Tilemap *tilemap, b32 *results)
+{
+    PhysicsComponent *target_physics = es_get_component(target, PhysicsComponent);
+
+    if (!target_physics) {
+        for (ssize i = 0; i < origin_count; ++i) {
+            results[i] = false;
+        }
+
+        return;
+    }
+
+    Rectangle target_bounds = world_get_entity_bounding_box(target, target_physics);
+
+    for (ssize i = 0; i < origin_count; ++i) {
+        results[i] = los_cache_lookup(cache, origins[i], target_id, target_bounds, tilemap);
+    }
+}
@@ -2,14 +2,50 @@
 #define LINE_OF_SIGHT_H
 
 #include "base/vector.h"
+#include "entity/entity_id.h"
+
+/*
+  Line of sight results towards entities are cached per frame, keyed by the tile the
+  query is made from and the target entity. Cached queries are made from the center of
+  the source tile, so every agent standing on the same tile gets the same answer.
+ */
+
+#define LINE_OF_SIGHT_CACHE_SIZE        1024 // Must be a power of two
+#define LINE_OF_SIGHT_CACHE_MAX_PROBES  8
 
 struct Tilemap;
 struct Entity;
-struct PhysicsComponent;
 
-Vector2 find_first_wall_in_direction(struct Tilemap *tilemap, Vector2 origin, Vector2 dir);
-b32 has_line_of_sight_to_entity(struct PhysicsComponent *self_physics,
-                                struct Entity *other, struct Tilemap *tilemap);
+typedef struct {
+    b32     hit_wall;
+    Vector2 position; // Where the wall was hit, or the end of the ray if none was hit
+} WallHit;
+
+typedef struct {
+    Vector2i source_tile;
+    EntityID target;
+    u64      frame; // Entries from earlier frames are treated as empty
+    b32      has_line_of_sight;
+} LineOfSightCacheEntry;
+
+typedef struct {
+    LineOfSightCacheEntry entries[LINE_OF_SIGHT_CACHE_SIZE];
+    u64                   frame;
+
+    // Reset every frame
+    ssize                 hits;
+    ssize                 misses;
+} LineOfSightCache;
+
+WallHit find_first_wall_in_direction(struct Tilemap *tilemap, Vector2 origin, Vector2 dir,
+                                     f32 max_distance);
 Vector2 find_first_wall_on_path(Vector2 origin, Vector2 target, struct Tilemap *tilemap);
 
+void los_cache_begin_frame(LineOfSightCache *cache);
+b32  los_cache_has_line_of_sight(LineOfSightCache *cache, Vector2 origin, EntityID target_id,
+                                 struct Entity *target, struct Tilemap *tilemap);
+void los_cache_has_line_of_sight_batch(LineOfSightCache *cache, const Vector2 *origins,
+                                       ssize origin_count, EntityID target_id, struct Entity *target,
+                                       struct Tilemap *tilemap, b32 *results);
+
 #endif //LINE_OF_SIGHT_H
@@ -35,8 +35,8 @@ void qt_initialize(QuadTree *qt, Rectangle area)
     qt_initialize_node(&qt->root, area);
 }
 
-static QuadTreeLocation qt_insert(QuadTree *qt, QuadTreeNode *node, EntityID id, Rectangle area, ssize depth,
-    LinearArena *arena)
+static QuadTreeLocation qt_insert(QuadTree *qt, QuadTreeNode *node, EntityID id, Rectangle area,
+    CollisionFilter filter, ssize depth, LinearArena *arena)
 {
     // TODO: clean up this function
     ASSERT(area.size.x > 0);
@@ -55,25 +55,25 @@ static QuadTreeLocation qt_insert(QuadTree *qt, QuadTreeNode *node, EntityID id,
 		qt_subdivide(node, arena);
 	    }
 
-	    result = qt_insert(qt, node->top_left, id, area, depth + 1, arena);
+	    result = qt_insert(qt, node->top_left, id, area, filter, depth + 1, arena);
 	} else if (rect_contains_rect(quadrants.top_right, area)) {
 	    if (no_children) {
 		qt_subdivide(node, arena);
 	    }
 
-	    result = qt_insert(qt, node->top_right, id, area, depth + 1, arena);
+	    result = qt_insert(qt, node->top_right, id, area, filter, depth + 1, arena);
 	} else if (rect_contains_rect(quadrants.bottom_right, area)) {
 	    if (no_children) {
 		qt_subdivide(node, arena);
 	    }
 
-	    result = qt_insert(qt, node->bottom_right, id, area, depth + 1, arena);
+	    result = qt_insert(qt, node->bottom_right, id, area, filter, depth + 1, arena);
 	} else if (rect_contains_rect(quadrants.bottom_left, area)) {
 	    if (no_children) {
 		qt_subdivide(node, arena);
 	    }
 
-	    result = qt_insert(qt, node->bottom_left, id, area, depth + 1, arena);
+	    result = qt_insert(qt, node->bottom_left, id, area, filter, depth + 1, arena);
 	}
     }
 
@@ -88,6 +88,7 @@ static QuadTreeLocation qt_insert(QuadTree *qt, QuadTreeNode *node, EntityID id,
 
         element->entity_id = id;
         element->area = area;
+        element->collision_filter = filter;
 
         list_push_back(&node->entities_in_node, element);
 
@@ -103,20 +104,21 @@ QuadTreeLocation qt_move_entity(QuadTree *qt, EntityID id,
 {
     ASSERT(!qt_location_is_null(location));
     Rectangle new_area = {new_position, location.element->area.size};
+    CollisionFilter filter = location.element->collision_filter;
 
-    QuadTreeLocation result = qt_set_entity_area(qt, id, location, new_area, arena);
+    QuadTreeLocation result = qt_set_entity_area(qt, id, location, new_area, filter, arena);
 
     return result;
 }
 
 QuadTreeLocation qt_set_entity_area(QuadTree *qt, EntityID id,
-    QuadTreeLocation location, Rectangle area, LinearArena *arena)
+    QuadTreeLocation location, Rectangle area, CollisionFilter filter, LinearArena *arena)
 {
     if (!qt_location_is_null(location)) {
         qt_remove_entity(qt, id, location);
     }
 
-    QuadTreeLocation result = qt_insert(qt, &qt->root, id, area, 0, arena);
+    QuadTreeLocation result = qt_insert(qt, &qt->root, id, area, filter, 0, arena);
 
     return result;
 }
@@ -160,6 +162,43 @@ EntityIDList qt_get_entities_in_area(QuadTree *qt, Rectangle area, LinearArena *
     return result;
 }
 
+static void qt_get_colliding_entities_in_area_recursive(QuadTreeNode *node, Rectangle area,
+    EntityID querying_entity, CollisionFilter filter, QuadTreeCollisionQuery *query, LinearArena *arena)
+{
+    if (node && rect_intersects(node->area, area)) {
+        for (QuadTreeElement *elem = list_head(&node->entities_in_node); elem; elem = list_next(elem)) {
+            if (entity_id_equal(elem->entity_id, querying_entity) || !rect_intersects(elem->area, area)) {
+                continue;
+            }
+
+            // Pairs that can never interact are rejected here so that they never
+            // reach the narrowphase
+            if (collision_filters_can_interact(filter, elem->collision_filter)) {
+                EntityIDNode *id_node = la_allocate_item(arena, EntityIDNode);
+                id_node->id = elem->entity_id;
+
+                sl_list_push_back(&query->entities, id_node);
+            } else {
+                ++query->culled_pair_count;
+            }
+        }
+
+        qt_get_colliding_entities_in_area_recursive(node->top_left, area, querying_entity, filter, query, arena);
+        qt_get_colliding_entities_in_area_recursive(node->top_right, area, querying_entity, filter, query, arena);
+        qt_get_colliding_entities_in_area_recursive(node->bottom_right, area, querying_entity, filter, query, arena);
+        qt_get_colliding_entities_in_area_recursive(node->bottom_left, area, querying_entity, filter, query, arena);
+    }
+}
+
+QuadTreeCollisionQuery qt_get_colliding_entities_in_area(QuadTree *qt, Rectangle area,
+    EntityID querying_entity, CollisionFilter filter, LinearArena *arena)
+{
+    QuadTreeCollisionQuery result = {0};
+    qt_get_colliding_entities_in_area_recursive(&qt->root, area, querying_entity, filter, &result, arena);
+
+    return result;
+}
+
 static ssize qt_get_node_count_recursive(const QuadTree *qt, const QuadTreeNode *node)
 {
     ssize result = 0;
@@ -3,6 +3,7 @@
 
 #include "base/linear_arena.h"
 #include "base/rectangle.h"
+#include "base/list.h"
 #include "base/utils.h"
 #include "entity/entity.h"
 
@@ -20,6 +21,7 @@
 typedef struct QuadTreeElement {
     EntityID entity_id;
     Rectangle area;
+    CollisionFilter collision_filter;
     struct QuadTreeElement *next;
     struct QuadTreeElement *prev;
 } QuadTreeElement;
@@ -63,15 +65,32 @@ typedef struct {
     EntityIDNode *tail;
 } EntityIDList;
 
+typedef struct {
+    EntityIDList entities;
+    ssize        culled_pair_count; // Entities in area rejected by the collision filter
+} QuadTreeCollisionQuery;
+
 void qt_initialize(QuadTree *qt, Rectangle area);
 QuadTreeLocation qt_move_entity(QuadTree *qt, EntityID id,
     QuadTreeLocation location, Vector2 new_position, LinearArena *arena);
 QuadTreeLocation qt_set_entity_area(QuadTree *qt, EntityID id,
-    QuadTreeLocation location, Rectangle area, LinearArena *arena);
+    QuadTreeLocation location, Rectangle area, CollisionFilter filter, LinearArena *arena);
 QuadTreeLocation qt_remove_entity(QuadTree *qt, EntityID id, QuadTreeLocation location);
 EntityIDList qt_get_entities_in_area(QuadTree *qt, Rectangle area, LinearArena *arena);
+QuadTreeCollisionQuery qt_get_colliding_entities_in_area(QuadTree *qt, Rectangle area,
+    EntityID querying_entity, CollisionFilter filter, LinearArena *arena);
 ssize qt_get_node_count(const QuadTree *qt);
 
+static inline void entity_id_list_append(EntityIDList *list, EntityIDList other)
+{
+    if (list_is_empty(list)) {
+        *list = other;
+    } else if (!list_is_empty(&other)) {
+        list->tail->next = other.head;
+        list->tail = other.tail;
+    }
+}
+
 static inline b32 qt_location_is_null(QuadTreeLocation loc)
 {
     b32 result = (loc.element == 0) && (loc.node == 0);
@@ -0,0 +1,284 @@
+#include "shadowcasting.h"
+#include "base/maths.h"
+#include "base/utils.h"
+#include "world.h"
+
+typedef enum {
+    SHADOWCAST_QUADRANT_NORTH,
+    SHADOWCAST_QUADRANT_SOUTH,
+    SHADOWCAST_QUADRANT_EAST,
+    SHADOWCAST_QUADRANT_WEST,
+    SHADOWCAST_QUADRANT_COUNT,
+} ShadowcastQuadrant;
+
+typedef enum {
+    SCANNED_TILE_NONE,
+    SCANNED_TILE_WALL,
+    SCANNED_TILE_FLOOR,
+} ScannedTileKind;
+
+typedef struct {
+    s32 depth;
+    f32 start_slope;
+    f32 end_slope;
+} ShadowcastRow;
+
+typedef struct {
+    Tilemap  *tilemap;
+    Vector2i  origin_tile;
+    s32       max_depth;
+
+    // Covers max_depth plus one extra ring so that walls next to revealed floor fit
+    s32       grid_half_size;
+    s32       grid_size;
+    b32      *revealed;
+} ShadowcastState;
+
+static b32 tile_blocks_light(Tilemap *tilemap, Vector2i coords)
+{
+    Tile *tile = tilemap_get_tile(tilemap, coords);
+    b32 result = !tile || (tile->type == TILE_WALL);
+
+    return result;
+}
+
+static b32 tile_is_wall(Tilemap *tilemap, Vector2i coords)
+{
+    Tile *tile = tilemap_get_tile(tilemap, coords);
+    b32 result = tile && (tile->type == TILE_WALL);
+
+    return result;
+}
+
+static ssize get_grid_index(const ShadowcastState *state, Vector2i coords)
+{
+    s32 local_x = coords.x - state->origin_tile.x + state->grid_half_size;
+    s32 local_y = coords.y - state->origin_tile.y + state->grid_half_size;
+
+    ssize result = -1;
+
+    if ((local_x >= 0) && (local_x < state->grid_size)
+        && (local_y >= 0) && (local_y < state->grid_size)) {
+        result = (ssize)local_y * state->grid_size + local_x;
+    }
+
+    return result;
+}
+
+static Vector2i quadrant_to_tile(const ShadowcastState *state, ShadowcastQuadrant quadrant,
+    s32 depth, s32 col)
+{
+    Vector2i origin = state->origin_tile;
+    Vector2i result = origin;
+
+    switch (quadrant) {
+        case SHADOWCAST_QUADRANT_NORTH: result = v2i(origin.x + col, origin.y + depth); break;
+        case SHADOWCAST_QUADRANT_SOUTH: result = v2i(origin.x + col, origin.y - depth); break;
+        case SHADOWCAST_QUADRANT_EAST:  result = v2i(origin.x + depth, origin.y + col); break;
+        case SHADOWCAST_QUADRANT_WEST:  result = v2i(origin.x - depth, origin.y + col); break;
+
+        INVALID_DEFAULT_CASE;
+    }
+
+    return result;
+}
+
+static f32 get_tile_slope(s32 depth, s32 col)
+{
+    f32 result = (2.0f * (f32)col - 1.0f) / (2.0f * (f32)depth);
+
+    return result;
+}
+
+static b32 tile_is_symmetric(ShadowcastRow row, s32 col)
+{
+    b32 result = ((f32)col >= (f32)row.depth * row.start_slope)
+        && ((f32)col <= (f32)row.depth * row.end_slope);
+
+    return result;
+}
+
+static void reveal_tile(ShadowcastState *state, Vector2i coords)
+{
+    ssize index = get_grid_index(state, coords);
+    ASSERT(index >= 0);
+
+    state->revealed[index] = true;
+}
+
+static void scan_row(ShadowcastState *state, ShadowcastQuadrant quadrant, ShadowcastRow row)
+{
+    if (row.depth > state->max_depth) {
+        return;
+    }
+
+    s32 min_col = (s32)floorf((f32)row.depth * row.start_slope + 0.5f);
+    s32 max_col = (s32)ceilf((f32)row.depth * row.end_slope - 0.5f);
+
+    ScannedTileKind previous = SCANNED_TILE_NONE;
+
+    for (s32 col = min_col; col <= max_col; ++col) {
+        Vector2i coords = quadrant_to_tile(state, quadrant, row.depth, col);
+        b32 is_wall = tile_blocks_light(state->tilemap, coords);
+
+        if (is_wall || tile_is_symmetric(row, col)) {
+            reveal_tile(state, coords);
+        }
+
+        if ((previous == SCANNED_TILE_WALL) && !is_wall) {
+            row.start_slope = get_tile_slope(row.depth, col);
+        }
+
+        if ((previous == SCANNED_TILE_FLOOR) && is_wall) {
+            ShadowcastRow next_row = {row.depth + 1, row.start_slope, get_tile_slope(row.depth, col)};
+            scan_row(state, quadrant, next_row);
+        }
+
+        previous = is_wall ? SCANNED_TILE_WALL : SCANNED_TILE_FLOOR;
+    }
+
+    if (previous == SCANNED_TILE_FLOOR) {
+        ShadowcastRow next_row = {row.depth + 1, row.start_slope, row.end_slope};
+        scan_row(state, quadrant, next_row);
+    }
+}
+
+// Walls that were revealed, or that border revealed floor. The second case catches walls
+// that are only partially visible, which the tile based scan might otherwise miss.
+static b32 wall_should_have_edges(ShadowcastState *state, Vector2i coords)
+{
+    if (!tile_is_wall(state->tilemap, coords)) {
+        return false;
+    }
+
+    ssize index = get_grid_index(state, coords);
+
+    if ((index >= 0) && state->revealed[index]) {
+        return true;
+    }
+
+    for (s32 y = -1; y <= 1; ++y) {
+        for (s32 x = -1; x <= 1; ++x) {
+            Vector2i neighbour = v2i(coords.x + x, coords.y + y);
+            ssize neighbour_index = get_grid_index(state, neighbour);
+
+            if ((neighbour_index >= 0) && state->revealed[neighbour_index]
+                && !tile_blocks_light(state->tilemap, neighbour)) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Same edge layout as tilemap_get_edge_list: only northern, western and eastern edges are
+// created, and neighbouring edges facing the same way are joined into one line
+static void add_wall_edge(ShadowcastState *state, EdgePool *edges, ssize *edge_ids,
+    Vector2i coords, CardinalDirection dir)
+{
+    Vector2i neighbour = v2i_add(coords, v2_to_v2i(cardinal_direction_vector(dir)));
+
+    if (tile_is_wall(state->tilemap, neighbour)) {
+        return;
+    }
+
+    Vector2 tile_position = tile_to_world_coords(coords);
+    Line line = {0};
+    CardinalDirection connectible_dir = CARDINAL_DIR_NORTH;
+
+    switch (dir) {
+        case CARDINAL_DIR_NORTH: {
+            line.start = v2_add(tile_position, v2(0, TILE_SIZE));
+            line.end = v2_add(tile_position, v2(TILE_SIZE, TILE_SIZE));
+            connectible_dir = CARDINAL_DIR_WEST;
+        } break;
+
+        case CARDINAL_DIR_WEST: {
+            line.start = v2_add(tile_position, v2(0, TILE_SIZE));
+            line.end = tile_position;
+        } break;
+
+        case CARDINAL_DIR_EAST: {
+            line.start = v2_add(tile_position, v2(TILE_SIZE, TILE_SIZE));
+            line.end = v2_add(tile_position, v2(TILE_SIZE, 0));
+        } break;
+
+        INVALID_DEFAULT_CASE;
+    }
+
+    Vector2i connected = v2i_add(coords, v2_to_v2i(cardinal_direction_vector(connectible_dir)));
+    ssize connected_index = get_grid_index(state, connected);
+    ssize index = get_grid_index(state, coords);
+    ASSERT(index >= 0);
+
+    ssize edge_id = -1;
+
+    if (connected_index >= 0) {
+        edge_id = edge_ids[connected_index * CARDINAL_DIR_COUNT + dir];
+    }
+
+    if (edge_id >= 0) {
+        edges->items[edge_id].line.end = line.end;
+    } else {
+        ASSERT(edges->count < edges->capacity);
+
+        edge_id = edges->count;
+        edges->items[edges->count++] = (EdgeLine){line, dir};
+    }
+
+    edge_ids[index * CARDINAL_DIR_COUNT + dir] = edge_id;
+}
+
+EdgePool shadowcast_get_visible_edges(Tilemap *tilemap, Vector2 origin, f32 radius,
+    LinearArena *arena)
+{
+    ASSERT(radius > 0.0f);
+
+    ShadowcastState state = {0};
+    state.tilemap = tilemap;
+    state.origin_tile = v2i((s32)floorf(origin.x / (f32)TILE_SIZE),
+        (s32)floorf(origin.y / (f32)TILE_SIZE));
+    state.max_depth = (s32)ceilf(radius / (f32)TILE_SIZE);
+    state.grid_half_size = state.max_depth + 1;
+    state.grid_size = state.grid_half_size * 2 + 1;
+
+    ssize cell_count = (ssize)state.grid_size * state.grid_size;
+    state.revealed = la_allocate_array(arena, b32, cell_count);
+
+    reveal_tile(&state, state.origin_tile);
+
+    if (!tile_blocks_light(tilemap, state.origin_tile)) {
+        for (ShadowcastQuadrant quadrant = 0; quadrant < SHADOWCAST_QUADRANT_COUNT; ++quadrant) {
+            ShadowcastRow first_row = {1, -1.0f, 1.0f};
+            scan_row(&state, quadrant, first_row);
+        }
+    }
+
+    EdgePool result = {0};
+    result.capacity = cell_count * 3;
+    result.items = la_allocate_array(arena, EdgeLine, result.capacity);
+
+    ssize *edge_ids = la_allocate_array(arena, ssize, cell_count * CARDINAL_DIR_COUNT);
+
+    for (ssize i = 0; i < cell_count * CARDINAL_DIR_COUNT; ++i) {
+        edge_ids[i] = -1;
+    }
+
+    // NOTE: we go through from TOP to BOTTOM, LEFT to RIGHT so that edges can be extended
+    s32 half = state.grid_half_size;
+
+    for (s32 y = state.origin_tile.y + half; y >= state.origin_tile.y - half; --y) {
+        for (s32 x = state.origin_tile.x - half; x <= state.origin_tile.x + half; ++x) {
+            Vector2i coords = {x, y};
+
+            if (wall_should_have_edges(&state, coords)) {
+                add_wall_edge(&state, &result, edge_ids, coords, CARDINAL_DIR_NORTH);
+                add_wall_edge(&state, &result, edge_ids, coords, CARDINAL_DIR_WEST);
+                add_wall_edge(&state, &result, edge_ids, coords, CARDINAL_DIR_EAST);
+            }
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,20 @@
+#ifndef SHADOWCASTING_H
+#define SHADOWCASTING_H
+
+#include "base/linear_arena.h"
+#include "base/vector.h"
+#include "tilemap.h"
+
+/*
+  Symmetric shadowcasting over the tile grid, bounded by a radius. Instead of
+  every edge in the tilemap, only the edges of wall tiles that can be seen from
+  the origin within the radius are returned. Work scales with the area of the
+  radius rather than with the size of the map.
+
+  Based on: https://www.albertford.com/shadowcasting/
+ */
+
+EdgePool shadowcast_get_visible_edges(Tilemap *tilemap, Vector2 origin, f32 radius,
+    LinearArena *arena);
+
+#endif //SHADOWCASTING_H
@@ -1,5 +1,6 @@
 #include "tilemap.h"
 #include "base/line.h"
+#include "base/maths.h"
 #include "base/dynamic_array.h"
 #include "base/vector.h"
 #include "world.h"
@@ -61,6 +62,8 @@ void tilemap_insert_tile(Tilemap *tilemap, Vector2i coords, TileType type, Linea
     tilemap->min_y = MIN(tilemap->min_y, coords.y);
     tilemap->max_x = MAX(tilemap->max_x, coords.x);
     tilemap->max_y = MAX(tilemap->max_y, coords.y);
+
+    ++tilemap->version;
 }
 
 Tile *tilemap_get_tile(Tilemap *tilemap, Vector2i coords)
@@ -262,3 +265,46 @@ EdgePool tilemap_get_edge_list(Tilemap *tilemap, Allocator alloc)
 
     return edge_pool;
 }
+
+// https://lodev.org/cgtutor/raycasting.html
+TileWalk tile_walk_begin(Vector2 origin, Vector2 delta)
+{
+    f32 tile_x = origin.x / (f32)TILE_SIZE;
+    f32 tile_y = origin.y / (f32)TILE_SIZE;
+    f32 dir_x = delta.x / (f32)TILE_SIZE;
+    f32 dir_y = delta.y / (f32)TILE_SIZE;
+
+    TileWalk result = {0};
+    result.tile = v2i((s32)floorf(tile_x), (s32)floorf(tile_y));
+    result.step = v2i((dir_x < 0.0f) ? -1 : 1, (dir_y < 0.0f) ? -1 : 1);
+
+    result.fraction_per_tile_x = (dir_x == 0.0f) ? INFINITY : 1.0f / abs_f32(dir_x);
+    result.fraction_per_tile_y = (dir_y == 0.0f) ? INFINITY : 1.0f / abs_f32(dir_y);
+
+    f32 dist_to_side_x = (dir_x < 0.0f)
+        ? (tile_x - (f32)result.tile.x)
+        : ((f32)result.tile.x + 1.0f - tile_x);
+    f32 dist_to_side_y = (dir_y < 0.0f)
+        ? (tile_y - (f32)result.tile.y)
+        : ((f32)result.tile.y + 1.0f - tile_y);
+
+    result.next_fraction_x = (dir_x == 0.0f) ? INFINITY : dist_to_side_x * result.fraction_per_tile_x;
+    result.next_fraction_y = (dir_y == 0.0f) ? INFINITY : dist_to_side_y * result.fraction_per_tile_y;
+
+    return result;
+}
+
+// Moves into the next tile along the line. The walk never ends by itself, callers stop
+// once the fraction is past the end of the line.
+void tile_walk_next(TileWalk *walk)
+{
+    if (walk->next_fraction_x < walk->next_fraction_y) {
+        walk->fraction = walk->next_fraction_x;
+        walk->next_fraction_x += walk->fraction_per_tile_x;
+        walk->tile.x += walk->step.x;
+    } else {
+        walk->fraction = walk->next_fraction_y;
+        walk->next_fraction_y += walk->fraction_per_tile_y;
+        walk->tile.y += walk->step.y;
+    }
+}
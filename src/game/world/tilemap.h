@@ -13,7 +13,6 @@
 /*
   TODO:
   - Don't return dynamic array from tilemap_get_edge_list
-  - Prebake static lights into texture
  */
 
 typedef struct {
@@ -56,12 +55,28 @@ typedef struct Tilemap {
     s32 min_y;
     s32 max_x;
     s32 max_y;
+
+    u64 version; // Incremented whenever tiles change, used for invalidating cached lighting
 } Tilemap;
 
+// Grid traversal of the tiles a line passes through, in order. Fractions are along the
+// delta the walk was started with.
+typedef struct {
+    Vector2i tile;             // The tile the walk is currently in
+    f32      fraction;         // Where the current tile was entered, zero for the first one
+    Vector2i step;
+    f32      fraction_per_tile_x;
+    f32      fraction_per_tile_y;
+    f32      next_fraction_x;  // Where the next tile boundary on each axis is crossed
+    f32      next_fraction_y;
+} TileWalk;
+
 void   tilemap_initialize(Tilemap *tilemap);
 void   tilemap_insert_tile(Tilemap *tilemap, Vector2i coords, TileType type, LinearArena *arena);
 Tile  *tilemap_get_tile(Tilemap *tilemap, Vector2i coords);
 Rectangle tilemap_get_bounding_box(const Tilemap *tilemap);
 EdgePool tilemap_get_edge_list(Tilemap *tilemap, Allocator alloc);
+TileWalk tile_walk_begin(Vector2 origin, Vector2 delta);
+void     tile_walk_next(TileWalk *walk);
 
 #endif //TILEMAP_H
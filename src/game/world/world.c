@@ -69,6 +69,32 @@ static Rectangle get_tile_rectangle_in_world_space(Vector2i tile_coords)
     return result;
 }
 
+// Entities with components that act on contact always need to search for collisions
+// themselves, even when standing still
+#define NON_RESTING_COMPONENTS (component_id(DamageFieldComponent) \
+    | component_id(EffectApplierComponent) | component_id(EventListenerComponent))
+
+static b32 entity_is_resting(Entity *entity, PhysicsComponent *physics)
+{
+    b32 result = v2_is_zero(physics->velocity)
+        && ((entity->active_components & NON_RESTING_COMPONENTS) == 0);
+
+    return result;
+}
+
+static QuadTree *get_entity_quad_tree(World *world, ssize alive_entity_index)
+{
+    ASSERT(alive_entity_index < world->alive_entity_count);
+
+    QuadTree *result = &world->quad_tree;
+
+    if (world->alive_entity_is_resting[alive_entity_index]) {
+        result = &world->resting_quad_tree;
+    }
+
+    return result;
+}
+
 static void world_update_entity_quad_tree_location(World *world, ssize alive_entity_index)
 {
     ASSERT(alive_entity_index < world->alive_entity_count);
@@ -79,17 +105,67 @@ static void world_update_entity_quad_tree_location(World *world, ssize alive_ent
 
     PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
     QuadTreeLocation *loc = &world->alive_entity_quad_tree_locations[alive_entity_index];
+    b32 *is_resting = &world->alive_entity_is_resting[alive_entity_index];
 
     if (physics) {
         Rectangle entity_area = world_get_entity_bounding_box(entity, physics);
+        CollisionFilter filter = collision_filter_ignore_all();
+
+        if (es_has_component(entity, ColliderComponent)) {
+            ColliderComponent *collider = es_get_component(entity, ColliderComponent);
+            filter = collider->collision_filter;
+        }
+
+        b32 should_rest = entity_is_resting(entity, physics);
+
+        if (should_rest) {
+            ++world->broadphase_stats.resting_entities;
+        }
+
+        if (!qt_location_is_null(*loc)) {
+            b32 unchanged = should_rest && *is_resting
+                && rect_eq(loc->element->area, entity_area)
+                && collision_filters_equal(loc->element->collision_filter, filter);
+
+            if (unchanged) {
+                // Resting entity is already where it should be
+                ++world->broadphase_stats.relocations_skipped;
+                return;
+            }
+
+            if (should_rest != *is_resting) {
+                *loc = qt_remove_entity(get_entity_quad_tree(world, alive_entity_index), id, *loc);
+            }
+        }
 
-        *loc = qt_set_entity_area(&world->quad_tree, id, *loc, entity_area, &world->world_arena);
+        *is_resting = should_rest;
+        *loc = qt_set_entity_area(get_entity_quad_tree(world, alive_entity_index), id, *loc,
+            entity_area, filter, &world->world_arena);
+
+        ++world->broadphase_stats.relocations;
     } else if (!qt_location_is_null(*loc)) {
         // Entity doesn't have PhysicsComponent but still exists in quad tree, remove it
-        *loc = qt_remove_entity(&world->quad_tree, id, *loc);
+        *loc = qt_remove_entity(get_entity_quad_tree(world, alive_entity_index), id, *loc);
+    }
+}
+
+void world_update_quad_tree_locations(World *world)
+{
+    for (ssize i = 0; i < world->alive_entity_count; ++i) {
+        world_update_entity_quad_tree_location(world, i);
     }
 }
 
+EntityIDList world_get_entities_in_area(World *world, Rectangle area, LinearArena *arena)
+{
+    EntityIDList result = qt_get_entities_in_area(&world->quad_tree, area, arena);
+    EntityIDList resting = qt_get_entities_in_area(&world->resting_quad_tree, area, arena);
+
+    entity_id_list_append(&result, resting);
+
+    return result;
+}
+
 EntityWithID world_spawn_non_spatial_entity(World *world, EntityFaction faction)
 {
     ASSERT(faction >= 0);
@@ -101,9 +177,24 @@ EntityWithID world_spawn_non_spatial_entity(World *world, EntityFaction faction)
     ssize alive_index = world->alive_entity_count++;
     world->alive_entity_ids[alive_index] = result.id;
     world->alive_entity_quad_tree_locations[alive_index] = QT_NULL_LOCATION;
+    world->alive_entity_is_resting[alive_index] = false;
+
+    return result;
+}
+
+Vector2 world_get_entity_render_position(World *world, EntityID id, PhysicsComponent *physics)
+{
+    Vector2 result = physics->position;
+
+    // Entities spawned since the last tick started have nothing to interpolate from
+    if (entity_id_equal(world->previous_tick_entity_ids[id.index], id)) {
+        result = v2_lerp(world->previous_tick_positions[id.index], physics->position,
+            world->render_interpolation);
+    }
 
     return result;
 }
+
 EntityWithID world_spawn_entity(World *world, Vector2 position, EntityFaction faction)
 {
     EntityWithID result = world_spawn_non_spatial_entity(world, faction);
@@ -210,16 +301,18 @@ static void world_remove_entity(World *world, ssize alive_entity_index, LinearAr
 
     handle_entity_removal_side_effects(world, *id, frame_arena);
 
+    remove_trigger_cooldowns_of_entity(&world->trigger_cooldowns, *id);
     es_remove_entity(&world->entity_system, *id);
 
     QuadTreeLocation *qt_location = &world->alive_entity_quad_tree_locations[alive_entity_index];
 
     if (!qt_location_is_null(*qt_location)) {
-        qt_remove_entity(&world->quad_tree, *id, *qt_location);
+        qt_remove_entity(get_entity_quad_tree(world, alive_entity_index), *id, *qt_location);
     }
 
     ssize last_index = world->alive_entity_count - 1;
     *qt_location = world->alive_entity_quad_tree_locations[last_index];
+    world->alive_entity_is_resting[alive_entity_index] = world->alive_entity_is_resting[last_index];
 
     *id = world->alive_entity_ids[last_index];
 
@@ -374,7 +467,7 @@ static void entity_update(World *world, ssize alive_entity_index, f32 dt, Linear
 
     if (es_has_component(entity, AIComponent)) {
 	AIComponent *ai = es_get_component(entity, AIComponent);
-	entity_update_ai(world, entity, ai);
+	entity_update_ai(world, entity, ai, frame_arena);
     }
 
     if (es_has_components(entity, component_id(ParticleSpawner) | component_id(PhysicsComponent))) {
@@ -417,21 +510,33 @@ static void entity_update(World *world, ssize alive_entity_index, f32 dt, Linear
     }
 }
 
-static void entity_render(Entity *entity, RenderBatches rbs,
-    LinearArena *scratch, struct DebugState *debug_state, World *world)
+// Static lights stop being baked once they start fading out
+static b32 light_is_baked(const LightSource *light)
 {
-    PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
+    b32 result = light->is_static && !light->fading_out;
 
-    if (!physics) {
+    return result;
+}
+
+static void entity_render(Entity *entity, EntityID id, RenderBatches rbs,
+    struct DebugState *debug_state, World *world)
+{
+    PhysicsComponent *simulated_physics = es_get_component(entity, PhysicsComponent);
+
+    if (!simulated_physics) {
         // Can't render a non-spatial entity
         return;
     }
 
+    PhysicsComponent render_physics = *simulated_physics;
+    render_physics.position = world_get_entity_render_position(world, id, simulated_physics);
+    PhysicsComponent *physics = &render_physics;
+
     if (es_has_component(entity, AnimationComponent)) {
         AnimationComponent *anim_component = es_get_component(entity, AnimationComponent);
         AnimationInstance *anim_instance = &anim_component->current_animation;
 
-	anim_render_instance(anim_instance, physics, rbs.world_rb, scratch);
+	anim_render_instance(anim_instance, physics, rbs.world_rb);
     } else if (es_has_component(entity, SpriteComponent)) {
         SpriteComponent *sprite_comp = es_get_component(entity, SpriteComponent);
 	Sprite *sprite = &sprite_comp->sprite;
@@ -439,7 +544,7 @@ static void entity_render(Entity *entity, RenderBatches rbs,
 	SpriteModifiers sprite_mods = sprite_get_modifiers(physics->direction, sprite->rotation_behaviour);
 
         Rectangle sprite_rect = { physics->position, sprite->size };
-        draw_colored_sprite(rbs.world_rb, scratch, sprite->texture, sprite_rect, sprite_mods,
+        draw_colored_sprite(rbs.world_rb, sprite->texture, sprite_rect, sprite_mods,
 	    sprite->color, shader_handle(TEXTURE_SHADER), RENDER_LAYER_ENTITIES);
     }
 
@@ -452,7 +557,11 @@ static void entity_render(Entity *entity, RenderBatches rbs,
             PhysicsComponent *next_link_physics = es_get_component(next_link, PhysicsComponent);
 
             if (next_link_physics) {
-                draw_line(rbs.worldspace_ui_rb, scratch, physics->position, next_link_physics->position,
+                EntityID next_link_id = es_get_id_of_entity(&world->entity_system, next_link);
+                Vector2 next_link_position = world_get_entity_render_position(world, next_link_id,
+                    next_link_physics);
+
+                draw_line(rbs.worldspace_ui_rb, physics->position, next_link_position,
                     RGBA32_WHITE, 4.0f, shader_handle(SHAPE_SHADER), 0);
             }
         }
@@ -466,20 +575,10 @@ static void entity_render(Entity *entity, RenderBatches rbs,
             .size = collider->size
         };
 
-        draw_rectangle(rbs.worldspace_ui_rb, scratch, collider_rect, (RGBA32){0, 1, 0, 0.5f},
+        draw_rectangle(rbs.worldspace_ui_rb, collider_rect, (RGBA32){0, 1, 0, 0.5f},
 	    shader_handle(SHAPE_SHADER), RENDER_LAYER_ENTITIES);
     }
 
-    if (es_has_component(entity, LightEmitter)) {
-        LightEmitter *light = es_get_component(entity, LightEmitter);
-        Rectangle entity_bounds = world_get_entity_bounding_box(entity, physics);
-
-        Vector2 light_origin = get_light_origin_position(entity_bounds);
-
-        // TODO: this might look better if the origin is center of entity
-        render_light_source(world, rbs.lighting_rb, light_origin, light->light, 1.0f, scratch);
-    }
-
     if (debug_state->render_entity_bounds) {
         Rectangle entity_rect = world_get_entity_bounding_box(entity, physics);
         f32 minimum_bounds_rect_size = 4.0f;
@@ -487,14 +586,14 @@ static void entity_render(Entity *entity, RenderBatches rbs,
         entity_rect.size.x = MAX(entity_rect.size.x, minimum_bounds_rect_size);
         entity_rect.size.y = MAX(entity_rect.size.y, minimum_bounds_rect_size);
 
-        draw_rectangle(rbs.worldspace_ui_rb, scratch, entity_rect, (RGBA32){1, 0, 1, 0.4f},
+        draw_rectangle(rbs.worldspace_ui_rb, entity_rect, (RGBA32){1, 0, 1, 0.4f},
 	    shader_handle(SHAPE_SHADER), RENDER_LAYER_ENTITIES);
     }
 
     if (debug_state->render_entity_velocity) {
 	Vector2 dir = v2_norm(physics->velocity);
 
-	draw_line(rbs.worldspace_ui_rb, scratch, physics->position,
+	draw_line(rbs.worldspace_ui_rb, physics->position,
 	    v2_add(physics->position, v2_mul_s(dir, 20.0f)),
             RGBA32_GREEN, 2.0f, shader_handle(SHAPE_SHADER), 0);
     }
@@ -580,11 +679,8 @@ static f32 entity_vs_entity_collision(World *world,
     CollisionInfo collision = collision_rect_vs_rect(movement_fraction_left, rect_a, rect_b,
 	physics_a->velocity, physics_b->velocity, dt);
 
-    b32 same_collision_group = (collider_a->collision_group == collider_b->collision_group)
-	&& (collider_a->collision_group != COLLISION_GROUP_NONE);
-
     if ((collision.collision_status != COLLISION_STATUS_NOT_COLLIDING)
-	&& !same_collision_group && !entities_intersected_this_frame(world, id_a, id_b)) {
+	&& !entities_intersected_this_frame(world, id_a, id_b)) {
 	b32 neither_collider_on_cooldown =
 	    !trigger_is_on_cooldown(&world->trigger_cooldowns, id_a, id_b,
 		component_id(ColliderComponent))
@@ -701,27 +797,40 @@ static void handle_collision_and_movement(World *world, f32 dt, LinearArena *fra
 
         f32 movement_fraction_left = 1.0f;
 
-        if (collider_a && physics_a) {
+        // Resting entities are only tested against by moving entities
+        if (collider_a && physics_a && !entity_is_resting(a, physics_a)) {
             movement_fraction_left = entity_vs_tilemap_collision(a, collider_a, physics_a, world,
 		movement_fraction_left, dt, frame_arena);
 	    ASSERT(movement_fraction_left >= 0.0f);
 
+            // Entities whose collision groups can never interact are culled inside the
+            // quad tree query, so every entity returned here is a potential collision
             Rectangle collision_area = get_entity_collision_area(collider_a, physics_a, dt);
-            EntityIDList entities_in_area =
-		qt_get_entities_in_area(&world->quad_tree, collision_area, frame_arena);
-
-            for (EntityIDNode *node = list_head(&entities_in_area); node; node = list_next(node)) {
-                if (!entity_id_equal(node->id, id_a)) {
-                    Entity *b = es_get_entity(&world->entity_system, node->id);
-
-                    ColliderComponent *collider_b = es_get_component(b, ColliderComponent);
-                    PhysicsComponent *physics_b = es_get_component(b, PhysicsComponent);
-
-                    if (collider_b && physics_b) {
-                        movement_fraction_left = entity_vs_entity_collision(world, a, collider_a,
-                            physics_a, b, collider_b, physics_b, movement_fraction_left,
-                            dt, frame_arena);
-                    }
+            QuadTreeCollisionQuery query = qt_get_colliding_entities_in_area(&world->quad_tree,
+                collision_area, id_a, collider_a->collision_filter, frame_arena);
+            QuadTreeCollisionQuery resting_query = qt_get_colliding_entities_in_area(
+                &world->resting_quad_tree, collision_area, id_a, collider_a->collision_filter, frame_arena);
+
+            world->broadphase_stats.pairs_culled += query.culled_pair_count + resting_query.culled_pair_count;
+            entity_id_list_append(&query.entities, resting_query.entities);
+
+            for (EntityIDNode *node = list_head(&query.entities); node; node = list_next(node)) {
+                ASSERT(!entity_id_equal(node->id, id_a));
+                Entity *b = es_get_entity(&world->entity_system, node->id);
+
+                ColliderComponent *collider_b = es_get_component(b, ColliderComponent);
+                PhysicsComponent *physics_b = es_get_component(b, PhysicsComponent);
+
+                // The quad tree filter is only updated at the end of the frame, so a collider
+                // could have been removed or reconfigured since
+                if (collider_b && physics_b
+                    && collision_filters_can_interact(collider_a->collision_filter,
+                        collider_b->collision_filter)) {
+                    ++world->broadphase_stats.pairs_tested;
+
+                    movement_fraction_left = entity_vs_entity_collision(world, a, collider_a,
+                        physics_a, b, collider_b, physics_b, movement_fraction_left,
+                        dt, frame_arena);
                 }
             }
 
@@ -762,7 +871,9 @@ static Rectangle get_area_visible_to_player(World *world, const FrameData *frame
     return result;
 }
 
-static Rectangle get_area_to_update_and_render(World *world, const FrameData *frame_data)
+// Lights and particles are simulated a little past the camera, so that things coming into
+// view don't pop in
+static Rectangle get_area_to_update(World *world, const FrameData *frame_data)
 {
     f32 margin = (f32)TILE_SIZE * 8.0f;
 
@@ -773,15 +884,39 @@ static Rectangle get_area_to_update_and_render(World *world, const FrameData *fr
     return result;
 }
 
+static void store_previous_tick_positions(World *world)
+{
+    for (EntityIndex i = 0; i < world->alive_entity_count; ++i) {
+        EntityID id = world->alive_entity_ids[i];
+        Entity *entity = es_get_entity(&world->entity_system, id);
+        PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
+
+        if (physics) {
+            world->previous_tick_entity_ids[id.index] = id;
+            world->previous_tick_positions[id.index] = physics->position;
+        } else {
+            world->previous_tick_entity_ids[id.index] = NULL_ENTITY_ID;
+        }
+    }
+}
+
 void world_update(World *world, const FrameData *frame_data, LinearArena *frame_arena)
 {
     if (world->alive_entity_count < 1) {
         return;
     }
 
+    world->broadphase_stats = zero_struct(BroadphaseStats);
+    los_cache_begin_frame(&world->line_of_sight_cache);
+    particle_pool_begin_tick(&world->particle_pool, frame_data->dt);
+
+    store_previous_tick_positions(world);
+
     // TODO: only update in certain area around player
     handle_collision_and_movement(world, frame_data->dt, frame_arena);
 
+    ai_acquire_targets(world, frame_arena);
+
     // TODO: should any newly spawned entities be updated this frame?
     EntityIndex entity_count = world->alive_entity_count;
 
@@ -792,12 +927,17 @@ void world_update(World *world, const FrameData *frame_data, LinearArena *frame_
     hitsplats_update(world, frame_data);
 
     ChunkPtrArray visible_chunks = get_chunks_in_area(&world->map_chunks,
-        get_area_to_update_and_render(world, frame_data), frame_arena);
+        get_area_to_update(world, frame_data), frame_arena);
 
     for (ssize i = 0; i < visible_chunks.count; ++i) {
         Chunk *chunk = visible_chunks.chunks[i];
 
-        update_particle_buffers(&chunk->particle_buffers, frame_data->dt);
+        catch_up_chunk_particles(&world->particle_pool, chunk, world->particle_pool.tick);
+    }
+
+    // Only after every chunk has been updated, so that no particle is moved twice
+    for (ssize i = 0; i < visible_chunks.count; ++i) {
+        rebin_chunk_particles(&world->particle_pool, &world->map_chunks, visible_chunks.chunks[i]);
     }
 
     update_trigger_cooldowns(world, frame_data->dt);
@@ -820,173 +960,469 @@ void world_update(World *world, const FrameData *frame_data, LinearArena *frame_
        that were spawned during the frame have the correct quad tree location and are therefore
        rendered if they are on screen.
     */
-    for (ssize i = 0; i < world->alive_entity_count; ++i) {
-        world_update_entity_quad_tree_location(world, i);
+    world_update_quad_tree_locations(world);
+}
+
+// Walls with a visible entity behind them are drawn transparent, and aren't kept out of
+// the lighting
+static QuadOverlay find_transparent_wall_tops(World *world, ChunkTileGeometry *geometry,
+    LinearArena *arena)
+{
+    QuadOverlay result = {0};
+    s32 *quads = la_allocate_array(arena, s32, MAX(geometry->wall_tops.quad_count, 1));
+
+    for (ssize i = 0; i < geometry->wall_tops.quad_count; ++i) {
+        WallTopInfo *wall = &geometry->wall_top_infos[i];
+
+        if (!wall->can_walk_behind) {
+            continue;
+        }
+
+        EntityIDList entities_near_tile = world_get_entities_in_area(world, wall->top_segment, arena);
+
+        for (EntityIDNode *node = list_head(&entities_near_tile); node; node = list_next(node)) {
+            Entity *entity = es_get_entity(&world->entity_system, node->id);
+            PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
+
+            // Entity could technically exist (I think) in quad tree despite not having
+            // a physics component if it was removed mid-frame and we haven't updated all
+            // quad tree locations yet, so we probably just ignore it
+            ASSERT(physics);
+            if (physics) {
+                Rectangle entity_bounds = world_get_entity_bounding_box(entity, physics);
+                b32 entity_intersects_wall = rect_intersects(entity_bounds, wall->top_segment);
+
+                b32 entity_is_behind_wall = entity_intersects_wall
+                    && (physics->position.y > wall->base_y);
+
+                b32 entity_is_visible = es_has_component(entity, AnimationComponent)
+                    || es_has_component(entity, SpriteComponent);
+
+                if (entity_is_behind_wall && entity_is_visible) {
+                    quads[result.count++] = (s32)i;
+                    break;
+                }
+            }
+            // TODO: only do this if it's the player?
+            // TODO: get sprite rect instead of all component bounds?
+        }
     }
+
+    result.quads = quads;
+
+    return result;
 }
 
-static void render_tilemap(World *world, RenderBatches rb_list, const FrameData *frame_data,
+// The geometry of the chunk has to be up to date, it can't be rebuilt from worker threads
+static void render_chunk_tiles(World *world, RenderBatches rb_list, Chunk *chunk,
     LinearArena *frame_arena)
 {
-    Rectangle tilemap_render_area = get_area_visible_to_player(world, frame_data);
-    tilemap_render_area.position = v2_sub(tilemap_render_area.position, v2(TILE_SIZE, TILE_SIZE));
-    tilemap_render_area.size = v2_add(tilemap_render_area.size, v2(TILE_SIZE * 2, TILE_SIZE * 2));
+    ChunkTileGeometry *geometry = &chunk->tile_geometry;
+    ASSERT(!chunk_tile_geometry_is_stale(chunk, &world->tilemap));
+
+    TextureHandle wall_texture = texture_handle(WALL_TEXTURE);
+    ShaderHandle texture_shader = shader_handle(TEXTURE_SHADER);
+    QuadOverlay no_overlay = {0};
 
-    Vector2i min_tile = world_to_tile_coords(rect_bottom_left(tilemap_render_area));
-    Vector2i max_tile = world_to_tile_coords(rect_top_right(tilemap_render_area));
+    if (geometry->floors.quad_count > 0) {
+        draw_static_quads(rb_list.world_rb, texture_handle(FLOOR_TEXTURE), geometry->floors.vertices,
+            geometry->floors.quad_count, no_overlay, texture_shader, RENDER_LAYER_FLOORS);
+    }
 
-    s32 min_x = min_tile.x;
-    s32 max_x = max_tile.x;
-    s32 min_y = min_tile.y;
-    s32 max_y = max_tile.y;
+    if (geometry->wall_tops.quad_count > 0) {
+        draw_static_quads(rb_list.world_rb, wall_texture, geometry->wall_bases.vertices,
+            geometry->wall_bases.quad_count, no_overlay, texture_shader, RENDER_LAYER_FLOORS);
 
-    for (s32 y = min_y; y <= max_y; ++y) {
-        for (s32 x = min_x; x <= max_x; ++x) {
-            Vector2i tile_coords = {x, y};
-            Tile *tile = tilemap_get_tile(&world->tilemap, tile_coords);
+        QuadOverlay transparent_walls = find_transparent_wall_tops(world, geometry, frame_arena);
+        transparent_walls.alpha = 0.5f;
 
-            if (tile) {
-                TextureHandle texture = {0};
+        draw_static_quads(rb_list.world_rb, wall_texture, geometry->wall_tops.vertices,
+            geometry->wall_tops.quad_count, transparent_walls, texture_shader, RENDER_LAYER_WALLS);
 
-                switch (tile->type) {
-                    case TILE_FLOOR: {
-                        texture = texture_handle(FLOOR_TEXTURE);
-                    } break;
+        // Render top segments to lighting stencil buffer so that wall top sides are never lit,
+        // unless the wall is transparent
+        QuadOverlay lit_walls = transparent_walls;
+        lit_walls.alpha = 0.0f;
 
-                    case TILE_WALL: {
-                        texture = texture_handle(WALL_TEXTURE);
-                    } break;
+        draw_static_quads(rb_list.lighting_stencil_rb, NULL_TEXTURE, geometry->wall_tops.vertices,
+            geometry->wall_tops.quad_count, lit_walls, shader_handle(SHAPE_SHADER), RENDER_LAYER_WALLS);
+    }
+}
 
-                        INVALID_DEFAULT_CASE;
-                }
+// Lights are culled against the camera and limited by the light budget before anything
+// is generated for them
+static ssize collect_lights_to_render(World *world, EntityIDList *entities, Rectangle visible_area,
+    LightCandidate **result_lights, LinearArena *frame_arena)
+{
+    LightCandidate *lights = la_allocate_array(frame_arena, LightCandidate, MAX_ENTITIES);
+    ssize light_count = 0;
 
-                Rectangle tile_rect = {
-                    .position = tile_to_world_coords(tile_coords),
-                    .size = { (f32)TILE_SIZE, (f32)TILE_SIZE }
-                };
+    for (EntityIDNode *node = list_head(entities); node; node = list_next(node)) {
+        Entity *entity = es_get_entity(&world->entity_system, node->id);
+        LightEmitter *emitter = es_get_component(entity, LightEmitter);
+        PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
 
-                RenderLayer layer = RENDER_LAYER_FLOORS;
+        if (!emitter || !physics) {
+            continue;
+        }
 
-                if (tile->type == TILE_WALL) {
-                    tile_rect.size.y += TILE_SIZE;
-                    layer = RENDER_LAYER_WALLS;
-                }
+        PhysicsComponent render_physics = *physics;
+        render_physics.position = world_get_entity_render_position(world, node->id, physics);
+        Rectangle entity_bounds = world_get_entity_bounding_box(entity, &render_physics);
 
-                if (tile->type == TILE_FLOOR) {
-                    draw_sprite(rb_list.world_rb, frame_arena, texture, tile_rect, (SpriteModifiers){0},
-                        shader_handle(TEXTURE_SHADER), layer);
-                } else if (tile->type == TILE_WALL) {
-                    Tile *tile_above = tilemap_get_tile(&world->tilemap,
-                        (Vector2i){tile_coords.x, tile_coords.y + 1});
-                    b32 can_walk_behind_tile = tile_above && (tile_above->type == TILE_FLOOR);
-
-                    Rectangle bottom_segment = {
-                        tile_rect.position,
-                        {tile_rect.size.x, tile_rect.size.y / 2}
-                    };
-
-                    Rectangle top_segment = {
-                        v2_add(bottom_segment.position, v2(0, bottom_segment.size.y)),
-                        bottom_segment.size
-                    };
-
-                    EntityIDList entities_near_tile =
-			qt_get_entities_in_area(&world->quad_tree, top_segment, frame_arena);
-
-                    b32 make_wall_transparent = false;
-
-                    for (EntityIDNode *node = list_head(&entities_near_tile); node; node = list_next(node)) {
-                        Entity *entity = es_get_entity(&world->entity_system, node->id);
-                        PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
-
-                        // Entity could technically exist (I think) in quad tree despite not having
-                        // a physics component if it was removed mid-frame and we haven't updated all
-                        // quad tree locations yet, so we probably just ignore it
-                        ASSERT(physics);
-                        if (physics) {
-                            Rectangle entity_bounds = world_get_entity_bounding_box(entity, physics);
-                            b32 entity_intersects_wall = rect_intersects(entity_bounds, top_segment);
-
-                            b32 entity_is_behind_wall = can_walk_behind_tile
-                                && entity_intersects_wall
-                                && (physics->position.y > tile_rect.position.y);
-
-                            b32 entity_is_visible = es_has_component(entity, AnimationComponent)
-                                || es_has_component(entity, SpriteComponent);
-
-                            if (entity_is_behind_wall && entity_is_visible) {
-                                make_wall_transparent = true;
-                                break;
-                            }
-                        }
-                        // TODO: only do this if it's the player?
-                        // TODO: get sprite rect instead of all component bounds?
-                    }
-
-                    draw_clipped_sprite(rb_list.world_rb, frame_arena, texture,
-                        tile_rect, bottom_segment, RGBA32_WHITE, shader_handle(TEXTURE_SHADER),
-			RENDER_LAYER_FLOORS);
-
-                    RGBA32 top_segment_color = RGBA32_WHITE;
-
-                    // If entity is behind wall, make top segment slightly transparent
-                    if (make_wall_transparent) {
-                        top_segment_color.a = 0.5f;
-                    }
-
-                    draw_clipped_sprite(rb_list.world_rb, frame_arena, texture,
-                        tile_rect, top_segment, top_segment_color, shader_handle(TEXTURE_SHADER),
-			RENDER_LAYER_WALLS);
-
-                    if (!make_wall_transparent) {
-                        // Render top segment to lighting stencil buffer so that wall top sides are never lit,
-                        // unless the wall is transparent
-                        draw_rectangle(rb_list.lighting_stencil_rb, frame_arena, top_segment, RGBA32_BLACK,
-                            shader_handle(SHAPE_SHADER), RENDER_LAYER_WALLS);
-                    }
-
-                } else {
-                    ASSERT(0);
-                }
+        // TODO: this might look better if the origin is center of entity
+        Vector2 origin = get_light_origin_position(entity_bounds);
+        Rectangle *clip_areas = 0;
+        ssize clip_area_count = 0;
+
+        // Static lights are baked into the lightmaps, so they're only drawn here inside the
+        // chunks whose bake is still pending
+        if (light_is_baked(&emitter->light)) {
+            f32 radius = emitter->light.radius;
+            Rectangle light_bounds = {v2_sub(origin, v2(radius, radius)), v2(2.0f * radius, 2.0f * radius)};
+
+            clip_areas = la_allocate_array(frame_arena, Rectangle, MAX(world->lightmaps.count, 1));
+            clip_area_count = lightmaps_get_unbaked_areas(&world->lightmaps, light_bounds, clip_areas,
+                world->lightmaps.count);
+
+            if (clip_area_count == 0) {
+                continue;
             }
         }
+
+        ASSERT(light_count < MAX_ENTITIES);
+        LightCandidate *light = &lights[light_count++];
+        light->entity = node->id;
+        light->origin = origin;
+        light->light = emitter->light;
+        light->clip_areas = clip_areas;
+        light->clip_area_count = clip_area_count;
     }
 
+    f32 world_to_screen_scale = 1.0f + world->camera.zoom;
+    *result_lights = lights;
+
+    ssize result = select_lights_to_render(lights, light_count, visible_area, world_to_screen_scale,
+        world->light_settings, &world->light_stats, frame_arena);
+
+    return result;
 }
 
-void world_render(World *world, RenderBatches rb_list, const FrameData *frame_data,
+// Visibility polygons of all raycasted lights about to be rendered are generated up front on
+// worker threads, so that rendering only has to look them up in the cache
+static void generate_visibility_polygons(World *world, const LightCandidate *lights,
+    ssize light_count, PlatformCode platform_code, LinearArena *frame_arena)
+{
+    VisibilityRequest *requests = la_allocate_array(frame_arena, VisibilityRequest, MAX(light_count, 1));
+    ssize request_count = 0;
+
+    for (ssize i = 0; i < light_count; ++i) {
+        const LightCandidate *light = &lights[i];
+
+        if (light->light.kind != LIGHT_RAYCASTED) {
+            continue;
+        }
+
+        VisibilityRequest *request = &requests[request_count++];
+        request->light_entity = light->entity;
+        request->origin = light->origin;
+        request->light = light->light;
+    }
+
+    visibility_cache_generate_polygons(&world->visibility_cache, requests, request_count,
+        &world->tilemap, platform_code, frame_arena);
+}
+
+static void render_lights(World *world, RenderBatch *rb, const LightCandidate *lights,
+    ssize light_count, LinearArena *frame_arena)
+{
+    for (ssize i = 0; i < light_count; ++i) {
+        const LightCandidate *light = &lights[i];
+
+        render_light_source(world, rb, light->entity, light->origin, light->light, 1.0f,
+            light->clip_areas, light->clip_area_count, frame_arena);
+    }
+}
+
+typedef enum {
+    WORLD_RENDER_JOB_TILES,
+    WORLD_RENDER_JOB_PARTICLES,
+    WORLD_RENDER_JOB_ENTITIES,
+} WorldRenderJobKind;
+
+typedef enum {
+    WORLD_RENDER_TARGET_WORLD,
+    WORLD_RENDER_TARGET_OVERLAY,
+    WORLD_RENDER_TARGET_LIGHTING,
+    WORLD_RENDER_TARGET_LIGHTING_STENCIL,
+    WORLD_RENDER_TARGET_WORLDSPACE_UI,
+    WORLD_RENDER_TARGET_COUNT,
+} WorldRenderTarget;
+
+typedef struct {
+    WorldRenderJobKind  kind;
+    World              *world;
+    struct DebugState  *debug_state;
+    LinearArena        *arena;
+
+    // Range of tile chunks or entities, depending on the kind of job
+    ssize               first;
+    ssize               end;
+
+    ChunkPtrArray       tile_chunks;
+    ChunkPtrArray       visible_chunks;
+    ChunkPtrArray       lit_chunks;
+    const EntityID     *entities;
+
+    RenderBatch         batches[WORLD_RENDER_TARGET_COUNT];
+    RenderBatches       rbs;
+} WorldRenderJob;
+
+static void get_world_render_targets(RenderBatches rbs, RenderBatch *targets[WORLD_RENDER_TARGET_COUNT])
+{
+    targets[WORLD_RENDER_TARGET_WORLD] = rbs.world_rb;
+    targets[WORLD_RENDER_TARGET_OVERLAY] = rbs.overlay_rb;
+    targets[WORLD_RENDER_TARGET_LIGHTING] = rbs.lighting_rb;
+    targets[WORLD_RENDER_TARGET_LIGHTING_STENCIL] = rbs.lighting_stencil_rb;
+    targets[WORLD_RENDER_TARGET_WORLDSPACE_UI] = rbs.worldspace_ui_rb;
+}
+
+static void initialize_world_render_job(WorldRenderJob *job, WorldRenderJobKind kind, World *world,
+    RenderBatches rb_list, LinearArena *arena)
+{
+    job->kind = kind;
+    job->world = world;
+    job->arena = arena;
+
+    RenderBatch *targets[WORLD_RENDER_TARGET_COUNT];
+    get_world_render_targets(rb_list, targets);
+
+    for (ssize i = 0; i < WORLD_RENDER_TARGET_COUNT; ++i) {
+        ASSERT(targets[i]);
+        job->batches[i] = create_partial_render_batch(targets[i], arena);
+    }
+
+    job->rbs.world_rb = &job->batches[WORLD_RENDER_TARGET_WORLD];
+    job->rbs.overlay_rb = &job->batches[WORLD_RENDER_TARGET_OVERLAY];
+    job->rbs.lighting_rb = &job->batches[WORLD_RENDER_TARGET_LIGHTING];
+    job->rbs.lighting_stencil_rb = &job->batches[WORLD_RENDER_TARGET_LIGHTING_STENCIL];
+    job->rbs.worldspace_ui_rb = &job->batches[WORLD_RENDER_TARGET_WORLDSPACE_UI];
+}
+
+static void world_render_job(void *data)
+{
+    WorldRenderJob *job = data;
+    World *world = job->world;
+
+    switch (job->kind) {
+        case WORLD_RENDER_JOB_TILES: {
+            for (ssize i = job->first; i < job->end; ++i) {
+                render_chunk_tiles(world, job->rbs, job->tile_chunks.chunks[i], job->arena);
+            }
+        } break;
+
+        case WORLD_RENDER_JOB_PARTICLES: {
+            for (ssize i = 0; i < job->visible_chunks.count; ++i) {
+                render_particles(&job->visible_chunks.chunks[i]->particle_buffers, job->rbs);
+            }
+
+            // Particle lights are small, so only the chunks under the camera need them
+            for (ssize i = 0; i < job->lit_chunks.count; ++i) {
+                render_light_emitting_particles(&job->lit_chunks.chunks[i]->particle_buffers, job->rbs);
+            }
+        } break;
+
+        case WORLD_RENDER_JOB_ENTITIES: {
+            for (ssize i = job->first; i < job->end; ++i) {
+                EntityID id = job->entities[i];
+                Entity *entity = es_get_entity(&world->entity_system, id);
+
+                entity_render(entity, id, job->rbs, job->debug_state, world);
+            }
+        } break;
+
+        INVALID_DEFAULT_CASE;
+    }
+
+    // Sorting is done here so that only merging is left for the main thread
+    for (ssize i = 0; i < WORLD_RENDER_TARGET_COUNT; ++i) {
+        sort_render_entries(&job->batches[i], job->arena);
+    }
+}
+
+static b32 entity_is_visible(World *world, EntityID id, Rectangle visible_area)
+{
+    Entity *entity = es_get_entity(&world->entity_system, id);
+    PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
+
+    if (!physics) {
+        return false;
+    }
+
+    PhysicsComponent render_physics = *physics;
+    render_physics.position = world_get_entity_render_position(world, id, physics);
+    Rectangle bounds = world_get_entity_bounding_box(entity, &render_physics);
+
+    b32 result = rect_intersects(bounds, visible_area);
+
+    return result;
+}
+
+// Tiles, particles and entities are split into jobs in the order they would be recorded
+// in serially, and the batches of the jobs are merged in that same order, so the result
+// doesn't depend on how the work was split up
+static void record_world_in_parallel(World *world, RenderBatches rb_list, Rectangle visible_area,
+    Rectangle update_area, EntityIDList *entities, PlatformCode platform_code,
     LinearArena *frame_arena, struct DebugState *debug_state)
 {
-    Rectangle render_area = get_area_to_update_and_render(world, frame_data);
+    // Tiles and particles may stick out of their chunk a little
+    Rectangle chunk_render_area = visible_area;
+    chunk_render_area.position = v2_sub(chunk_render_area.position, v2(TILE_SIZE, TILE_SIZE));
+    chunk_render_area.size = v2_add(chunk_render_area.size, v2(TILE_SIZE * 2, TILE_SIZE * 2));
 
-    // TODO: move this and similar things to game.c
-    if (debug_state->render_camera_bounds) {
-        Rectangle visible_area = get_area_visible_to_player(world, frame_data);
+    ChunkPtrArray tile_chunks = get_chunks_in_area(&world->map_chunks, chunk_render_area, frame_arena);
+    ssize update_chunk_count = get_chunks_in_area(&world->map_chunks, update_area, frame_arena).count;
 
-        draw_outlined_rectangle(rb_list.worldspace_ui_rb, frame_arena, visible_area,
-            RGBA32_GREEN, 4.0f / (1.0f + world->camera.zoom), shader_handle(SHAPE_SHADER), 0);
+    world->cull_stats.chunks_drawn = tile_chunks.count;
+    world->cull_stats.chunks_culled = MAX(update_chunk_count - tile_chunks.count, 0);
 
-        draw_outlined_rectangle(rb_list.worldspace_ui_rb, frame_arena, render_area,
-            RGBA32_RED, 4.0f / (1.0f + world->camera.zoom), shader_handle(SHAPE_SHADER), 0);
+    // Geometry is only rebuilt after the tilemap changes, and the allocator isn't thread safe
+    for (ssize i = 0; i < tile_chunks.count; ++i) {
+        Chunk *chunk = tile_chunks.chunks[i];
+
+        if (chunk_tile_geometry_is_stale(chunk, &world->tilemap)) {
+            build_chunk_tile_geometry(&world->map_chunks, chunk, &world->tilemap,
+                world->tile_geometry_allocator);
+        }
     }
 
-    render_tilemap(world, rb_list, frame_data, frame_arena);
+    ssize entity_count = 0;
+    EntityID *entity_ids = la_allocate_array(frame_arena, EntityID, MAX_ENTITIES);
 
-    ChunkPtrArray visible_chunks = get_chunks_in_area(&world->map_chunks, render_area, frame_arena);
-    for (ssize i = 0; i < visible_chunks.count; ++i) {
-        Chunk *chunk = visible_chunks.chunks[i];
+    // Chain links are drawn towards the next link, which may be on screen even if this one isn't
+    b32 cull_entities = !debug_state->render_chain_links;
+
+    for (EntityIDNode *node = list_head(entities); node; node = list_next(node)) {
+        if (cull_entities && !entity_is_visible(world, node->id, visible_area)) {
+            ++world->cull_stats.entities_culled;
+            continue;
+        }
 
-        render_particle_buffers(&chunk->particle_buffers, rb_list, frame_arena);
+        ASSERT(entity_count < MAX_ENTITIES);
+        entity_ids[entity_count++] = node->id;
     }
 
-    EntityIDList entities_in_area = qt_get_entities_in_area(&world->quad_tree, render_area, frame_arena);
+    world->cull_stats.entities_drawn = entity_count;
 
-    for (EntityIDNode *node = list_head(&entities_in_area); node; node = list_next(node)) {
-        Entity *entity = es_get_entity(&world->entity_system, node->id);
+    WorldRenderJob *jobs = la_allocate_array(frame_arena, WorldRenderJob, WORLD_RENDER_JOB_COUNT);
+    ssize job_count = 0;
+
+    for (ssize i = 0; i < WORLD_RENDER_JOB_COUNT; ++i) {
+        la_reset(&world->render_job_arenas[i]);
+    }
+
+    for (ssize i = 0; i < WORLD_RENDER_TILE_JOB_COUNT; ++i) {
+        WorldRenderJob *job = &jobs[job_count];
+        initialize_world_render_job(job, WORLD_RENDER_JOB_TILES, world, rb_list,
+            &world->render_job_arenas[job_count]);
+        ++job_count;
+
+        job->first = (tile_chunks.count * i) / WORLD_RENDER_TILE_JOB_COUNT;
+        job->end = (tile_chunks.count * (i + 1)) / WORLD_RENDER_TILE_JOB_COUNT;
+        job->tile_chunks = tile_chunks;
+    }
+
+    {
+        WorldRenderJob *job = &jobs[job_count];
+        initialize_world_render_job(job, WORLD_RENDER_JOB_PARTICLES, world, rb_list,
+            &world->render_job_arenas[job_count]);
+        ++job_count;
 
-        entity_render(entity, rb_list, frame_arena, debug_state, world);
+        job->visible_chunks = tile_chunks;
+        job->lit_chunks = get_chunks_in_area(&world->map_chunks, visible_area, frame_arena);
     }
 
+    for (ssize i = 0; i < WORLD_RENDER_ENTITY_JOB_COUNT; ++i) {
+        WorldRenderJob *job = &jobs[job_count];
+        initialize_world_render_job(job, WORLD_RENDER_JOB_ENTITIES, world, rb_list,
+            &world->render_job_arenas[job_count]);
+        ++job_count;
+
+        job->first = (entity_count * i) / WORLD_RENDER_ENTITY_JOB_COUNT;
+        job->end = (entity_count * (i + 1)) / WORLD_RENDER_ENTITY_JOB_COUNT;
+        job->entities = entity_ids;
+        job->debug_state = debug_state;
+    }
+
+    ASSERT(job_count == WORLD_RENDER_JOB_COUNT);
+
+    JobCounter counter = {0};
+
+    for (ssize i = 0; i < job_count; ++i) {
+        platform_code.submit_job(world_render_job, &jobs[i], &counter);
+    }
+
+    platform_code.wait_for_jobs(&counter);
+
+    RenderBatch *targets[WORLD_RENDER_TARGET_COUNT];
+    get_world_render_targets(rb_list, targets);
+
+    RenderBatch **parts = la_allocate_array(frame_arena, RenderBatch *, job_count);
+
+    for (ssize target = 0; target < WORLD_RENDER_TARGET_COUNT; ++target) {
+        for (ssize i = 0; i < job_count; ++i) {
+            parts[i] = &jobs[i].batches[target];
+        }
+
+        merge_partial_render_batches(targets[target], parts, job_count, frame_arena);
+    }
+}
+
+void world_render(World *world, RenderBatches rb_list, const FrameData *frame_data,
+    PlatformCode platform_code, LinearArena *frame_arena, struct DebugState *debug_state)
+{
+    Rectangle update_area = get_area_to_update(world, frame_data);
+
+    world->visibility_cache.hits = 0;
+    world->visibility_cache.misses = 0;
+    world->light_stats = zero_struct(LightRenderStats);
+    world->cull_stats = zero_struct(RenderCullStats);
+
+    RenderBatch *targets[WORLD_RENDER_TARGET_COUNT];
+    get_world_render_targets(rb_list, targets);
+
+    for (ssize i = 0; i < WORLD_RENDER_TARGET_COUNT; ++i) {
+        world->cull_stats.commands_drawn -= targets[i]->entry_count;
+        world->cull_stats.commands_culled -= targets[i]->culled_entry_count;
+    }
+
+    Rectangle visible_area = get_area_visible_to_player(world, frame_data);
+
+    // TODO: move this and similar things to game.c
+    if (debug_state->render_camera_bounds) {
+        draw_outlined_rectangle(rb_list.worldspace_ui_rb, visible_area,
+            RGBA32_GREEN, 4.0f / (1.0f + world->camera.zoom), shader_handle(SHAPE_SHADER), 0);
+
+        draw_outlined_rectangle(rb_list.worldspace_ui_rb, update_area,
+            RGBA32_RED, 4.0f / (1.0f + world->camera.zoom), shader_handle(SHAPE_SHADER), 0);
+    }
+
+    // Lightmaps come before the light emitting particles in the lighting batch
+    lightmaps_render(&world->lightmaps, rb_list.lighting_rb, visible_area);
+
+    // Lights outside the camera may still reach into it, so entities are gathered from the
+    // whole update area and culled separately for recording and lighting
+    EntityIDList entities_in_area = world_get_entities_in_area(world, update_area, frame_arena);
+
+    record_world_in_parallel(world, rb_list, visible_area, update_area, &entities_in_area,
+        platform_code, frame_arena, debug_state);
+
+    LightCandidate *lights = 0;
+    ssize light_count = collect_lights_to_render(world, &entities_in_area, visible_area, &lights,
+        frame_arena);
+    generate_visibility_polygons(world, lights, light_count, platform_code, frame_arena);
+    render_lights(world, rb_list.lighting_rb, lights, light_count, frame_arena);
+
     hitsplats_render(world, rb_list.worldspace_ui_rb, frame_arena);
 
     if (debug_state->render_edge_list) {
@@ -999,19 +1435,35 @@ void world_render(World *world, RenderBatches rb_list, const FrameData *frame_da
             Vector2 origin = line_center(edge.line);
             Vector2 end = v2_add(origin, v2_mul_s(vec, 10.0f));
 
-            draw_line(rb_list.worldspace_ui_rb, frame_arena, origin, end, RGBA32_GREEN, 4.0f,
+            draw_line(rb_list.worldspace_ui_rb, origin, end, RGBA32_GREEN, 4.0f,
                 shader_handle(SHAPE_SHADER), 0);
 
-            draw_line(rb_list.worldspace_ui_rb, frame_arena, edge.line.start, edge.line.end,
+            draw_line(rb_list.worldspace_ui_rb, edge.line.start, edge.line.end,
 		RGBA32_BLUE, 4.0f,
                 shader_handle(SHAPE_SHADER), 0);
         }
     }
+
+    for (ssize i = 0; i < WORLD_RENDER_TARGET_COUNT; ++i) {
+        world->cull_stats.commands_drawn += targets[i]->entry_count;
+        world->cull_stats.commands_culled += targets[i]->culled_entry_count;
+    }
 }
 
 void world_initialize(World *world, FreeListArena *parent_arena)
 {
     world->world_arena = la_create(fl_allocator(parent_arena), WORLD_ARENA_SIZE);
+    visibility_cache_initialize(&world->visibility_cache, fl_allocator(parent_arena));
+    particle_pool_initialize(&world->particle_pool, fl_allocator(parent_arena),
+        PARTICLE_POOL_DEFAULT_MAX_PARTICLES);
+    world->tile_geometry_allocator = fl_allocator(parent_arena);
+
+    for (ssize i = 0; i < ARRAY_COUNT(world->render_job_arenas); ++i) {
+        world->render_job_arenas[i] = la_create(default_allocator, WORLD_RENDER_JOB_ARENA_SIZE);
+    }
+
+    world->light_settings.max_lights_per_frame = LIGHT_DEFAULT_BUDGET;
+    world->light_settings.min_raycasted_screen_radius = LIGHT_DEFAULT_MIN_RAYCAST_SCREEN_RADIUS;
 
     es_initialize(&world->entity_system);
 
@@ -1056,6 +1508,7 @@ void world_initialize(World *world, FreeListArena *parent_arena)
     Rectangle tilemap_area = tilemap_get_bounding_box(&world->tilemap);
 
     qt_initialize(&world->quad_tree, tilemap_area);
+    qt_initialize(&world->resting_quad_tree, tilemap_area);
 
     for (s32 i = 0; i < 3; ++i) {
 #if 1
@@ -1079,6 +1532,7 @@ void world_initialize(World *world, FreeListArena *parent_arena)
 
         ColliderComponent *collider = es_add_component(entity, ColliderComponent);
         collider->size = v2(16.0f, 16.0f);
+        set_collision_group(collider, i == 0 ? COLLISION_GROUP_PLAYERS : COLLISION_GROUP_ENEMIES);
 	set_collision_policy_vs_entities(collider, COLLISION_POLICY_STOP);
 	set_collision_policy_vs_tilemaps(collider, COLLISION_POLICY_STOP);
 
@@ -1177,11 +1631,68 @@ void world_initialize(World *world, FreeListArena *parent_arena)
 #endif
     }
 
+    {
+        // Static torch, baked into the lightmaps of the chunks around it
+        EntityWithID torch = world_spawn_entity(world, v2(12.5f * TILE_SIZE, 3.5f * TILE_SIZE),
+            FACTION_NEUTRAL);
+
+        LightEmitter *light = es_add_component(torch.entity, LightEmitter);
+        light->light.kind = LIGHT_RAYCASTED;
+        light->light.radius = 400.0f;
+        light->light.color = rgba32(1.0f, 0.6f, 0.2f, 1.0f);
+        light->light.is_static = true;
+    }
+
     // NOTE: be sure to only create these AFTER tilemap is finished
     world->map_chunks = create_chunks_for_tilemap(&world->tilemap, &world->world_arena);
+    lightmaps_initialize(&world->lightmaps, &world->map_chunks, fl_allocator(parent_arena),
+        &world->world_arena);
 }
 
-void world_destroy(World *world)
+// Collects the static lights and starts rebaking the lightmaps of any chunks they affect
+// that are out of date
+void world_update_lightmaps(World *world, PlatformCode platform_code, LinearArena *frame_arena)
 {
+    BakedLight *lights = la_allocate_array(frame_arena, BakedLight, MAX_ENTITIES);
+    ssize light_count = 0;
+
+    for (EntityIndex i = 0; i < world->alive_entity_count; ++i) {
+        EntityID id = world->alive_entity_ids[i];
+        Entity *entity = es_get_entity(&world->entity_system, id);
+
+        LightEmitter *emitter = es_get_component(entity, LightEmitter);
+        PhysicsComponent *physics = es_get_component(entity, PhysicsComponent);
+
+        if (!emitter || !physics || !light_is_baked(&emitter->light)) {
+            continue;
+        }
+
+        Rectangle entity_bounds = world_get_entity_bounding_box(entity, physics);
+
+        BakedLight *baked = &lights[light_count++];
+        baked->origin = get_light_origin_position(entity_bounds);
+        baked->radius = emitter->light.radius;
+        baked->color = emitter->light.color;
+        baked->casts_shadows = emitter->light.kind == LIGHT_RAYCASTED;
+    }
+
+    lightmaps_update(&world->lightmaps, &world->tilemap, lights, light_count, platform_code,
+        frame_arena);
+}
+
+void world_destroy(World *world, PlatformCode platform_code)
+{
+    lightmaps_destroy(&world->lightmaps, platform_code);
+
+    for (ssize i = 0; i < world->map_chunks.chunk_count; ++i) {
+        particle_buffers_destroy(&world->particle_pool, &world->map_chunks.chunks[i].particle_buffers);
+        destroy_chunk_tile_geometry(&world->map_chunks.chunks[i], world->tile_geometry_allocator);
+    }
+
+    for (ssize i = 0; i < ARRAY_COUNT(world->render_job_arenas); ++i) {
+        la_destroy(&world->render_job_arenas[i]);
+    }
+
+    visibility_cache_destroy(&world->visibility_cache);
     la_destroy(&world->world_arena);
 }
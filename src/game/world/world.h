@@ -12,6 +12,9 @@
 #include "hitsplat.h"
 #include "collision/collision_event.h"
 #include "world/chunk.h"
+#include "light.h"
+#include "lightmap.h"
+#include "line_of_sight.h"
 
 /*
   TODO:
@@ -26,6 +29,33 @@ struct DebugState;
 struct RenderBatch;
 struct RenderBatchList;
 
+// Tile chunks, particles and entities are recorded on worker threads, into render batches of
+// their own that are merged into the real ones afterwards
+#define WORLD_RENDER_TILE_JOB_COUNT    4
+#define WORLD_RENDER_ENTITY_JOB_COUNT  3
+#define WORLD_RENDER_JOB_COUNT         (WORLD_RENDER_TILE_JOB_COUNT + 1 + WORLD_RENDER_ENTITY_JOB_COUNT)
+#define WORLD_RENDER_JOB_ARENA_SIZE    MB(1)
+
+// Collected each frame for the debug overlay
+typedef struct {
+    ssize pairs_tested;
+    ssize pairs_culled;
+    ssize resting_entities;
+    ssize relocations;
+    ssize relocations_skipped;
+} BroadphaseStats;
+
+// Reset every frame. Chunks and entities inside the update area but outside the camera are
+// culled, and draw commands are culled by the render batches themselves.
+typedef struct {
+    ssize chunks_drawn;
+    ssize chunks_culled;
+    ssize entities_drawn;
+    ssize entities_culled;
+    ssize commands_drawn;
+    ssize commands_culled;
+} RenderCullStats;
+
 typedef struct World {
     // All allocations specific to the world instance should go here, and when destroying
     // a world, it should be destroyed so that the memory can be reused by other world instances
@@ -45,22 +75,53 @@ typedef struct World {
     EntityID             player_entity;
 
     Chunks               map_chunks;
+    ParticlePool         particle_pool; // Owns the particle buffers of every chunk
+    Allocator            tile_geometry_allocator;
 
     EntitySystem         entity_system;
     EntityID             alive_entity_ids[MAX_ENTITIES];
     EntityIndex          alive_entity_count;
     QuadTreeLocation     alive_entity_quad_tree_locations[MAX_ENTITIES];
+    b32                  alive_entity_is_resting[MAX_ENTITIES];
+
+    // Entities are split between two quad trees. Moving entities are relocated every
+    // frame, while resting entities stay put until they start moving again. Resting
+    // entities don't search for collisions themselves, they are only found by moving ones.
     QuadTree             quad_tree;
+    QuadTree             resting_quad_tree;
+
+    BroadphaseStats      broadphase_stats;
+
+    // Positions at the start of the latest simulation tick, indexed by entity index.
+    // Rendering interpolates between these and the current positions.
+    EntityID             previous_tick_entity_ids[MAX_ENTITIES];
+    Vector2              previous_tick_positions[MAX_ENTITIES];
+    f32                  render_interpolation;
+
+    VisibilityPolygonCache visibility_cache;
+    LightRenderSettings  light_settings;
+    LightRenderStats     light_stats;
+    RenderCullStats      cull_stats;
+    Lightmaps            lightmaps;
+
+    // Cleared at the start of every simulation tick
+    LineOfSightCache     line_of_sight_cache;
+
+    LinearArena          render_job_arenas[WORLD_RENDER_JOB_COUNT];
 } World;
 
 void world_initialize(World *world, FreeListArena *parent_arena);
-void world_destroy(World *world);
+void world_destroy(World *world, PlatformCode platform_code);
 void world_update(World *world, const struct FrameData *frame_data, LinearArena *frame_arena);
+void world_update_lightmaps(World *world, PlatformCode platform_code, LinearArena *frame_arena);
 void world_render(World *world, RenderBatches rb_list, const struct FrameData *frame_data,
-                  LinearArena *frame_arena, struct DebugState *debug_state);
+                  PlatformCode platform_code, LinearArena *frame_arena, struct DebugState *debug_state);
 EntityWithID world_spawn_entity(World *world, Vector2 position, EntityFaction faction);
 EntityWithID world_spawn_non_spatial_entity(World *world, EntityFaction faction);
 Rectangle world_get_entity_bounding_box(Entity *entity, PhysicsComponent *physics);
+EntityIDList world_get_entities_in_area(World *world, Rectangle area, LinearArena *arena); // Searches both quad trees
+void world_update_quad_tree_locations(World *world); // Also moves entities between the quad trees
+Vector2 world_get_entity_render_position(World *world, EntityID id, PhysicsComponent *physics);
 void world_kill_entity(World *world, Entity *entity, LinearArena *frame_arena);
 void world_add_trigger_cooldown(World *world, EntityID a, EntityID b, ComponentID component,
                                 RetriggerBehaviour retrigger_behaviour);
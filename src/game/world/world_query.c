@@ -0,0 +1,320 @@
+#include <string.h>
+
+#include "world_query.h"
+#include "base/maths.h"
+#include "base/utils.h"
+#include "tilemap.h"
+#include "world.h"
+
+typedef struct {
+    Vector2          origin;
+    Vector2          delta;
+    Vector2          inflation; // Size of the swept rectangle, zero for rays
+    WorldCastParams  params;
+    f32              max_fraction;
+
+    WorldCastHit    *hits;
+    ssize            hit_count;
+    ssize            hit_capacity;
+    LinearArena     *arena;
+} WorldCastState;
+
+static b32 tile_blocks_cast(Tilemap *tilemap, Vector2i coords)
+{
+    Tile *tile = tilemap_get_tile(tilemap, coords);
+    b32 result = !tile || (tile->type == TILE_WALL);
+
+    return result;
+}
+
+static b32 clip_cast_axis(f32 origin, f32 delta, f32 min, f32 max, f32 *t_min, f32 *t_max)
+{
+    if (delta == 0.0f) {
+        b32 result = (origin > min) && (origin < max);
+
+        return result;
+    }
+
+    f32 t_a = (min - origin) / delta;
+    f32 t_b = (max - origin) / delta;
+
+    *t_min = MAX(*t_min, MIN(t_a, t_b));
+    *t_max = MIN(*t_max, MAX(t_a, t_b));
+
+    b32 result = *t_min < *t_max;
+
+    return result;
+}
+
+// Returns the fraction along delta where the cast enters the rectangle, or INFINITY if
+// it doesn't within max_fraction
+static f32 cast_vs_rect(Vector2 origin, Vector2 delta, Rectangle rect, f32 max_fraction)
+{
+    f32 t_min = 0.0f;
+    f32 t_max = max_fraction;
+
+    b32 hit = clip_cast_axis(origin.x, delta.x, rect.position.x, rect.position.x + rect.size.x,
+        &t_min, &t_max)
+        && clip_cast_axis(origin.y, delta.y, rect.position.y, rect.position.y + rect.size.y,
+            &t_min, &t_max);
+
+    f32 result = hit ? t_min : INFINITY;
+
+    return result;
+}
+
+static Rectangle inflate_for_cast(Rectangle rect, Vector2 inflation)
+{
+    Rectangle result = {
+        v2_sub(rect.position, inflation),
+        v2_add(rect.size, inflation)
+    };
+
+    return result;
+}
+
+// Returns the fraction along delta where the first wall is entered, or INFINITY if there
+// is no wall before origin + delta
+f32 tilemap_ray_cast(Tilemap *tilemap, Vector2 origin, Vector2 delta)
+{
+    TileWalk walk = tile_walk_begin(origin, delta);
+
+    if (tile_blocks_cast(tilemap, walk.tile)) {
+        return 0.0f;
+    }
+
+    f32 result = INFINITY;
+
+    for (;;) {
+        tile_walk_next(&walk);
+
+        if (walk.fraction > 1.0f) {
+            break;
+        }
+
+        if (tile_blocks_cast(tilemap, walk.tile)) {
+            result = walk.fraction;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static f32 tilemap_rect_cast(Tilemap *tilemap, Rectangle rect, Vector2 movement)
+{
+    Vector2 end = v2_add(rect.position, movement);
+
+    f32 min_x = MIN(rect.position.x, end.x);
+    f32 min_y = MIN(rect.position.y, end.y);
+    f32 max_x = MAX(rect.position.x, end.x) + rect.size.x;
+    f32 max_y = MAX(rect.position.y, end.y) + rect.size.y;
+
+    s32 min_tile_x = (s32)floorf(min_x / (f32)TILE_SIZE);
+    s32 min_tile_y = (s32)floorf(min_y / (f32)TILE_SIZE);
+    s32 max_tile_x = (s32)floorf(max_x / (f32)TILE_SIZE);
+    s32 max_tile_y = (s32)floorf(max_y / (f32)TILE_SIZE);
+
+    f32 result = INFINITY;
+
+    for (s32 y = min_tile_y; y <= max_tile_y; ++y) {
+        for (s32 x = min_tile_x; x <= max_tile_x; ++x) {
+            if (tile_blocks_cast(tilemap, v2i(x, y))) {
+                Rectangle tile_rect = {
+                    tile_to_world_coords(v2i(x, y)),
+                    {(f32)TILE_SIZE, (f32)TILE_SIZE}
+                };
+
+                Rectangle inflated = inflate_for_cast(tile_rect, rect.size);
+                f32 t = cast_vs_rect(rect.position, movement, inflated, MIN(result, 1.0f));
+
+                result = MIN(result, t);
+            }
+        }
+    }
+
+    return result;
+}
+
+// Anything entered past this fraction can't end up in the result
+static f32 get_cast_cutoff(const WorldCastState *state)
+{
+    f32 result = state->max_fraction;
+
+    if ((state->params.max_hits > 0) && (state->hit_count == state->params.max_hits)) {
+        result = MIN(result, state->hits[state->hit_count - 1].fraction);
+    }
+
+    return result;
+}
+
+static void insert_cast_hit(WorldCastState *state, EntityID id, f32 fraction)
+{
+    if (state->hit_count == state->hit_capacity) {
+        if (state->params.max_hits > 0) {
+            // Full, drop the hit furthest away
+            ASSERT(fraction < state->hits[state->hit_count - 1].fraction);
+            --state->hit_count;
+        } else {
+            ssize new_capacity = state->hit_capacity * 2;
+            WorldCastHit *new_hits = la_allocate_array(state->arena, WorldCastHit, new_capacity);
+            memcpy(new_hits, state->hits, (usize)state->hit_count * sizeof(*new_hits));
+
+            state->hits = new_hits;
+            state->hit_capacity = new_capacity;
+        }
+    }
+
+    ssize index = state->hit_count;
+
+    while ((index > 0) && (state->hits[index - 1].fraction > fraction)) {
+        state->hits[index] = state->hits[index - 1];
+        --index;
+    }
+
+    WorldCastHit hit = {
+        .entity_id = id,
+        .fraction = fraction,
+        .point = v2_add(state->origin, v2_mul_s(state->delta, fraction))
+    };
+
+    state->hits[index] = hit;
+    ++state->hit_count;
+}
+
+static void cast_through_quad_tree_node(WorldCastState *state, QuadTreeNode *node)
+{
+    for (QuadTreeElement *elem = list_head(&node->entities_in_node); elem; elem = list_next(elem)) {
+        if (entity_id_equal(elem->entity_id, state->params.ignored_entity)) {
+            continue;
+        }
+
+        if (state->params.use_collision_filter
+            && !collision_filters_can_interact(state->params.collision_filter, elem->collision_filter)) {
+            continue;
+        }
+
+        Rectangle area = inflate_for_cast(elem->area, state->inflation);
+        f32 cutoff = get_cast_cutoff(state);
+        f32 t = cast_vs_rect(state->origin, state->delta, area, cutoff);
+
+        if (t < cutoff) {
+            insert_cast_hit(state, elem->entity_id, t);
+        }
+    }
+
+    if (!node->top_left) {
+        return;
+    }
+
+    QuadTreeNode *children[] = {
+        node->top_left, node->top_right, node->bottom_right, node->bottom_left
+    };
+
+    f32 entry_fractions[ARRAY_COUNT(children)];
+
+    for (ssize i = 0; i < ARRAY_COUNT(children); ++i) {
+        Rectangle area = inflate_for_cast(children[i]->area, state->inflation);
+        entry_fractions[i] = cast_vs_rect(state->origin, state->delta, area, state->max_fraction);
+    }
+
+    // Visit children in the order the cast passes through them
+    for (ssize i = 1; i < ARRAY_COUNT(children); ++i) {
+        for (ssize j = i; (j > 0) && (entry_fractions[j - 1] > entry_fractions[j]); --j) {
+            f32 tmp_fraction = entry_fractions[j];
+            entry_fractions[j] = entry_fractions[j - 1];
+            entry_fractions[j - 1] = tmp_fraction;
+
+            QuadTreeNode *tmp_node = children[j];
+            children[j] = children[j - 1];
+            children[j - 1] = tmp_node;
+        }
+    }
+
+    for (ssize i = 0; i < ARRAY_COUNT(children); ++i) {
+        if (entry_fractions[i] > get_cast_cutoff(state)) {
+            break;
+        }
+
+        cast_through_quad_tree_node(state, children[i]);
+    }
+}
+
+static WorldCastResult world_cast(World *world, Vector2 origin, Vector2 delta, Vector2 inflation,
+    WorldCastParams params, LinearArena *arena)
+{
+    ASSERT(params.max_hits >= 0);
+
+    WorldCastResult result = {0};
+    result.wall_fraction = 1.0f;
+
+    if (!params.ignore_walls) {
+        f32 wall_fraction = 0.0f;
+
+        if (v2_is_zero(inflation)) {
+            wall_fraction = tilemap_ray_cast(&world->tilemap, origin, delta);
+        } else {
+            wall_fraction = tilemap_rect_cast(&world->tilemap, (Rectangle){origin, inflation}, delta);
+        }
+
+        if (wall_fraction <= 1.0f) {
+            result.hit_wall = true;
+            result.wall_fraction = wall_fraction;
+            result.wall_point = v2_add(origin, v2_mul_s(delta, wall_fraction));
+        }
+    }
+
+    WorldCastState state = {
+        .origin = origin,
+        .delta = delta,
+        .inflation = inflation,
+        .params = params,
+        .max_fraction = result.wall_fraction,
+        .hit_capacity = (params.max_hits > 0) ? params.max_hits : 16,
+        .arena = arena
+    };
+
+    state.hits = la_allocate_array(arena, WorldCastHit, state.hit_capacity);
+
+    QuadTree *trees[] = {&world->quad_tree, &world->resting_quad_tree};
+
+    for (ssize i = 0; i < ARRAY_COUNT(trees); ++i) {
+        QuadTreeNode *root = &trees[i]->root;
+        Rectangle root_area = inflate_for_cast(root->area, inflation);
+
+        if (cast_vs_rect(origin, delta, root_area, state.max_fraction) <= get_cast_cutoff(&state)) {
+            cast_through_quad_tree_node(&state, root);
+        }
+    }
+
+    result.hits = state.hits;
+    result.hit_count = state.hit_count;
+
+    return result;
+}
+
+WorldCastResult world_ray_cast(World *world, Vector2 origin, Vector2 target,
+    WorldCastParams params, LinearArena *arena)
+{
+    WorldCastResult result = world_cast(world, origin, v2_sub(target, origin), V2_ZERO,
+        params, arena);
+
+    return result;
+}
+
+WorldCastResult world_rect_cast(World *world, Rectangle rect, Vector2 movement,
+    WorldCastParams params, LinearArena *arena)
+{
+    WorldCastResult result = world_cast(world, rect.position, movement, rect.size,
+        params, arena);
+
+    return result;
+}
+
+b32 world_has_clear_path(World *world, Vector2 origin, Vector2 target)
+{
+    f32 wall_fraction = tilemap_ray_cast(&world->tilemap, origin, v2_sub(target, origin));
+    b32 result = wall_fraction > 1.0f;
+
+    return result;
+}
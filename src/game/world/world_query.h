@@ -0,0 +1,50 @@
+#ifndef WORLD_QUERY_H
+#define WORLD_QUERY_H
+
+#include "base/linear_arena.h"
+#include "base/rectangle.h"
+#include "base/vector.h"
+#include "collision/collider.h"
+#include "entity/entity_id.h"
+
+/*
+  Ray and swept rectangle queries against both the entity quad trees and the tilemap.
+  Quad tree nodes are visited in the order the cast enters them, and anything past the
+  first wall (or past the last accepted hit once max_hits is reached) is never visited.
+ */
+
+struct World;
+struct Tilemap;
+
+typedef struct {
+    EntityID entity_id;
+    f32      fraction; // 0 at the start of the cast, 1 at the end
+    Vector2  point;    // Position of the ray, or of the rectangle, when the hit occurs
+} WorldCastHit;
+
+typedef struct {
+    WorldCastHit *hits; // Sorted front to back
+    ssize         hit_count;
+
+    b32           hit_wall;
+    f32           wall_fraction;
+    Vector2       wall_point;
+} WorldCastResult;
+
+typedef struct {
+    ssize           max_hits; // 0 means no limit
+    EntityID        ignored_entity;
+    b32             ignore_walls;
+
+    b32             use_collision_filter;
+    CollisionFilter collision_filter;
+} WorldCastParams;
+
+WorldCastResult world_ray_cast(struct World *world, Vector2 origin, Vector2 target,
+    WorldCastParams params, LinearArena *arena);
+WorldCastResult world_rect_cast(struct World *world, Rectangle rect, Vector2 movement,
+    WorldCastParams params, LinearArena *arena);
+b32 world_has_clear_path(struct World *world, Vector2 origin, Vector2 target);
+f32 tilemap_ray_cast(struct Tilemap *tilemap, Vector2 origin, Vector2 delta);
+
+#endif //WORLD_QUERY_H
@@ -6,6 +6,8 @@
 #include "platform/platform.h"
 #include "platform/file_watcher.h"
 #include "platform/hot_reload.h"
+#include "platform/job_system.h"
+#include "platform/render_thread.h"
 #include "renderer/backend/render_command_interpreter.h"
 #include "game/game.h"
 
@@ -16,17 +18,30 @@
 // loaded from the shared library. Otherwise, we just call the functions directly.
 #if HOT_RELOAD
 #    define GAME_INITIALIZE(game, mem, gc) (gc).initialize(game, mem);
-#    define GAME_UPDATE_AND_RENDER(game, pf_code, rbs, frame_data, mem, gc)     \
-        (gc).update_and_render(game, pf_code, rbs, frame_data, mem);
-#    define HOT_RELOAD_IF_RECOMPILED(gc, mem) reload_game_code_if_recompiled(gc, mem)
+#    define GAME_UPDATE_AND_RENDER(game, pf_code, rbs, frame_data, stats, mem, gc) \
+        (gc).update_and_render(game, pf_code, rbs, frame_data, stats, mem);
+#    define HOT_RELOAD_IF_RECOMPILED(gc, game, pf_code, mem) reload_game_code_if_recompiled(gc, game, pf_code, mem)
 #else
 #    define GAME_INITIALIZE(game, mem, gc) game_initialize(game_state, game_memory);
-#    define GAME_UPDATE_AND_RENDER(game, pf_code, rbs, frame_data, mem, gc) \
-        game_update_and_render(game, pf_code, rbs, frame_data, mem);
+#    define GAME_UPDATE_AND_RENDER(game, pf_code, rbs, frame_data, stats, mem, gc) \
+        game_update_and_render(game, pf_code, rbs, frame_data, stats, mem);
+#    define HOT_RELOAD_IF_RECOMPILED(gc, game, pf_code, mem)
 #endif
 
+typedef struct {
+    AssetWatcherContext *watcher;
+    LinearArena         *scratch;
+} AssetReloadTask;
+
 const char *__asan_default_options(void) { return "detect_leaks=0"; }
 
+// Reloading assets creates GPU resources, so it has to happen on the render thread
+static void reload_modified_assets_task(void *data)
+{
+    AssetReloadTask *task = data;
+    file_watcher_reload_modified_assets(task->watcher, task->scratch);
+}
+
 int main(void)
 {
     LinearArena main_arena = la_create(default_allocator, GAME_MEMORY_SIZE);
@@ -34,7 +49,8 @@ int main(void)
     GameMemory game_memory = {0};
 
     game_memory.permanent_memory = la_create(la_allocator(&main_arena), PERMANENT_ARENA_SIZE);
-    game_memory.temporary_memory = la_create(la_allocator(&main_arena), FRAME_ARENA_SIZE);
+    // Only used while starting up, frames are recorded into the arenas of the render thread
+    game_memory.temporary_memory = la_create(default_allocator, FRAME_ARENA_SIZE);
     game_memory.free_list_memory = fl_create(la_allocator(&game_memory.permanent_memory), FREE_LIST_ARENA_SIZE);
 
     Game *game_state = la_allocate_item(&game_memory.permanent_memory, Game);
@@ -47,6 +63,7 @@ int main(void)
         la_allocator(&game_memory.permanent_memory));
 
     assets_initialize(la_allocator(&game_memory.permanent_memory));
+    job_system_initialize();
 
     u64 rng_seed = (u64)time(0); // TODO: better seed
     rng_initialize(&game_state->rng_state, rng_seed);
@@ -58,6 +75,10 @@ int main(void)
         .get_text_dimensions = assets_get_text_dimensions,
         .get_text_newline_advance = assets_get_text_newline_advance,
         .get_font_baseline_offset = assets_get_font_baseline_offset,
+        .create_texture = render_thread_create_texture,
+        .update_texture = render_thread_update_texture,
+        .submit_job = job_system_submit,
+        .wait_for_jobs = job_system_wait_for_counter,
     };
 
 #if HOT_RELOAD
@@ -73,20 +94,40 @@ int main(void)
     f32 time_point_last = platform_get_seconds_since_launch();
     f32 time_point_new = time_point_last;
 
+    RenderThreadSettings render_settings = {
+        .backend = backend,
+        .window = window,
+        .light_blending_shader = get_shader_handle_from_table(&game_state->asset_table,
+            GAME_ASSET_LIGHT_BLENDING_SHADER),
+        .screenspace_texture_shader = get_shader_handle_from_table(&game_state->asset_table,
+            GAME_ASSET_SCREENSPACE_TEXTURE_SHADER),
+        .frame_arena_size = FRAME_ARENA_SIZE,
+        .is_threaded = true
+    };
+
+    // From here on the GPU context belongs to the render thread
+    render_thread_initialize(render_settings);
+
     GAME_INITIALIZE(game_state, &game_memory, game_code);
 
-    RenderBatchList render_batches = {0};
+    la_destroy(&game_memory.temporary_memory);
 
     while (!platform_window_should_close(window)) {
         time_point_new = platform_get_seconds_since_launch();
         f32 dt = time_point_new - time_point_last;
         time_point_last = time_point_new;
 
-        la_reset(&game_memory.temporary_memory);
+        // Frame N + 1 is recorded into this while frame N is being executed
+        RenderFrame *frame = render_thread_begin_frame();
+        game_memory.temporary_memory = frame->arena;
 
         // TODO: Guard asset reloading behind macro too, just like code hot reloading
-        file_watcher_reload_modified_assets(&asset_watcher, &game_memory.temporary_memory);
-        HOT_RELOAD_IF_RECOMPILED(&game_code, &game_memory.temporary_memory);
+        if (file_watcher_has_modified_assets(&asset_watcher)) {
+            AssetReloadTask reload_task = {&asset_watcher, &game_memory.temporary_memory};
+            render_thread_run_task(reload_modified_assets_task, &reload_task);
+        }
+
+        HOT_RELOAD_IF_RECOMPILED(&game_code, game_state, platform_code, &game_memory.temporary_memory);
 
         platform_update_input(&input, window);
 
@@ -97,33 +138,20 @@ int main(void)
             .window_size = window_size
         };
 
-        list_clear(&render_batches);
-
-        GAME_UPDATE_AND_RENDER(game_state, platform_code, &render_batches, frame_data, &game_memory, game_code);
+        GAME_UPDATE_AND_RENDER(game_state, platform_code, &frame->batches, frame_data, frame->render_stats,
+            &game_memory, game_code);
 
-        renderer_backend_begin_frame(backend);
-
-        for (RenderBatch *batch = list_head(&render_batches); batch; batch = list_next(batch)) {
-            execute_render_commands(batch, backend, &game_memory.temporary_memory);
-        }
-
-        renderer_backend_set_stencil_function(backend, STENCIL_FUNCTION_ALWAYS, 0);
-
-        // TODO: Do this somewhere else
-        ShaderAsset *light_blending_shader = assets_get_shader(
-            get_shader_handle_from_table(&game_state->asset_table, GAME_ASSET_LIGHT_BLENDING_SHADER));
-
-        renderer_backend_blend_framebuffers(backend, FRAME_BUFFER_GAMEPLAY, FRAME_BUFFER_LIGHTING,
-            light_blending_shader);
-
-        ShaderAsset *screenspace_texture_shader = assets_get_shader(
-            get_shader_handle_from_table(&game_state->asset_table, GAME_ASSET_SCREENSPACE_TEXTURE_SHADER));
-
-        renderer_backend_draw_framebuffer_as_texture(backend, FRAME_BUFFER_OVERLAY, screenspace_texture_shader);
+        frame->arena = game_memory.temporary_memory;
+        render_thread_submit_frame(frame);
 
         platform_poll_events(window);
     }
 
+    render_thread_shutdown();
+
+    // Jobs may still be writing to game memory
+    job_system_shutdown();
+
     platform_destroy_window(window);
     la_destroy(&main_arena);
 
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "asset_table.h"
+#include "platform/asset_system.h"
+#include "platform/platform.h"
+#include "platform/job_system.h"
+#include "platform/render_thread.h"
+#include "renderer/backend/render_command_interpreter.h"
+#include "renderer/backend/headless/headless_backend.h"
+#include "game/game.h"
+
+/*
+  Runs the game without a window on the headless renderer backend and measures how many
+  frames per second it gets through, first executing every frame right after it has been
+  recorded and then on the render thread while the next frame is being recorded.
+
+  Flushes are free by default, which leaves the render thread with almost nothing to do.
+  Giving them a cost in microseconds makes frame execution take about as long as it would
+  with a driver behind it.
+
+  Usage: arpg-headless [frame count] [flush cost in microseconds]
+ */
+
+#define HEADLESS_WINDOW_WIDTH  1280
+#define HEADLESS_WINDOW_HEIGHT 768
+#define HEADLESS_FRAME_COUNT   1000
+#define HEADLESS_DT            (1.0f / 60.0f)
+
+const char *__asan_default_options(void) { return "detect_leaks=0"; }
+
+static f64 seconds_between(Timestamp start, Timestamp end)
+{
+    f64 result = (f64)(end.seconds - start.seconds) + (f64)(end.nanoseconds - start.nanoseconds) / 1e9;
+
+    return result;
+}
+
+// Each run starts from a freshly initialized game so both runs simulate the same frames
+static f64 run_frames(s32 frame_count, b32 is_threaded, RendererBackend *backend, PlatformCode platform_code,
+    AssetTable asset_table)
+{
+    LinearArena game_arena = la_create(default_allocator, GAME_MEMORY_SIZE);
+
+    GameMemory game_memory = {0};
+    game_memory.permanent_memory = la_create(la_allocator(&game_arena), PERMANENT_ARENA_SIZE);
+    game_memory.free_list_memory = fl_create(la_allocator(&game_memory.permanent_memory), FREE_LIST_ARENA_SIZE);
+
+    Game *game_state = la_allocate_item(&game_memory.permanent_memory, Game);
+    rng_initialize(&game_state->rng_state, 0);
+    game_state->asset_table = asset_table;
+
+    RenderThreadSettings render_settings = {
+        .backend = backend,
+        .light_blending_shader = get_shader_handle_from_table(&game_state->asset_table,
+            GAME_ASSET_LIGHT_BLENDING_SHADER),
+        .screenspace_texture_shader = get_shader_handle_from_table(&game_state->asset_table,
+            GAME_ASSET_SCREENSPACE_TEXTURE_SHADER),
+        .frame_arena_size = FRAME_ARENA_SIZE,
+        .is_threaded = is_threaded
+    };
+
+    render_thread_initialize(render_settings);
+    game_initialize(game_state, &game_memory);
+
+    Timestamp start = platform_get_time();
+
+    for (s32 i = 0; i < frame_count; ++i) {
+        RenderFrame *frame = render_thread_begin_frame();
+        game_memory.temporary_memory = frame->arena;
+
+        FrameData frame_data = {
+            .dt = HEADLESS_DT,
+            .window_size = v2i(HEADLESS_WINDOW_WIDTH, HEADLESS_WINDOW_HEIGHT)
+        };
+
+        game_update_and_render(game_state, platform_code, &frame->batches, frame_data, frame->render_stats,
+            &game_memory);
+
+        frame->arena = game_memory.temporary_memory;
+        render_thread_submit_frame(frame);
+    }
+
+    // Waits for the last frames to be executed
+    render_thread_shutdown();
+
+    Timestamp end = platform_get_time();
+    f64 result = (f64)frame_count / seconds_between(start, end);
+
+    la_destroy(&game_arena);
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    s32 frame_count = (argc > 1) ? atoi(argv[1]) : HEADLESS_FRAME_COUNT;
+    s32 flush_cost_in_microseconds = (argc > 2) ? atoi(argv[2]) : 0;
+
+    if ((frame_count <= 0) || (flush_cost_in_microseconds < 0)) {
+        fprintf(stderr, "Usage: %s [frame count] [flush cost in microseconds]\n", argv[0]);
+        return 1;
+    }
+
+    LinearArena platform_arena = la_create(default_allocator, MB(32));
+    RendererBackend *backend = renderer_backend_initialize(v2i(HEADLESS_WINDOW_WIDTH, HEADLESS_WINDOW_HEIGHT),
+        la_allocator(&platform_arena));
+    headless_backend_set_flush_cost(backend, (s64)flush_cost_in_microseconds * 1000);
+
+    assets_initialize(la_allocator(&platform_arena));
+    job_system_initialize();
+
+    LinearArena scratch = la_create(la_allocator(&platform_arena), MB(8));
+    AssetTable asset_table = load_game_assets(&scratch);
+
+    PlatformCode platform_code = {
+        .get_text_dimensions = assets_get_text_dimensions,
+        .get_text_newline_advance = assets_get_text_newline_advance,
+        .get_font_baseline_offset = assets_get_font_baseline_offset,
+        .create_texture = render_thread_create_texture,
+        .update_texture = render_thread_update_texture,
+        .submit_job = job_system_submit,
+        .wait_for_jobs = job_system_wait_for_counter,
+    };
+
+    f64 serial_fps = run_frames(frame_count, false, backend, platform_code, asset_table);
+    f64 threaded_fps = run_frames(frame_count, true, backend, platform_code, asset_table);
+
+    printf("Flush cost: %d us\n", flush_cost_in_microseconds);
+    printf("Serial:   %.1f frames/s\n", serial_fps);
+    printf("Threaded: %.1f frames/s\n", threaded_fps);
+    printf("Speedup:  %.2fx\n", threaded_fps / serial_fps);
+
+    job_system_shutdown();
+    la_destroy(&platform_arena);
+
+    return 0;
+}
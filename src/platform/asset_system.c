@@ -2,6 +2,7 @@
 #include "asset.h"
 #include "asset_table.h"
 #include "base/linear_arena.h"
+#include "base/rect_pack.h"
 #include "base/string8.h"
 #include "base/utils.h"
 #include "font.h"
@@ -25,6 +26,10 @@ typedef struct {
     } as;
 
     String canonical_asset_path;
+
+    // Textures packed into an atlas share the texture of their page and have no texture of their own
+    TextureHandle atlas_page;
+    Rectangle     atlas_uv_rect;
 } AssetSlot;
 
 typedef struct AssetSystem {
@@ -195,19 +200,27 @@ ShaderHandle assets_register_shader(String name, LinearArena *scratch)
     return (ShaderHandle){slot_and_id.id};
 }
 
-static TextureAsset *load_asset_data_texture(String path, LinearArena *scratch)
+static Image load_texture_image(String path, LinearArena *scratch)
 {
-    TextureAsset *result = 0;
+    Image result = {0};
     Span file_contents = platform_read_entire_file(path, la_allocator(scratch), scratch);
 
     if (file_contents.data && file_contents.size) {
-        Image image = image_decode_png(file_contents, la_allocator(scratch));
+        result = image_decode_png(file_contents, la_allocator(scratch));
+    }
 
-        if (image.data) {
-            TextureAsset *texture = renderer_backend_create_texture(image, fl_allocator(&g_asset_system.asset_arena));
+    return result;
+}
 
-            result = texture;
-        }
+static TextureAsset *load_asset_data_texture(String path, LinearArena *scratch)
+{
+    TextureAsset *result = 0;
+    Image image = load_texture_image(path, scratch);
+
+    if (image.data) {
+        TextureAsset *texture = renderer_backend_create_texture(image, fl_allocator(&g_asset_system.asset_arena));
+
+        result = texture;
     }
 
     return result;
@@ -226,6 +239,103 @@ TextureHandle assets_register_texture(String name, LinearArena *scratch)
     return (TextureHandle){slot_and_id.id};
 }
 
+// Copies image into an RGBA atlas page and repeats its edge pixels into the padding around it
+static void blit_into_atlas_page(Image page, Image image, Vector2i position, s32 padding)
+{
+    ASSERT(page.channels == 4);
+
+    for (s32 y = -padding; y < image.height + padding; ++y) {
+        for (s32 x = -padding; x < image.width + padding; ++x) {
+            s32 src_x = CLAMP(x, 0, image.width - 1);
+            s32 src_y = CLAMP(y, 0, image.height - 1);
+
+            byte *src = image.data + (src_y * image.width + src_x) * image.channels;
+            byte *dst = page.data + ((position.y + y) * page.width + (position.x + x)) * page.channels;
+
+            if (image.channels >= 3) {
+                dst[0] = src[0];
+                dst[1] = src[1];
+                dst[2] = src[2];
+            } else {
+                dst[0] = src[0];
+                dst[1] = src[0];
+                dst[2] = src[0];
+            }
+
+            if (image.channels == 4) {
+                dst[3] = src[3];
+            } else if (image.channels == 2) {
+                dst[3] = src[1];
+            } else {
+                dst[3] = 255;
+            }
+        }
+    }
+}
+
+void assets_register_texture_atlas(const String *names, ssize count, TextureHandle *handles, LinearArena *scratch)
+{
+    Image *images = la_allocate_array(scratch, Image, count);
+    Vector2i *sizes = la_allocate_array(scratch, Vector2i, count);
+    PackedRect *packed = la_allocate_array(scratch, PackedRect, count);
+
+    for (ssize i = 0; i < count; ++i) {
+        String path = get_canonical_asset_path(names[i], ASSET_KIND_TEXTURE, &g_asset_system.asset_arena, scratch);
+        AssetSlotWithID slot_and_id = allocate_asset_slot(path);
+
+        images[i] = load_texture_image(path, scratch);
+        ASSERT(images[i].data);
+
+        sizes[i] = v2i(images[i].width, images[i].height);
+        handles[i] = (TextureHandle){slot_and_id.id};
+    }
+
+    Vector2i page_size = v2i(ASSET_ATLAS_PAGE_SIZE, ASSET_ATLAS_PAGE_SIZE);
+    s32 page_count = rect_pack(sizes, count, page_size, ASSET_ATLAS_PADDING, packed, scratch);
+
+    for (s32 page = 0; page < page_count; ++page) {
+        Image page_image = {
+            .data = la_allocate_array(scratch, byte, page_size.x * page_size.y * 4),
+            .width = page_size.x,
+            .height = page_size.y,
+            .channels = 4
+        };
+
+        for (ssize i = 0; i < count; ++i) {
+            if (packed[i].page == page) {
+                blit_into_atlas_page(page_image, images[i], packed[i].position, ASSET_ATLAS_PADDING);
+            }
+        }
+
+        TextureAsset *texture = renderer_backend_create_texture(page_image, fl_allocator(&g_asset_system.asset_arena));
+        AssetSlotWithID page_slot = allocate_asset_slot(null_string);
+        assign_asset_slot_data(page_slot.slot, ASSET_KIND_TEXTURE, texture);
+
+        for (ssize i = 0; i < count; ++i) {
+            if (packed[i].page == page) {
+                AssetSlot *slot = get_asset_slot(handles[i].id);
+                Vector2 position = v2i_to_v2(packed[i].position);
+                Vector2 size = v2i_to_v2(sizes[i]);
+
+                assign_asset_slot_data(slot, ASSET_KIND_TEXTURE, 0);
+                slot->atlas_page = (TextureHandle){page_slot.id};
+                slot->atlas_uv_rect = (Rectangle){
+                    v2_div_s(position, (f32)ASSET_ATLAS_PAGE_SIZE),
+                    v2_div_s(size, (f32)ASSET_ATLAS_PAGE_SIZE)
+                };
+            }
+        }
+    }
+
+    // Anything too large for a page keeps a texture of its own
+    for (ssize i = 0; i < count; ++i) {
+        if (packed[i].page == RECT_PACK_NO_PAGE) {
+            TextureAsset *texture = renderer_backend_create_texture(images[i], fl_allocator(&g_asset_system.asset_arena));
+            assign_asset_slot_data(get_asset_slot(handles[i].id), ASSET_KIND_TEXTURE, texture);
+        }
+    }
+}
+
 static FontAsset *load_asset_data_font(String path, LinearArena *scratch)
 {
     FontAsset *result = font_create_atlas(path, fl_allocator(&g_asset_system.asset_arena), scratch);
@@ -257,7 +367,26 @@ ShaderAsset *assets_get_shader(ShaderHandle handle)
 
 TextureAsset *assets_get_texture(TextureHandle handle)
 {
-    TextureAsset *result = get_asset_data(handle.id, ASSET_KIND_TEXTURE);
+    TextureRegion region = assets_get_texture_region(handle);
+    TextureAsset *result = get_asset_data(region.page.id, ASSET_KIND_TEXTURE);
+
+    return result;
+}
+
+TextureRegion assets_get_texture_region(TextureHandle handle)
+{
+    AssetSlot *slot = get_asset_slot(handle.id);
+    ASSERT(slot->kind == ASSET_KIND_TEXTURE);
+
+    TextureRegion result = {
+        .page = handle,
+        .uv_rect = {{0.0f, 0.0f}, {1.0f, 1.0f}}
+    };
+
+    if (slot->atlas_page.id != NULL_TEXTURE.id) {
+        result.page = slot->atlas_page;
+        result.uv_rect = slot->atlas_uv_rect;
+    }
 
     return result;
 }
@@ -288,7 +417,13 @@ static b32 assets_reload_texture(AssetSlot *slot, LinearArena *scratch)
     TextureAsset *new_texture = load_asset_data_texture(slot->canonical_asset_path, scratch);
 
     if (new_texture) {
-        renderer_backend_destroy_texture(slot->as.texture_asset, fl_allocator(&g_asset_system.asset_arena));
+        // A reloaded texture leaves its atlas, since it may no longer fit where it was packed
+        if (slot->atlas_page.id != NULL_TEXTURE.id) {
+            slot->atlas_page = NULL_TEXTURE;
+        } else {
+            renderer_backend_destroy_texture(slot->as.texture_asset, fl_allocator(&g_asset_system.asset_arena));
+        }
+
         assign_asset_slot_data(slot, ASSET_KIND_TEXTURE, new_texture);
 
         return true;
@@ -338,6 +473,12 @@ TextureHandle assets_create_texture_from_memory(Image image)
     return result;
 }
 
+void assets_update_texture_from_memory(TextureHandle handle, Image image)
+{
+    TextureAsset *texture = assets_get_texture(handle);
+    renderer_backend_update_texture(texture, image);
+}
+
 Vector2 assets_get_text_dimensions(FontHandle font_handle, String text, s32 text_size)
 {
     FontAsset *asset = assets_get_font(font_handle);
@@ -365,11 +506,18 @@ AssetTable load_game_assets(LinearArena *scratch)
 {
     AssetTable result = {0};
 
+    // Textures are collected first so that they can all be packed into atlases together
+    String texture_names[GAME_ASSET_COUNT] = {0};
+    GameAsset texture_assets[GAME_ASSET_COUNT] = {0};
+    TextureHandle texture_handles[GAME_ASSET_COUNT] = {0};
+    ssize texture_count = 0;
+
 #define DEFINE_ASSET(name, type, path)                                  \
     switch (get_game_asset_kind(ASSET_NAME_TO_ENUM(name))) {            \
         case ASSET_KIND_TEXTURE: {                                      \
-            result.textures[ASSET_NAME_TO_ENUM(name)] =                 \
-                assets_register_texture(str_lit(path), scratch);        \
+            texture_names[texture_count] = str_lit(path);               \
+            texture_assets[texture_count] = ASSET_NAME_TO_ENUM(name);   \
+            ++texture_count;                                            \
         } break;                                                        \
         case ASSET_KIND_SHADER: {                                       \
             result.shaders[ASSET_NAME_TO_ENUM(name)] =                  \
@@ -385,5 +533,11 @@ AssetTable load_game_assets(LinearArena *scratch)
 
 #undef DEFINE_ASSET
 
+    assets_register_texture_atlas(texture_names, texture_count, texture_handles, scratch);
+
+    for (ssize i = 0; i < texture_count; ++i) {
+        result.textures[texture_assets[i]] = texture_handles[i];
+    }
+
     return result;
 }
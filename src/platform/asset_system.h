@@ -6,6 +6,7 @@
 #include "base/linear_arena.h"
 #include "base/string8.h"
 #include "base/image.h"
+#include "base/rectangle.h"
 #include "renderer/backend/renderer_backend.h"
 #include "font.h"
 #include "game/asset_table.h"
@@ -15,15 +16,27 @@
 #define SPRITE_DIRECTORY "sprites/"
 #define FONT_DIRECTORY   "fonts/"
 
+#define ASSET_ATLAS_PAGE_SIZE 512
+#define ASSET_ATLAS_PADDING   1 // Edge pixels are repeated into the padding
+
+typedef struct {
+    TextureHandle page;    // The texture to bind, which is the atlas page for packed textures
+    Rectangle     uv_rect; // Where the texture is on the page, in UV coordinates
+} TextureRegion;
+
 void              assets_initialize(Allocator parent_allocator);
 ShaderHandle      assets_register_shader(String name, LinearArena *scratch);
 TextureHandle     assets_register_texture(String name, LinearArena *scratch);
+void              assets_register_texture_atlas(const String *names, ssize count, TextureHandle *handles,
+                                                LinearArena *scratch);
 FontHandle        assets_register_font(String name, LinearArena *scratch);
 ShaderAsset      *assets_get_shader(ShaderHandle handle);
 TextureAsset     *assets_get_texture(TextureHandle handle);
+TextureRegion     assets_get_texture_region(TextureHandle handle);
 FontAsset        *assets_get_font(FontHandle handle);
 b32               assets_reload_asset_with_path(String path, LinearArena *scratch);
 TextureHandle     assets_create_texture_from_memory(Image image);
+void              assets_update_texture_from_memory(TextureHandle handle, Image image);
 Vector2           assets_get_text_dimensions(FontHandle font_handle, String text, s32 text_size);
 f32               assets_get_text_newline_advance(FontHandle font_handle, s32 text_size);
 f32               assets_get_font_baseline_offset(FontHandle font_handle, s32 text_size);
@@ -154,6 +154,15 @@ void file_watcher_stop(AssetWatcherContext *ctx)
     mutex_destroy(ctx->lock, ctx->allocator);
 }
 
+b32 file_watcher_has_modified_assets(AssetWatcherContext *ctx)
+{
+    mutex_lock(ctx->lock);
+    b32 result = list_head(&ctx->asset_reload_queue) != 0;
+    mutex_release(ctx->lock);
+
+    return result;
+}
+
 void file_watcher_reload_modified_assets(AssetWatcherContext *ctx, LinearArena *scratch)
 {
     mutex_lock(ctx->lock);
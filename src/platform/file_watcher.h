@@ -25,6 +25,7 @@ typedef struct {
 
 void file_watcher_start(AssetWatcherContext *ctx);
 void file_watcher_stop(AssetWatcherContext *ctx);
+b32  file_watcher_has_modified_assets(AssetWatcherContext *ctx);
 void file_watcher_reload_modified_assets(AssetWatcherContext *ctx, LinearArena *scratch);
 
 #endif //FILE_WATCHER_H
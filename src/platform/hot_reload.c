@@ -31,19 +31,22 @@ void load_game_code_impl(GameCode *game_code, LinearArena *scratch)
 
     void *initialize = dlsym(handle, "game_initialize");
     void *update_and_render = dlsym(handle, "game_update_and_render");
+    void *prepare_for_reload = dlsym(handle, "game_prepare_for_reload");
 
-    if (!initialize || !update_and_render) {
+    if (!initialize || !update_and_render || !prepare_for_reload) {
         goto error;
     }
 
     ASSERT(initialize);
     ASSERT(update_and_render);
+    ASSERT(prepare_for_reload);
 
     BEGIN_IGNORE_FUNCTION_PTR_WARNINGS;
 
     game_code->handle = handle;
     game_code->initialize = initialize;
     game_code->update_and_render = update_and_render;
+    game_code->prepare_for_reload = prepare_for_reload;
 
     END_IGNORE_FUNCTION_PTR_WARNINGS;
 
@@ -59,17 +62,22 @@ void load_game_code_impl(GameCode *game_code, LinearArena *scratch)
 void unload_game_code_impl(GameCode *game_code)
 {
     game_code->update_and_render = 0;
+    game_code->prepare_for_reload = 0;
     dlclose(game_code->handle);
     game_code->handle = 0;
 }
 
-void reload_game_code_if_recompiled_impl(GameCode *game_code, LinearArena *frame_arena)
+void reload_game_code_if_recompiled_impl(GameCode *game_code, Game *game, PlatformCode platform_code,
+    LinearArena *frame_arena)
 {
     Timestamp so_mod_time =
 	platform_get_file_info(str_lit(GAME_SO_PATH), frame_arena).last_modification_time;
 
     if (timestamp_less_than(game_code->last_load_time, so_mod_time)
         && !platform_file_exists(str_lit(COMPILATION_LOCK_FILE_PATH), frame_arena)) {
+        // Background jobs may still be running code from the old library
+        game_code->prepare_for_reload(game, platform_code);
+
         unload_game_code(game_code);
         load_game_code(game_code, frame_arena);
 
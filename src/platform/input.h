@@ -132,4 +132,43 @@ static inline void input_consume_input(Input *input, Key key)
     input->previous_keystates[key] = KEYSTATE_UP;
 }
 
+static inline b32 keystate_is_edge(Keystate keystate)
+{
+    b32 result = (keystate == KEYSTATE_PRESSED) || (keystate == KEYSTATE_RELEASED);
+
+    return result;
+}
+
+// Keeps presses and releases in latched until a simulation step has seen them, so they're
+// neither lost on frames that run no steps nor repeated on frames that run several. A press
+// that hasn't been seen yet wins over a later release since presses are what trigger actions.
+static inline void input_latch_edges(Input *latched, const Input *input)
+{
+    Input result = *input;
+
+    for (s32 key = 0; key < KEY_COUNT; ++key) {
+        Keystate latched_state = latched->keystates[key];
+        b32 keep_latched = keystate_is_edge(latched_state)
+            && (!keystate_is_edge(input->keystates[key]) || (latched_state == KEYSTATE_PRESSED));
+
+        if (keep_latched) {
+            result.keystates[key] = latched_state;
+        }
+    }
+
+    *latched = result;
+}
+
+// Turns presses into holds and releases into ups once a simulation step has seen them
+static inline void input_clear_edges(Input *input)
+{
+    for (s32 key = 0; key < KEY_COUNT; ++key) {
+        if (input->keystates[key] == KEYSTATE_PRESSED) {
+            input->keystates[key] = KEYSTATE_HELD;
+        } else if (input->keystates[key] == KEYSTATE_RELEASED) {
+            input->keystates[key] = KEYSTATE_UP;
+        }
+    }
+}
+
 #endif //INPUT_H
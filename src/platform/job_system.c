@@ -0,0 +1,149 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "job_system.h"
+
+typedef struct {
+    JobFunction *function;
+    void        *data;
+    JobCounter  *counter;
+} Job;
+
+typedef struct {
+    pthread_t        workers[JOB_SYSTEM_MAX_WORKERS];
+    s32              worker_count;
+
+    pthread_mutex_t  lock;
+    pthread_cond_t   jobs_available;
+    Job              queue[JOB_QUEUE_CAPACITY]; // NOTE: must be power of 2
+    ssize            queue_head;
+    ssize            queue_count;
+    b32              should_terminate;
+} JobSystem;
+
+static JobSystem g_job_system;
+
+static void run_job(Job job)
+{
+    job.function(job.data);
+    atomic_add_s32(&job.counter->pending_jobs, -1);
+}
+
+// Must be called with the lock held
+static b32 try_pop_job(Job *out_job)
+{
+    if (g_job_system.queue_count == 0) {
+        return false;
+    }
+
+    *out_job = g_job_system.queue[g_job_system.queue_head];
+    g_job_system.queue_head = mod_index((u64)(g_job_system.queue_head + 1), JOB_QUEUE_CAPACITY);
+    --g_job_system.queue_count;
+
+    return true;
+}
+
+static void *job_worker_thread(void *data)
+{
+    (void)data;
+
+    for (;;) {
+        pthread_mutex_lock(&g_job_system.lock);
+
+        while ((g_job_system.queue_count == 0) && !g_job_system.should_terminate) {
+            pthread_cond_wait(&g_job_system.jobs_available, &g_job_system.lock);
+        }
+
+        Job job = {0};
+        b32 has_job = try_pop_job(&job);
+        b32 should_terminate = g_job_system.should_terminate;
+
+        pthread_mutex_unlock(&g_job_system.lock);
+
+        if (has_job) {
+            run_job(job);
+        } else if (should_terminate) {
+            break;
+        }
+    }
+
+    return 0;
+}
+
+void job_system_initialize(void)
+{
+    ASSERT(is_pow2(JOB_QUEUE_CAPACITY));
+
+    pthread_mutex_init(&g_job_system.lock, 0);
+    pthread_cond_init(&g_job_system.jobs_available, 0);
+
+    // Leave one core for the main thread
+    s32 core_count = (s32)sysconf(_SC_NPROCESSORS_ONLN);
+    g_job_system.worker_count = CLAMP(core_count - 1, 1, JOB_SYSTEM_MAX_WORKERS);
+
+    for (s32 i = 0; i < g_job_system.worker_count; ++i) {
+        pthread_create(&g_job_system.workers[i], 0, job_worker_thread, 0);
+    }
+}
+
+void job_system_shutdown(void)
+{
+    pthread_mutex_lock(&g_job_system.lock);
+    g_job_system.should_terminate = true;
+    pthread_cond_broadcast(&g_job_system.jobs_available);
+    pthread_mutex_unlock(&g_job_system.lock);
+
+    for (s32 i = 0; i < g_job_system.worker_count; ++i) {
+        pthread_join(g_job_system.workers[i], 0);
+    }
+
+    pthread_cond_destroy(&g_job_system.jobs_available);
+    pthread_mutex_destroy(&g_job_system.lock);
+}
+
+void job_system_submit(JobFunction *function, void *data, JobCounter *counter)
+{
+    Job job = {function, data, counter};
+    atomic_add_s32(&counter->pending_jobs, 1);
+
+    pthread_mutex_lock(&g_job_system.lock);
+
+    b32 queue_full = g_job_system.queue_count == JOB_QUEUE_CAPACITY;
+
+    if (!queue_full) {
+        ssize index = mod_index((u64)(g_job_system.queue_head + g_job_system.queue_count),
+            JOB_QUEUE_CAPACITY);
+        g_job_system.queue[index] = job;
+        ++g_job_system.queue_count;
+
+        pthread_cond_signal(&g_job_system.jobs_available);
+    }
+
+    pthread_mutex_unlock(&g_job_system.lock);
+
+    if (queue_full) {
+        // Run it right away instead of blocking until there's room
+        run_job(job);
+    }
+}
+
+void job_system_wait_for_counter(JobCounter *counter)
+{
+    while (!job_counter_is_done(counter)) {
+        pthread_mutex_lock(&g_job_system.lock);
+
+        Job job = {0};
+        b32 has_job = try_pop_job(&job);
+
+        pthread_mutex_unlock(&g_job_system.lock);
+
+        if (has_job) {
+            run_job(job);
+        } else {
+            sched_yield();
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include "platform.h"
+
+/*
+  Fixed pool of worker threads pulling jobs from a single queue. Threads waiting on
+  a counter help out by running queued jobs themselves.
+ */
+
+#define JOB_QUEUE_CAPACITY 512
+#define JOB_SYSTEM_MAX_WORKERS 16
+
+void job_system_initialize(void);
+void job_system_shutdown(void);
+void job_system_submit(JobFunction *function, void *data, JobCounter *counter);
+void job_system_wait_for_counter(JobCounter *counter);
+
+#endif //JOB_SYSTEM_H
@@ -7,18 +7,35 @@
 #include "base/vector.h"
 #include "base/span.h"
 #include "base/timestamp.h"
+#include "base/image.h"
 
 /* Window */
 typedef struct WindowHandle WindowHandle;
 
+/* Jobs */
+typedef void (JobFunction)(void *data);
+
+// Incremented when a job is submitted and decremented once it has finished
+typedef struct {
+    s32 pending_jobs;
+} JobCounter;
+
 typedef Vector2 (PlatformGetTextDimensions)(FontHandle, String, s32);
 typedef f32     (PlatformGetTextNewlineAdvance)(FontHandle, s32);
 typedef f32     (PlatformGetFontBaselineOffset)(FontHandle, s32);
+typedef TextureHandle (PlatformCreateTexture)(Image);
+typedef void    (PlatformUpdateTexture)(TextureHandle, Image);
+typedef void    (PlatformSubmitJob)(JobFunction *, void *, JobCounter *);
+typedef void    (PlatformWaitForJobs)(JobCounter *);
 
 typedef struct {
     PlatformGetTextDimensions *get_text_dimensions;
     PlatformGetTextNewlineAdvance *get_text_newline_advance; // TODO: not needed?
     PlatformGetFontBaselineOffset *get_font_baseline_offset;
+    PlatformCreateTexture *create_texture;
+    PlatformUpdateTexture *update_texture;
+    PlatformSubmitJob *submit_job;
+    PlatformWaitForJobs *wait_for_jobs;
 } PlatformCode;
 
 enum {
@@ -29,6 +46,8 @@ WindowHandle  *platform_create_window(s32 width, s32 height, const char *title,
 void           platform_destroy_window(WindowHandle *handle);
 bool           platform_window_should_close(WindowHandle *handle);
 void           platform_poll_events(WindowHandle *window);
+void           platform_swap_buffers(WindowHandle *window);
+void           platform_make_context_current(WindowHandle *window); // Null releases the current context
 Vector2i       platform_get_window_size(WindowHandle *window);
 
 /* Input */
@@ -104,6 +123,60 @@ static inline void atomic_store_s32(s32 *ptr, s32 new_value)
 #endif
 }
 
+// Sees everything written before the matching atomic_store_release_s32
+static inline s32 atomic_load_acquire_s32(s32 *ptr)
+{
+    ASSERT(ptr);
+#if __GNUC__
+    s32 result = __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+    return result;
+#else
+#  error
+#endif
+}
+
+static inline void atomic_store_release_s32(s32 *ptr, s32 new_value)
+{
+    ASSERT(ptr);
+#if __GNUC__
+    __atomic_store_n(ptr, new_value, __ATOMIC_RELEASE);
+#else
+#  error
+#endif
+}
+
+// Orders earlier stores before later loads, which acquire and release alone don't
+static inline void atomic_full_barrier(void)
+{
+#if __GNUC__
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+#else
+#  error
+#endif
+}
+
+static inline s32 atomic_add_s32(s32 *ptr, s32 value)
+{
+    ASSERT(ptr);
+#if __GNUC__
+    s32 result = __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+    return result;
+#else
+#  error
+#endif
+}
+
+static inline b32 job_counter_is_done(JobCounter *counter)
+{
+    ASSERT(counter);
+#if __GNUC__
+    b32 result = __atomic_load_n(&counter->pending_jobs, __ATOMIC_ACQUIRE) == 0;
+    return result;
+#else
+#  error
+#endif
+}
+
 /* Misc */
 void platform_trap_on_fp_exceptions(void);
 
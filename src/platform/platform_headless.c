@@ -0,0 +1,97 @@
+#define _GNU_SOURCE
+
+#include <string.h>
+#include <time.h>
+
+#include "platform.h"
+#include "input.h"
+
+/*
+  Stands in for platform_glfw.c when running without a window. No windows can be created,
+  so the rest of the window functions are never reached, and input stays untouched.
+ */
+
+/* Window */
+WindowHandle *platform_create_window(s32 width, s32 height, const char *title, u32 window_flags, Allocator allocator)
+{
+    (void)width;
+    (void)height;
+    (void)title;
+    (void)window_flags;
+    (void)allocator;
+
+    return 0;
+}
+
+void platform_destroy_window(WindowHandle *handle)
+{
+    (void)handle;
+    ASSERT(false);
+}
+
+bool platform_window_should_close(WindowHandle *handle)
+{
+    (void)handle;
+    ASSERT(false);
+
+    return true;
+}
+
+void platform_poll_events(WindowHandle *window)
+{
+    (void)window;
+}
+
+void platform_swap_buffers(WindowHandle *window)
+{
+    (void)window;
+    ASSERT(false);
+}
+
+void platform_make_context_current(WindowHandle *window)
+{
+    ASSERT(!window);
+}
+
+Vector2i platform_get_window_size(WindowHandle *window)
+{
+    (void)window;
+    ASSERT(false);
+
+    Vector2i result = {0};
+
+    return result;
+}
+
+/* Input */
+void platform_update_input(Input *input, WindowHandle *window)
+{
+    (void)window;
+
+    memcpy(input->previous_keystates, input->keystates, KEY_COUNT * sizeof(*input->keystates));
+    input->scroll_delta = 0.0f;
+}
+
+void platform_initialize_input(Input *input, struct WindowHandle *window)
+{
+    (void)window;
+    input->mouse_click_position = v2(-1.0f, -1.0f);
+}
+
+/* Time */
+f32 platform_get_seconds_since_launch(void)
+{
+    static struct timespec launch_time;
+
+    if ((launch_time.tv_sec == 0) && (launch_time.tv_nsec == 0)) {
+        clock_gettime(CLOCK_MONOTONIC, &launch_time);
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    f64 seconds = (f64)(now.tv_sec - launch_time.tv_sec) + (f64)(now.tv_nsec - launch_time.tv_nsec) / 1e9;
+    f32 result = (f32)seconds;
+
+    return result;
+}
@@ -0,0 +1,312 @@
+#define _GNU_SOURCE
+
+#include <pthread.h>
+
+#include "render_thread.h"
+#include "asset_system.h"
+#include "renderer/backend/render_command_interpreter.h"
+
+// Counters wrap at twice the frame count so that a full ring can be told apart from an empty one
+#define RENDER_THREAD_COUNTER_WRAP (RENDER_THREAD_FRAME_COUNT * 2)
+
+typedef struct {
+    RenderThreadSettings settings;
+    pthread_t            thread;
+    LinearArena          scratch; // Only touched by the thread executing frames
+
+    RenderFrame          frames[RENDER_THREAD_FRAME_COUNT];
+    s32                  frames_submitted; // Only written by the game thread
+    s32                  frames_executed;  // Only written by the render thread
+
+    RenderThreadTask    *task;
+    void                *task_data;
+    s32                  task_pending;
+    s32                  should_terminate;
+
+    // Only used for sleeping when the counters say there is nothing to do yet. Waking is
+    // skipped unless a thread has announced that it's going to sleep.
+    pthread_mutex_t      wake_mutex;
+    pthread_cond_t       wake_condition;
+    s32                  sleeping_waiters;
+} RenderThread;
+
+typedef struct {
+    Image         image;
+    TextureHandle handle;
+} TextureTask;
+
+static RenderThread g_render_thread;
+
+static s32 frames_in_flight(s32 submitted, s32 executed)
+{
+    s32 result = (submitted - executed + RENDER_THREAD_COUNTER_WRAP) % RENDER_THREAD_COUNTER_WRAP;
+    ASSERT(result <= RENDER_THREAD_FRAME_COUNT);
+
+    return result;
+}
+
+typedef b32 (RenderThreadCondition)(void);
+
+// Returns right away when the condition already holds, which is the common case
+static void wait_until(RenderThreadCondition *condition)
+{
+    if (condition()) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_render_thread.wake_mutex);
+
+    // Pairs with the barrier in wake_other_thread, either the condition is seen to hold
+    // below or the waker sees this thread sleeping
+    atomic_add_s32(&g_render_thread.sleeping_waiters, 1);
+    atomic_full_barrier();
+
+    while (!condition()) {
+        pthread_cond_wait(&g_render_thread.wake_condition, &g_render_thread.wake_mutex);
+    }
+
+    atomic_add_s32(&g_render_thread.sleeping_waiters, -1);
+    pthread_mutex_unlock(&g_render_thread.wake_mutex);
+}
+
+// Called after changing a counter or flag. Nothing is locked unless the other thread is
+// sleeping, in which case taking the lock makes sure that it's already waiting on the
+// condition variable.
+static void wake_other_thread(void)
+{
+    atomic_full_barrier();
+
+    if (atomic_load_s32(&g_render_thread.sleeping_waiters) > 0) {
+        pthread_mutex_lock(&g_render_thread.wake_mutex);
+        pthread_cond_broadcast(&g_render_thread.wake_condition);
+        pthread_mutex_unlock(&g_render_thread.wake_mutex);
+    }
+}
+
+static b32 render_thread_has_work(void)
+{
+    s32 submitted = atomic_load_acquire_s32(&g_render_thread.frames_submitted);
+
+    b32 result = atomic_load_acquire_s32(&g_render_thread.task_pending)
+        || (frames_in_flight(submitted, g_render_thread.frames_executed) > 0)
+        || atomic_load_acquire_s32(&g_render_thread.should_terminate);
+
+    return result;
+}
+
+static b32 next_frame_slot_is_free(void)
+{
+    s32 executed = atomic_load_acquire_s32(&g_render_thread.frames_executed);
+    b32 result = frames_in_flight(g_render_thread.frames_submitted, executed) < RENDER_THREAD_FRAME_COUNT;
+
+    return result;
+}
+
+static b32 task_is_done(void)
+{
+    b32 result = !atomic_load_acquire_s32(&g_render_thread.task_pending);
+
+    return result;
+}
+
+static RenderFrame *frame_from_counter(s32 counter)
+{
+    RenderFrame *result = &g_render_thread.frames[counter % RENDER_THREAD_FRAME_COUNT];
+
+    return result;
+}
+
+static void execute_frame(RenderFrame *frame)
+{
+    RenderThreadSettings *settings = &g_render_thread.settings;
+    RendererBackend *backend = settings->backend;
+    RenderStats stats = {0};
+
+    la_reset(&g_render_thread.scratch);
+    renderer_backend_begin_frame(backend);
+
+    for (RenderBatch *batch = list_head(&frame->batches); batch; batch = list_next(batch)) {
+        execute_render_commands(batch, backend, &stats, &g_render_thread.scratch);
+    }
+
+    renderer_backend_set_stencil_function(backend, STENCIL_FUNCTION_ALWAYS, 0);
+
+    ShaderAsset *light_blending_shader = assets_get_shader(settings->light_blending_shader);
+    renderer_backend_blend_framebuffers(backend, FRAME_BUFFER_GAMEPLAY, FRAME_BUFFER_LIGHTING,
+        light_blending_shader);
+
+    ShaderAsset *screenspace_texture_shader = assets_get_shader(settings->screenspace_texture_shader);
+    renderer_backend_draw_framebuffer_as_texture(backend, FRAME_BUFFER_OVERLAY, screenspace_texture_shader);
+
+    if (settings->window) {
+        platform_swap_buffers(settings->window);
+    }
+
+    frame->render_stats = stats;
+}
+
+// Tasks are run before any waiting frame so the game isn't held up for longer than needed
+static void *render_thread_main(void *data)
+{
+    (void)data;
+
+    if (g_render_thread.settings.window) {
+        platform_make_context_current(g_render_thread.settings.window);
+    }
+
+    for (;;) {
+        s32 submitted = atomic_load_acquire_s32(&g_render_thread.frames_submitted);
+        s32 executed = g_render_thread.frames_executed;
+
+        if (atomic_load_acquire_s32(&g_render_thread.task_pending)) {
+            g_render_thread.task(g_render_thread.task_data);
+            atomic_store_release_s32(&g_render_thread.task_pending, false);
+            wake_other_thread();
+        } else if (frames_in_flight(submitted, executed) > 0) {
+            execute_frame(frame_from_counter(executed));
+
+            s32 next = (executed + 1) % RENDER_THREAD_COUNTER_WRAP;
+            atomic_store_release_s32(&g_render_thread.frames_executed, next);
+            wake_other_thread();
+        } else if (atomic_load_acquire_s32(&g_render_thread.should_terminate)) {
+            break;
+        } else {
+            wait_until(render_thread_has_work);
+        }
+    }
+
+    if (g_render_thread.settings.window) {
+        platform_make_context_current(0);
+    }
+
+    return 0;
+}
+
+void render_thread_initialize(RenderThreadSettings settings)
+{
+    ASSERT(settings.backend);
+    ASSERT(settings.frame_arena_size > 0);
+
+    g_render_thread = zero_struct(RenderThread);
+    g_render_thread.settings = settings;
+    g_render_thread.scratch = la_create(default_allocator, RENDER_THREAD_SCRATCH_SIZE);
+
+    for (s32 i = 0; i < RENDER_THREAD_FRAME_COUNT; ++i) {
+        g_render_thread.frames[i].arena = la_create(default_allocator, settings.frame_arena_size);
+    }
+
+    pthread_mutex_init(&g_render_thread.wake_mutex, 0);
+    pthread_cond_init(&g_render_thread.wake_condition, 0);
+
+    if (settings.is_threaded) {
+        // The context can only be current on one thread at a time
+        if (settings.window) {
+            platform_make_context_current(0);
+        }
+
+        s32 create_result = pthread_create(&g_render_thread.thread, 0, render_thread_main, 0);
+        ASSERT(create_result == 0);
+    }
+}
+
+// Frames that have already been submitted are executed before the thread exits
+void render_thread_shutdown(void)
+{
+    if (g_render_thread.settings.is_threaded) {
+        atomic_store_release_s32(&g_render_thread.should_terminate, true);
+        wake_other_thread();
+        pthread_join(g_render_thread.thread, 0);
+
+        if (g_render_thread.settings.window) {
+            platform_make_context_current(g_render_thread.settings.window);
+        }
+    }
+
+    for (s32 i = 0; i < RENDER_THREAD_FRAME_COUNT; ++i) {
+        la_destroy(&g_render_thread.frames[i].arena);
+    }
+
+    la_destroy(&g_render_thread.scratch);
+
+    pthread_cond_destroy(&g_render_thread.wake_condition);
+    pthread_mutex_destroy(&g_render_thread.wake_mutex);
+}
+
+// Waits until the render thread is done with the frame that last used the slot
+RenderFrame *render_thread_begin_frame(void)
+{
+    wait_until(next_frame_slot_is_free);
+
+    RenderFrame *result = frame_from_counter(g_render_thread.frames_submitted);
+    la_reset(&result->arena);
+    list_clear(&result->batches);
+
+    return result;
+}
+
+void render_thread_submit_frame(RenderFrame *frame)
+{
+    s32 submitted = g_render_thread.frames_submitted;
+    ASSERT(frame == frame_from_counter(submitted));
+
+    // The batches point to the arena the game recorded them with, which by the time the
+    // frame is executed holds the next frame. Nothing may allocate through them from here on.
+    for (RenderBatch *batch = list_head(&frame->batches); batch; batch = list_next(batch)) {
+        for (RenderBatch *pass = batch; pass; pass = pass->stencil_batch) {
+            pass->arena = 0;
+        }
+    }
+
+    if (!g_render_thread.settings.is_threaded) {
+        execute_frame(frame);
+        return;
+    }
+
+    s32 next = (submitted + 1) % RENDER_THREAD_COUNTER_WRAP;
+    atomic_store_release_s32(&g_render_thread.frames_submitted, next);
+    wake_other_thread();
+}
+
+// Blocks until the task has been run
+void render_thread_run_task(RenderThreadTask *task, void *data)
+{
+    if (!g_render_thread.settings.is_threaded) {
+        task(data);
+        return;
+    }
+
+    ASSERT(!atomic_load_acquire_s32(&g_render_thread.task_pending));
+
+    g_render_thread.task = task;
+    g_render_thread.task_data = data;
+    atomic_store_release_s32(&g_render_thread.task_pending, true);
+    wake_other_thread();
+
+    wait_until(task_is_done);
+}
+
+static void create_texture_task(void *data)
+{
+    TextureTask *task = data;
+    task->handle = assets_create_texture_from_memory(task->image);
+}
+
+static void update_texture_task(void *data)
+{
+    TextureTask *task = data;
+    assets_update_texture_from_memory(task->handle, task->image);
+}
+
+TextureHandle render_thread_create_texture(Image image)
+{
+    TextureTask task = {.image = image};
+    render_thread_run_task(create_texture_task, &task);
+
+    return task.handle;
+}
+
+void render_thread_update_texture(TextureHandle handle, Image image)
+{
+    TextureTask task = {.image = image, .handle = handle};
+    render_thread_run_task(update_texture_task, &task);
+}
@@ -0,0 +1,49 @@
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "platform.h"
+#include "renderer/backend/renderer_backend.h"
+#include "renderer/frontend/render_batch.h"
+#include "renderer/frontend/render_stats.h"
+
+/*
+  Executes render batches on a thread of its own, which owns the GPU context. The game
+  records a frame into one of the frame arenas while the previous frame is being executed
+  from another. Frames are handed over through two counters, one written by each side, so
+  neither side takes a lock while the other is keeping up. A side that has to wait marks
+  itself as sleeping and sleeps on a condition variable instead of spinning, and only then
+  does the other side lock to wake it.
+
+  Work that needs the GPU context, like creating textures, is run on the render thread
+  between frames with render_thread_run_task.
+ */
+
+#define RENDER_THREAD_FRAME_COUNT   2
+#define RENDER_THREAD_SCRATCH_SIZE  MB(16)
+
+typedef struct {
+    LinearArena     arena;        // Everything the batches point to lives here
+    RenderBatchList batches;
+    RenderStats     render_stats; // From the last time this frame slot was executed
+} RenderFrame;
+
+typedef struct {
+    RendererBackend *backend;
+    WindowHandle    *window; // Null when rendering headless, otherwise buffers are swapped after each frame
+    ShaderHandle     light_blending_shader;
+    ShaderHandle     screenspace_texture_shader;
+    ssize            frame_arena_size;
+    b32              is_threaded; // Otherwise frames are executed by the thread submitting them
+} RenderThreadSettings;
+
+typedef void (RenderThreadTask)(void *data);
+
+void          render_thread_initialize(RenderThreadSettings settings);
+void          render_thread_shutdown(void);
+RenderFrame  *render_thread_begin_frame(void);
+void          render_thread_submit_frame(RenderFrame *frame);
+void          render_thread_run_task(RenderThreadTask *task, void *data);
+TextureHandle render_thread_create_texture(Image image);
+void          render_thread_update_texture(TextureHandle handle, Image image);
+
+#endif //RENDER_THREAD_H
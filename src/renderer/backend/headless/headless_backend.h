@@ -0,0 +1,10 @@
+#ifndef HEADLESS_BACKEND_H
+#define HEADLESS_BACKEND_H
+
+#include "renderer/backend/renderer_backend.h"
+
+// Every flush blocks the calling thread for this long, standing in for the time a real
+// driver takes to accept a draw call. Zero, the default, makes flushes free.
+void headless_backend_set_flush_cost(RendererBackend *backend, s64 flush_cost_in_nanoseconds);
+
+#endif //HEADLESS_BACKEND_H
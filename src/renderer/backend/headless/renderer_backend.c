@@ -0,0 +1,255 @@
+#define _GNU_SOURCE
+
+#include <sys/prctl.h>
+#include <time.h>
+
+#include "headless_backend.h"
+#include "base/allocator.h"
+#include "base/rectangle.h"
+#include "base/utils.h"
+#include "base/vertex.h"
+#include "renderer/frontend/render_target.h"
+#include "renderer/backend/renderer_backend.h"
+#include "renderer/backend/vertex_buffer.h"
+
+/*
+  Backend that batches vertices exactly like the OpenGL backend but never draws them. Used
+  to measure how render batches are submitted without a window or GPU context.
+ */
+
+struct RendererBackend {
+    VertexBuffer vertex_buffer;
+    ssize        draw_calls;
+    ssize        vertices_drawn;
+    s64          flush_cost_in_nanoseconds;
+};
+
+struct ShaderAsset {
+    String source;
+};
+
+struct TextureAsset {
+    Image image;
+};
+
+RendererBackend *renderer_backend_initialize(Vector2i window_dims, Allocator allocator)
+{
+    (void)window_dims;
+
+    RendererBackend *state = allocate_item(allocator, RendererBackend);
+    ASSERT(state->vertex_buffer.vertex_count == 0);
+    ASSERT(state->vertex_buffer.index_count == 0);
+
+    return state;
+}
+
+ShaderAsset *renderer_backend_create_shader(String shader_source, Allocator allocator)
+{
+    ShaderAsset *result = allocate_item(allocator, ShaderAsset);
+    result->source = shader_source;
+
+    return result;
+}
+
+void renderer_backend_destroy_shader(ShaderAsset *shader, Allocator allocator)
+{
+    deallocate(allocator, shader);
+}
+
+TextureAsset *renderer_backend_create_texture(Image image, Allocator allocator)
+{
+    TextureAsset *result = allocate_item(allocator, TextureAsset);
+    result->image = image;
+
+    return result;
+}
+
+void renderer_backend_update_texture(TextureAsset *texture, Image image)
+{
+    texture->image = image;
+}
+
+void renderer_backend_destroy_texture(TextureAsset *texture, Allocator allocator)
+{
+    deallocate(allocator, texture);
+}
+
+void renderer_backend_use_shader(ShaderAsset *shader)
+{
+    (void)shader;
+}
+
+void renderer_backend_bind_texture(TextureAsset *texture)
+{
+    (void)texture;
+}
+
+void renderer_backend_set_global_projection(RendererBackend *backend, Matrix4 matrix)
+{
+    (void)backend;
+    (void)matrix;
+}
+
+void renderer_backend_set_uniform_vec4(ShaderAsset *shader, String uniform_name, Vector4 vec, LinearArena *scratch)
+{
+    (void)shader;
+    (void)uniform_name;
+    (void)vec;
+    (void)scratch;
+}
+
+void renderer_backend_set_uniform_float(ShaderAsset *shader, String uniform_name, f32 value, LinearArena *scratch)
+{
+    (void)shader;
+    (void)uniform_name;
+    (void)value;
+    (void)scratch;
+}
+
+void renderer_backend_clear_color_buffer(RGBA32 color)
+{
+    (void)color;
+}
+
+void headless_backend_set_flush_cost(RendererBackend *backend, s64 flush_cost_in_nanoseconds)
+{
+    ASSERT(flush_cost_in_nanoseconds >= 0);
+
+    backend->flush_cost_in_nanoseconds = flush_cost_in_nanoseconds;
+
+    // The default 50 us timer slack would swamp short costs. Threads started after this,
+    // such as the render thread, inherit the tighter slack.
+    prctl(PR_SET_TIMERSLACK, 1000UL);
+}
+
+void renderer_backend_flush(RendererBackend *backend)
+{
+    if (backend->vertex_buffer.index_count == 0) {
+        return;
+    }
+
+    backend->vertices_drawn += backend->vertex_buffer.vertex_count;
+    vertex_buffer_reset(&backend->vertex_buffer);
+    ++backend->draw_calls;
+
+    if (backend->flush_cost_in_nanoseconds > 0) {
+        struct timespec duration = {
+            .tv_sec = backend->flush_cost_in_nanoseconds / 1000000000,
+            .tv_nsec = backend->flush_cost_in_nanoseconds % 1000000000
+        };
+
+        nanosleep(&duration, 0);
+    }
+}
+
+ssize renderer_backend_get_draw_call_count(RendererBackend *backend)
+{
+    return backend->draw_calls;
+}
+
+ssize renderer_backend_get_vertex_count(RendererBackend *backend)
+{
+    return backend->vertices_drawn;
+}
+
+static void flush_if_needed(RendererBackend *backend, s32 vertices_to_draw, ssize indices_to_draw)
+{
+    if (vertex_buffer_flush_needed(&backend->vertex_buffer, vertices_to_draw, indices_to_draw)) {
+        renderer_backend_flush(backend);
+    }
+}
+
+void renderer_backend_draw_triangle(RendererBackend *backend, Vertex a, Vertex b, Vertex c)
+{
+    flush_if_needed(backend, 3, 3);
+
+    vertex_buffer_push_triangle(&backend->vertex_buffer, a, b, c);
+}
+
+void renderer_backend_draw_quad(RendererBackend *backend, Vertex a, Vertex b, Vertex c, Vertex d)
+{
+    flush_if_needed(backend, 4, 6);
+
+    vertex_buffer_push_quad(&backend->vertex_buffer, a, b, c, d);
+}
+
+void renderer_backend_change_framebuffer(RendererBackend *backend, FrameBuffer render_target)
+{
+    (void)backend;
+    (void)render_target;
+}
+
+void renderer_backend_change_to_main_framebuffer(RendererBackend *backend)
+{
+    (void)backend;
+}
+
+void renderer_backend_blend_framebuffers(RendererBackend *backend, FrameBuffer a, FrameBuffer b,
+    ShaderAsset *shader)
+{
+    (void)a;
+    (void)b;
+    (void)shader;
+
+    Rectangle rect = {{-1, -1}, {2, 2}};
+    RectangleVertices verts = rect_get_vertices(rect, RGBA32_WHITE, Y_IS_DOWN);
+
+    renderer_backend_draw_quad(backend, verts.top_left, verts.top_right,
+        verts.bottom_right, verts.bottom_left);
+    renderer_backend_flush(backend);
+}
+
+void renderer_backend_set_blend_function(BlendFunction function)
+{
+    (void)function;
+}
+
+void renderer_backend_draw_framebuffer_as_texture(RendererBackend *backend, FrameBuffer render_target,
+    ShaderAsset *shader)
+{
+    (void)render_target;
+    (void)shader;
+
+    Rectangle rect = {{-1, -1}, {2, 2}};
+    RectangleVertices verts = rect_get_vertices(rect, RGBA32_WHITE, Y_IS_DOWN);
+
+    renderer_backend_draw_quad(backend, verts.top_left, verts.top_right,
+        verts.bottom_right, verts.bottom_left);
+    renderer_backend_flush(backend);
+}
+
+void renderer_backend_begin_frame(RendererBackend *backend)
+{
+    (void)backend;
+}
+
+void renderer_backend_enable_stencil_writes(void)
+{
+}
+
+void renderer_backend_disable_stencil_writes(void)
+{
+}
+
+void renderer_backend_enable_color_buffer_writes(RendererBackend *backend)
+{
+    (void)backend;
+}
+
+void renderer_backend_disable_color_buffer_writes(RendererBackend *backend)
+{
+    (void)backend;
+}
+
+void renderer_backend_set_stencil_function(RendererBackend *backend, StencilFunction function, s32 arg)
+{
+    (void)backend;
+    (void)function;
+    (void)arg;
+}
+
+void renderer_backend_set_stencil_pass_operation(RendererBackend *backend, StencilOperation op)
+{
+    (void)backend;
+    (void)op;
+}
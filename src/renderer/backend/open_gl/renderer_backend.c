@@ -62,6 +62,8 @@ struct RendererBackend {
     BackendFramebuffer framebuffers[FRAME_BUFFER_COUNT];
 
     VertexBuffer vertex_buffer;
+    ssize        draw_calls;
+    ssize        vertices_drawn;
 };
 
 struct ShaderAsset {
@@ -378,6 +380,18 @@ TextureAsset *renderer_backend_create_texture(Image image, Allocator allocator)
     return handle;
 }
 
+// Image must have the same dimensions and channel count as the one the texture was created with
+void renderer_backend_update_texture(TextureAsset *texture, Image image)
+{
+    ASSERT(image.channels == 4);
+
+    glBindTexture(GL_TEXTURE_2D, texture->native_handle);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image.width, image.height, GL_RGBA, GL_UNSIGNED_BYTE,
+        image.data);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
 void renderer_backend_destroy_texture(TextureAsset *texture, Allocator allocator)
 {
     glDeleteTextures(1, &texture->native_handle);
@@ -441,6 +455,10 @@ void renderer_backend_clear_color_buffer(RGBA32 color)
 
 void renderer_backend_flush(RendererBackend *backend)
 {
+    if (backend->vertex_buffer.index_count == 0) {
+        return;
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, backend->vbo);
     glBufferSubData(GL_ARRAY_BUFFER, 0, (usize)backend->vertex_buffer.vertex_count
         * sizeof(*backend->vertex_buffer.vertices), backend->vertex_buffer.vertices);
@@ -453,7 +471,19 @@ void renderer_backend_flush(RendererBackend *backend)
     glDrawElements(GL_TRIANGLES, backend->vertex_buffer.index_count, GL_UNSIGNED_INT, 0);
     glBindVertexArray(0);
 
+    backend->vertices_drawn += backend->vertex_buffer.vertex_count;
     vertex_buffer_reset(&backend->vertex_buffer);
+    ++backend->draw_calls;
+}
+
+ssize renderer_backend_get_draw_call_count(RendererBackend *backend)
+{
+    return backend->draw_calls;
+}
+
+ssize renderer_backend_get_vertex_count(RendererBackend *backend)
+{
+    return backend->vertices_drawn;
 }
 
 void renderer_backend_draw_triangle(RendererBackend *backend, Vertex a, Vertex b, Vertex c)
@@ -9,18 +9,22 @@
 #include "renderer/frontend/render_key.h"
 #include "renderer/frontend/render_target.h"
 #include "renderer/backend/renderer_backend.h"
+#include "renderer/backend/tessellation.h"
 #include "game/particle.h"
 
-#define INVALID_RENDERER_STATE (RendererState){{(AssetID)-1}, {(AssetID)-1}}
+#define INVALID_RENDERER_STATE (RendererState){{(AssetID)-1}, {(AssetID)-1}, {(AssetID)-1}, {{0, 0}, {1, 1}}}
 
 typedef struct {
     ShaderHandle shader;
-    TextureHandle texture;
+    TextureHandle texture;        // What is bound, the atlas page for packed textures
+    TextureHandle source_texture; // What the render entry asked for
+    Rectangle uv_rect;            // Where the source texture is within the bound texture
 } RendererState;
 
 static RendererState get_state_needed_for_entry(RenderKey key)
 {
     RendererState result = {0};
+    result.uv_rect = (Rectangle){{0.0f, 0.0f}, {1.0f, 1.0f}};
 
     RenderKey shader_id = render_key_extract_shader(key);
     RenderKey texture_id = render_key_extract_texture(key);
@@ -32,8 +36,13 @@ static RendererState get_state_needed_for_entry(RenderKey key)
         TextureHandle font_texture_handle = font_get_texture_handle(font_asset);
 
         result.texture = font_texture_handle;
-    } else {
-        result.texture = (TextureHandle){(u32)texture_id};
+        result.source_texture = font_texture_handle;
+    } else if (texture_id != NULL_TEXTURE.id) {
+        TextureRegion region = assets_get_texture_region((TextureHandle){(u32)texture_id});
+
+        result.texture = region.page;
+        result.source_texture = (TextureHandle){(u32)texture_id};
+        result.uv_rect = region.uv_rect;
     }
 
     result.shader = (ShaderHandle){(u32)shader_id};
@@ -66,59 +75,92 @@ static RendererState switch_renderer_state(RendererState new_state, RendererStat
     return new_state;
 }
 
-static void render_line(RendererBackend *backend, Vector2 start, Vector2 end, f32 thickness, RGBA32 color)
+// Textures packed into an atlas only cover part of the bound texture
+static Vertex remap_vertex_uv(Vertex vertex, Rectangle uv_rect)
+{
+    vertex.uv.x = uv_rect.position.x + vertex.uv.x * uv_rect.size.x;
+    vertex.uv.y = uv_rect.position.y + vertex.uv.y * uv_rect.size.y;
+
+    return vertex;
+}
+
+static void submit_triangle(RendererBackend *backend, const RendererState *state, Vertex a, Vertex b, Vertex c)
+{
+    Rectangle uv_rect = state->uv_rect;
+
+    renderer_backend_draw_triangle(backend, remap_vertex_uv(a, uv_rect), remap_vertex_uv(b, uv_rect),
+        remap_vertex_uv(c, uv_rect));
+}
+
+// Light vertices carry their offset from the light origin in multiples of the radius as UVs
+static Vertex get_light_vertex(const LightCmd *cmd, Vector2 position)
 {
-    Vector2 dir_r = v2_mul_s(v2_norm(v2_sub(end, start)), thickness / 2.0f);
-    Vector2 dir_l = v2_neg(dir_r);
-    Vector2 dir_u = { -dir_r.y, dir_r.x };
-    Vector2 dir_d = v2_neg(dir_u);
-
-    Vector2 tl = v2_add(v2_add(start, dir_l), dir_u);
-    Vector2 tr = v2_add(end, v2_add(dir_r, dir_u));
-    Vector2 br = v2_add(end, v2_add(dir_d, dir_r));
-    Vector2 bl = v2_add(start, v2_add(dir_d, dir_l));
-
-    // TODO: UV constants to make this easier to remember
-    Vertex vtl = {
-	.position = tl,
-	.uv = {0, 1},
-	.color = color
-    };
-
-    Vertex vtr = {
-	.position = tr,
-	.uv = {1, 1},
-	.color = color
-    };
-
-    Vertex vbr = {
-	.position = br,
-	.uv = {1, 0},
-	.color = color
-    };
-
-    Vertex vbl = {
-	.position = bl,
-	.uv = {0, 0},
-	.color = color
-    };
-
-    renderer_backend_draw_quad(backend, vtl, vtr, vbr, vbl);
+    Vertex result = {position, v2_div_s(v2_sub(position, cmd->origin), cmd->radius), cmd->color};
+
+    return result;
+}
+
+static void submit_light_triangle(RendererBackend *backend, const RendererState *state,
+    const LightCmd *cmd, Vertex a, Vertex b, Vertex c)
+{
+    if (!cmd->is_clipped) {
+        submit_triangle(backend, state, a, b, c);
+        return;
+    }
+
+    Triangle triangle = {a.position, b.position, c.position};
+    ClippedTriangle clipped = triangle_clip_to_rect(triangle, cmd->clip_rect);
+
+    for (s32 i = 1; i + 1 < clipped.count; ++i) {
+        submit_triangle(backend, state, get_light_vertex(cmd, clipped.points[0]),
+            get_light_vertex(cmd, clipped.points[i]), get_light_vertex(cmd, clipped.points[i + 1]));
+    }
+}
+
+static void submit_quad(RendererBackend *backend, const RendererState *state, Vertex a, Vertex b, Vertex c,
+    Vertex d)
+{
+    Rectangle uv_rect = state->uv_rect;
+
+    renderer_backend_draw_quad(backend, remap_vertex_uv(a, uv_rect), remap_vertex_uv(b, uv_rect),
+        remap_vertex_uv(c, uv_rect), remap_vertex_uv(d, uv_rect));
+}
+
+static void render_line(RendererBackend *backend, const RendererState *state, Vector2 start, Vector2 end,
+    f32 thickness, RGBA32 color)
+{
+    RectangleVertices verts = get_line_vertices(start, end, thickness, color);
+
+    submit_quad(backend, state, verts.top_left, verts.top_right, verts.bottom_right, verts.bottom_left);
 }
 
 static void execute_render_command(RenderEntry *entry, RenderBatch *rb, RendererState *current_state,
-    RendererBackend *backend, LinearArena *scratch)
+    RendererBackend *backend, RenderStats *stats, LinearArena *scratch)
 {
-    RenderCmdHeader *header = entry->data;
+    RenderCmdHeader *header = render_entry_command(rb, entry);
 
     RendererState needed_state = get_state_needed_for_entry(entry->key);
 
     if (renderer_state_change_needed(*current_state, needed_state)) {
         renderer_backend_flush(backend);
         *current_state = switch_renderer_state(needed_state, *current_state, backend);
+
+        ++stats->state_flushes;
+    } else {
+        if (needed_state.source_texture.id != current_state->source_texture.id) {
+            // Would have been a texture switch if these textures weren't on the same atlas page
+            ++stats->atlas_flushes_saved;
+        }
+
+        *current_state = needed_state;
     }
 
-    for (SetupCmdHeader *setup_cmd = header->first_setup_command; setup_cmd; setup_cmd = setup_cmd->next) {
+    byte *setup_cmd_ptr = (byte *)header + header->setup_commands_offset;
+
+    for (u32 i = 0; i < header->setup_command_count; ++i) {
+        SetupCmdHeader *setup_cmd = (SetupCmdHeader *)setup_cmd_ptr;
+        setup_cmd_ptr += setup_cmd->size;
+
         switch (setup_cmd->kind) {
             case RENDER_SETUP_COMMAND_ENUM_NAME(SetupCmdUniformVec4): {
                 SetupCmdUniformVec4 *cmd = (SetupCmdUniformVec4 *)setup_cmd;
@@ -137,10 +179,10 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
         }
     }
 
-    switch (entry->data->kind) {
+    switch (header->kind) {
         // TODO: can these switch cases be simplified?
         case RENDER_COMMAND_ENUM_NAME(RectangleCmd): {
-            RectangleCmd *cmd = (RectangleCmd *)entry->data;
+            RectangleCmd *cmd = (RectangleCmd *)header;
             RectangleVertices verts = rect_get_vertices(cmd->rect, cmd->color, rb->y_direction);
             ASSERT(rect_is_valid(cmd->rect));
 
@@ -174,12 +216,12 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
             verts.bottom_right.position = v2_rotate_around_point(verts.bottom_right.position, rotation, origin);
             verts.bottom_left.position = v2_rotate_around_point(verts.bottom_left.position, rotation, origin);
 
-            renderer_backend_draw_quad(backend, verts.top_left, verts.top_right,
+            submit_quad(backend, current_state, verts.top_left, verts.top_right,
                 verts.bottom_right, verts.bottom_left);
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(ClippedRectangleCmd): {
-            ClippedRectangleCmd *cmd = (ClippedRectangleCmd *)entry->data;
+            ClippedRectangleCmd *cmd = (ClippedRectangleCmd *)header;
 
             Rectangle rect = cmd->rect;
             Rectangle viewport = cmd->viewport_rect;
@@ -188,8 +230,8 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
             ClippedRectangleVertices verts = rect_get_clipped_vertices(rect, viewport, color, rb->y_direction);
 
             if (verts.is_visible) {
-                renderer_backend_draw_quad(
-                    backend,
+                submit_quad(
+                    backend, current_state,
                     verts.vertices.top_left,
                     verts.vertices.top_right,
                     verts.vertices.bottom_right,
@@ -199,86 +241,73 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(TriangleCmd): {
-            TriangleCmd *cmd = (TriangleCmd *)entry->data;
+            TriangleCmd *cmd = (TriangleCmd *)header;
             Triangle triangle = cmd->triangle;
 
             TriangleVertices verts = triangle_get_vertices(triangle, cmd->color);
 
-            renderer_backend_draw_triangle(backend, verts.a, verts.b, verts.c);
+            submit_triangle(backend, current_state, verts.a, verts.b, verts.c);
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(OutlinedTriangleCmd): {
-            OutlinedTriangleCmd *cmd = (OutlinedTriangleCmd *)entry->data;
+            OutlinedTriangleCmd *cmd = (OutlinedTriangleCmd *)header;
             Triangle triangle = cmd->triangle;
             RGBA32 color = cmd->color;
             f32 thickness = cmd->thickness;
 
-            render_line(backend, triangle.a, triangle.b, thickness, color);
-            render_line(backend, triangle.b, triangle.c, thickness, color);
-            render_line(backend, triangle.c, triangle.a, thickness, color);
+            render_line(backend, current_state, triangle.a, triangle.b, thickness, color);
+            render_line(backend, current_state, triangle.b, triangle.c, thickness, color);
+            render_line(backend, current_state, triangle.c, triangle.a, thickness, color);
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(OutlinedRectangleCmd): {
-            OutlinedRectangleCmd *cmd = (OutlinedRectangleCmd *)entry->data;
+            OutlinedRectangleCmd *cmd = (OutlinedRectangleCmd *)header;
             ASSERT(cmd->rect.size.x > 0.0f && cmd->rect.size.y > 0.0f);
 
-            RGBA32 color = cmd->color;
-            f32 thick = cmd->thickness;
-
-            Vector2 tl = rect_top_left(cmd->rect);
-            Vector2 tr = rect_top_right(cmd->rect);
-            Vector2 br = rect_bottom_right(cmd->rect);
-            Vector2 bl = rect_bottom_left(cmd->rect);
-
             // TODO: These lines overlap which looks wrong when color is transparent
-            render_line(backend, tl, v2_sub(tr, v2(thick, 0.0f)), thick, color);
-            render_line(backend, tr, v2_add(br, v2(0.0f, thick)), thick, color);
-            render_line(backend, br, v2_add(bl, v2(thick, 0.0f)), thick, color);
-            render_line(backend, bl, v2_sub(tl, v2(0.0f, thick)), thick, color);
+            OutlinedRectangleVertices outline = get_outlined_rectangle_vertices(cmd->rect, cmd->thickness,
+                cmd->color);
+
+            for (s32 i = 0; i < ARRAY_COUNT(outline.edges); ++i) {
+                RectangleVertices edge = outline.edges[i];
 
+                submit_quad(backend, current_state, edge.top_left, edge.top_right, edge.bottom_right,
+                    edge.bottom_left);
+            }
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(CircleCmd): {
-            CircleCmd *cmd = (CircleCmd *)entry->data;
+            CircleCmd *cmd = (CircleCmd *)header;
 
-            s32 segments = 64;
             f32 radius = cmd->radius;
-            f32 posx = cmd->position.x;
-            f32 posy = cmd->position.y;
+            Vector2 center = cmd->position;
             RGBA32 color = cmd->color;
+            UnitCircle circle = get_unit_circle(radius * rb->world_to_screen_scale);
 
-            Vertex a = { {posx, posy}, {0.5f, 0.5f}, color };
-
-            f32 step_angle = (2.0f * PI) / (f32)segments;
+            Vertex a = { center, {0.5f, 0.5f}, color };
 
-            for (s32 k = 0; k < segments; ++k) {
-                f32 segment = (f32)k;
+            for (s32 k = 0; k < circle.segment_count; ++k) {
+                Vector2 dir1 = circle.points[k];
+                Vector2 dir2 = circle.points[k + 1];
 
-                f32 x1 = posx + radius * cosf(step_angle * segment);
-                f32 y1 = posy + radius * sinf(step_angle * segment);
-                f32 tx1 = (x1 / radius + 1.0f) * 0.5f;
-                f32 ty1 = 1.0f - ((y1 / radius + 1.0f) * 0.5f);
+                Vector2 uv1 = {(dir1.x + 1.0f) * 0.5f, (1.0f - dir1.y) * 0.5f};
+                Vector2 uv2 = {(dir2.x + 1.0f) * 0.5f, (1.0f - dir2.y) * 0.5f};
 
-                f32 x2 = posx + radius * cosf(step_angle * (segment + 1));
-                f32 y2 = posy + radius * sinf(step_angle * (segment + 1));
-                f32 tx2 = (x2 / radius + 1.0f) * 0.5f;
-                f32 ty2 = 1.0f - ((y2 / radius + 1.0f) * 0.5f);
+                Vertex b = { v2_add(center, v2_mul_s(dir1, radius)), uv1, color };
+                Vertex c = { v2_add(center, v2_mul_s(dir2, radius)), uv2, color };
 
-                Vertex b = { {x1, y1}, {tx1, ty1}, color};
-                Vertex c = { {x2, y2}, {tx2, ty2}, color};
-
-                renderer_backend_draw_triangle(backend, a, b, c);
+                submit_triangle(backend, current_state, a, b, c);
             }
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(LineCmd): {
-            LineCmd *cmd = (LineCmd *)entry->data;
+            LineCmd *cmd = (LineCmd *)header;
 
-            render_line(backend, cmd->start, cmd->end, cmd->thickness, cmd->color);
+            render_line(backend, current_state, cmd->start, cmd->end, cmd->thickness, cmd->color);
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(TextCmd): {
-            TextCmd *cmd = (TextCmd *)entry->data;
+            TextCmd *cmd = (TextCmd *)header;
 
             FontHandle font_handle = (FontHandle){(u32)render_key_extract_font(entry->key)};
             FontAsset *font_asset = assets_get_font(font_handle);
@@ -325,8 +354,8 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
 
                     if (verts.is_visible) {
                         // TODO: overload for this that takes RectangleVertices
-                        renderer_backend_draw_quad(
-                            backend,
+                        submit_quad(
+                            backend, current_state,
                             verts.vertices.top_left,
                             verts.vertices.top_right,
                             verts.vertices.bottom_right,
@@ -340,24 +369,23 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(ParticleGroupCmd): {
-            ParticleGroupCmd *cmd = (ParticleGroupCmd *)entry->data;
+            ParticleGroupCmd *cmd = (ParticleGroupCmd *)header;
             ParticleBuffer *particles = cmd->particles;
 
-            for (ssize p = 0; p < ring_length(particles); ++p) {
-                Particle *particle = ring_at(particles, p);
-
-                Rectangle rect = {particle->position, v2(particle->size, particle->size)};
-                RGBA32 color = particle->color;
+            for (ssize p = 0; p < particles->count; ++p) {
+                f32 size = particles->size[p];
+                Rectangle rect = {{particles->position_x[p], particles->position_y[p]}, {size, size}};
+                RGBA32 color = particles->color[p];
 
-                f32 alpha = color.a - (particle->timer / particle->lifetime) * color.a;
+                f32 alpha = color.a - (particles->timer[p] / particles->lifetime[p]) * color.a;
                 alpha = CLAMP(alpha, 0.0f, 1.0f);
 
                 color.a = alpha;
 
                 RectangleVertices verts = rect_get_vertices(rect, color, Y_IS_UP);
 
-                renderer_backend_draw_quad(
-                    backend,
+                submit_quad(
+                    backend, current_state,
                     verts.top_left,
                     verts.top_right,
                     verts.bottom_right,
@@ -367,19 +395,19 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(PolygonCmd): {
-            PolygonCmd *cmd = (PolygonCmd *)entry->data;
+            PolygonCmd *cmd = (PolygonCmd *)header;
             RGBA32 color = cmd->color;
 
             for (PolygonTriangle *tri = list_head(&cmd->polygon); tri; tri = list_next(tri)) {
                 TriangleVertices verts = triangle_get_vertices(tri->triangle, color);
 
-                renderer_backend_draw_triangle(backend, verts.a, verts.b, verts.c);
+                submit_triangle(backend, current_state, verts.a, verts.b, verts.c);
             }
 
         } break;
 
         case RENDER_COMMAND_ENUM_NAME(TriangleFanCmd): {
-            TriangleFanCmd *cmd = (TriangleFanCmd *)entry->data;
+            TriangleFanCmd *cmd = (TriangleFanCmd *)header;
 
             RGBA32 color = cmd->color;
             Vector2 center = cmd->triangle_fan.center;
@@ -390,19 +418,85 @@ static void execute_render_command(RenderEntry *entry, RenderBatch *rb, Renderer
                 Triangle triangle = {center, curr.a, curr.b};
 
                 TriangleVertices verts = triangle_get_vertices(triangle, color);
-                renderer_backend_draw_triangle(backend, verts.a, verts.b, verts.c);
+                submit_triangle(backend, current_state, verts.a, verts.b, verts.c);
+            }
+        } break;
+
+        case RENDER_COMMAND_ENUM_NAME(StaticQuadsCmd): {
+            StaticQuadsCmd *cmd = (StaticQuadsCmd *)header;
+            QuadOverlay overlay = cmd->overlay;
+            ssize next_overlay_quad = 0;
+
+            for (ssize quad = 0; quad < cmd->quad_count; ++quad) {
+                const Vertex *vertices = cmd->vertices + quad * 4;
+
+                Vertex tl = vertices[0];
+                Vertex tr = vertices[1];
+                Vertex br = vertices[2];
+                Vertex bl = vertices[3];
+
+                if ((next_overlay_quad < overlay.count) && (overlay.quads[next_overlay_quad] == quad)) {
+                    ++next_overlay_quad;
+
+                    if (overlay.alpha == 0.0f) {
+                        continue;
+                    }
+
+                    tl.color.a *= overlay.alpha;
+                    tr.color.a *= overlay.alpha;
+                    br.color.a *= overlay.alpha;
+                    bl.color.a *= overlay.alpha;
+                }
+
+                submit_quad(backend, current_state, tl, tr, br, bl);
+            }
+        } break;
+
+        case RENDER_COMMAND_ENUM_NAME(LightCmd): {
+            LightCmd *cmd = (LightCmd *)header;
+            Vector2 origin = cmd->origin;
+            f32 radius = cmd->radius;
+            RGBA32 color = cmd->color;
+
+            // The light shader reads the offset from the light origin in multiples of the
+            // radius from the UVs, so every light can share the same draw call
+            if (cmd->area.count == 0) {
+                UnitCircle circle = get_unit_circle(radius * rb->world_to_screen_scale);
+                Vertex center = {origin, {0.0f, 0.0f}, color};
+
+                for (s32 k = 0; k < circle.segment_count; ++k) {
+                    Vector2 dir1 = circle.points[k];
+                    Vector2 dir2 = circle.points[k + 1];
+
+                    Vertex b = {v2_add(origin, v2_mul_s(dir1, radius)), dir1, color};
+                    Vertex c = {v2_add(origin, v2_mul_s(dir2, radius)), dir2, color};
+
+                    submit_light_triangle(backend, current_state, cmd, center, b, c);
+                }
+            } else {
+                TriangleFan fan = cmd->area;
+                Vertex center = {fan.center, v2_div_s(v2_sub(fan.center, origin), radius), color};
+
+                for (ssize elem = 0; elem < fan.count; ++elem) {
+                    TriangleFanElement curr = fan.items[elem];
+
+                    Vertex b = {curr.a, v2_div_s(v2_sub(curr.a, origin), radius), color};
+                    Vertex c = {curr.b, v2_div_s(v2_sub(curr.b, origin), radius), color};
+
+                    submit_light_triangle(backend, current_state, cmd, center, b, c);
+                }
             }
         } break;
     }
 
     // If this render entry had setup commands we need to flush afterwards since
     // those may set uniform variables and we don't want those to leak into next render entry
-    if (header->first_setup_command) {
+    if (header->setup_command_count > 0) {
         renderer_backend_flush(backend);
     }
 }
 
-void execute_render_commands(RenderBatch *rb, RendererBackend *backend, LinearArena *scratch)
+void execute_render_commands(RenderBatch *rb, RendererBackend *backend, RenderStats *stats, LinearArena *scratch)
 {
     // NOTE: The color buffer should always be cleared, even if there is nothing to draw
     // as some batches may always need the background color to be drawn
@@ -426,7 +520,7 @@ void execute_render_commands(RenderBatch *rb, RendererBackend *backend, LinearAr
         renderer_backend_enable_stencil_writes();
         renderer_backend_disable_color_buffer_writes(backend);
 
-        execute_render_commands(stencil, backend, scratch);
+        execute_render_commands(stencil, backend, stats, scratch);
 
         // We should only write to color buffer, not stencil buffer
         renderer_backend_disable_stencil_writes();
@@ -443,6 +537,9 @@ void execute_render_commands(RenderBatch *rb, RendererBackend *backend, LinearAr
         renderer_backend_set_stencil_pass_operation(backend, rb->stencil_op);
     }
 
+    ssize draw_calls_before = renderer_backend_get_draw_call_count(backend);
+    ssize vertices_before = renderer_backend_get_vertex_count(backend);
+
     RendererState current_state = get_state_needed_for_entry(rb->entries[0].key);
     switch_renderer_state(current_state, INVALID_RENDERER_STATE, backend);
 
@@ -452,8 +549,12 @@ void execute_render_commands(RenderBatch *rb, RendererBackend *backend, LinearAr
     for (ssize i = 0; i < rb->entry_count; ++i) {
         RenderEntry *entry = &rb->entries[i];
 
-        execute_render_command(entry, rb, &current_state, backend, scratch);
+        execute_render_command(entry, rb, &current_state, backend, stats, scratch);
     }
 
     renderer_backend_flush(backend);
+
+    // Counted after the stencil pass, which counts its own draw calls
+    stats->draw_calls += renderer_backend_get_draw_call_count(backend) - draw_calls_before;
+    stats->vertices += renderer_backend_get_vertex_count(backend) - vertices_before;
 }
@@ -2,7 +2,9 @@
 #define RENDERER_DISPATCH_H
 
 #include "renderer/frontend/render_batch.h"
+#include "renderer/frontend/render_stats.h"
 
-void execute_render_commands(RenderBatch *rb, struct RendererBackend *backend, LinearArena *scratch);
+void execute_render_commands(RenderBatch *rb, struct RendererBackend *backend, RenderStats *stats,
+                             LinearArena *scratch);
 
 #endif //RENDERER_DISPATCH_H
@@ -34,6 +34,7 @@ RendererBackend *renderer_backend_initialize(Vector2i window_dims, Allocator all
 ShaderAsset     *renderer_backend_create_shader(String shader_source, Allocator allocator);
 void             renderer_backend_destroy_shader(ShaderAsset *shader, Allocator allocator);
 TextureAsset    *renderer_backend_create_texture(Image image, Allocator allocator);
+void             renderer_backend_update_texture(TextureAsset *texture, Image image);
 void             renderer_backend_destroy_texture(TextureAsset *texture, Allocator allocator);
 void             renderer_backend_use_shader(ShaderAsset *shader);
 void             renderer_backend_bind_texture(TextureAsset *texture);
@@ -44,6 +45,8 @@ void             renderer_backend_set_uniform_float(ShaderAsset *shader, String
                                                    LinearArena *scratch);
 void             renderer_backend_clear_color_buffer(RGBA32 color);
 void             renderer_backend_flush(RendererBackend *backend);
+ssize            renderer_backend_get_draw_call_count(RendererBackend *backend); // Since initialization
+ssize            renderer_backend_get_vertex_count(RendererBackend *backend); // Since initialization
 void             renderer_backend_draw_triangle(RendererBackend *backend, Vertex a, Vertex b, Vertex c);
 void             renderer_backend_draw_quad(RendererBackend *backend, Vertex a, Vertex b, Vertex c, Vertex d);
 void             renderer_backend_change_framebuffer(RendererBackend *backend, FrameBuffer render_target);
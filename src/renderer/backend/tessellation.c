@@ -0,0 +1,134 @@
+#include <math.h>
+
+#include "tessellation.h"
+#include "base/maths.h"
+#include "base/utils.h"
+
+typedef struct {
+    Vector2 points[CIRCLE_LOD_COUNT][CIRCLE_LOD_MAX_SEGMENTS + 1];
+    f32     max_screen_radius[CIRCLE_LOD_COUNT];
+    b32     is_initialized;
+} UnitCircleTables;
+
+// Corner of a line quad. Corners are offset from the start or end of the line, along and
+// across it, in multiples of half the thickness.
+typedef struct {
+    b32     from_end;
+    f32     along;
+    f32     across;
+    Vector2 uv;
+} LineQuadCorner;
+
+// Edge of a rectangle outline, in multiples of the rectangle size. The end is pulled back
+// by end_offset times the thickness so that the next edge starts where this one ends.
+typedef struct {
+    Vector2 start;
+    Vector2 end;
+    Vector2 end_offset;
+    Vector2 dir;
+} OutlineEdge;
+
+static const LineQuadCorner g_line_quad_corners[4] = {
+    {false, -1.0f,  1.0f, {0.0f, 1.0f}},
+    {true,   1.0f,  1.0f, {1.0f, 1.0f}},
+    {true,   1.0f, -1.0f, {1.0f, 0.0f}},
+    {false, -1.0f, -1.0f, {0.0f, 0.0f}},
+};
+
+static const OutlineEdge g_outline_edges[4] = {
+    {{0.0f, 1.0f}, {1.0f, 1.0f}, {-1.0f,  0.0f}, { 1.0f,  0.0f}},
+    {{1.0f, 1.0f}, {1.0f, 0.0f}, { 0.0f,  1.0f}, { 0.0f, -1.0f}},
+    {{1.0f, 0.0f}, {0.0f, 0.0f}, { 1.0f,  0.0f}, {-1.0f,  0.0f}},
+    {{0.0f, 0.0f}, {0.0f, 1.0f}, { 0.0f, -1.0f}, { 0.0f,  1.0f}},
+};
+
+// Only touched by the thread executing render commands
+static UnitCircleTables g_unit_circles;
+
+static void initialize_unit_circles(UnitCircleTables *tables)
+{
+    for (s32 lod = 0; lod < CIRCLE_LOD_COUNT; ++lod) {
+        s32 segments = CIRCLE_LOD_MIN_SEGMENTS << lod;
+        f32 step_angle = (2.0f * PI) / (f32)segments;
+
+        for (s32 k = 0; k < segments; ++k) {
+            f32 angle = step_angle * (f32)k;
+            tables->points[lod][k] = v2(cosf(angle), sinf(angle));
+        }
+
+        tables->points[lod][segments] = tables->points[lod][0];
+
+        // How far the middle of a segment is from the circle, per unit of radius
+        f32 error_per_radius = 1.0f - cosf(PI / (f32)segments);
+        tables->max_screen_radius[lod] = CIRCLE_LOD_MAX_ERROR_PIXELS / error_per_radius;
+    }
+
+    tables->is_initialized = true;
+}
+
+UnitCircle get_unit_circle(f32 screen_radius)
+{
+    if (!g_unit_circles.is_initialized) {
+        initialize_unit_circles(&g_unit_circles);
+    }
+
+    s32 lod = 0;
+
+    while ((lod < CIRCLE_LOD_COUNT - 1) && (screen_radius > g_unit_circles.max_screen_radius[lod])) {
+        ++lod;
+    }
+
+    UnitCircle result = {
+        .points = g_unit_circles.points[lod],
+        .segment_count = CIRCLE_LOD_MIN_SEGMENTS << lod
+    };
+
+    return result;
+}
+
+static RectangleVertices line_quad_from_direction(Vector2 start, Vector2 end, Vector2 dir, f32 thickness,
+    RGBA32 color)
+{
+    Vector2 half_along = v2_mul_s(dir, thickness / 2.0f);
+    Vector2 half_across = {-half_along.y, half_along.x};
+
+    Vertex corners[4];
+
+    for (s32 i = 0; i < ARRAY_COUNT(g_line_quad_corners); ++i) {
+        LineQuadCorner corner = g_line_quad_corners[i];
+        Vector2 base = corner.from_end ? end : start;
+
+        Vector2 offset = v2_add(v2_mul_s(half_along, corner.along), v2_mul_s(half_across, corner.across));
+        corners[i] = (Vertex){v2_add(base, offset), corner.uv, color};
+    }
+
+    RectangleVertices result = {corners[0], corners[1], corners[2], corners[3]};
+
+    return result;
+}
+
+RectangleVertices get_line_vertices(Vector2 start, Vector2 end, f32 thickness, RGBA32 color)
+{
+    Vector2 dir = v2_norm(v2_sub(end, start));
+    RectangleVertices result = line_quad_from_direction(start, end, dir, thickness, color);
+
+    return result;
+}
+
+// Edges are axis aligned, so their directions are known up front
+OutlinedRectangleVertices get_outlined_rectangle_vertices(Rectangle rect, f32 thickness, RGBA32 color)
+{
+    OutlinedRectangleVertices result = {0};
+
+    for (s32 i = 0; i < ARRAY_COUNT(g_outline_edges); ++i) {
+        OutlineEdge edge = g_outline_edges[i];
+
+        Vector2 start = v2_add(rect.position, v2(edge.start.x * rect.size.x, edge.start.y * rect.size.y));
+        Vector2 end = v2_add(rect.position, v2(edge.end.x * rect.size.x, edge.end.y * rect.size.y));
+        end = v2_add(end, v2_mul_s(edge.end_offset, thickness));
+
+        result.edges[i] = line_quad_from_direction(start, end, edge.dir, thickness, color);
+    }
+
+    return result;
+}
@@ -0,0 +1,33 @@
+#ifndef TESSELLATION_H
+#define TESSELLATION_H
+
+#include "base/rectangle.h"
+#include "base/rgba.h"
+#include "base/vertex.h"
+
+/*
+  Shared geometry for the shapes that the command interpreter tessellates. Circles use a
+  precomputed unit circle with as few segments as their size on screen allows, and lines
+  and rectangle outlines are built from fixed corner templates instead of being derived
+  from scratch for every edge.
+ */
+
+#define CIRCLE_LOD_COUNT            4
+#define CIRCLE_LOD_MIN_SEGMENTS     8
+#define CIRCLE_LOD_MAX_SEGMENTS     (CIRCLE_LOD_MIN_SEGMENTS << (CIRCLE_LOD_COUNT - 1))
+#define CIRCLE_LOD_MAX_ERROR_PIXELS 0.5f // Furthest the polygon may be from the true circle
+
+typedef struct {
+    const Vector2 *points;        // segment_count + 1 points, the last one is the same as the first
+    s32            segment_count;
+} UnitCircle;
+
+typedef struct {
+    RectangleVertices edges[4];
+} OutlinedRectangleVertices;
+
+UnitCircle                get_unit_circle(f32 screen_radius);
+RectangleVertices         get_line_vertices(Vector2 start, Vector2 end, f32 thickness, RGBA32 color);
+OutlinedRectangleVertices get_outlined_rectangle_vertices(Rectangle rect, f32 thickness, RGBA32 color);
+
+#endif //TESSELLATION_H
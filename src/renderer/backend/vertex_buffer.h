@@ -1,13 +1,15 @@
 #ifndef VERTEX_BUFFER_H
 #define VERTEX_BUFFER_H
 
-#define VERTEX_BUFFER_CAPACITY 512
+// Large enough that a frame of lights fits in one draw call
+#define VERTEX_BUFFER_CAPACITY 16384
+#define INDEX_BUFFER_CAPACITY  (VERTEX_BUFFER_CAPACITY * 3 / 2) // Quads use six indices for four vertices
 
 typedef struct {
     Vertex    vertices[VERTEX_BUFFER_CAPACITY];
     s32       vertex_count;
 
-    uint32_t  indices[VERTEX_BUFFER_CAPACITY];
+    uint32_t  indices[INDEX_BUFFER_CAPACITY];
     s32       index_count;
 } VertexBuffer;
 
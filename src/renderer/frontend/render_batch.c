@@ -1,6 +1,9 @@
+#include <string.h>
+
 #include "render_batch.h"
 #include "base/linear_arena.h"
 #include "base/list.h"
+#include "base/radix_sort.h"
 #include "base/rectangle.h"
 #include "base/rgba.h"
 #include "base/sl_list.h"
@@ -12,7 +15,8 @@
 
 // TODO: lots of code duplication in this file
 
-#define allocate_render_cmd(arena, type) (type *)(allocate_render_cmd_impl((arena), RENDER_COMMAND_ENUM_NAME(type)))
+#define allocate_render_cmd(rb, type)                                   \
+    (type *)(allocate_render_cmd_impl((rb), RENDER_COMMAND_ENUM_NAME(type), SIZEOF(type)))
 
 static inline s32 get_key_y_sort_order(struct RenderBatch *rb, s32 y_pos)
 {
@@ -50,9 +54,10 @@ static inline RenderKey render_key_create(struct RenderBatch *rb, s32 layer, Sha
 }
 
 static RenderBatch rb_create(Camera camera, Vector2i viewport_size, YDirection y_dir, FrameBuffer render_target,
-    RGBA32 clear_color, BlendFunction blend_func)
+    RGBA32 clear_color, BlendFunction blend_func, LinearArena *arena)
 {
     RenderBatch result = {0};
+    result.arena = arena;
 
     Matrix4 proj_matrix = camera_get_matrix(camera, viewport_size, y_dir);
 
@@ -64,7 +69,9 @@ static RenderBatch rb_create(Camera camera, Vector2i viewport_size, YDirection y
     }
 
     result.projection = proj_matrix;
+    result.world_to_screen_scale = 1.0f + camera.zoom;
     result.y_direction = y_dir;
+    result.cull_area = camera_bounds;
     result.y_sorting_basis = (s32)top_y;
     result.render_target = render_target;
     result.clear_color = clear_color;
@@ -77,7 +84,7 @@ RenderBatch *push_new_render_batch(RenderBatchList *list, Camera camera, Vector2
     FrameBuffer render_target, RGBA32 clear_color, BlendFunction blend_func, LinearArena *arena)
 {
     RenderBatch *batch = la_allocate_item(arena, RenderBatch);
-    *batch = rb_create(camera, viewport_size, y_dir, render_target, clear_color, blend_func);
+    *batch = rb_create(camera, viewport_size, y_dir, render_target, clear_color, blend_func, arena);
 
     sl_list_push_back(list, batch);
 
@@ -88,9 +95,12 @@ RenderBatch *add_stencil_pass(RenderBatch *rb, StencilFunction stencil_func, s32
     StencilOperation stencil_op, LinearArena *arena)
 {
     RenderBatch *stencil_batch = la_allocate_item(arena, RenderBatch);
+    stencil_batch->arena = arena;
     stencil_batch->y_sorting_basis = rb->y_sorting_basis;
     stencil_batch->projection = rb->projection;
+    stencil_batch->world_to_screen_scale = rb->world_to_screen_scale;
     stencil_batch->y_direction = rb->y_direction;
+    stencil_batch->cull_area = rb->cull_area;
     stencil_batch->render_target = rb->render_target;
     stencil_batch->clear_color = rb->clear_color;
     stencil_batch->blend_function = rb->blend_function;
@@ -104,112 +114,415 @@ RenderBatch *add_stencil_pass(RenderBatch *rb, StencilFunction stencil_func, s32
     return stencil_batch;
 }
 
-static void merge_render_entry_arrays(RenderEntry *dst, RenderEntry *left, ssize left_count,
-    RenderEntry *right, ssize right_count)
+static b32 render_entries_are_sorted(const RenderEntry *entries, ssize count)
 {
-    ssize end = left_count + right_count;
+    for (ssize i = 1; i < count; ++i) {
+        if (entries[i].key < entries[i - 1].key) {
+            return false;
+        }
+    }
 
-    ssize left_idx = 0;
-    ssize right_idx = 0;
+    return true;
+}
+
+// Batches that are already sorted, such as ones that partial batches were just merged into,
+// are left as they are
+void sort_render_entries(RenderBatch *rb, LinearArena *scratch)
+{
+    if (render_entries_are_sorted(rb->entries, rb->entry_count)) {
+        return;
+    }
 
-    for (ssize dst_idx = 0; dst_idx < end; ++dst_idx) {
-        b32 left_half_done = left_idx == left_count;
-        b32 right_half_done = right_idx == right_count;
+    radix_sort(rb->entries, rb->entry_count, key, scratch);
+}
 
-	ASSERT(!(left_half_done && right_half_done));
+// Batches only take up as much memory as they need. Entries are copied to a new array twice
+// the size when full, the old one stays in the arena until it is reset.
+static void grow_render_entries(RenderBatch *rb)
+{
+    ASSERT(rb->arena);
 
-        if (!left_half_done && (right_half_done || (left[left_idx].key <= right[right_idx].key))) {
-	    ASSERT(left_idx < left_count);
+    ssize new_capacity = MAX(RENDER_BATCH_INITIAL_CAPACITY, rb->entry_capacity * 2);
+    RenderEntry *new_entries = la_allocate_array(rb->arena, RenderEntry, new_capacity);
 
-            dst[dst_idx] = left[left_idx++];
-        } else {
-	    ASSERT(!right_half_done);
-	    ASSERT(right_idx < right_count);
+    if (rb->entry_count > 0) {
+        memcpy(new_entries, rb->entries, (usize)rb->entry_count * sizeof(*new_entries));
+    }
+
+    rb->entries = new_entries;
+    rb->entry_capacity = new_capacity;
+}
+
+// Same as the entries, but commands are referred to by offset so moving them is fine
+static void grow_render_commands(RenderBatch *rb, ssize needed_capacity)
+{
+    ASSERT(rb->arena);
+
+    ssize new_capacity = MAX(RENDER_BATCH_INITIAL_COMMAND_CAPACITY, rb->command_capacity * 2);
+
+    while (new_capacity < needed_capacity) {
+        new_capacity *= 2;
+    }
+
+    byte *new_commands = la_allocate(rb->arena, new_capacity, 1, RENDER_COMMAND_ALIGNMENT);
+
+    if (rb->command_size > 0) {
+        memcpy(new_commands, rb->commands, (usize)rb->command_size);
+    }
+
+    rb->commands = new_commands;
+    rb->command_capacity = new_capacity;
+}
 
-            dst[dst_idx] = right[right_idx++];
+// Returns zeroed memory at the end of the command buffer
+static inline void *push_render_command_bytes(RenderBatch *rb, ssize size)
+{
+    ssize aligned_size = align(size, RENDER_COMMAND_ALIGNMENT);
+
+    if (rb->command_size + aligned_size > rb->command_capacity) {
+        grow_render_commands(rb, rb->command_size + aligned_size);
+    }
+
+    void *result = rb->commands + rb->command_size;
+    memset(result, 0, (usize)aligned_size);
+
+    rb->command_size += aligned_size;
+
+    return result;
+}
+
+// Inlined so that the size is known when zeroing the command
+static inline void *allocate_render_cmd_impl(RenderBatch *rb, RenderCmdKind kind, ssize size)
+{
+    RenderCmdHeader *result = push_render_command_bytes(rb, size);
+    result->kind = kind;
+    result->size = (u32)align(size, RENDER_COMMAND_ALIGNMENT);
+    result->setup_commands_offset = result->size;
+
+    return result;
+}
+
+static RenderEntry *push_render_entry(RenderBatch *rb, RenderKey key, void *command)
+{
+    if (rb->entry_count == rb->entry_capacity) {
+        grow_render_entries(rb);
+    }
+
+    RenderEntry *entry = &rb->entries[rb->entry_count++];
+    entry->key = key;
+    entry->command_offset = (byte *)command - rb->commands;
+
+    return entry;
+}
+
+// Entries from the left run go first when keys are equal, which keeps the merge stable
+static void merge_render_entry_runs(const RenderEntry *left, ssize left_count,
+    const RenderEntry *right, ssize right_count, RenderEntry *destination)
+{
+    ssize l = 0;
+    ssize r = 0;
+    ssize d = 0;
+
+    while ((l < left_count) && (r < right_count)) {
+        if (right[r].key < left[l].key) {
+            destination[d++] = right[r++];
+        } else {
+            destination[d++] = left[l++];
         }
     }
+
+    while (l < left_count) {
+        destination[d++] = left[l++];
+    }
+
+    while (r < right_count) {
+        destination[d++] = right[r++];
+    }
+}
+
+static void append_render_commands(RenderBatch *rb, const byte *commands, ssize size)
+{
+    if (rb->command_size + size > rb->command_capacity) {
+        grow_render_commands(rb, rb->command_size + size);
+    }
+
+    if (size > 0) {
+        memcpy(rb->commands + rb->command_size, commands, (usize)size);
+    }
+
+    rb->command_size += size;
+}
+
+RenderBatch create_partial_render_batch(RenderBatch *rb, LinearArena *arena)
+{
+    // Keys depend on these, so they have to match the target
+    RenderBatch result = {0};
+    result.arena = arena;
+    result.y_sorting_basis = rb->y_sorting_basis;
+    result.projection = rb->projection;
+    result.world_to_screen_scale = rb->world_to_screen_scale;
+    result.y_direction = rb->y_direction;
+    result.cull_area = rb->cull_area;
+    result.render_target = rb->render_target;
+
+    return result;
 }
 
-static void merge_sort_render_entries(RenderEntry *entries, ssize count, LinearArena *scratch)
+// The entries already in rb count as recorded before any of the parts. Runs are merged
+// pairwise, always merging neighbours, so entries with equal keys keep their relative order.
+void merge_partial_render_batches(RenderBatch *rb, RenderBatch **parts, ssize part_count,
+    LinearArena *scratch)
 {
-    if (count <= 1) {
+    sort_render_entries(rb, scratch);
+
+    ssize run_count = part_count + 1;
+    ssize *run_starts = la_allocate_array(scratch, ssize, run_count + 1);
+    ssize total_count = rb->entry_count;
+
+    run_starts[0] = 0;
+    run_starts[1] = rb->entry_count;
 
-    } else if (count == 2) {
-        RenderEntry *a = &entries[0];
-        RenderEntry *b = &entries[1];
+    for (ssize i = 0; i < part_count; ++i) {
+        ASSERT(parts[i]->y_sorting_basis == rb->y_sorting_basis);
+        ASSERT(parts[i]->y_direction == rb->y_direction);
 
-        if (a->key > b->key) {
-            RenderEntry tmp = *a;
-            *a = *b;
-            *b = tmp;
+        total_count += parts[i]->entry_count;
+        run_starts[i + 2] = total_count;
+        rb->culled_entry_count += parts[i]->culled_entry_count;
+    }
+
+    if (total_count == rb->entry_count) {
+        return;
+    }
+
+    RenderEntry *source = la_allocate_array(rb->arena, RenderEntry, total_count);
+    RenderEntry *destination = la_allocate_array(scratch, RenderEntry, total_count);
+
+    if (rb->entry_count > 0) {
+        memcpy(source, rb->entries, (usize)rb->entry_count * sizeof(*source));
+    }
+
+    // Commands of the parts are moved to the end of the command buffer of rb
+    for (ssize i = 0; i < part_count; ++i) {
+        RenderBatch *part = parts[i];
+        ASSERT(render_entries_are_sorted(part->entries, part->entry_count));
+
+        ssize command_base = rb->command_size;
+        append_render_commands(rb, part->commands, part->command_size);
+
+        RenderEntry *run = source + run_starts[i + 1];
+
+        for (ssize j = 0; j < part->entry_count; ++j) {
+            run[j].key = part->entries[j].key;
+            run[j].command_offset = part->entries[j].command_offset + command_base;
         }
-    } else {
-        RenderEntry *copy = la_copy_array(scratch, entries, count);
+    }
 
-        ssize left_half_count = count / 2;
-        ssize right_half_count = count - left_half_count;
+    RenderEntry *merged_entries = source;
 
-        RenderEntry *left_half = copy;
-        RenderEntry *right_half = left_half + left_half_count;
+    while (run_count > 1) {
+        ssize merged_run_count = 0;
 
-        merge_sort_render_entries(left_half, left_half_count, scratch);
-        merge_sort_render_entries(right_half, right_half_count, scratch);
+        for (ssize i = 0; i < run_count; i += 2) {
+            ssize start = run_starts[i];
+            ssize middle = run_starts[MIN(i + 1, run_count)];
+            ssize end = run_starts[MIN(i + 2, run_count)];
+
+            merge_render_entry_runs(source + start, middle - start, source + middle, end - middle,
+                destination + start);
+
+            run_starts[merged_run_count++] = start;
+        }
 
-        merge_render_entry_arrays(entries, left_half, left_half_count, right_half, right_half_count);
+        run_starts[merged_run_count] = total_count;
+        run_count = merged_run_count;
+
+        RenderEntry *tmp = source;
+        source = destination;
+        destination = tmp;
+    }
+
+    if (source != merged_entries) {
+        memcpy(merged_entries, source, (usize)total_count * sizeof(*source));
     }
+
+    rb->entries = merged_entries;
+    rb->entry_count = total_count;
+    rb->entry_capacity = total_count;
 }
 
-void sort_render_entries(RenderBatch *rb, LinearArena *scratch)
+#define copy_array_to_batch(rb, ptr, count) \
+    copy_to_batch((rb), (ptr), (count), SIZEOF(*(ptr)), ALIGNOF(*(ptr)))
+
+static void *copy_to_batch(RenderBatch *rb, const void *data, ssize count, ssize item_size, ssize alignment)
 {
-    merge_sort_render_entries(rb->entries, rb->entry_count, scratch);
+    if (count == 0) {
+        return 0;
+    }
 
-    // TODO: use a unit test for this instead
-#if 1
-    for (ssize i = 0; i < rb->entry_count - 1; ++i) {
-        RenderEntry *a = &rb->entries[i];
-        RenderEntry *b = &rb->entries[i + 1];
+    void *result = la_allocate(rb->arena, count, item_size, alignment);
+    memcpy(result, data, (usize)(count * item_size));
 
-        ASSERT(a->key <= b->key);
+    return result;
+}
+
+static ParticleBuffer *copy_particle_buffer(RenderBatch *rb, const ParticleBuffer *particles)
+{
+    ParticleBuffer *result = la_allocate_item(rb->arena, ParticleBuffer);
+    ssize count = particles->count;
+
+    // Velocities aren't needed for drawing
+    result->position_x = copy_array_to_batch(rb, particles->position_x, count);
+    result->position_y = copy_array_to_batch(rb, particles->position_y, count);
+    result->timer = copy_array_to_batch(rb, particles->timer, count);
+    result->lifetime = copy_array_to_batch(rb, particles->lifetime, count);
+    result->size = copy_array_to_batch(rb, particles->size, count);
+    result->color = copy_array_to_batch(rb, particles->color, count);
+    result->count = count;
+    result->capacity = count;
+
+    return result;
+}
+
+static TriangulatedPolygon copy_polygon(RenderBatch *rb, TriangulatedPolygon polygon)
+{
+    TriangulatedPolygon result = {0};
+
+    for (PolygonTriangle *tri = list_head(&polygon); tri; tri = list_next(tri)) {
+        PolygonTriangle *copy = la_allocate_item(rb->arena, PolygonTriangle);
+        copy->triangle = tri->triangle;
+        copy->next = 0;
+
+        sl_list_push_back(&result, copy);
     }
-#endif
+
+    return result;
+}
+
+static TriangleFan copy_triangle_fan(RenderBatch *rb, TriangleFan fan)
+{
+    TriangleFan result = fan;
+    result.items = copy_array_to_batch(rb, fan.items, fan.count);
+
+    return result;
 }
 
-static void *allocate_render_cmd_impl(LinearArena *arena, RenderCmdKind kind)
+void copy_referenced_render_data(RenderBatch *rb)
 {
-    void *result = 0;
+    for (ssize i = 0; i < rb->entry_count; ++i) {
+        RenderCmdHeader *header = render_entry_command(rb, &rb->entries[i]);
+        byte *setup_cmd_ptr = (byte *)header + header->setup_commands_offset;
+
+        // Uniform names are usually literals, which go away if the game code is reloaded
+        for (u32 j = 0; j < header->setup_command_count; ++j) {
+            SetupCmdHeader *setup_cmd = (SetupCmdHeader *)setup_cmd_ptr;
+            setup_cmd_ptr += setup_cmd->size;
 
-    switch (kind) {
-#define RENDER_COMMAND(type) case RENDER_COMMAND_ENUM_NAME(type): { result = la_allocate_item(arena, type); } break;
-        RENDER_COMMAND_LIST
-#undef RENDER_COMMAND
+            setup_cmd->uniform_name.data = copy_array_to_batch(rb, setup_cmd->uniform_name.data,
+                setup_cmd->uniform_name.length);
+        }
+
+        switch (header->kind) {
+            case RENDER_COMMAND_ENUM_NAME(TextCmd): {
+                TextCmd *cmd = (TextCmd *)header;
+                cmd->text.data = copy_array_to_batch(rb, cmd->text.data, cmd->text.length);
+            } break;
+
+            case RENDER_COMMAND_ENUM_NAME(ParticleGroupCmd): {
+                ParticleGroupCmd *cmd = (ParticleGroupCmd *)header;
+                cmd->particles = copy_particle_buffer(rb, cmd->particles);
+            } break;
+
+            case RENDER_COMMAND_ENUM_NAME(PolygonCmd): {
+                PolygonCmd *cmd = (PolygonCmd *)header;
+                cmd->polygon = copy_polygon(rb, cmd->polygon);
+            } break;
+
+            case RENDER_COMMAND_ENUM_NAME(TriangleFanCmd): {
+                TriangleFanCmd *cmd = (TriangleFanCmd *)header;
+                cmd->triangle_fan = copy_triangle_fan(rb, cmd->triangle_fan);
+            } break;
+
+            case RENDER_COMMAND_ENUM_NAME(StaticQuadsCmd): {
+                StaticQuadsCmd *cmd = (StaticQuadsCmd *)header;
+                cmd->vertices = copy_array_to_batch(rb, cmd->vertices, cmd->quad_count * 4);
+                cmd->overlay.quads = copy_array_to_batch(rb, cmd->overlay.quads, cmd->overlay.count);
+            } break;
+
+            case RENDER_COMMAND_ENUM_NAME(LightCmd): {
+                LightCmd *cmd = (LightCmd *)header;
+                cmd->area = copy_triangle_fan(rb, cmd->area);
+            } break;
+
+            default: {
+                // Everything else is stored inline
+            } break;
+        }
+    }
 
-        INVALID_DEFAULT_CASE;
+    if (rb->stencil_batch) {
+        copy_referenced_render_data(rb->stencil_batch);
     }
+}
+
+static b32 should_cull(RenderBatch *rb, Rectangle bounds)
+{
+    b32 result = !rect_intersects(bounds, rb->cull_area);
 
-    ASSERT(result);
-    ((RenderCmdHeader *)result)->kind = kind;
+    if (result) {
+        ++rb->culled_entry_count;
+    }
 
     return result;
 }
 
-static RenderEntry *push_render_entry(RenderBatch *rb, RenderKey key, void *data)
+static Rectangle bounds_around_point(Vector2 center, f32 radius)
 {
-    ASSERT(rb->entry_count < ARRAY_COUNT(rb->entries));
-    RenderEntry *entry = &rb->entries[rb->entry_count++];
-    entry->key = key;
-    entry->data = data;
+    Rectangle result = {v2_sub(center, v2(radius, radius)), v2(radius * 2.0f, radius * 2.0f)};
 
-    return entry;
+    return result;
+}
+
+static Rectangle bounds_of_points(const Vector2 *points, ssize count, f32 padding)
+{
+    ASSERT(count > 0);
+
+    Vector2 min = points[0];
+    Vector2 max = points[0];
+
+    for (ssize i = 1; i < count; ++i) {
+        min.x = MIN(min.x, points[i].x);
+        min.y = MIN(min.y, points[i].y);
+        max.x = MAX(max.x, points[i].x);
+        max.y = MAX(max.y, points[i].y);
+    }
+
+    Rectangle result = {
+        v2_sub(min, v2(padding, padding)),
+        v2_add(v2_sub(max, min), v2(padding * 2.0f, padding * 2.0f))
+    };
+
+    return result;
 }
 
-RenderEntry *draw_colored_sprite(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+RenderEntry *draw_colored_sprite(RenderBatch *rb, TextureHandle texture,
     Rectangle rectangle, SpriteModifiers mods, RGBA32 color,
     ShaderHandle shader, RenderLayer layer)
 {
     ASSERT(rect_is_valid(rectangle));
 
-    RectangleCmd *cmd = allocate_render_cmd(arena, RectangleCmd);
+    Rectangle bounds = rectangle;
+
+    // Rotated sprites may reach as far as their corners from the center in any direction
+    if (mods.rotation != 0.0f) {
+        bounds = bounds_around_point(rect_center(rectangle), v2_mag(rectangle.size) / 2.0f);
+    }
+
+    if (should_cull(rb, bounds)) {
+        return 0;
+    }
+
+    RectangleCmd *cmd = allocate_render_cmd(rb, RectangleCmd);
     cmd->rect = rectangle;
     cmd->color = color;
     cmd->rotation_in_radians = mods.rotation;
@@ -222,23 +535,29 @@ RenderEntry *draw_colored_sprite(RenderBatch *rb, LinearArena *arena, TextureHan
     return result;
 }
 
-RenderEntry *draw_sprite(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+RenderEntry *draw_sprite(RenderBatch *rb, TextureHandle texture,
     Rectangle rectangle, SpriteModifiers mods, ShaderHandle shader, RenderLayer layer)
 {
-    return draw_colored_sprite(rb, arena, texture, rectangle, mods,
+    return draw_colored_sprite(rb, texture, rectangle, mods,
 	RGBA32_WHITE, shader, layer);
 }
 
-RenderEntry *draw_rectangle(RenderBatch *rb, LinearArena *arena, Rectangle rect,
+RenderEntry *draw_rectangle(RenderBatch *rb, Rectangle rect,
     RGBA32 color, ShaderHandle shader, RenderLayer layer)
 {
-    return draw_colored_sprite(rb, arena, NULL_TEXTURE, rect, (SpriteModifiers){0}, color, shader, layer);
+    return draw_colored_sprite(rb, NULL_TEXTURE, rect, (SpriteModifiers){0}, color, shader, layer);
 }
 
-RenderEntry *draw_triangle(RenderBatch *rb, LinearArena *arena, Triangle triangle, RGBA32 color,
+RenderEntry *draw_triangle(RenderBatch *rb, Triangle triangle, RGBA32 color,
     ShaderHandle shader, RenderLayer layer)
 {
-    TriangleCmd *cmd = allocate_render_cmd(arena, TriangleCmd);
+    Vector2 points[] = {triangle.a, triangle.b, triangle.c};
+
+    if (should_cull(rb, bounds_of_points(points, ARRAY_COUNT(points), 0.0f))) {
+        return 0;
+    }
+
+    TriangleCmd *cmd = allocate_render_cmd(rb, TriangleCmd);
     cmd->triangle = triangle;
     cmd->color = color;
 
@@ -248,10 +567,16 @@ RenderEntry *draw_triangle(RenderBatch *rb, LinearArena *arena, Triangle triangl
     return result;
 }
 
-RenderEntry *draw_outlined_triangle(RenderBatch *rb, LinearArena *arena, Triangle triangle, RGBA32 color,
+RenderEntry *draw_outlined_triangle(RenderBatch *rb, Triangle triangle, RGBA32 color,
     f32 thickness, ShaderHandle shader, RenderLayer layer)
 {
-    OutlinedTriangleCmd *cmd = allocate_render_cmd(arena, OutlinedTriangleCmd);
+    Vector2 points[] = {triangle.a, triangle.b, triangle.c};
+
+    if (should_cull(rb, bounds_of_points(points, ARRAY_COUNT(points), thickness))) {
+        return 0;
+    }
+
+    OutlinedTriangleCmd *cmd = allocate_render_cmd(rb, OutlinedTriangleCmd);
     cmd->triangle = triangle;
     cmd->color = color;
     cmd->thickness = thickness;
@@ -262,10 +587,14 @@ RenderEntry *draw_outlined_triangle(RenderBatch *rb, LinearArena *arena, Triangl
     return result;
 }
 
-RenderEntry *draw_clipped_sprite(RenderBatch *rb, LinearArena *arena, TextureHandle texture, Rectangle rect,
+RenderEntry *draw_clipped_sprite(RenderBatch *rb, TextureHandle texture, Rectangle rect,
     Rectangle viewport, RGBA32 color, ShaderHandle shader, RenderLayer layer)
 {
-    ClippedRectangleCmd *cmd = allocate_render_cmd(arena, ClippedRectangleCmd);
+    if (!rect_intersects(rect, viewport) || should_cull(rb, viewport)) {
+        return 0;
+    }
+
+    ClippedRectangleCmd *cmd = allocate_render_cmd(rb, ClippedRectangleCmd);
     cmd->rect = rect;
     cmd->viewport_rect = viewport;
     cmd->color = color;
@@ -276,10 +605,19 @@ RenderEntry *draw_clipped_sprite(RenderBatch *rb, LinearArena *arena, TextureHan
     return result;
 }
 
-RenderEntry *draw_outlined_rectangle(RenderBatch *rb, LinearArena *arena, Rectangle rect, RGBA32 color,
+RenderEntry *draw_outlined_rectangle(RenderBatch *rb, Rectangle rect, RGBA32 color,
     f32 thickness, ShaderHandle shader, RenderLayer layer)
 {
-    OutlinedRectangleCmd *cmd = allocate_render_cmd(arena, OutlinedRectangleCmd);
+    Rectangle bounds = {
+        v2_sub(rect.position, v2(thickness, thickness)),
+        v2_add(rect.size, v2(thickness * 2.0f, thickness * 2.0f))
+    };
+
+    if (should_cull(rb, bounds)) {
+        return 0;
+    }
+
+    OutlinedRectangleCmd *cmd = allocate_render_cmd(rb, OutlinedRectangleCmd);
     cmd->rect = rect;
     cmd->color = color;
     cmd->thickness = thickness;
@@ -290,10 +628,14 @@ RenderEntry *draw_outlined_rectangle(RenderBatch *rb, LinearArena *arena, Rectan
     return result;
 }
 
-RenderEntry *draw_textured_circle(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+RenderEntry *draw_textured_circle(RenderBatch *rb, TextureHandle texture,
     Vector2 position, RGBA32 color, f32 radius, ShaderHandle shader, RenderLayer layer)
 {
-    CircleCmd *cmd = allocate_render_cmd(arena, CircleCmd);
+    if (should_cull(rb, bounds_around_point(position, radius))) {
+        return 0;
+    }
+
+    CircleCmd *cmd = allocate_render_cmd(rb, CircleCmd);
     cmd->position = position;
     cmd->color = color;
     cmd->radius = radius;
@@ -304,16 +646,23 @@ RenderEntry *draw_textured_circle(RenderBatch *rb, LinearArena *arena, TextureHa
     return result;
 }
 
-RenderEntry *draw_circle(RenderBatch *rb, LinearArena *arena, Vector2 position,
+RenderEntry *draw_circle(RenderBatch *rb, Vector2 position,
     RGBA32 color, f32 radius, ShaderHandle shader, RenderLayer layer)
 {
-    return draw_textured_circle(rb, arena, NULL_TEXTURE, position, color, radius, shader, layer);
+    return draw_textured_circle(rb, NULL_TEXTURE, position, color, radius, shader, layer);
 }
 
-RenderEntry *draw_line(RenderBatch *rb, LinearArena *arena, Vector2 start, Vector2 end,
+RenderEntry *draw_line(RenderBatch *rb, Vector2 start, Vector2 end,
     RGBA32 color, f32 thickness, ShaderHandle shader, RenderLayer layer)
 {
-    LineCmd *cmd = allocate_render_cmd(arena, LineCmd);
+    Vector2 points[] = {start, end};
+
+    // The ends of a line reach past its end points by half the thickness
+    if (should_cull(rb, bounds_of_points(points, ARRAY_COUNT(points), thickness))) {
+        return 0;
+    }
+
+    LineCmd *cmd = allocate_render_cmd(rb, LineCmd);
     cmd->start = start;
     cmd->end = end;
     cmd->color = color;
@@ -325,10 +674,10 @@ RenderEntry *draw_line(RenderBatch *rb, LinearArena *arena, Vector2 start, Vecto
     return result;
 }
 
-RenderEntry *draw_text(RenderBatch *rb, LinearArena *arena, String text, Vector2 position,
+RenderEntry *draw_text(RenderBatch *rb, String text, Vector2 position,
     RGBA32 color, s32 size, ShaderHandle shader, FontHandle font, RenderLayer layer)
 {
-    TextCmd *cmd = allocate_render_cmd(arena, TextCmd);
+    TextCmd *cmd = allocate_render_cmd(rb, TextCmd);
     cmd->text = text;
     cmd->position = position;
     cmd->color = color;
@@ -340,10 +689,14 @@ RenderEntry *draw_text(RenderBatch *rb, LinearArena *arena, String text, Vector2
     return result;
 }
 
-RenderEntry *draw_clipped_text(RenderBatch *rb, LinearArena *arena, String text, Vector2 position,
+RenderEntry *draw_clipped_text(RenderBatch *rb, String text, Vector2 position,
     Rectangle clip_rect, RGBA32 color, s32 size, ShaderHandle shader, FontHandle font, RenderLayer layer)
 {
-    TextCmd *cmd = allocate_render_cmd(arena, TextCmd);
+    if (should_cull(rb, clip_rect)) {
+        return 0;
+    }
+
+    TextCmd *cmd = allocate_render_cmd(rb, TextCmd);
     cmd->text = text;
     cmd->position = position;
     cmd->color = color;
@@ -357,10 +710,10 @@ RenderEntry *draw_clipped_text(RenderBatch *rb, LinearArena *arena, String text,
     return result;
 }
 
-RenderEntry *draw_particles(RenderBatch *rb, LinearArena *arena, ParticleBuffer *particles,
+RenderEntry *draw_particles(RenderBatch *rb, ParticleBuffer *particles,
     ShaderHandle shader, RenderLayer layer)
 {
-    ParticleGroupCmd *cmd = allocate_render_cmd(arena, ParticleGroupCmd);
+    ParticleGroupCmd *cmd = allocate_render_cmd(rb, ParticleGroupCmd);
     cmd->particles = particles;
 
     RenderKey key = render_key_create(rb, (s32)layer, shader, NULL_TEXTURE, NULL_FONT, 0);
@@ -369,10 +722,10 @@ RenderEntry *draw_particles(RenderBatch *rb, LinearArena *arena, ParticleBuffer
     return result;
 }
 
-RenderEntry *draw_polygon(RenderBatch *rb, LinearArena *arena, TriangulatedPolygon polygon,
+RenderEntry *draw_polygon(RenderBatch *rb, TriangulatedPolygon polygon,
     RGBA32 color, ShaderHandle shader, RenderLayer layer)
 {
-    PolygonCmd *cmd = allocate_render_cmd(arena, PolygonCmd);
+    PolygonCmd *cmd = allocate_render_cmd(rb, PolygonCmd);
     cmd->polygon = polygon;
     cmd->color = color;
 
@@ -382,10 +735,10 @@ RenderEntry *draw_polygon(RenderBatch *rb, LinearArena *arena, TriangulatedPolyg
     return result;
 }
 
-RenderEntry *draw_triangle_fan(RenderBatch *rb, LinearArena *arena, TriangleFan triangle_fan,
+RenderEntry *draw_triangle_fan(RenderBatch *rb, TriangleFan triangle_fan,
     RGBA32 color, ShaderHandle shader, RenderLayer layer)
 {
-    TriangleFanCmd *cmd = allocate_render_cmd(arena, TriangleFanCmd);
+    TriangleFanCmd *cmd = allocate_render_cmd(rb, TriangleFanCmd);
     cmd->triangle_fan = triangle_fan;
     cmd->color = color;
 
@@ -395,54 +748,116 @@ RenderEntry *draw_triangle_fan(RenderBatch *rb, LinearArena *arena, TriangleFan
     return result;
 }
 
-#define allocate_render_setup_cmd(arena, entry, type, uniform_name)      \
-    (type *)(allocate_render_setup_cmd_impl((arena), entry, RENDER_SETUP_COMMAND_ENUM_NAME(type), uniform_name))
+// The vertices aren't copied, so they have to stay alive until the batch has been executed
+RenderEntry *draw_static_quads(RenderBatch *rb, TextureHandle texture, const Vertex *vertices,
+    ssize quad_count, QuadOverlay overlay, ShaderHandle shader, RenderLayer layer)
+{
+    StaticQuadsCmd *cmd = allocate_render_cmd(rb, StaticQuadsCmd);
+    cmd->vertices = vertices;
+    cmd->quad_count = quad_count;
+    cmd->overlay = overlay;
+
+    RenderKey key = render_key_create(rb, (s32)layer, shader, texture, NULL_FONT, 0);
+    RenderEntry *result = push_render_entry(rb, key, cmd);
+
+    return result;
+}
 
-static void *allocate_render_setup_cmd_impl(LinearArena *arena, RenderEntry *re,
-    SetupCmdKind kind, String uniform_name)
+RenderEntry *draw_light(RenderBatch *rb, Vector2 origin, f32 radius, RGBA32 color,
+    ShaderHandle shader, RenderLayer layer)
 {
-    void *result = 0;
+    TriangleFan whole_circle = {0};
+    RenderEntry *result = draw_raycasted_light(rb, origin, radius, whole_circle, color, shader, layer);
 
-    switch (kind) {
-#define RENDER_SETUP_COMMAND(type)                                      \
-        case RENDER_SETUP_COMMAND_ENUM_NAME(type): { result = la_allocate_item(arena, type); } break;
+    return result;
+}
 
-        RENDER_SETUP_COMMAND_LIST
-#undef RENDER_SETUP_COMMAND
+// The triangles of the area aren't copied, so they have to stay alive until the batch has been executed
+RenderEntry *draw_raycasted_light(RenderBatch *rb, Vector2 origin, f32 radius, TriangleFan area,
+    RGBA32 color, ShaderHandle shader, RenderLayer layer)
+{
+    ASSERT(radius > 0.0f);
 
-        INVALID_DEFAULT_CASE;
+    // The area of raycasted lights never reaches past the radius
+    if (should_cull(rb, bounds_around_point(origin, radius))) {
+        return 0;
     }
 
-    ASSERT(result);
+    LightCmd *cmd = allocate_render_cmd(rb, LightCmd);
+    cmd->origin = origin;
+    cmd->radius = radius;
+    cmd->color = color;
+    cmd->area = area;
 
-    SetupCmdHeader *header = result;
-    header->kind = kind;
-    header->uniform_name = uniform_name;
+    RenderKey key = render_key_create(rb, (s32)layer, shader, NULL_TEXTURE, NULL_FONT, (s32)origin.y);
+    RenderEntry *result = push_render_entry(rb, key, cmd);
 
-    if (!re->data->first_setup_command) {
-        re->data->first_setup_command = header;
-    } else {
-        SetupCmdHeader *curr_cmd;
-        for (curr_cmd = re->data->first_setup_command; curr_cmd->next; curr_cmd = curr_cmd->next);
+    return result;
+}
+
+// Only the part of the light inside the clip rectangle is drawn
+RenderEntry *draw_clipped_light(RenderBatch *rb, Vector2 origin, f32 radius, TriangleFan area,
+    Rectangle clip_rect, RGBA32 color, ShaderHandle shader, RenderLayer layer)
+{
+    ASSERT(radius > 0.0f);
+
+    Rectangle bounds = bounds_around_point(origin, radius);
 
-        curr_cmd->next = header;
+    if (!rect_intersects(bounds, clip_rect) || should_cull(rb, rect_overlap_area(bounds, clip_rect))) {
+        return 0;
     }
 
+    LightCmd *cmd = allocate_render_cmd(rb, LightCmd);
+    cmd->origin = origin;
+    cmd->radius = radius;
+    cmd->color = color;
+    cmd->area = area;
+    cmd->is_clipped = true;
+    cmd->clip_rect = clip_rect;
+
+    RenderKey key = render_key_create(rb, (s32)layer, shader, NULL_TEXTURE, NULL_FONT, (s32)origin.y);
+    RenderEntry *result = push_render_entry(rb, key, cmd);
+
+    return result;
+}
+
+#define allocate_render_setup_cmd(rb, entry, type, uniform_name)      \
+    (type *)(allocate_render_setup_cmd_impl((rb), entry, RENDER_SETUP_COMMAND_ENUM_NAME(type), \
+        SIZEOF(type), uniform_name))
+
+static inline void *allocate_render_setup_cmd_impl(RenderBatch *rb, RenderEntry *re,
+    SetupCmdKind kind, ssize size, String uniform_name)
+{
+    // Setup commands are stored inline after their command, so nothing may have been
+    // pushed after it
+    ASSERT(re == &rb->entries[rb->entry_count - 1]);
+    ASSERT(re->command_offset + render_entry_command(rb, re)->size == rb->command_size);
+
+    SetupCmdHeader *result = push_render_command_bytes(rb, size);
+    result->kind = kind;
+    result->size = (u32)align(size, RENDER_COMMAND_ALIGNMENT);
+    result->uniform_name = uniform_name;
+
+    // The buffer may have moved, so the command is looked up after pushing
+    RenderCmdHeader *header = render_entry_command(rb, re);
+    header->size += result->size;
+    ++header->setup_command_count;
+
     return result;
 }
 
-void set_vec4_uniform(RenderEntry *re, LinearArena *arena, String uniform_name, Vector4 vec)
+void set_vec4_uniform(RenderBatch *rb, RenderEntry *re, String uniform_name, Vector4 vec)
 {
     ASSERT(re);
 
-    SetupCmdUniformVec4 *cmd = allocate_render_setup_cmd(arena, re, SetupCmdUniformVec4, uniform_name);
+    SetupCmdUniformVec4 *cmd = allocate_render_setup_cmd(rb, re, SetupCmdUniformVec4, uniform_name);
     cmd->value = vec;
 }
 
-void set_f32_uniform(RenderEntry *re, LinearArena *arena, String uniform_name, f32 value)
+void set_f32_uniform(RenderBatch *rb, RenderEntry *re, String uniform_name, f32 value)
 {
     ASSERT(re);
 
-    SetupCmdUniformFloat *cmd = allocate_render_setup_cmd(arena, re, SetupCmdUniformFloat, uniform_name);
+    SetupCmdUniformFloat *cmd = allocate_render_setup_cmd(rb, re, SetupCmdUniformFloat, uniform_name);
     cmd->value = value;
 }
@@ -17,7 +17,6 @@ struct Particle;
 
 /*
   TODO:
-  - make RenderEntry array into ring buffer in case it overflows?
   - reduce amount of parameters, eg. create specialization for push_sprite in case
     color needs to be provided, otherwise default to white
   - Maybe it would be better to have all types of render commands in union inside renderentry?
@@ -28,16 +27,32 @@ struct Particle;
 
 typedef struct RenderEntry {
     RenderKey         key;
-    RenderCmdHeader  *data;
+    ssize             command_offset; // Into the command buffer of the batch
 } RenderEntry;
 
+// Batches start out with room for this many entries and bytes of commands, and double
+// whenever they fill up
+#define RENDER_BATCH_INITIAL_CAPACITY         256
+#define RENDER_BATCH_INITIAL_COMMAND_CAPACITY KB(16)
+
 typedef struct RenderBatch {
-    RenderEntry         entries[4096];
+    RenderEntry        *entries;
     ssize               entry_count;
+    ssize               entry_capacity;
+
+    byte               *commands;
+    ssize               command_size;
+    ssize               command_capacity;
+
+    LinearArena        *arena; // Entries and commands are allocated here
     s32                 y_sorting_basis;
     Matrix4             projection;
+    f32                 world_to_screen_scale; // Pixels per world unit, used to pick tessellation detail
     YDirection          y_direction;
 
+    Rectangle           cull_area;           // Area seen by the camera, draws entirely outside are dropped
+    ssize               culled_entry_count;  // Reset when the batch is created
+
     FrameBuffer         render_target;
 
     RGBA32              clear_color;
@@ -59,39 +74,80 @@ RenderBatch *add_stencil_pass(RenderBatch *rb, StencilFunction stencil_func, s32
                                  StencilOperation stencil_op, LinearArena *arena);
 void         sort_render_entries(RenderBatch *rb, LinearArena *scratch);
 
-RenderEntry *draw_sprite(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+/*
+  Partial batches record entries on behalf of another batch, so that several threads can
+  record into the same batch at once. Each thread sorts its own partial batches, and the
+  sorted runs are merged into the target afterwards. If the partial batches are passed in
+  the order their work would have been recorded serially, the merged order is identical to
+  recording everything into the target directly.
+ */
+RenderBatch  create_partial_render_batch(RenderBatch *rb, LinearArena *arena);
+void         merge_partial_render_batches(RenderBatch *rb, RenderBatch **parts, ssize part_count,
+                                          LinearArena *scratch);
+
+/*
+  Commands may point at data owned by the game, such as particle buffers and cached tile
+  geometry. Copying that data into the arena of the batch makes the batch self contained,
+  so it can be executed on another thread while the game moves on to the next frame.
+ */
+void         copy_referenced_render_data(RenderBatch *rb);
+
+static inline RenderCmdHeader *render_entry_command(RenderBatch *rb, RenderEntry *entry)
+{
+    ASSERT(entry->command_offset < rb->command_size);
+
+    RenderCmdHeader *result = (RenderCmdHeader *)(rb->commands + entry->command_offset);
+
+    return result;
+}
+
+/*
+  The draw functions return null if the shape lies entirely outside the cull area of the
+  batch. Text without a clip rectangle, particles, polygons, triangle fans and static quads
+  are never culled here, their callers are expected to cull them in larger groups.
+ */
+RenderEntry *draw_sprite(RenderBatch *rb, TextureHandle texture,
     Rectangle rectangle, SpriteModifiers mods, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_colored_sprite(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+RenderEntry *draw_colored_sprite(RenderBatch *rb, TextureHandle texture,
     Rectangle rectangle, SpriteModifiers mods, RGBA32 color, // TODO: pack color into sprite mods
     ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_rectangle(RenderBatch *rb, LinearArena *arena, Rectangle rect, RGBA32 color,
+RenderEntry *draw_rectangle(RenderBatch *rb, Rectangle rect, RGBA32 color,
     ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_triangle(RenderBatch *rb, LinearArena *arena, Triangle triangle, RGBA32 color,
+RenderEntry *draw_triangle(RenderBatch *rb, Triangle triangle, RGBA32 color,
     ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_outlined_triangle(RenderBatch *rb, LinearArena *arena, Triangle triangle, RGBA32 color,
+RenderEntry *draw_outlined_triangle(RenderBatch *rb, Triangle triangle, RGBA32 color,
     f32 thickness, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_clipped_sprite(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+RenderEntry *draw_clipped_sprite(RenderBatch *rb, TextureHandle texture,
     Rectangle rect, Rectangle viewport, RGBA32 color, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_outlined_rectangle(RenderBatch *rb, LinearArena *arena, Rectangle rect, RGBA32 color,
+RenderEntry *draw_outlined_rectangle(RenderBatch *rb, Rectangle rect, RGBA32 color,
     f32 thickness, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_textured_circle(RenderBatch *rb, LinearArena *arena, TextureHandle texture,
+RenderEntry *draw_textured_circle(RenderBatch *rb, TextureHandle texture,
     Vector2 position, RGBA32 color, f32 radius, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_circle(RenderBatch *rb, LinearArena *arena, Vector2 position,
+RenderEntry *draw_circle(RenderBatch *rb, Vector2 position,
     RGBA32 color, f32 radius, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_line(RenderBatch *rb, LinearArena *arena, Vector2 start, Vector2 end,
+RenderEntry *draw_line(RenderBatch *rb, Vector2 start, Vector2 end,
     RGBA32 color, f32 thickness, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_text(RenderBatch *rb, LinearArena *arena, String text, Vector2 position,
+RenderEntry *draw_text(RenderBatch *rb, String text, Vector2 position,
     RGBA32 color, s32 size, ShaderHandle shader, FontHandle font, RenderLayer layer);
-RenderEntry *draw_clipped_text(RenderBatch *rb, LinearArena *arena, String text, Vector2 position,
+RenderEntry *draw_clipped_text(RenderBatch *rb, String text, Vector2 position,
     Rectangle clip_rect, RGBA32 color, s32 size, ShaderHandle shader, FontHandle font, RenderLayer layer);
-RenderEntry *draw_particles(RenderBatch *rb, LinearArena *arena, struct ParticleBuffer *particles,
+RenderEntry *draw_particles(RenderBatch *rb, struct ParticleBuffer *particles,
     ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_polygon(RenderBatch *rb, LinearArena *arena, TriangulatedPolygon polygon,
+RenderEntry *draw_polygon(RenderBatch *rb, TriangulatedPolygon polygon,
     RGBA32 color, ShaderHandle shader, RenderLayer layer);
-RenderEntry *draw_triangle_fan(RenderBatch *rb, LinearArena *arena, TriangleFan triangle_fan,
+RenderEntry *draw_triangle_fan(RenderBatch *rb, TriangleFan triangle_fan,
+    RGBA32 color, ShaderHandle shader, RenderLayer layer);
+RenderEntry *draw_static_quads(RenderBatch *rb, TextureHandle texture, const Vertex *vertices,
+    ssize quad_count, QuadOverlay overlay, ShaderHandle shader, RenderLayer layer);
+RenderEntry *draw_light(RenderBatch *rb, Vector2 origin, f32 radius, RGBA32 color,
+    ShaderHandle shader, RenderLayer layer);
+RenderEntry *draw_raycasted_light(RenderBatch *rb, Vector2 origin, f32 radius, TriangleFan area,
     RGBA32 color, ShaderHandle shader, RenderLayer layer);
+RenderEntry *draw_clipped_light(RenderBatch *rb, Vector2 origin, f32 radius, TriangleFan area,
+    Rectangle clip_rect, RGBA32 color, ShaderHandle shader, RenderLayer layer);
 
-void set_vec4_uniform(RenderEntry *re, LinearArena *arena, String uniform_name, Vector4 vec);
-void set_f32_uniform(RenderEntry *re, LinearArena *arena, String uniform_name, f32 value);
+// Setup commands can only be added to the most recently pushed entry of a batch
+void set_vec4_uniform(RenderBatch *rb, RenderEntry *re, String uniform_name, Vector4 vec);
+void set_f32_uniform(RenderBatch *rb, RenderEntry *re, String uniform_name, f32 value);
 
 #endif //RENDER_BATCH_H
@@ -6,6 +6,7 @@
 #include "base/rectangle.h"
 #include "base/string8.h"
 #include "base/triangle.h"
+#include "base/vertex.h"
 #include "platform/asset.h"
 
 // TODO: X macro to avoid defining new commands in multiple places
@@ -24,6 +25,8 @@ struct ParticleBufferNew;
     RENDER_COMMAND(ParticleGroupCmd)            \
     RENDER_COMMAND(PolygonCmd)                  \
     RENDER_COMMAND(TriangleFanCmd)              \
+    RENDER_COMMAND(StaticQuadsCmd)              \
+    RENDER_COMMAND(LightCmd)                    \
 
 #define RENDER_SETUP_COMMAND_LIST               \
     RENDER_SETUP_COMMAND(SetupCmdUniformVec4)   \
@@ -44,15 +47,26 @@ typedef enum {
 #undef RENDER_SETUP_COMMAND
 } SetupCmdKind;
 
-typedef struct SetupCmdHeader {
+/*
+  Commands are stored back to back in the command buffer of their render batch. Any setup
+  commands for a command are stored directly after it, so executing an entry only touches
+  one contiguous range of memory.
+ */
+
+// Every command and setup command starts at a multiple of this
+#define RENDER_COMMAND_ALIGNMENT 8
+
+typedef struct {
     SetupCmdKind kind;
-    struct SetupCmdHeader *next;
+    u32 size; // Distance to the next setup command
     String uniform_name;
 } SetupCmdHeader;
 
 typedef struct {
     RenderCmdKind kind;
-    SetupCmdHeader *first_setup_command;
+    u32 size; // Including setup commands
+    u32 setup_commands_offset;
+    u32 setup_command_count;
 } RenderCmdHeader;
 
 /* Render command types */
@@ -134,6 +148,32 @@ typedef struct {
     RGBA32 color;
 } TriangleFanCmd;
 
+// Quads of a StaticQuadsCmd that are drawn differently this frame, without touching the
+// vertices, which are usually cached between frames
+typedef struct {
+    const s32 *quads; // Ascending order
+    ssize count;
+    f32 alpha;        // Multiplies the alpha of the listed quads, zero skips them
+} QuadOverlay;
+
+typedef struct {
+    RenderCmdHeader header;
+    const Vertex *vertices; // Four per quad: top left, top right, bottom right, bottom left
+    ssize quad_count;
+    QuadOverlay overlay;
+} StaticQuadsCmd;
+
+// Light parameters are passed per vertex, so lights using the same shader are drawn together
+typedef struct {
+    RenderCmdHeader header;
+    Vector2 origin;
+    f32 radius;
+    RGBA32 color;
+    TriangleFan area; // The lit area, the whole circle if it has no triangles
+    b32 is_clipped;
+    Rectangle clip_rect;
+} LightCmd;
+
 /* Setup command types */
 typedef struct {
     SetupCmdHeader header;
@@ -0,0 +1,14 @@
+#ifndef RENDER_STATS_H
+#define RENDER_STATS_H
+
+#include "base/typedefs.h"
+
+// Gathered while executing render batches, handed to the game with the next frame
+typedef struct {
+    ssize draw_calls;
+    ssize vertices;
+    ssize state_flushes;       // Flushes caused by switching shader or texture
+    ssize atlas_flushes_saved; // Texture changes that didn't flush since both were on the same atlas page
+} RenderStats;
+
+#endif //RENDER_STATS_H
@@ -12,11 +12,14 @@ SOURCE_TEMPLATE = """/**********************************************************
 /* This file is generated by a script - do not modify it or add to source control! */
 /***********************************************************************************/
 
+#define _POSIX_C_SOURCE 199309L
+
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <assert.h>
+#include <time.h>
 
 #include "test_macros.h"
 
@@ -106,6 +109,45 @@ static void IMPL_save_passed_assert(const char *filename, const char *expr_strin
     IMPL_push_assert(current_case, &current_case->successful_assertions, filename, expr_string, line);
 }
 
+/* Benchmark timing */
+typedef struct {
+    const char *label;
+    int32_t run_count;
+    int32_t run;
+    struct timespec start;
+} IMPL_BenchmarkTimer;
+
+static inline IMPL_BenchmarkTimer IMPL_start_benchmark(const char *label, int32_t run_count)
+{
+    assert(run_count > 0);
+
+    IMPL_BenchmarkTimer result = {0};
+    result.label = label;
+    result.run_count = run_count;
+    clock_gettime(CLOCK_MONOTONIC, &result.start);
+
+    return result;
+}
+
+// Prints the average time of a run once all runs are done
+static inline int32_t IMPL_benchmark_is_running(IMPL_BenchmarkTimer *timer)
+{
+    if (timer->run < timer->run_count) {
+        return 1;
+    }
+
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed_ns = (double)(end.tv_sec - timer->start.tv_sec) * 1e9
+        + (double)(end.tv_nsec - timer->start.tv_nsec);
+
+    printf("    %-44s %14.1f ns/run (%d runs)\\n", timer->label,
+        elapsed_ns / (double)timer->run_count, timer->run_count);
+
+    return 0;
+}
+
 /* Included test files go here */
 {INSERT_INCLUDE_DIRECTIVES}
 
@@ -144,6 +186,15 @@ static void IMPL_save_passed_assert(const char *filename, const char *expr_strin
         IMPL_GET_CASE_FUNCTION_NAME(name)();    \\
     } while (0)
 
+#define RUN_BENCHMARK(name)                                             \\
+    do {                                                                \\
+        if (!benchmark_filter || strstr(#name, benchmark_filter)) {     \\
+            push_new_test_case(#name);                                  \\
+            printf("%s\\n", #name);                                      \\
+            IMPL_GET_BENCHMARK_FUNCTION_NAME(name)();                   \\
+        }                                                               \\
+    } while (0)
+
 typedef struct {
     int32_t failed_assert_count;
     int32_t passed_assert_count;
@@ -298,12 +349,20 @@ static void print_summary(void)
     repeat_char('~', COLOR_NORMAL, BAR_WIDTH, 1);
 }
 
-int main(void)
+int main(int argc, char **argv)
 {
     IMPL_test_cases = create_test_case_list();
 
-    /* Calls to test case functions go here */
-    {INSERT_TEST_CASE_CALLS}
+    if ((argc > 1) && (strcmp(argv[1], "--benchmark") == 0)) {
+        const char *benchmark_filter = (argc > 2) ? argv[2] : 0;
+        (void)benchmark_filter;
+
+        /* Calls to benchmark case functions go here */
+        {INSERT_BENCHMARK_CASE_CALLS}
+    } else {
+        /* Calls to test case functions go here */
+        {INSERT_TEST_CASE_CALLS}
+    }
 
     print_summary();
 
@@ -319,8 +378,12 @@ def gather_test_cases_in_file(file_contents):
     matches = re.findall(r'TEST_CASE\((.*)\)', file_contents)
     return matches
 
+def gather_benchmark_cases_in_file(file_contents):
+    matches = re.findall(r'BENCHMARK_CASE\((.*)\)', file_contents)
+    return matches
 
-def gather_test_cases(filenames):
+
+def gather_test_cases(filenames, gather_cases_in_file=gather_test_cases_in_file):
     cases = []
     encountered_case_names = set()
     errors = []
@@ -328,7 +391,7 @@ def gather_test_cases(filenames):
     for filename in filenames:
         try:
             with open(filename) as f:
-                cases_in_file = gather_test_cases_in_file(f.read())
+                cases_in_file = gather_cases_in_file(f.read())
                 cases += cases_in_file
 
                 for case in cases_in_file:
@@ -345,7 +408,7 @@ def gather_test_cases(filenames):
             exit(1)
     return cases
 
-def create_test_runner_source(files, test_cases, output_dir):
+def create_test_runner_source(files, test_cases, benchmark_cases, output_dir):
     include_directives = ''
 
     for f in files:
@@ -355,12 +418,18 @@ def create_test_runner_source(files, test_cases, output_dir):
     test_case_calls = ''
 
     for case in test_cases:
-        test_case_calls += f'RUN_TEST({case});\n    '
+        test_case_calls += f'RUN_TEST({case});\n        '
+
+    benchmark_case_calls = ''
+
+    for case in benchmark_cases:
+        benchmark_case_calls += f'RUN_BENCHMARK({case});\n        '
 
     # TODO: find a better way to replace strings in this template
-    result = SOURCE_TEMPLATE                                    \
-    .replace('{INSERT_INCLUDE_DIRECTIVES}', include_directives) \
-    .replace('{INSERT_TEST_CASE_CALLS}',    test_case_calls)
+    result = SOURCE_TEMPLATE                                          \
+    .replace('{INSERT_INCLUDE_DIRECTIVES}',    include_directives)    \
+    .replace('{INSERT_TEST_CASE_CALLS}',       test_case_calls)       \
+    .replace('{INSERT_BENCHMARK_CASE_CALLS}', benchmark_case_calls)
 
     return result
 
@@ -376,8 +445,10 @@ def main():
     output_dir = output_path.parent
 
     test_cases_to_run = gather_test_cases(input_files)
+    benchmark_cases_to_run = gather_test_cases(input_files, gather_benchmark_cases_in_file)
 
-    source_string = create_test_runner_source(input_files, test_cases_to_run, output_dir)
+    source_string = create_test_runner_source(input_files, test_cases_to_run,
+                                              benchmark_cases_to_run, output_dir)
 
     with open(output_path, 'w') as f:
         f.write(source_string)
@@ -8,6 +8,9 @@
 #define IMPL_CASE_FUNCTION_NAME_PREFIX IMPL_TEST_FUNCTION_
 #define IMPL_GET_CASE_FUNCTION_NAME(name) IMPL_CONCAT(IMPL_CASE_FUNCTION_NAME_PREFIX, name)
 
+#define IMPL_BENCHMARK_FUNCTION_NAME_PREFIX IMPL_BENCHMARK_FUNCTION_
+#define IMPL_GET_BENCHMARK_FUNCTION_NAME(name) IMPL_CONCAT(IMPL_BENCHMARK_FUNCTION_NAME_PREFIX, name)
+
 /* User macros */
 #define TEST_CASE(name) static void IMPL_GET_CASE_FUNCTION_NAME(name)(void)
 
@@ -22,4 +25,18 @@
         }                                                               \
     } while (0)
 
+/*
+  Benchmark cases are only run when the test executable is started with --benchmark,
+  optionally followed by a part of the names of the cases to run. Each BENCHMARK_LOOP
+  runs its body the given number of times and prints the average time of a run.
+  REQUIRE can be used in benchmark cases too, for example to keep results from being
+  optimized away.
+ */
+#define BENCHMARK_CASE(name) static void IMPL_GET_BENCHMARK_FUNCTION_NAME(name)(void)
+
+#define BENCHMARK_LOOP(label, run_count)                                        \
+    for (IMPL_BenchmarkTimer IMPL_timer = IMPL_start_benchmark((label), (run_count)); \
+         IMPL_benchmark_is_running(&IMPL_timer);                                \
+         ++IMPL_timer.run)
+
 #endif //TEST_MACROS_H
@@ -0,0 +1,73 @@
+#include "test_macros.h"
+#include "base/rect_pack.h"
+
+static b32 packed_rects_overlap(PackedRect a, Vector2i a_size, PackedRect b, Vector2i b_size, s32 padding)
+{
+    if (a.page != b.page) {
+        return false;
+    }
+
+    b32 result = (a.position.x - padding < b.position.x + b_size.x + padding)
+        && (b.position.x - padding < a.position.x + a_size.x + padding)
+        && (a.position.y - padding < b.position.y + b_size.y + padding)
+        && (b.position.y - padding < a.position.y + a_size.y + padding);
+
+    return result;
+}
+
+TEST_CASE(rect_pack_places_sprites_without_overlap)
+{
+    LinearArena arena = la_create(default_allocator, 4096);
+
+    // Same sizes as the sprites in the assets directory
+    Vector2i sizes[] = {
+        {64, 64}, {64, 64}, {32, 32}, {32, 32}, {32, 32}, {32, 32}, {32, 32}, {32, 32},
+        {32, 32}, {32, 32}, {32, 32}, {64, 64}, {64, 64}, {32, 32}, {64, 64},
+    };
+
+    s32 padding = 1;
+    Vector2i page_size = v2i(160, 160);
+    PackedRect packed[ARRAY_COUNT(sizes)] = {0};
+
+    s32 page_count = rect_pack(sizes, ARRAY_COUNT(sizes), page_size, padding, packed, &arena);
+    REQUIRE(page_count == 2);
+
+    for (s32 i = 0; i < ARRAY_COUNT(sizes); ++i) {
+        REQUIRE((packed[i].page >= 0) && (packed[i].page < page_count));
+        REQUIRE(packed[i].position.x >= padding);
+        REQUIRE(packed[i].position.y >= padding);
+        REQUIRE(packed[i].position.x + sizes[i].x + padding <= page_size.x);
+        REQUIRE(packed[i].position.y + sizes[i].y + padding <= page_size.y);
+
+        for (s32 j = i + 1; j < ARRAY_COUNT(sizes); ++j) {
+            REQUIRE(!packed_rects_overlap(packed[i], sizes[i], packed[j], sizes[j], padding));
+        }
+    }
+
+    // Everything fits on one page of the size the assets use
+    page_count = rect_pack(sizes, ARRAY_COUNT(sizes), v2i(512, 512), padding, packed, &arena);
+    REQUIRE(page_count == 1);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(rect_pack_skips_rects_larger_than_a_page)
+{
+    LinearArena arena = la_create(default_allocator, 4096);
+
+    Vector2i sizes[] = {{16, 16}, {64, 8}, {10, 70}};
+    PackedRect packed[ARRAY_COUNT(sizes)] = {0};
+
+    // The padding makes the second one too wide
+    s32 page_count = rect_pack(sizes, ARRAY_COUNT(sizes), v2i(64, 64), 1, packed, &arena);
+
+    REQUIRE(page_count == 1);
+    REQUIRE(packed[0].page == 0);
+    REQUIRE(v2i_eq(packed[0].position, v2i(1, 1)));
+    REQUIRE(packed[1].page == RECT_PACK_NO_PAGE);
+    REQUIRE(packed[2].page == RECT_PACK_NO_PAGE);
+
+    REQUIRE(rect_pack(sizes, 0, v2i(64, 64), 1, packed, &arena) == 0);
+
+    la_destroy(&arena);
+}
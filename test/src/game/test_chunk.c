@@ -0,0 +1,204 @@
+#include "base/linear_arena.h"
+#include "renderer/frontend/render_batch.h"
+#include "test_macros.h"
+#include "world/chunk.h"
+#include "world/tilemap.h"
+#include "world/world.h"
+
+#define CHUNK_TEST_WALL_ROW 3
+
+static b32 static_quad_matches(const Vertex *quad, RectangleVertices expected)
+{
+    b32 result = v2_eq(quad[0].position, expected.top_left.position)
+        && v2_eq(quad[1].position, expected.top_right.position)
+        && v2_eq(quad[2].position, expected.bottom_right.position)
+        && v2_eq(quad[3].position, expected.bottom_left.position)
+        && v2_eq(quad[0].uv, expected.top_left.uv)
+        && v2_eq(quad[2].uv, expected.bottom_right.uv);
+
+    return result;
+}
+
+// Two chunks side by side, with a row of walls through both of them. The top right tile of
+// the first chunk is left out, and one extra wall stands on top of the row.
+static Chunks create_chunk_test_map(Tilemap *tilemap, LinearArena *arena)
+{
+    tilemap_initialize(tilemap);
+
+    for (s32 y = 0; y < CHUNK_SIZE_IN_TILES; ++y) {
+        for (s32 x = 0; x < CHUNK_SIZE_IN_TILES * 2; ++x) {
+            if ((x == CHUNK_SIZE_IN_TILES - 1) && (y == CHUNK_SIZE_IN_TILES - 1)) {
+                continue;
+            }
+
+            b32 is_wall = (y == CHUNK_TEST_WALL_ROW) || ((x == 1) && (y == CHUNK_TEST_WALL_ROW + 1));
+            tilemap_insert_tile(tilemap, v2i(x, y), is_wall ? TILE_WALL : TILE_FLOOR, arena);
+        }
+    }
+
+    Chunks result = create_chunks_for_tilemap(tilemap, arena);
+
+    return result;
+}
+
+TEST_CASE(chunk_tile_geometry_is_built_once_and_rebuilt_after_tile_changes)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    Chunks chunks = create_chunk_test_map(tilemap, &arena);
+
+    REQUIRE(chunks.chunk_count == 2);
+
+    Chunk *first = &chunks.chunks[0];
+    Chunk *second = &chunks.chunks[1];
+
+    REQUIRE(v2i_eq(get_chunk_base_tile_coords(&chunks, first), v2i(0, 0)));
+    REQUIRE(v2i_eq(get_chunk_base_tile_coords(&chunks, second), v2i(CHUNK_SIZE_IN_TILES, 0)));
+    REQUIRE(chunk_tile_geometry_is_stale(first, tilemap));
+
+    build_chunk_tile_geometry(&chunks, first, tilemap, default_allocator);
+
+    ChunkTileGeometry *geometry = &first->tile_geometry;
+    s32 wall_count = CHUNK_SIZE_IN_TILES + 1;
+    s32 floor_count = CHUNK_SIZE_IN_TILES * CHUNK_SIZE_IN_TILES - wall_count - 1;
+
+    REQUIRE(!chunk_tile_geometry_is_stale(first, tilemap));
+    REQUIRE(geometry->floors.quad_count == floor_count);
+    REQUIRE(geometry->wall_bases.quad_count == wall_count);
+    REQUIRE(geometry->wall_tops.quad_count == wall_count);
+
+    // Same vertices as drawing the tiles one by one
+    Rectangle floor_rect = {{0, 0}, {TILE_SIZE, TILE_SIZE}};
+    REQUIRE(static_quad_matches(geometry->floors.vertices,
+        rect_get_vertices(floor_rect, RGBA32_WHITE, Y_IS_UP)));
+
+    Rectangle wall_rect = {{TILE_SIZE, CHUNK_TEST_WALL_ROW * TILE_SIZE}, {TILE_SIZE, TILE_SIZE * 2}};
+    Rectangle wall_base = {wall_rect.position, {TILE_SIZE, TILE_SIZE}};
+    Rectangle wall_top = {v2_add(wall_rect.position, v2(0, TILE_SIZE)), {TILE_SIZE, TILE_SIZE}};
+
+    REQUIRE(static_quad_matches(geometry->wall_bases.vertices + 4,
+        rect_get_clipped_vertices(wall_rect, wall_base, RGBA32_WHITE, Y_IS_UP).vertices));
+    REQUIRE(static_quad_matches(geometry->wall_tops.vertices + 4,
+        rect_get_clipped_vertices(wall_rect, wall_top, RGBA32_WHITE, Y_IS_UP).vertices));
+    REQUIRE(rect_eq(geometry->wall_top_infos[1].top_segment, wall_top));
+
+    // Only walls with floor above them can be walked behind
+    REQUIRE(geometry->wall_top_infos[0].can_walk_behind);
+    REQUIRE(!geometry->wall_top_infos[1].can_walk_behind);
+    REQUIRE(geometry->wall_top_infos[wall_count - 1].can_walk_behind);
+
+    // Filling in the missing tile invalidates the geometry
+    tilemap_insert_tile(tilemap, v2i(CHUNK_SIZE_IN_TILES - 1, CHUNK_SIZE_IN_TILES - 1), TILE_FLOOR, &arena);
+    REQUIRE(chunk_tile_geometry_is_stale(first, tilemap));
+
+    build_chunk_tile_geometry(&chunks, first, tilemap, default_allocator);
+    REQUIRE(!chunk_tile_geometry_is_stale(first, tilemap));
+    REQUIRE(geometry->floors.quad_count == floor_count + 1);
+
+    build_chunk_tile_geometry(&chunks, second, tilemap, default_allocator);
+    REQUIRE(second->tile_geometry.wall_tops.quad_count == CHUNK_SIZE_IN_TILES);
+    REQUIRE(second->tile_geometry.floors.quad_count
+        == CHUNK_SIZE_IN_TILES * CHUNK_SIZE_IN_TILES - CHUNK_SIZE_IN_TILES);
+
+    destroy_chunk_tile_geometry(first, default_allocator);
+    destroy_chunk_tile_geometry(second, default_allocator);
+    REQUIRE(chunk_tile_geometry_is_stale(first, tilemap));
+
+    la_destroy(&arena);
+}
+
+#define TILE_BENCHMARK_CHUNKS_PER_SIDE 2
+#define TILE_BENCHMARK_VIEWPORT_SIZE   (TILE_BENCHMARK_CHUNKS_PER_SIDE * CHUNK_SIZE_IN_TILES * TILE_SIZE)
+
+static RenderBatch *push_tile_benchmark_batch(RenderBatchList *list, LinearArena *arena)
+{
+    Vector2i viewport = v2i(TILE_BENCHMARK_VIEWPORT_SIZE, TILE_BENCHMARK_VIEWPORT_SIZE);
+    Camera camera = create_screenspace_camera(viewport);
+    RenderBatch *result = push_new_render_batch(list, camera, viewport, Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, arena);
+
+    return result;
+}
+
+// Every fourth row is a wall. Drawing tiles one by one is done like the world did before
+// chunks cached their geometry, minus the wall transparency checks.
+BENCHMARK_CASE(tiles_recorded_per_tile_and_from_chunk_geometry)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    LinearArena frame_arena = la_create(default_allocator, MB(4));
+
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    tilemap_initialize(tilemap);
+
+    s32 tiles_per_side = TILE_BENCHMARK_CHUNKS_PER_SIDE * CHUNK_SIZE_IN_TILES;
+
+    for (s32 y = 0; y < tiles_per_side; ++y) {
+        for (s32 x = 0; x < tiles_per_side; ++x) {
+            tilemap_insert_tile(tilemap, v2i(x, y), (y % 4 == 3) ? TILE_WALL : TILE_FLOOR, &arena);
+        }
+    }
+
+    Chunks chunks = create_chunks_for_tilemap(tilemap, &arena);
+
+    for (ssize i = 0; i < chunks.chunk_count; ++i) {
+        build_chunk_tile_geometry(&chunks, &chunks.chunks[i], tilemap, default_allocator);
+    }
+
+    TextureHandle floor_texture = {1};
+    TextureHandle wall_texture = {2};
+    ShaderHandle texture_shader = {1};
+    ssize entry_count = 0;
+
+    BENCHMARK_LOOP("per tile: record and sort", 1000) {
+        la_reset(&frame_arena);
+        RenderBatchList list = {0};
+        RenderBatch *rb = push_tile_benchmark_batch(&list, &frame_arena);
+
+        for (s32 y = 0; y < tiles_per_side; ++y) {
+            for (s32 x = 0; x < tiles_per_side; ++x) {
+                Tile *tile = tilemap_get_tile(tilemap, v2i(x, y));
+                Rectangle rect = {{(f32)(x * TILE_SIZE), (f32)(y * TILE_SIZE)}, {TILE_SIZE, TILE_SIZE}};
+
+                if (tile->type == TILE_WALL) {
+                    rect.size.y += TILE_SIZE;
+                    draw_sprite(rb, wall_texture, rect, (SpriteModifiers){0}, texture_shader, RENDER_LAYER_WALLS);
+                } else {
+                    draw_sprite(rb, floor_texture, rect, (SpriteModifiers){0}, texture_shader, RENDER_LAYER_FLOORS);
+                }
+            }
+        }
+
+        sort_render_entries(rb, &frame_arena);
+        entry_count += rb->entry_count;
+    }
+
+    BENCHMARK_LOOP("chunk geometry: record and sort", 1000) {
+        la_reset(&frame_arena);
+        RenderBatchList list = {0};
+        RenderBatch *rb = push_tile_benchmark_batch(&list, &frame_arena);
+        QuadOverlay no_overlay = {0};
+
+        for (ssize i = 0; i < chunks.chunk_count; ++i) {
+            ChunkTileGeometry *geometry = &chunks.chunks[i].tile_geometry;
+
+            draw_static_quads(rb, floor_texture, geometry->floors.vertices, geometry->floors.quad_count,
+                no_overlay, texture_shader, RENDER_LAYER_FLOORS);
+            draw_static_quads(rb, wall_texture, geometry->wall_bases.vertices, geometry->wall_bases.quad_count,
+                no_overlay, texture_shader, RENDER_LAYER_FLOORS);
+            draw_static_quads(rb, wall_texture, geometry->wall_tops.vertices, geometry->wall_tops.quad_count,
+                no_overlay, texture_shader, RENDER_LAYER_WALLS);
+        }
+
+        sort_render_entries(rb, &frame_arena);
+        entry_count += rb->entry_count;
+    }
+
+    REQUIRE(entry_count > 0);
+
+    for (ssize i = 0; i < chunks.chunk_count; ++i) {
+        destroy_chunk_tile_geometry(&chunks.chunks[i], default_allocator);
+    }
+
+    la_destroy(&frame_arena);
+    la_destroy(&arena);
+}
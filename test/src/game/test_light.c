@@ -0,0 +1,536 @@
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+#include "base/linear_arena.h"
+#include "base/maths.h"
+#include "light.h"
+#include "world/edge_raycast.h"
+#include "test_macros.h"
+#include "world/tilemap.h"
+
+// Square room of floor tiles surrounded by walls
+static void create_test_room(Tilemap *tilemap, s32 size, LinearArena *arena)
+{
+    tilemap_initialize(tilemap);
+
+    for (s32 y = 0; y < size; ++y) {
+        for (s32 x = 0; x < size; ++x) {
+            b32 is_border = (x == 0) || (y == 0) || (x == size - 1) || (y == size - 1);
+            tilemap_insert_tile(tilemap, v2i(x, y), is_border ? TILE_WALL : TILE_FLOOR, arena);
+        }
+    }
+}
+
+TEST_CASE(visibility_cache_hits_until_key_changes)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 6, &arena);
+
+    VisibilityPolygonCache cache = {0};
+    visibility_cache_initialize(&cache, default_allocator);
+
+    LightSource light = {.kind = LIGHT_RAYCASTED, .radius = 200.0f};
+    LightSource smaller_light = {.kind = LIGHT_RAYCASTED, .radius = 100.0f};
+
+    EntityID light_entity = {.index = 3, .generation = 1};
+    EntityID other_light_entity = {.index = 4, .generation = 1};
+
+    Vector2 origin = {150.0f, 170.0f};
+    TriangleFan first = visibility_cache_get_polygon(&cache, light_entity, origin, &light, tilemap, &arena);
+
+    REQUIRE(cache.misses == 1);
+    REQUIRE(cache.hits == 0);
+    REQUIRE(first.count > 0);
+
+    // Sub-quantum movement still hits
+    TriangleFan second = visibility_cache_get_polygon(&cache, light_entity,
+        v2_add(origin, v2(0.25f, 0.25f)), &light, tilemap, &arena);
+
+    REQUIRE(cache.hits == 1);
+    REQUIRE(second.items == first.items);
+    REQUIRE(second.count == first.count);
+
+    // Other lights have their own entries
+    visibility_cache_get_polygon(&cache, other_light_entity, origin, &light, tilemap, &arena);
+    REQUIRE(cache.misses == 2);
+
+    visibility_cache_get_polygon(&cache, light_entity, origin, &smaller_light, tilemap, &arena);
+    REQUIRE(cache.misses == 3);
+
+    visibility_cache_get_polygon(&cache, light_entity, v2(250.0f, 170.0f), &smaller_light, tilemap, &arena);
+    REQUIRE(cache.misses == 4);
+
+    tilemap_insert_tile(tilemap, v2i(10, 10), TILE_WALL, &arena);
+    visibility_cache_get_polygon(&cache, light_entity, v2(250.0f, 170.0f), &smaller_light, tilemap, &arena);
+    REQUIRE(cache.misses == 5);
+    REQUIRE(cache.hits == 1);
+
+    visibility_cache_destroy(&cache);
+    la_destroy(&arena);
+}
+
+TEST_CASE(visibility_cache_misses_for_reused_entity_slot)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 6, &arena);
+
+    VisibilityPolygonCache cache = {0};
+    visibility_cache_initialize(&cache, default_allocator);
+
+    LightSource light = {.kind = LIGHT_RAYCASTED, .radius = 200.0f};
+    Vector2 origin = {150.0f, 170.0f};
+
+    EntityID old_entity = {.index = 3, .generation = 1};
+    EntityID new_entity = {.index = 3, .generation = 2};
+
+    visibility_cache_get_polygon(&cache, old_entity, origin, &light, tilemap, &arena);
+    REQUIRE(cache.misses == 1);
+
+    // A new light in the same slot with an identical key must not get the old polygon
+    visibility_cache_get_polygon(&cache, new_entity, origin, &light, tilemap, &arena);
+    REQUIRE(cache.misses == 2);
+    REQUIRE(cache.hits == 0);
+
+    visibility_cache_get_polygon(&cache, new_entity, origin, &light, tilemap, &arena);
+    REQUIRE(cache.hits == 1);
+
+    visibility_cache_destroy(&cache);
+    la_destroy(&arena);
+}
+
+// Distance from the fan center to the fan outline in the given direction
+static f32 get_fan_extent_in_direction(TriangleFan fan, Vector2 dir)
+{
+    f32 result = INFINITY;
+
+    for (ssize i = 0; i < fan.count; ++i) {
+        Vector2 a = v2_sub(fan.items[i].a, fan.center);
+        Vector2 b = v2_sub(fan.items[i].b, fan.center);
+        Vector2 edge = v2_sub(b, a);
+
+        f32 denominator = v2_cross(dir, edge);
+
+        if (denominator != 0.0f) {
+            f32 t = v2_cross(a, edge) / denominator;
+            f32 s = v2_cross(a, dir) / denominator;
+
+            if ((t > 0.0f) && (s >= 0.0f) && (s <= 1.0f)) {
+                result = MIN(result, t);
+            }
+        }
+    }
+
+    return result;
+}
+
+// Counts the sampled directions where the two fans disagree inside the light radius
+static s32 count_visibility_mismatches(TriangleFan reference, TriangleFan fan, f32 radius)
+{
+    s32 sample_count = 720;
+    s32 result = 0;
+
+    for (s32 i = 0; i < sample_count; ++i) {
+        f32 angle = 0.0013f + (f32)i * (2.0f * PI / (f32)sample_count);
+        Vector2 dir = {cosf(angle), sinf(angle)};
+
+        f32 reference_extent = MIN(get_fan_extent_in_direction(reference, dir), radius);
+        f32 extent = MIN(get_fan_extent_in_direction(fan, dir), radius);
+
+        if (abs_f32(reference_extent - extent) > 0.5f) {
+            ++result;
+        }
+    }
+
+    return result;
+}
+
+static void insert_wall_block(Tilemap *tilemap, s32 min_x, s32 min_y, s32 max_x, s32 max_y,
+    LinearArena *arena)
+{
+    for (s32 y = min_y; y <= max_y; ++y) {
+        for (s32 x = min_x; x <= max_x; ++x) {
+            Tile *tile = tilemap_get_tile(tilemap, v2i(x, y));
+
+            if (tile) {
+                tile->type = TILE_WALL;
+            } else {
+                tilemap_insert_tile(tilemap, v2i(x, y), TILE_WALL, arena);
+            }
+        }
+    }
+}
+
+TEST_CASE(shadowcast_visibility_matches_edge_raycast_in_empty_room)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 12, &arena);
+
+    Vector2 origins[] = {{390.0f, 410.0f}, {100.0f, 100.0f}, {700.0f, 200.0f}};
+    f32 radius = 300.0f;
+
+    for (s32 i = 0; i < ARRAY_COUNT(origins); ++i) {
+        TriangleFan reference = get_visibility_polygon(origins[i], tilemap, &arena);
+        TriangleFan fan = get_shadowcast_visibility_polygon(origins[i], radius, tilemap, &arena);
+
+        REQUIRE(fan.count > 0);
+        REQUIRE(count_visibility_mismatches(reference, fan, radius) == 0);
+    }
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(shadowcast_visibility_matches_edge_raycast_with_pillars)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 16, &arena);
+
+    insert_wall_block(tilemap, 4, 4, 5, 5, &arena);
+    insert_wall_block(tilemap, 9, 3, 9, 8, &arena);
+    insert_wall_block(tilemap, 3, 10, 7, 10, &arena);
+    insert_wall_block(tilemap, 12, 11, 12, 11, &arena);
+
+    Vector2 origins[] = {
+        {450.0f, 450.0f}, {200.0f, 520.0f}, {700.0f, 700.0f}, {530.0f, 130.0f}
+    };
+    f32 radii[] = {150.0f, 400.0f};
+
+    for (s32 i = 0; i < ARRAY_COUNT(origins); ++i) {
+        for (s32 j = 0; j < ARRAY_COUNT(radii); ++j) {
+            TriangleFan reference = get_visibility_polygon(origins[i], tilemap, &arena);
+            TriangleFan fan = get_shadowcast_visibility_polygon(origins[i], radii[j], tilemap, &arena);
+
+            REQUIRE(count_visibility_mismatches(reference, fan, radii[j]) == 0);
+        }
+    }
+
+    la_destroy(&arena);
+}
+
+#define MAX_TEST_JOB_THREADS 16
+
+typedef struct {
+    JobFunction *function;
+    void        *data;
+    JobCounter  *counter;
+} ThreadedTestJob;
+
+// Every job gets its own thread, so that jobs really do run concurrently
+static pthread_t g_job_threads[MAX_TEST_JOB_THREADS];
+static ThreadedTestJob   g_threaded_jobs[MAX_TEST_JOB_THREADS];
+static s32       g_job_thread_count;
+
+static void *run_threaded_test_job(void *data)
+{
+    ThreadedTestJob *job = data;
+    job->function(job->data);
+    atomic_add_s32(&job->counter->pending_jobs, -1);
+
+    return 0;
+}
+
+static void threaded_submit_job(JobFunction *function, void *data, JobCounter *counter)
+{
+    REQUIRE(g_job_thread_count < MAX_TEST_JOB_THREADS);
+
+    atomic_add_s32(&counter->pending_jobs, 1);
+
+    ThreadedTestJob *job = &g_threaded_jobs[g_job_thread_count];
+    *job = (ThreadedTestJob){function, data, counter};
+    pthread_create(&g_job_threads[g_job_thread_count++], 0, run_threaded_test_job, job);
+}
+
+static void threaded_wait_for_jobs(JobCounter *counter)
+{
+    for (s32 i = 0; i < g_job_thread_count; ++i) {
+        pthread_join(g_job_threads[i], 0);
+    }
+
+    g_job_thread_count = 0;
+    REQUIRE(job_counter_is_done(counter));
+}
+
+TEST_CASE(parallel_visibility_polygons_match_serial)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 8);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 16, &arena);
+
+    insert_wall_block(tilemap, 4, 4, 5, 5, &arena);
+    insert_wall_block(tilemap, 9, 3, 9, 8, &arena);
+
+    PlatformCode platform_code = {
+        .submit_job = threaded_submit_job,
+        .wait_for_jobs = threaded_wait_for_jobs
+    };
+
+    VisibilityRequest requests[12] = {0};
+
+    for (s32 i = 0; i < ARRAY_COUNT(requests); ++i) {
+        VisibilityRequest *request = &requests[i];
+        request->light_entity = (EntityID){.index = i, .generation = 1};
+        request->origin = v2(100.0f + 61.0f * (f32)i, 120.0f + 47.0f * (f32)(i % 5));
+        request->light.kind = LIGHT_RAYCASTED;
+        request->light.radius = 150.0f + 20.0f * (f32)i;
+        request->light.visibility_backend = (i % 2) ? LIGHT_VISIBILITY_SHADOWCAST
+            : LIGHT_VISIBILITY_EDGE_RAYCAST;
+    }
+
+    VisibilityPolygonCache parallel_cache = {0};
+    VisibilityPolygonCache serial_cache = {0};
+    visibility_cache_initialize(&parallel_cache, default_allocator);
+    visibility_cache_initialize(&serial_cache, default_allocator);
+
+    visibility_cache_generate_polygons(&parallel_cache, requests, ARRAY_COUNT(requests), tilemap,
+        platform_code, &arena);
+    REQUIRE(parallel_cache.misses == ARRAY_COUNT(requests));
+
+    for (s32 i = 0; i < ARRAY_COUNT(requests); ++i) {
+        VisibilityRequest *request = &requests[i];
+
+        TriangleFan parallel = visibility_cache_get_polygon(&parallel_cache, request->light_entity,
+            request->origin, &request->light, tilemap, &arena);
+        TriangleFan serial = visibility_cache_get_polygon(&serial_cache, request->light_entity,
+            request->origin, &request->light, tilemap, &arena);
+
+        REQUIRE(parallel.count > 0);
+        REQUIRE(parallel.count == serial.count);
+        REQUIRE(v2_eq(parallel.center, serial.center));
+        REQUIRE(memcmp(parallel.items, serial.items, (usize)serial.count * sizeof(*serial.items)) == 0);
+    }
+
+    // Looking up freshly generated polygons doesn't count as a hit
+    REQUIRE(parallel_cache.hits == 0);
+    REQUIRE(parallel_cache.misses == ARRAY_COUNT(requests));
+
+    // Nothing left to generate
+    visibility_cache_generate_polygons(&parallel_cache, requests, ARRAY_COUNT(requests), tilemap,
+        platform_code, &arena);
+    REQUIRE(parallel_cache.misses == ARRAY_COUNT(requests));
+
+    visibility_cache_destroy(&parallel_cache);
+    visibility_cache_destroy(&serial_cache);
+    la_destroy(&arena);
+}
+
+TEST_CASE(edge_raycast_avx2_matches_scalar)
+{
+#if EDGE_RAYCAST_AVX2
+    if (!edge_raycast_has_avx2()) {
+        return;
+    }
+
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 16, &arena);
+
+    insert_wall_block(tilemap, 4, 4, 5, 5, &arena);
+    insert_wall_block(tilemap, 9, 3, 9, 8, &arena);
+
+    Vector2 origin = {260.0f, 230.0f};
+    EdgePool edge_pool = tilemap_get_edge_list(tilemap, la_allocator(&arena));
+    EdgeSoA edges = edge_soa_create_for_origin(edge_pool, origin, &arena);
+
+    REQUIRE(edges.count > 0);
+    REQUIRE((edges.padded_count % EDGE_RAYCAST_LANE_COUNT) == 0);
+
+    for (s32 i = 0; i < 720; ++i) {
+        f32 angle = (f32)i * (2.0f * PI / 720.0f);
+        Vector2 dir = {cos_f32(angle), sin_f32(angle)};
+
+        f32 scalar = edge_raycast_closest_hit_scalar(&edges, origin, dir);
+        f32 avx2 = edge_raycast_closest_hit_avx2(&edges, origin, dir);
+
+        // The room is closed, so every ray hits something
+        REQUIRE(scalar < INFINITY);
+        REQUIRE(scalar == avx2);
+    }
+
+    la_destroy(&arena);
+#endif
+}
+
+TEST_CASE(pseudo_angle_orders_like_atan2)
+{
+    f32 previous = -1.0f;
+
+    for (s32 i = 0; i < 720; ++i) {
+        f32 angle = (f32)i * (2.0f * PI / 720.0f);
+        f32 result = pseudo_angle(v2(cos_f32(angle), sin_f32(angle)));
+
+        REQUIRE(result >= 0.0f);
+        REQUIRE(result < 4.0f);
+        REQUIRE(result > previous);
+
+        previous = result;
+    }
+
+    // Negative zero must not end up after every other angle
+    REQUIRE(pseudo_angle(v2(1.0f, -0.0f)) == 0.0f);
+    REQUIRE(!signbit(pseudo_angle(v2(1.0f, -0.0f))));
+}
+
+static LightCandidate make_light_candidate(s32 index, Vector2 origin, LightKind kind, f32 radius)
+{
+    LightCandidate result = {0};
+    result.entity.index = index;
+    result.origin = origin;
+    result.light.kind = kind;
+    result.light.radius = radius;
+    result.light.color = RGBA32_WHITE;
+
+    return result;
+}
+
+TEST_CASE(light_selection_culls_downgrades_and_budgets)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 64);
+
+    Rectangle visible_area = {{0.0f, 0.0f}, {1000.0f, 1000.0f}};
+    LightRenderSettings settings = {3, 20.0f, false};
+    LightRenderStats stats = {0};
+
+    LightCandidate lights[] = {
+        make_light_candidate(0, v2(-500.0f, 500.0f), LIGHT_RAYCASTED, 100.0f), // Off screen
+        make_light_candidate(1, v2(500.0f, 500.0f), LIGHT_REGULAR, 50.0f),
+        make_light_candidate(2, v2(200.0f, 200.0f), LIGHT_RAYCASTED, 200.0f),
+        make_light_candidate(3, v2(1050.0f, 500.0f), LIGHT_REGULAR, 100.0f),  // Partially on screen
+        make_light_candidate(4, v2(700.0f, 700.0f), LIGHT_RAYCASTED, 5.0f),    // Tiny
+        make_light_candidate(5, v2(300.0f, 800.0f), LIGHT_REGULAR, 10.0f),
+    };
+
+    ssize count = select_lights_to_render(lights, ARRAY_COUNT(lights), visible_area, 2.0f, settings,
+        &stats, &arena);
+
+    REQUIRE(count == 3);
+    REQUIRE(stats.candidates == 6);
+    REQUIRE(stats.culled == 1);
+    REQUIRE(stats.over_budget == 2);
+    REQUIRE(stats.drawn == 3);
+
+    // Largest on screen first
+    REQUIRE(lights[0].entity.index == 2);
+    REQUIRE(lights[1].entity.index == 1);
+    REQUIRE(lights[2].entity.index == 3);
+    REQUIRE(lights[0].light.kind == LIGHT_RAYCASTED);
+
+    // 5 world units are 10 pixels, so the tiny light is drawn as a circle if it's in budget
+    REQUIRE(stats.downgraded == 1);
+
+    settings.max_lights_per_frame = 8;
+    stats = zero_struct(LightRenderStats);
+
+    LightCandidate tiny = make_light_candidate(4, v2(700.0f, 700.0f), LIGHT_RAYCASTED, 5.0f);
+    count = select_lights_to_render(&tiny, 1, visible_area, 2.0f, settings, &stats, &arena);
+
+    REQUIRE(count == 1);
+    REQUIRE(tiny.light.kind == LIGHT_REGULAR);
+
+    // Zooming in makes it large enough to cast shadows again
+    tiny = make_light_candidate(4, v2(700.0f, 700.0f), LIGHT_RAYCASTED, 5.0f);
+    count = select_lights_to_render(&tiny, 1, visible_area, 8.0f, settings, &stats, &arena);
+
+    REQUIRE(count == 1);
+    REQUIRE(tiny.light.kind == LIGHT_RAYCASTED);
+    REQUIRE(tiny.light.visibility_backend == LIGHT_VISIBILITY_EDGE_RAYCAST);
+
+    // Opting into shadowcasting switches the backend without changing the light itself
+    settings.force_shadowcast = true;
+    tiny = make_light_candidate(4, v2(700.0f, 700.0f), LIGHT_RAYCASTED, 5.0f);
+    count = select_lights_to_render(&tiny, 1, visible_area, 8.0f, settings, &stats, &arena);
+
+    REQUIRE(count == 1);
+    REQUIRE(tiny.light.kind == LIGHT_RAYCASTED);
+    REQUIRE(tiny.light.visibility_backend == LIGHT_VISIBILITY_SHADOWCAST);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(light_selection_keeps_order_of_equal_coverage)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 64);
+
+    Rectangle visible_area = {{0.0f, 0.0f}, {1000.0f, 1000.0f}};
+    LightRenderSettings settings = {8, 0.0f, false};
+    LightRenderStats stats = {0};
+
+    LightCandidate lights[] = {
+        make_light_candidate(0, v2(100.0f, 100.0f), LIGHT_REGULAR, 10.0f),
+        make_light_candidate(1, v2(500.0f, 500.0f), LIGHT_REGULAR, 50.0f),
+        make_light_candidate(2, v2(200.0f, 200.0f), LIGHT_REGULAR, 10.0f),
+        make_light_candidate(3, v2(600.0f, 600.0f), LIGHT_REGULAR, 50.0f),
+        make_light_candidate(4, v2(300.0f, 300.0f), LIGHT_REGULAR, 10.0f),
+    };
+
+    ssize count = select_lights_to_render(lights, ARRAY_COUNT(lights), visible_area, 1.0f, settings,
+        &stats, &arena);
+
+    REQUIRE(count == 5);
+    REQUIRE(lights[0].entity.index == 1);
+    REQUIRE(lights[1].entity.index == 3);
+    REQUIRE(lights[2].entity.index == 0);
+    REQUIRE(lights[3].entity.index == 2);
+    REQUIRE(lights[4].entity.index == 4);
+
+    la_destroy(&arena);
+}
+
+BENCHMARK_CASE(visibility_polygon_with_pillars)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    LinearArena scratch = la_create(default_allocator, MB(4));
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_test_room(tilemap, 16, &arena);
+
+    insert_wall_block(tilemap, 4, 4, 5, 5, &arena);
+    insert_wall_block(tilemap, 9, 3, 9, 8, &arena);
+    insert_wall_block(tilemap, 3, 10, 7, 10, &arena);
+    insert_wall_block(tilemap, 12, 11, 12, 11, &arena);
+
+    Vector2 origin = {450.0f, 450.0f};
+    EdgePool edge_pool = tilemap_get_edge_list(tilemap, la_allocator(&arena));
+    EdgeSoA edges = edge_soa_create_for_origin(edge_pool, origin, &arena);
+
+    Vector2 directions[720];
+
+    for (s32 i = 0; i < ARRAY_COUNT(directions); ++i) {
+        f32 angle = (f32)i * (2.0f * PI / (f32)ARRAY_COUNT(directions));
+        directions[i] = v2(cos_f32(angle), sin_f32(angle));
+    }
+
+    f32 distance_sum = 0.0f;
+
+    BENCHMARK_LOOP("edge raycast: scalar, 720 rays", 2000) {
+        for (s32 i = 0; i < ARRAY_COUNT(directions); ++i) {
+            distance_sum += edge_raycast_closest_hit_scalar(&edges, origin, directions[i]);
+        }
+    }
+
+#if EDGE_RAYCAST_AVX2
+    if (edge_raycast_has_avx2()) {
+        BENCHMARK_LOOP("edge raycast: avx2, 720 rays", 2000) {
+            for (s32 i = 0; i < ARRAY_COUNT(directions); ++i) {
+                distance_sum += edge_raycast_closest_hit_avx2(&edges, origin, directions[i]);
+            }
+        }
+    }
+#endif
+
+    ssize vertex_count = 0;
+
+    BENCHMARK_LOOP("visibility polygon", 2000) {
+        la_reset(&scratch);
+        TriangleFan fan = get_visibility_polygon(origin, tilemap, &scratch);
+        vertex_count += fan.count;
+    }
+
+    REQUIRE(distance_sum > 0.0f);
+    REQUIRE(vertex_count > 0);
+
+    la_destroy(&scratch);
+    la_destroy(&arena);
+}
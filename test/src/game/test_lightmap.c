@@ -0,0 +1,249 @@
+#include <string.h>
+
+#include "base/linear_arena.h"
+#include "test_macros.h"
+#include "world/chunk.h"
+#include "world/lightmap.h"
+#include "world/tilemap.h"
+
+#define TEST_ROOM_SIZE 16
+#define TEST_HOLE_TILE_X 6
+#define TEST_HOLE_TILE_Y 4
+
+// Bakes run synchronously, and the latest uploaded image is kept around for inspection
+static s32  g_submitted_jobs;
+static s32  g_created_textures;
+static s32  g_updated_textures;
+static byte g_uploaded_image[LIGHTMAP_SIZE_IN_TEXELS * LIGHTMAP_SIZE_IN_TEXELS * 4];
+
+static void test_submit_job(JobFunction *function, void *data, JobCounter *counter)
+{
+    ++g_submitted_jobs;
+
+    atomic_add_s32(&counter->pending_jobs, 1);
+    function(data);
+    atomic_add_s32(&counter->pending_jobs, -1);
+}
+
+static void test_wait_for_jobs(JobCounter *counter)
+{
+    REQUIRE(job_counter_is_done(counter));
+}
+
+static TextureHandle test_create_texture(Image image)
+{
+    memcpy(g_uploaded_image, image.data, sizeof(g_uploaded_image));
+    ++g_created_textures;
+
+    TextureHandle result = {(AssetID)g_created_textures};
+    return result;
+}
+
+static void test_update_texture(TextureHandle texture, Image image)
+{
+    (void)texture;
+
+    memcpy(g_uploaded_image, image.data, sizeof(g_uploaded_image));
+    ++g_updated_textures;
+}
+
+static PlatformCode get_test_platform_code(void)
+{
+    g_submitted_jobs = 0;
+    g_created_textures = 0;
+    g_updated_textures = 0;
+
+    PlatformCode result = {
+        .create_texture = test_create_texture,
+        .update_texture = test_update_texture,
+        .submit_job = test_submit_job,
+        .wait_for_jobs = test_wait_for_jobs,
+    };
+
+    return result;
+}
+
+// Walled room with a single missing tile, which blocks light until it is filled in
+static void create_lightmap_test_room(Tilemap *tilemap, LinearArena *arena)
+{
+    tilemap_initialize(tilemap);
+
+    for (s32 y = 0; y < TEST_ROOM_SIZE; ++y) {
+        for (s32 x = 0; x < TEST_ROOM_SIZE; ++x) {
+            if ((x == TEST_HOLE_TILE_X) && (y == TEST_HOLE_TILE_Y)) {
+                continue;
+            }
+
+            b32 is_border = (x == 0) || (y == 0) || (x == TEST_ROOM_SIZE - 1) || (y == TEST_ROOM_SIZE - 1);
+            tilemap_insert_tile(tilemap, v2i(x, y), is_border ? TILE_WALL : TILE_FLOOR, arena);
+        }
+    }
+}
+
+// Red channel of the texel covering the position, assumes the first chunk was uploaded last
+static byte get_uploaded_texel(Rectangle chunk_area, Vector2 position)
+{
+    f32 texel_size = chunk_area.size.x / (f32)LIGHTMAP_SIZE_IN_TEXELS;
+
+    s32 col = (s32)((position.x - chunk_area.position.x) / texel_size);
+    s32 row = (s32)((chunk_area.position.y + chunk_area.size.y - position.y) / texel_size);
+
+    byte result = g_uploaded_image[(row * LIGHTMAP_SIZE_IN_TEXELS + col) * 4];
+    return result;
+}
+
+TEST_CASE(lightmap_bakes_only_chunks_reached_by_lights)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_lightmap_test_room(tilemap, &arena);
+
+    Chunks chunks = create_chunks_for_tilemap(tilemap, &arena);
+    Lightmaps lightmaps = {0};
+    lightmaps_initialize(&lightmaps, &chunks, default_allocator, &arena);
+
+    PlatformCode platform_code = get_test_platform_code();
+    BakedLight light = {{288.0f, 288.0f}, 200.0f, RGBA32_WHITE, true};
+    Rectangle chunk_area = lightmaps.lightmaps[0].area;
+
+    REQUIRE(lightmaps.count == 4);
+
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_submitted_jobs == 1);
+    REQUIRE(lightmaps.pending_bakes == 1);
+
+    // Only the chunk being baked falls back to drawing the light dynamically
+    REQUIRE(!lightmaps.lightmaps[0].is_baked);
+    REQUIRE(lightmaps.lightmaps[1].is_baked);
+
+    Rectangle everything = {{-1000.0f, -1000.0f}, {4000.0f, 4000.0f}};
+    Rectangle unbaked_areas[4];
+    ssize unbaked_count = lightmaps_get_unbaked_areas(&lightmaps, everything, unbaked_areas,
+        ARRAY_COUNT(unbaked_areas));
+
+    REQUIRE(unbaked_count == 1);
+    REQUIRE(rect_eq(unbaked_areas[0], chunk_area));
+
+    // Finished bakes are uploaded on the next update
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_created_textures == 1);
+    REQUIRE(lightmaps.lightmaps[0].is_baked);
+    REQUIRE(lightmaps_get_unbaked_areas(&lightmaps, everything, unbaked_areas,
+        ARRAY_COUNT(unbaked_areas)) == 0);
+    REQUIRE(lightmaps.lightmaps[0].is_lit);
+    REQUIRE(!lightmaps.lightmaps[1].is_lit);
+
+    REQUIRE(get_uploaded_texel(chunk_area, light.origin) > 200);
+    REQUIRE(get_uploaded_texel(chunk_area, v2(438.0f, 288.0f)) > 0);    // Lit face of the hole
+    REQUIRE(get_uploaded_texel(chunk_area, v2(470.0f, 288.0f)) == 0);   // Behind the hole
+    REQUIRE(get_uploaded_texel(chunk_area, v2(288.0f, 490.0f)) == 0);   // Out of range
+
+    // Nothing changed, so nothing is rebaked
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_submitted_jobs == 1);
+
+    lightmaps_destroy(&lightmaps, platform_code);
+    la_destroy(&arena);
+}
+
+TEST_CASE(lightmap_rebakes_when_nearby_tiles_change)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_lightmap_test_room(tilemap, &arena);
+
+    Chunks chunks = create_chunks_for_tilemap(tilemap, &arena);
+    Lightmaps lightmaps = {0};
+    lightmaps_initialize(&lightmaps, &chunks, default_allocator, &arena);
+
+    PlatformCode platform_code = get_test_platform_code();
+    BakedLight light = {{288.0f, 288.0f}, 200.0f, RGBA32_WHITE, true};
+    Rectangle chunk_area = lightmaps.lightmaps[0].area;
+
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_submitted_jobs == 1);
+
+    // Tiles the light can't reach don't matter
+    tilemap_insert_tile(tilemap, v2i(TEST_ROOM_SIZE + 4, 0), TILE_FLOOR, &arena);
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_submitted_jobs == 1);
+
+    tilemap_insert_tile(tilemap, v2i(TEST_HOLE_TILE_X, TEST_HOLE_TILE_Y), TILE_FLOOR, &arena);
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_submitted_jobs == 2);
+
+    // The stale lightmap isn't drawn while the rebake is pending
+    REQUIRE(!lightmaps.lightmaps[0].is_baked);
+
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_updated_textures == 1);
+    REQUIRE(get_uploaded_texel(chunk_area, v2(470.0f, 288.0f)) > 0);
+
+    // Moving the light also rebakes
+    light.origin.x += 10.0f;
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_submitted_jobs == 3);
+
+    lightmaps_destroy(&lightmaps, platform_code);
+    la_destroy(&arena);
+}
+
+// Jobs are only run once they're waited on, like a bake still in flight on a worker
+static JobFunction *g_deferred_job;
+static void        *g_deferred_job_data;
+static JobCounter  *g_deferred_job_counter;
+
+static void deferred_submit_job(JobFunction *function, void *data, JobCounter *counter)
+{
+    REQUIRE(!g_deferred_job);
+
+    atomic_add_s32(&counter->pending_jobs, 1);
+    g_deferred_job = function;
+    g_deferred_job_data = data;
+    g_deferred_job_counter = counter;
+}
+
+static void deferred_wait_for_jobs(JobCounter *counter)
+{
+    if (g_deferred_job && (counter == g_deferred_job_counter)) {
+        g_deferred_job(g_deferred_job_data);
+        atomic_add_s32(&counter->pending_jobs, -1);
+        g_deferred_job = 0;
+    }
+}
+
+TEST_CASE(lightmap_bakes_in_flight_finish_before_reload)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_lightmap_test_room(tilemap, &arena);
+
+    Chunks chunks = create_chunks_for_tilemap(tilemap, &arena);
+    Lightmaps lightmaps = {0};
+    lightmaps_initialize(&lightmaps, &chunks, default_allocator, &arena);
+
+    PlatformCode platform_code = get_test_platform_code();
+    platform_code.submit_job = deferred_submit_job;
+    platform_code.wait_for_jobs = deferred_wait_for_jobs;
+
+    BakedLight light = {{288.0f, 288.0f}, 200.0f, RGBA32_WHITE, true};
+
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_deferred_job);
+    REQUIRE(!job_counter_is_done(&lightmaps.lightmaps[0].bake_counter));
+
+    // What the game does before its library is unloaded
+    lightmaps_wait_for_bakes(&lightmaps, platform_code);
+    REQUIRE(!g_deferred_job);
+    REQUIRE(job_counter_is_done(&lightmaps.lightmaps[0].bake_counter));
+
+    // The finished bake is still uploaded by the reloaded code
+    REQUIRE(lightmaps.lightmaps[0].pending_bake);
+    lightmaps_update(&lightmaps, tilemap, &light, 1, platform_code, &arena);
+    REQUIRE(g_created_textures == 1);
+    REQUIRE(lightmaps.lightmaps[0].is_baked);
+
+    lightmaps_destroy(&lightmaps, platform_code);
+    la_destroy(&arena);
+}
@@ -0,0 +1,172 @@
+#include "ai.h"
+#include "base/linear_arena.h"
+#include "components/component.h"
+#include "test_macros.h"
+#include "testing_utils.h"
+#include "world/line_of_sight.h"
+#include "world/world.h"
+
+#define LOS_TEST_MAP_TILES   10
+#define LOS_TEST_WALL_COLUMN 5
+
+// Floor tiles with a wall column that has a gap in the middle row
+static void create_los_test_tilemap(Tilemap *tilemap, LinearArena *arena)
+{
+    tilemap_initialize(tilemap);
+
+    for (s32 y = 0; y < LOS_TEST_MAP_TILES; ++y) {
+        for (s32 x = 0; x < LOS_TEST_MAP_TILES; ++x) {
+            b32 is_wall = (x == LOS_TEST_WALL_COLUMN) && (y != LOS_TEST_MAP_TILES / 2);
+            tilemap_insert_tile(tilemap, v2i(x, y), is_wall ? TILE_WALL : TILE_FLOOR, arena);
+        }
+    }
+}
+
+static Vector2 los_test_tile_center(s32 x, s32 y)
+{
+    Vector2 result = v2(((f32)x + 0.5f) * TILE_SIZE, ((f32)y + 0.5f) * TILE_SIZE);
+
+    return result;
+}
+
+TEST_CASE(first_wall_in_direction_respects_max_distance)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_los_test_tilemap(tilemap, &arena);
+
+    Vector2 origin = los_test_tile_center(1, 2);
+    f32 distance_to_wall = (f32)(LOS_TEST_WALL_COLUMN * TILE_SIZE) - origin.x;
+
+    WallHit hit = find_first_wall_in_direction(tilemap, origin, v2(1.0f, 0.0f), 10000.0f);
+    REQUIRE(hit.hit_wall);
+    REQUIRE(abs_f32(hit.position.x - (f32)(LOS_TEST_WALL_COLUMN * TILE_SIZE)) < 0.01f);
+    REQUIRE(abs_f32(hit.position.y - origin.y) < 0.01f);
+
+    hit = find_first_wall_in_direction(tilemap, origin, v2(1.0f, 0.0f), distance_to_wall - 1.0f);
+    REQUIRE(!hit.hit_wall);
+    REQUIRE(abs_f32(hit.position.x - (origin.x + distance_to_wall - 1.0f)) < 0.01f);
+
+    // Missing tiles block rays even without a distance limit
+    hit = find_first_wall_in_direction(tilemap, origin, v2(-1.0f, 0.0f), INFINITY);
+    REQUIRE(hit.hit_wall);
+    REQUIRE(abs_f32(hit.position.x) < 0.01f);
+
+    // Stops at the target instead of the wall behind it
+    Vector2 target = los_test_tile_center(3, 2);
+    Vector2 path_end = find_first_wall_on_path(origin, target, tilemap);
+    REQUIRE(v2_eq(path_end, target));
+
+    path_end = find_first_wall_on_path(origin, los_test_tile_center(8, 2), tilemap);
+    REQUIRE(abs_f32(path_end.x - (f32)(LOS_TEST_WALL_COLUMN * TILE_SIZE)) < 0.01f);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(line_of_sight_cache_batches_and_reuses_results)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024);
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    create_los_test_tilemap(tilemap, &arena);
+
+    EntitySystem *entity_sys = allocate_entity_system();
+    EntityWithID target = es_create_entity(entity_sys, FACTION_NEUTRAL);
+    PhysicsComponent *physics = es_add_component(target.entity, PhysicsComponent);
+    physics->position = los_test_tile_center(8, 5);
+
+    LineOfSightCache *cache = la_allocate_item(&arena, LineOfSightCache);
+    los_cache_begin_frame(cache);
+
+    Vector2 origins[] = {
+        los_test_tile_center(8, 7),                           // Same side as the target
+        los_test_tile_center(1, 2),                           // Behind the wall
+        v2_add(los_test_tile_center(1, 2), v2(10.0f, 5.0f)),  // Same tile as the previous one
+        los_test_tile_center(2, 5),                           // Looks through the gap
+        los_test_tile_center(8, 6),
+    };
+
+    b32 results[ARRAY_COUNT(origins)] = {0};
+    los_cache_has_line_of_sight_batch(cache, origins, ARRAY_COUNT(origins), target.id,
+        target.entity, tilemap, results);
+
+    REQUIRE(results[0]);
+    REQUIRE(!results[1]);
+    REQUIRE(!results[2]);
+    REQUIRE(results[3]);
+    REQUIRE(results[4]);
+
+    REQUIRE(cache->misses == 4);
+    REQUIRE(cache->hits == 1);
+
+    REQUIRE(los_cache_has_line_of_sight(cache, origins[0], target.id, target.entity, tilemap));
+    REQUIRE(cache->hits == 2);
+
+    // Results are only reused within the same frame
+    physics->position = los_test_tile_center(1, 8);
+    los_cache_begin_frame(cache);
+
+    REQUIRE(!los_cache_has_line_of_sight(cache, origins[0], target.id, target.entity, tilemap));
+    REQUIRE(los_cache_has_line_of_sight(cache, origins[1], target.id, target.entity, tilemap));
+    REQUIRE(cache->misses == 2);
+    REQUIRE(cache->hits == 0);
+
+    free_entity_system(entity_sys);
+    la_destroy(&arena);
+}
+
+static EntityWithID add_los_test_entity(World *world, EntityFaction faction, Vector2 position)
+{
+    EntityWithID result = es_create_entity(&world->entity_system, faction);
+    PhysicsComponent *physics = es_add_component(result.entity, PhysicsComponent);
+    physics->position = position;
+
+    world->alive_entity_ids[world->alive_entity_count++] = result.id;
+
+    return result;
+}
+
+TEST_CASE(idle_ai_only_chases_targets_in_line_of_sight)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024);
+
+    // Worlds need to be heap allocated since they're fairly large
+    World *world = calloc(1, sizeof(World));
+    es_initialize(&world->entity_system);
+    create_los_test_tilemap(&world->tilemap, &arena);
+    los_cache_begin_frame(&world->line_of_sight_cache);
+
+    EntityWithID player = add_los_test_entity(world, FACTION_PLAYER, los_test_tile_center(6, 2));
+    es_add_component(player.entity, StatsComponent);
+
+    EntityWithID agents[] = {
+        add_los_test_entity(world, FACTION_ENEMY, los_test_tile_center(7, 2)), // Next to the player
+        add_los_test_entity(world, FACTION_ENEMY, los_test_tile_center(3, 2)), // Behind the wall
+        add_los_test_entity(world, FACTION_ENEMY, los_test_tile_center(6, 8)), // Too far away
+        add_los_test_entity(world, FACTION_ENEMY, los_test_tile_center(7, 3)),
+    };
+
+    for (s32 i = 0; i < ARRAY_COUNT(agents); ++i) {
+        es_add_component(agents[i].entity, AIComponent);
+    }
+
+    ai_acquire_targets(world, &arena);
+
+    b32 expect_chasing[ARRAY_COUNT(agents)] = {true, false, false, true};
+
+    for (s32 i = 0; i < ARRAY_COUNT(agents); ++i) {
+        AIComponent *ai = es_get_component(agents[i].entity, AIComponent);
+
+        if (expect_chasing[i]) {
+            REQUIRE(ai->current_state.kind == AI_STATE_CHASING);
+            REQUIRE(entity_id_equal(ai->current_state.as.chasing.target, player.id));
+        } else {
+            REQUIRE(ai->current_state.kind == AI_STATE_IDLE);
+        }
+    }
+
+    // Everyone near the player asked in one batch, the agents only looked at the player
+    REQUIRE(world->line_of_sight_cache.misses == 3);
+
+    free(world);
+    la_destroy(&arena);
+}
@@ -0,0 +1,319 @@
+#include "base/linear_arena.h"
+#include "particle.h"
+#include "world/chunk.h"
+#include "world/tilemap.h"
+#include "world/world.h"
+#include "test_macros.h"
+
+#define PARTICLE_TEST_BUFFER_COUNT 100
+
+static Particle make_test_particle(s32 i)
+{
+    Particle result = {
+        .position = {(f32)(i % 97) * 3.0f, (f32)(i % 89) * -2.0f},
+        .velocity = {(f32)(i % 13) - 6.0f, (f32)(i % 7) * 4.0f},
+        .timer = 0.0f,
+        .lifetime = 0.5f + (f32)(i % 10) * 0.1f,
+        .color = RGBA32_WHITE,
+        .size = 2.0f,
+    };
+
+    return result;
+}
+
+// Reference integration one particle at a time, same order of operations as the buffers
+static Particle integrate_test_particle(Particle p, f32 dt)
+{
+    p.timer += dt;
+    p.position.x += p.velocity.x * dt;
+    p.position.y += p.velocity.y * dt;
+    p.velocity.y += PARTICLE_GRAVITY;
+    p.velocity.x += p.velocity.x * -PARTICLE_DRAG;
+    p.velocity.y += p.velocity.y * -PARTICLE_DRAG;
+
+    return p;
+}
+
+TEST_CASE(particle_update_matches_reference_for_100k_particles)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    ParticleBuffer *buffers = la_allocate_array(&arena, ParticleBuffer, PARTICLE_TEST_BUFFER_COUNT);
+
+    ParticlePool pool = {0};
+    particle_pool_initialize(&pool, default_allocator, PARTICLE_POOL_DEFAULT_MAX_PARTICLES);
+
+    // Odd counts so the remainder after the four wide spans is covered too
+    s32 per_buffer = 1001;
+
+    for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+        for (s32 i = 0; i < per_buffer; ++i) {
+            particle_buffer_push(&pool, &buffers[b], make_test_particle(b * per_buffer + i));
+        }
+    }
+
+    f32 dt = 1.0f / 60.0f;
+    s32 steps = 40;
+
+    for (s32 step = 0; step < steps; ++step) {
+        for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+            update_particle_buffer(&pool, &buffers[b], dt);
+        }
+    }
+
+    for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+        ssize alive = 0;
+
+        for (s32 i = 0; i < per_buffer; ++i) {
+            Particle expected = make_test_particle(b * per_buffer + i);
+            b32 expired = false;
+
+            for (s32 step = 0; step < steps; ++step) {
+                expected = integrate_test_particle(expected, dt);
+
+                if (expected.timer > expected.lifetime) {
+                    expired = true;
+                    break;
+                }
+            }
+
+            if (expired) {
+                continue;
+            }
+
+            // Survivors keep their spawn order
+            Particle actual = particle_buffer_get(&buffers[b], alive++);
+
+            REQUIRE(v2_eq(actual.position, expected.position));
+            REQUIRE(v2_eq(actual.velocity, expected.velocity));
+            REQUIRE(actual.timer == expected.timer);
+            REQUIRE(actual.lifetime == expected.lifetime);
+        }
+
+        REQUIRE(buffers[b].count == alive);
+    }
+
+    for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+        particle_buffer_destroy(&pool, &buffers[b]);
+    }
+
+    REQUIRE(pool.live_particles == 0);
+    la_destroy(&arena);
+}
+
+TEST_CASE(particle_pool_grows_buffers_and_drops_at_limit)
+{
+    ParticlePool pool = {0};
+    particle_pool_initialize(&pool, default_allocator, 3000);
+
+    ParticleBuffer a = {0};
+    ParticleBuffer b = {0};
+
+    // A single burst far larger than the starting capacity
+    for (s32 i = 0; i < 2500; ++i) {
+        Particle particle = make_test_particle(i);
+        particle.size = (f32)i;
+
+        REQUIRE(particle_buffer_push(&pool, &a, particle));
+    }
+
+    REQUIRE(a.count == 2500);
+    REQUIRE(a.capacity >= 2500);
+    REQUIRE(particle_buffer_get(&a, 0).size == 0.0f);
+    REQUIRE(particle_buffer_get(&a, 2499).size == 2499.0f);
+
+    // The limit is shared between buffers
+    for (s32 i = 0; i < 600; ++i) {
+        particle_buffer_push(&pool, &b, make_test_particle(i));
+    }
+
+    REQUIRE(b.count == 500);
+    REQUIRE(pool.live_particles == 3000);
+    REQUIRE(pool.dropped_particles == 100);
+
+    // Everything expires at once
+    update_particle_buffer(&pool, &a, 100.0f);
+    REQUIRE(a.count == 0);
+    REQUIRE(pool.live_particles == 500);
+
+    particle_buffer_destroy(&pool, &a);
+    particle_buffer_destroy(&pool, &b);
+    REQUIRE(pool.live_particles == 0);
+}
+
+TEST_CASE(particles_are_rebinned_into_the_chunk_they_occupy)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    Tilemap *tilemap = la_allocate_item(&arena, Tilemap);
+    tilemap_initialize(tilemap);
+
+    s32 tiles = CHUNK_SIZE_IN_TILES * 2;
+
+    for (s32 y = 0; y < tiles; ++y) {
+        for (s32 x = 0; x < tiles; ++x) {
+            tilemap_insert_tile(tilemap, v2i(x, y), TILE_FLOOR, &arena);
+        }
+    }
+
+    Chunks chunks = create_chunks_for_tilemap(tilemap, &arena);
+    REQUIRE(chunks.chunk_count == 4);
+
+    ParticlePool pool = {0};
+    particle_pool_initialize(&pool, default_allocator, PARTICLE_POOL_DEFAULT_MAX_PARTICLES);
+
+    f32 chunk_size = (f32)(CHUNK_SIZE_IN_TILES * TILE_SIZE);
+    Chunk *first = &chunks.chunks[0];
+
+    Vector2 positions[] = {
+        {10.0f, 10.0f},                            // Stays
+        {chunk_size + 10.0f, 10.0f},               // Drifted right
+        {10.0f, chunk_size + 10.0f},               // Drifted up
+        {-10.0f, 10.0f},                           // Left the map
+        {20.0f, 20.0f},                            // Stays
+    };
+
+    for (s32 i = 0; i < ARRAY_COUNT(positions); ++i) {
+        Particle particle = make_test_particle(i);
+        particle.position = positions[i];
+        particle.size = (f32)i;
+
+        particle_buffer_push(&pool, &first->particle_buffers.light_emitting_particles, particle);
+    }
+
+    rebin_chunk_particles(&pool, &chunks, first);
+
+    ParticleBuffer *kept = &first->particle_buffers.light_emitting_particles;
+    REQUIRE(kept->count == 2);
+    REQUIRE(particle_buffer_get(kept, 0).size == 0.0f);
+    REQUIRE(particle_buffer_get(kept, 1).size == 4.0f);
+
+    Chunk *right = get_chunk_at_position(&chunks, positions[1]);
+    Chunk *above = get_chunk_at_position(&chunks, positions[2]);
+
+    // Light emitting particles stay light emitting
+    REQUIRE(right->particle_buffers.light_emitting_particles.count == 1);
+    REQUIRE(right->particle_buffers.normal_particles.count == 0);
+    REQUIRE(above->particle_buffers.light_emitting_particles.count == 1);
+    REQUIRE(particle_buffer_get(&above->particle_buffers.light_emitting_particles, 0).size == 2.0f);
+
+    REQUIRE(pool.rebinned_particles == 2);
+    REQUIRE(pool.dropped_particles == 1);
+    REQUIRE(pool.live_particles == 4);
+
+    for (ssize i = 0; i < chunks.chunk_count; ++i) {
+        particle_buffers_destroy(&pool, &chunks.chunks[i].particle_buffers);
+    }
+
+    REQUIRE(pool.live_particles == 0);
+    la_destroy(&arena);
+}
+
+static b32 particle_values_match(f32 a, f32 b)
+{
+    f32 tolerance = 1e-3f * MAX(1.0f, MAX(abs_f32(a), abs_f32(b)));
+    b32 result = abs_f32(a - b) <= tolerance;
+
+    return result;
+}
+
+TEST_CASE(lazy_particle_fast_forward_matches_eager_updates)
+{
+    ParticlePool pool = {0};
+    particle_pool_initialize(&pool, default_allocator, PARTICLE_POOL_DEFAULT_MAX_PARTICLES);
+
+    f32 dt = 1.0f / 60.0f;
+    ParticleBuffers eager = {0};
+    Chunk lazy_chunk = {0};
+
+    for (s32 i = 0; i < 500; ++i) {
+        Particle particle = make_test_particle(i);
+
+        // Lifetimes between ticks, so rounding can't decide which tick a particle expires on
+        particle.lifetime = ((f32)(20 + i % 150) + 0.5f) * dt;
+        particle.size = (f32)i;
+
+        particle_buffer_push(&pool, &eager.normal_particles, particle);
+        particle_buffer_push(&pool, &lazy_chunk.particle_buffers.normal_particles, particle);
+    }
+
+    // The lazy chunk is out of view for all but the first tick and then comes back
+    s32 ticks = 90;
+
+    for (s32 tick = 1; tick <= ticks; ++tick) {
+        particle_pool_begin_tick(&pool, dt);
+        update_particle_buffers(&pool, &eager, dt);
+
+        if (tick == 1) {
+            catch_up_chunk_particles(&pool, &lazy_chunk, pool.tick);
+        }
+    }
+
+    catch_up_chunk_particles(&pool, &lazy_chunk, pool.tick);
+
+    REQUIRE(pool.fast_forwarded_chunks == 1);
+    REQUIRE(lazy_chunk.particles_tick == (u64)ticks);
+
+    ParticleBuffer *expected = &eager.normal_particles;
+    ParticleBuffer *actual = &lazy_chunk.particle_buffers.normal_particles;
+
+    REQUIRE(expected->count > 0);
+    REQUIRE(expected->count < 500);
+    REQUIRE(actual->count == expected->count);
+
+    for (ssize i = 0; i < expected->count; ++i) {
+        Particle e = particle_buffer_get(expected, i);
+        Particle a = particle_buffer_get(actual, i);
+
+        REQUIRE(a.size == e.size);
+        REQUIRE(particle_values_match(a.timer, e.timer));
+        REQUIRE(particle_values_match(a.position.x, e.position.x));
+        REQUIRE(particle_values_match(a.position.y, e.position.y));
+        REQUIRE(particle_values_match(a.velocity.x, e.velocity.x));
+        REQUIRE(particle_values_match(a.velocity.y, e.velocity.y));
+    }
+
+    // Long enough for everything to expire, which is done without integrating anything
+    pool.tick += 100000;
+    catch_up_chunk_particles(&pool, &lazy_chunk, pool.tick);
+    REQUIRE(actual->count == 0);
+
+    particle_buffers_destroy(&pool, &eager);
+    particle_buffers_destroy(&pool, &lazy_chunk.particle_buffers);
+    REQUIRE(pool.live_particles == 0);
+}
+
+// Lifetimes are long enough for nothing to expire, so every run integrates the same count
+BENCHMARK_CASE(particle_update_for_100k_particles)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    ParticleBuffers *buffers = la_allocate_array(&arena, ParticleBuffers, PARTICLE_TEST_BUFFER_COUNT);
+
+    ParticlePool pool = {0};
+    particle_pool_initialize(&pool, default_allocator, PARTICLE_POOL_DEFAULT_MAX_PARTICLES);
+
+    s32 per_buffer = 1000;
+
+    for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+        for (s32 i = 0; i < per_buffer; ++i) {
+            Particle particle = make_test_particle(b * per_buffer + i);
+            particle.lifetime = 1e9f;
+
+            particle_buffer_push(&pool, &buffers[b].normal_particles, particle);
+        }
+    }
+
+    f32 dt = 1.0f / 60.0f;
+
+    BENCHMARK_LOOP("update 100 buffers of 1000 particles", 200) {
+        for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+            update_particle_buffers(&pool, &buffers[b], dt);
+        }
+    }
+
+    REQUIRE(pool.live_particles == PARTICLE_TEST_BUFFER_COUNT * per_buffer);
+
+    for (s32 b = 0; b < PARTICLE_TEST_BUFFER_COUNT; ++b) {
+        particle_buffers_destroy(&pool, &buffers[b]);
+    }
+
+    la_destroy(&arena);
+}
@@ -0,0 +1,262 @@
+#include "base/linear_arena.h"
+#include "base/random.h"
+#include "base/sl_list.h"
+#include "collision/collider.h"
+#include "test_macros.h"
+#include "world/quad_tree.h"
+
+static ssize entity_id_list_length(EntityIDList *list)
+{
+    ssize result = 0;
+
+    for (EntityIDNode *node = list_head(list); node; node = list_next(node)) {
+        ++result;
+    }
+
+    return result;
+}
+
+static CollisionFilter filter_for_group(CollisionGroup group, CollisionGroupMask ignored)
+{
+    CollisionFilter result = {group, ignored};
+
+    return result;
+}
+
+TEST_CASE(qt_collision_query_basic)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 64);
+    QuadTree *qt = la_allocate_item(&arena, QuadTree);
+    qt_initialize(qt, (Rectangle){{0, 0}, {1024, 1024}});
+
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+    EntityID c = {3, 1};
+
+    CollisionFilter none = filter_for_group(COLLISION_GROUP_NONE, 0);
+
+    qt_set_entity_area(qt, a, QT_NULL_LOCATION, (Rectangle){{10, 10}, {16, 16}}, none, &arena);
+    qt_set_entity_area(qt, b, QT_NULL_LOCATION, (Rectangle){{20, 20}, {16, 16}}, none, &arena);
+    qt_set_entity_area(qt, c, QT_NULL_LOCATION, (Rectangle){{500, 500}, {16, 16}}, none, &arena);
+
+    QuadTreeCollisionQuery query = qt_get_colliding_entities_in_area(qt,
+        (Rectangle){{0, 0}, {64, 64}}, a, none, &arena);
+
+    // Querying entity should never be returned
+    REQUIRE(entity_id_list_length(&query.entities) == 1);
+    REQUIRE(entity_id_equal(list_head(&query.entities)->id, b));
+    REQUIRE(query.culled_pair_count == 0);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(qt_collision_query_culls_ignored_groups)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 64);
+    QuadTree *qt = la_allocate_item(&arena, QuadTree);
+    qt_initialize(qt, (Rectangle){{0, 0}, {1024, 1024}});
+
+    CollisionGroupMask projectile_bit = collision_group_bit(COLLISION_GROUP_PROJECTILES);
+    CollisionFilter projectile = filter_for_group(COLLISION_GROUP_PROJECTILES, projectile_bit);
+    CollisionFilter enemy = filter_for_group(COLLISION_GROUP_ENEMIES, 0);
+
+    EntityID projectile_a = {1, 1};
+    EntityID projectile_b = {2, 1};
+    EntityID enemy_id = {3, 1};
+    EntityID non_collider = {4, 1};
+
+    qt_set_entity_area(qt, projectile_a, QT_NULL_LOCATION, (Rectangle){{10, 10}, {8, 8}},
+        projectile, &arena);
+    qt_set_entity_area(qt, projectile_b, QT_NULL_LOCATION, (Rectangle){{12, 12}, {8, 8}},
+        projectile, &arena);
+    qt_set_entity_area(qt, enemy_id, QT_NULL_LOCATION, (Rectangle){{14, 14}, {8, 8}},
+        enemy, &arena);
+    qt_set_entity_area(qt, non_collider, QT_NULL_LOCATION, (Rectangle){{16, 16}, {8, 8}},
+        collision_filter_ignore_all(), &arena);
+
+    Rectangle area = {{0, 0}, {64, 64}};
+
+    QuadTreeCollisionQuery projectile_query =
+        qt_get_colliding_entities_in_area(qt, area, projectile_a, projectile, &arena);
+
+    REQUIRE(entity_id_list_length(&projectile_query.entities) == 1);
+    REQUIRE(entity_id_equal(list_head(&projectile_query.entities)->id, enemy_id));
+    REQUIRE(projectile_query.culled_pair_count == 2);
+
+    QuadTreeCollisionQuery enemy_query =
+        qt_get_colliding_entities_in_area(qt, area, enemy_id, enemy, &arena);
+
+    REQUIRE(entity_id_list_length(&enemy_query.entities) == 2);
+    REQUIRE(enemy_query.culled_pair_count == 1);
+
+    // Unfiltered query still returns everything
+    EntityIDList all = qt_get_entities_in_area(qt, area, &arena);
+    REQUIRE(entity_id_list_length(&all) == 4);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(qt_collision_filter_kept_when_moving)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 64);
+    QuadTree *qt = la_allocate_item(&arena, QuadTree);
+    qt_initialize(qt, (Rectangle){{0, 0}, {1024, 1024}});
+
+    CollisionFilter ignore_all = collision_filter_ignore_all();
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+
+    QuadTreeLocation loc = qt_set_entity_area(qt, a, QT_NULL_LOCATION,
+        (Rectangle){{10, 10}, {8, 8}}, ignore_all, &arena);
+    qt_set_entity_area(qt, b, QT_NULL_LOCATION, (Rectangle){{600, 600}, {8, 8}},
+        filter_for_group(COLLISION_GROUP_NONE, 0), &arena);
+
+    loc = qt_move_entity(qt, a, loc, v2(602, 602), &arena);
+
+    QuadTreeCollisionQuery query = qt_get_colliding_entities_in_area(qt,
+        (Rectangle){{590, 590}, {32, 32}}, b, filter_for_group(COLLISION_GROUP_NONE, 0), &arena);
+
+    REQUIRE(list_is_empty(&query.entities));
+    REQUIRE(query.culled_pair_count == 1);
+
+    la_destroy(&arena);
+}
+
+#define RESTING_BENCHMARK_STATIC_COUNT 4000
+#define RESTING_BENCHMARK_MOVING_COUNT 64
+#define RESTING_BENCHMARK_QUERY_COUNT  1000
+#define RESTING_BENCHMARK_ENTITY_COUNT (RESTING_BENCHMARK_STATIC_COUNT + RESTING_BENCHMARK_MOVING_COUNT)
+
+typedef struct {
+    QuadTree          *tree;
+    QuadTreeLocation   location;
+    Rectangle          area;
+} RestingBenchmarkEntity;
+
+// One frame of broadphase work: entities that move are relocated and run a collision query
+// against every tree. Without the split, static entities do the same every frame.
+static ssize run_resting_benchmark_frame(RestingBenchmarkEntity *entities, QuadTree **trees,
+    ssize tree_count, b32 skip_static, CollisionFilter filter, LinearArena *world_arena,
+    LinearArena *frame_arena)
+{
+    ssize result = 0;
+
+    for (s32 i = 0; i < RESTING_BENCHMARK_ENTITY_COUNT; ++i) {
+        b32 is_static = i < RESTING_BENCHMARK_STATIC_COUNT;
+
+        if (is_static && skip_static) {
+            continue;
+        }
+
+        RestingBenchmarkEntity *entity = &entities[i];
+
+        if (!is_static) {
+            entity->area.position.x += 3.0f;
+
+            if (entity->area.position.x > 4000.0f) {
+                entity->area.position.x -= 4000.0f;
+            }
+        }
+
+        EntityID id = {i + 1, 1};
+        entity->location = qt_set_entity_area(entity->tree, id, entity->location, entity->area,
+            filter, world_arena);
+
+        for (ssize t = 0; t < tree_count; ++t) {
+            QuadTreeCollisionQuery query = qt_get_colliding_entities_in_area(trees[t], entity->area,
+                id, filter, frame_arena);
+            result += entity_id_list_length(&query.entities);
+        }
+    }
+
+    return result;
+}
+
+BENCHMARK_CASE(resting_quad_tree_with_static_entities)
+{
+    LinearArena world_arena = la_create(default_allocator, MB(16));
+    LinearArena frame_arena = la_create(default_allocator, MB(4));
+    Rectangle area = {{0, 0}, {4096, 4096}};
+
+    QuadTree *single_tree = la_allocate_item(&world_arena, QuadTree);
+    QuadTree *dynamic_tree = la_allocate_item(&world_arena, QuadTree);
+    QuadTree *resting_tree = la_allocate_item(&world_arena, QuadTree);
+    qt_initialize(single_tree, area);
+    qt_initialize(dynamic_tree, area);
+    qt_initialize(resting_tree, area);
+
+    RNGState rng = {0};
+    rng_initialize(&rng, 1);
+    rng_set_global_state(&rng);
+
+    RestingBenchmarkEntity *single = la_allocate_array(&world_arena, RestingBenchmarkEntity,
+        RESTING_BENCHMARK_ENTITY_COUNT);
+    RestingBenchmarkEntity *split = la_allocate_array(&world_arena, RestingBenchmarkEntity,
+        RESTING_BENCHMARK_ENTITY_COUNT);
+    CollisionFilter filter = filter_for_group(COLLISION_GROUP_NONE, 0);
+
+    for (s32 i = 0; i < RESTING_BENCHMARK_ENTITY_COUNT; ++i) {
+        EntityID id = {i + 1, 1};
+        Rectangle entity_area = {rng_position_in_rect((Rectangle){{0, 0}, {4000, 4000}}), {32, 32}};
+
+        single[i].tree = single_tree;
+        single[i].area = entity_area;
+        single[i].location = qt_set_entity_area(single_tree, id, QT_NULL_LOCATION, entity_area,
+            filter, &world_arena);
+
+        split[i].tree = (i < RESTING_BENCHMARK_STATIC_COUNT) ? resting_tree : dynamic_tree;
+        split[i].area = entity_area;
+        split[i].location = qt_set_entity_area(split[i].tree, id, QT_NULL_LOCATION, entity_area,
+            filter, &world_arena);
+    }
+
+    ssize pair_count = 0;
+    QuadTree *single_trees[] = {single_tree};
+    QuadTree *split_trees[] = {dynamic_tree, resting_tree};
+
+    BENCHMARK_LOOP("broadphase: one tree", 50) {
+        la_reset(&frame_arena);
+        pair_count += run_resting_benchmark_frame(single, single_trees, ARRAY_COUNT(single_trees),
+            false, filter, &world_arena, &frame_arena);
+    }
+
+    BENCHMARK_LOOP("broadphase: resting tree split", 50) {
+        la_reset(&frame_arena);
+        pair_count += run_resting_benchmark_frame(split, split_trees, ARRAY_COUNT(split_trees),
+            true, filter, &world_arena, &frame_arena);
+    }
+
+    Rectangle *query_areas = la_allocate_array(&world_arena, Rectangle, RESTING_BENCHMARK_QUERY_COUNT);
+
+    for (s32 i = 0; i < RESTING_BENCHMARK_QUERY_COUNT; ++i) {
+        query_areas[i] = (Rectangle){rng_position_in_rect((Rectangle){{0, 0}, {3840, 3840}}), {256, 256}};
+    }
+
+    ssize found_count = 0;
+
+    BENCHMARK_LOOP("1000 area queries: one tree", 50) {
+        la_reset(&frame_arena);
+
+        for (s32 i = 0; i < RESTING_BENCHMARK_QUERY_COUNT; ++i) {
+            EntityIDList found = qt_get_entities_in_area(single_tree, query_areas[i], &frame_arena);
+            found_count += entity_id_list_length(&found);
+        }
+    }
+
+    BENCHMARK_LOOP("1000 area queries: both trees", 50) {
+        la_reset(&frame_arena);
+
+        for (s32 i = 0; i < RESTING_BENCHMARK_QUERY_COUNT; ++i) {
+            EntityIDList found = qt_get_entities_in_area(dynamic_tree, query_areas[i], &frame_arena);
+            entity_id_list_append(&found,
+                qt_get_entities_in_area(resting_tree, query_areas[i], &frame_arena));
+            found_count += entity_id_list_length(&found);
+        }
+    }
+
+    REQUIRE(pair_count > 0);
+    REQUIRE(found_count > 0);
+
+    la_destroy(&frame_arena);
+    la_destroy(&world_arena);
+}
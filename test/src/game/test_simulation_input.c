@@ -0,0 +1,104 @@
+#include "test_macros.h"
+#include "testing_utils.h"
+#include "components/component.h"
+#include "game.h"
+#include "platform/input.h"
+
+typedef struct {
+    EntitySystem *es;
+    Entity       *player;
+    Entity       *item;
+    Input         latched_input;
+} PickupTestState;
+
+static PickupTestState create_pickup_test_state(void)
+{
+    PickupTestState result = {0};
+    result.es = allocate_entity_system();
+
+    result.player = es_create_entity(result.es, FACTION_PLAYER).entity;
+    es_add_component(result.player, Inventory);
+
+    result.item = es_create_entity(result.es, FACTION_NEUTRAL).entity;
+    es_add_component(result.item, InventoryStorable);
+    es_add_component(result.item, PhysicsComponent);
+
+    return result;
+}
+
+// Steps a rendered frame the same way game_update does and returns how many items were picked up
+static s32 run_pickup_frame(PickupTestState *state, Keystate pickup_key, ssize step_count)
+{
+    Input frame_input = {0};
+    frame_input.keystates[MOUSE_RIGHT] = pickup_key;
+
+    input_latch_edges(&state->latched_input, &frame_input);
+    Input tick_input = state->latched_input;
+
+    // Like in the game, the hovered entity is only looked up once per frame
+    Entity *hovered = es_has_component(state->item, PhysicsComponent) ? state->item : 0;
+    s32 result = 0;
+
+    for (ssize i = 0; i < step_count; ++i) {
+        result += player_try_pick_up_item(state->es, state->player, hovered, &tick_input);
+
+        input_clear_edges(&tick_input);
+    }
+
+    if (step_count > 0) {
+        input_clear_edges(&state->latched_input);
+    }
+
+    return result;
+}
+
+TEST_CASE(pickup_pressed_on_frame_without_steps_happens_on_next_step)
+{
+    PickupTestState state = create_pickup_test_state();
+    Inventory *inv = es_get_component(state.player, Inventory);
+
+    REQUIRE(run_pickup_frame(&state, KEYSTATE_PRESSED, 0) == 0);
+    REQUIRE(inventory_is_empty(inv));
+
+    REQUIRE(run_pickup_frame(&state, KEYSTATE_HELD, 1) == 1);
+    REQUIRE(!inventory_is_empty(inv));
+
+    free_entity_system(state.es);
+}
+
+TEST_CASE(pickup_pressed_on_catch_up_frame_happens_once)
+{
+    PickupTestState state = create_pickup_test_state();
+    Inventory *inv = es_get_component(state.player, Inventory);
+
+    // The item stays hovered for every step, picking it up again would append it twice
+    REQUIRE(run_pickup_frame(&state, KEYSTATE_PRESSED, 2) == 1);
+    REQUIRE(entity_id_equal(inv->first_item_in_inventory, state.item->id));
+    REQUIRE(entity_id_equal(inv->last_item_in_inventory, state.item->id));
+
+    // Held on the next frames, nothing more is picked up
+    REQUIRE(run_pickup_frame(&state, KEYSTATE_HELD, 2) == 0);
+    REQUIRE(run_pickup_frame(&state, KEYSTATE_HELD, 0) == 0);
+    REQUIRE(run_pickup_frame(&state, KEYSTATE_HELD, 1) == 0);
+
+    free_entity_system(state.es);
+}
+
+TEST_CASE(unseen_press_is_kept_over_later_release)
+{
+    Input latched = {0};
+    Input input = {0};
+
+    input.keystates[MOUSE_RIGHT] = KEYSTATE_PRESSED;
+    input_latch_edges(&latched, &input);
+
+    input.keystates[MOUSE_RIGHT] = KEYSTATE_RELEASED;
+    input_latch_edges(&latched, &input);
+    REQUIRE(latched.keystates[MOUSE_RIGHT] == KEYSTATE_PRESSED);
+
+    input_clear_edges(&latched);
+
+    input.keystates[MOUSE_RIGHT] = KEYSTATE_UP;
+    input_latch_edges(&latched, &input);
+    REQUIRE(latched.keystates[MOUSE_RIGHT] == KEYSTATE_UP);
+}
@@ -0,0 +1,111 @@
+#include "base/linear_arena.h"
+#include "collision/trigger.h"
+#include "components/component.h"
+#include "test_macros.h"
+
+static TriggerCooldownTable *allocate_cooldown_table(LinearArena *arena)
+{
+    TriggerCooldownTable *result = la_allocate_item(arena, TriggerCooldownTable);
+
+    return result;
+}
+
+TEST_CASE(trigger_cooldown_after_duration_expires)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 256);
+    TriggerCooldownTable *table = allocate_cooldown_table(&arena);
+
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+    ComponentID component = component_id(DamageFieldComponent);
+
+    add_trigger_cooldown(table, a, b, component, retrigger_after_duration(0.5f), &arena);
+
+    REQUIRE(trigger_is_on_cooldown(table, a, b, component));
+    REQUIRE(!trigger_is_on_cooldown(table, b, a, component));
+
+    advance_trigger_cooldown_timers(table, 0.25f);
+    REQUIRE(trigger_is_on_cooldown(table, a, b, component));
+
+    advance_trigger_cooldown_timers(table, 0.2f);
+    REQUIRE(trigger_is_on_cooldown(table, a, b, component));
+
+    advance_trigger_cooldown_timers(table, 0.1f);
+    REQUIRE(!trigger_is_on_cooldown(table, a, b, component));
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(trigger_cooldown_longer_than_wheel_revolution)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 256);
+    TriggerCooldownTable *table = allocate_cooldown_table(&arena);
+
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+    ComponentID component = component_id(DamageFieldComponent);
+
+    f32 revolution = TRIGGER_TIMER_WHEEL_TICK * TRIGGER_TIMER_WHEEL_SLOT_COUNT;
+    add_trigger_cooldown(table, a, b, component, retrigger_after_duration(revolution * 2.5f), &arena);
+
+    for (s32 i = 0; i < 2 * TRIGGER_TIMER_WHEEL_SLOT_COUNT; ++i) {
+        advance_trigger_cooldown_timers(table, TRIGGER_TIMER_WHEEL_TICK);
+    }
+
+    REQUIRE(trigger_is_on_cooldown(table, a, b, component));
+
+    // A single huge step should also expire it
+    advance_trigger_cooldown_timers(table, revolution * 4.0f);
+    REQUIRE(!trigger_is_on_cooldown(table, a, b, component));
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(trigger_cooldown_removed_with_entity)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 256);
+    TriggerCooldownTable *table = allocate_cooldown_table(&arena);
+
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+    EntityID c = {3, 1};
+    ComponentID component = component_id(DamageFieldComponent);
+
+    add_trigger_cooldown(table, a, b, component, retrigger_never(), &arena);
+    add_trigger_cooldown(table, c, a, component, retrigger_after_duration(1.0f), &arena);
+    add_trigger_cooldown(table, b, c, component, retrigger_after_non_contact(), &arena);
+
+    remove_trigger_cooldowns_of_entity(table, a);
+
+    REQUIRE(!trigger_is_on_cooldown(table, a, b, component));
+    REQUIRE(!trigger_is_on_cooldown(table, c, a, component));
+    REQUIRE(trigger_is_on_cooldown(table, b, c, component));
+    REQUIRE(list_is_empty(&table->per_entity_cooldowns[a.index]));
+
+    // Expiry of a removed cooldown shouldn't touch freed nodes
+    advance_trigger_cooldown_timers(table, 2.0f);
+    REQUIRE(trigger_is_on_cooldown(table, b, c, component));
+
+    remove_trigger_cooldowns_of_entity(table, c);
+    REQUIRE(!trigger_is_on_cooldown(table, b, c, component));
+    REQUIRE(list_is_empty(&table->non_contact_cooldowns));
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(trigger_cooldown_whenever_not_added)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 256);
+    TriggerCooldownTable *table = allocate_cooldown_table(&arena);
+
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+    ComponentID component = component_id(DamageFieldComponent);
+
+    add_trigger_cooldown(table, a, b, component, retrigger_whenever(), &arena);
+
+    REQUIRE(!trigger_is_on_cooldown(table, a, b, component));
+    REQUIRE(list_is_empty(&table->per_entity_cooldowns[a.index]));
+
+    la_destroy(&arena);
+}
@@ -0,0 +1,390 @@
+#include "base/linear_arena.h"
+#include "test_macros.h"
+#include "world/world.h"
+#include "world/world_query.h"
+
+#define TEST_MAP_TILES 10
+#define TEST_WALL_COLUMN 6
+
+// Floor tiles with a single wall column, the quad trees only get initialized
+static World *create_query_test_world(LinearArena *arena)
+{
+    World *world = la_allocate_item(arena, World);
+    tilemap_initialize(&world->tilemap);
+
+    for (s32 y = 0; y < TEST_MAP_TILES; ++y) {
+        for (s32 x = 0; x < TEST_MAP_TILES; ++x) {
+            TileType type = (x == TEST_WALL_COLUMN) ? TILE_WALL : TILE_FLOOR;
+            tilemap_insert_tile(&world->tilemap, v2i(x, y), type, arena);
+        }
+    }
+
+    Rectangle area = {{0, 0}, {TEST_MAP_TILES * TILE_SIZE, TEST_MAP_TILES * TILE_SIZE}};
+    qt_initialize(&world->quad_tree, area);
+    qt_initialize(&world->resting_quad_tree, area);
+
+    return world;
+}
+
+static void add_query_test_entity(World *world, QuadTree *qt, EntityID id, Rectangle area,
+    LinearArena *arena)
+{
+    CollisionFilter filter = {0};
+    world->alive_entity_quad_tree_locations[id.index] =
+        qt_set_entity_area(qt, id, QT_NULL_LOCATION, area, filter, arena);
+}
+
+TEST_CASE(world_ray_cast_sorted_and_stops_at_wall)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    World *world = create_query_test_world(&arena);
+
+    EntityID near = {1, 1};
+    EntityID far = {2, 1};
+    EntityID behind_wall = {3, 1};
+
+    add_query_test_entity(world, &world->quad_tree, far, (Rectangle){{300, 90}, {20, 20}}, &arena);
+    add_query_test_entity(world, &world->resting_quad_tree, near, (Rectangle){{100, 90}, {20, 20}},
+        &arena);
+    add_query_test_entity(world, &world->quad_tree, behind_wall, (Rectangle){{500, 90}, {20, 20}},
+        &arena);
+
+    WorldCastParams params = {0};
+    WorldCastResult result = world_ray_cast(world, v2(10, 100), v2(600, 100), params, &arena);
+
+    REQUIRE(result.hit_count == 2);
+    REQUIRE(entity_id_equal(result.hits[0].entity_id, near));
+    REQUIRE(entity_id_equal(result.hits[1].entity_id, far));
+    REQUIRE(result.hits[0].fraction < result.hits[1].fraction);
+    REQUIRE(abs_f32(result.hits[0].point.x - 100.0f) < 0.01f);
+
+    REQUIRE(result.hit_wall);
+    REQUIRE(abs_f32(result.wall_point.x - (f32)(TEST_WALL_COLUMN * TILE_SIZE)) < 0.01f);
+
+    params.ignore_walls = true;
+    result = world_ray_cast(world, v2(10, 100), v2(600, 100), params, &arena);
+
+    REQUIRE(result.hit_count == 3);
+    REQUIRE(!result.hit_wall);
+    REQUIRE(entity_id_equal(result.hits[2].entity_id, behind_wall));
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(world_ray_cast_max_hits_keeps_closest)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    World *world = create_query_test_world(&arena);
+
+    EntityID a = {1, 1};
+    EntityID b = {2, 1};
+    EntityID c = {3, 1};
+
+    add_query_test_entity(world, &world->quad_tree, c, (Rectangle){{300, 90}, {20, 20}}, &arena);
+    add_query_test_entity(world, &world->quad_tree, b, (Rectangle){{200, 90}, {20, 20}}, &arena);
+    add_query_test_entity(world, &world->quad_tree, a, (Rectangle){{100, 90}, {20, 20}}, &arena);
+
+    // Cast right to left so the closest hit is the last one inserted
+    WorldCastParams params = {.max_hits = 1};
+    WorldCastResult result = world_ray_cast(world, v2(380, 100), v2(10, 100), params, &arena);
+
+    REQUIRE(result.hit_count == 1);
+    REQUIRE(entity_id_equal(result.hits[0].entity_id, c));
+
+    params.max_hits = 2;
+    params.ignored_entity = c;
+    result = world_ray_cast(world, v2(380, 100), v2(10, 100), params, &arena);
+
+    REQUIRE(result.hit_count == 2);
+    REQUIRE(entity_id_equal(result.hits[0].entity_id, b));
+    REQUIRE(entity_id_equal(result.hits[1].entity_id, a));
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(world_rect_cast_hits_what_ray_misses)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    World *world = create_query_test_world(&arena);
+
+    EntityID id = {1, 1};
+    add_query_test_entity(world, &world->quad_tree, id, (Rectangle){{200, 110}, {20, 20}}, &arena);
+
+    WorldCastParams params = {0};
+    WorldCastResult ray = world_ray_cast(world, v2(10, 100), v2(300, 100), params, &arena);
+    REQUIRE(ray.hit_count == 0);
+
+    Rectangle rect = {{10, 95}, {16, 16}};
+    WorldCastResult swept = world_rect_cast(world, rect, v2(290, 0), params, &arena);
+
+    REQUIRE(swept.hit_count == 1);
+    REQUIRE(abs_f32(swept.hits[0].point.x - (200.0f - 16.0f)) < 0.01f);
+    REQUIRE(!swept.hit_wall);
+
+    // A rectangle ending inside the wall stops at its edge
+    swept = world_rect_cast(world, (Rectangle){{300, 300}, {16, 16}}, v2(200, 0), params, &arena);
+    REQUIRE(swept.hit_wall);
+    REQUIRE(abs_f32(swept.wall_point.x - (f32)(TEST_WALL_COLUMN * TILE_SIZE - 16)) < 0.01f);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(world_has_clear_path_through_tiles)
+{
+    LinearArena arena = la_create(default_allocator, 1024 * 1024 * 4);
+    World *world = create_query_test_world(&arena);
+
+    REQUIRE(world_has_clear_path(world, v2(10, 10), v2(380, 600)));
+    REQUIRE(!world_has_clear_path(world, v2(10, 10), v2(450, 10)));
+    REQUIRE(world_has_clear_path(world, v2(600, 10), v2(450, 600)));
+
+    // Leaving the map counts as hitting a wall
+    REQUIRE(!world_has_clear_path(world, v2(10, 10), v2(-10, 10)));
+
+    la_destroy(&arena);
+}
+
+static b32 entity_list_contains(EntityIDList *list, EntityID id)
+{
+    for (EntityIDNode *node = list_head(list); node; node = list_next(node)) {
+        if (entity_id_equal(node->id, id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static World *create_resting_test_world(LinearArena *arena)
+{
+    World *world = create_query_test_world(arena);
+    world->world_arena = la_create(default_allocator, MB(1));
+    es_initialize(&world->entity_system);
+
+    return world;
+}
+
+static b32 quad_tree_has_entity(QuadTree *qt, EntityID id, LinearArena *arena)
+{
+    Rectangle everything = {{0, 0}, {TEST_MAP_TILES * TILE_SIZE, TEST_MAP_TILES * TILE_SIZE}};
+    EntityIDList entities = qt_get_entities_in_area(qt, everything, arena);
+    b32 result = entity_list_contains(&entities, id);
+
+    return result;
+}
+
+TEST_CASE(entities_move_between_resting_and_dynamic_quad_trees)
+{
+    LinearArena arena = la_create(default_allocator, MB(16));
+    World *world = create_resting_test_world(&arena);
+
+    EntityWithID e = world_spawn_entity(world, v2(100, 100), FACTION_NEUTRAL);
+    PhysicsComponent *physics = es_get_component(e.entity, PhysicsComponent);
+
+    // Standing still puts it in the resting tree
+    world_update_quad_tree_locations(world);
+
+    REQUIRE(world->alive_entity_is_resting[0]);
+    REQUIRE(quad_tree_has_entity(&world->resting_quad_tree, e.id, &arena));
+    REQUIRE(!quad_tree_has_entity(&world->quad_tree, e.id, &arena));
+    REQUIRE(world->broadphase_stats.resting_entities == 1);
+    REQUIRE(world->broadphase_stats.relocations == 1);
+
+    // Resting entities that haven't changed aren't relocated
+    world->broadphase_stats = zero_struct(BroadphaseStats);
+    world_update_quad_tree_locations(world);
+
+    REQUIRE(world->broadphase_stats.relocations == 0);
+    REQUIRE(world->broadphase_stats.relocations_skipped == 1);
+
+    // Starting to move puts it in the dynamic tree
+    physics->velocity = v2(10, 0);
+    physics->position = v2(200, 100);
+    world->broadphase_stats = zero_struct(BroadphaseStats);
+    world_update_quad_tree_locations(world);
+
+    REQUIRE(!world->alive_entity_is_resting[0]);
+    REQUIRE(quad_tree_has_entity(&world->quad_tree, e.id, &arena));
+    REQUIRE(!quad_tree_has_entity(&world->resting_quad_tree, e.id, &arena));
+    REQUIRE(world->broadphase_stats.resting_entities == 0);
+    REQUIRE(world->broadphase_stats.relocations == 1);
+
+    // Moving entities are relocated every time
+    world_update_quad_tree_locations(world);
+    REQUIRE(world->broadphase_stats.relocations == 2);
+    REQUIRE(world->broadphase_stats.relocations_skipped == 0);
+
+    // And stopping puts it back in the resting tree
+    physics->velocity = V2_ZERO;
+    world_update_quad_tree_locations(world);
+
+    REQUIRE(world->alive_entity_is_resting[0]);
+    REQUIRE(quad_tree_has_entity(&world->resting_quad_tree, e.id, &arena));
+    REQUIRE(!quad_tree_has_entity(&world->quad_tree, e.id, &arena));
+
+    la_destroy(&world->world_arena);
+    la_destroy(&arena);
+}
+
+TEST_CASE(entities_acting_on_contact_never_rest)
+{
+    LinearArena arena = la_create(default_allocator, MB(16));
+    World *world = create_resting_test_world(&arena);
+
+    EntityWithID e = world_spawn_entity(world, v2(100, 100), FACTION_NEUTRAL);
+    es_add_component(e.entity, DamageFieldComponent);
+
+    world_update_quad_tree_locations(world);
+
+    REQUIRE(!world->alive_entity_is_resting[0]);
+    REQUIRE(quad_tree_has_entity(&world->quad_tree, e.id, &arena));
+    REQUIRE(world->broadphase_stats.resting_entities == 0);
+
+    la_destroy(&world->world_arena);
+    la_destroy(&arena);
+}
+
+TEST_CASE(world_area_query_returns_resting_and_moving_entities)
+{
+    LinearArena arena = la_create(default_allocator, MB(16));
+    World *world = create_resting_test_world(&arena);
+
+    EntityWithID resting = world_spawn_entity(world, v2(100, 100), FACTION_NEUTRAL);
+    EntityWithID moving = world_spawn_entity(world, v2(120, 100), FACTION_NEUTRAL);
+    EntityWithID far_away = world_spawn_entity(world, v2(500, 500), FACTION_NEUTRAL);
+
+    es_get_component(moving.entity, PhysicsComponent)->velocity = v2(0, 5);
+    world_update_quad_tree_locations(world);
+
+    REQUIRE(world->alive_entity_is_resting[0]);
+    REQUIRE(!world->alive_entity_is_resting[1]);
+
+    EntityIDList entities = world_get_entities_in_area(world, (Rectangle){{90, 90}, {50, 20}}, &arena);
+
+    REQUIRE(entity_list_contains(&entities, resting.id));
+    REQUIRE(entity_list_contains(&entities, moving.id));
+    REQUIRE(!entity_list_contains(&entities, far_away.id));
+
+    la_destroy(&world->world_arena);
+    la_destroy(&arena);
+}
+
+TEST_CASE(tile_walk_visits_tiles_in_order)
+{
+    // Three tiles right and one down, crossing the horizontal boundary halfway
+    Vector2 origin = v2(TILE_SIZE * 0.5f, TILE_SIZE * 0.5f);
+    Vector2 delta = v2(3.0f * TILE_SIZE, 1.0f * TILE_SIZE);
+
+    TileWalk walk = tile_walk_begin(origin, delta);
+    REQUIRE(v2i_eq(walk.tile, v2i(0, 0)));
+    REQUIRE(walk.fraction == 0.0f);
+
+    Vector2i expected_tiles[] = {{1, 0}, {1, 1}, {2, 1}, {3, 1}};
+    f32 expected_fractions[] = {1.0f / 6.0f, 0.5f, 0.5f, 5.0f / 6.0f};
+
+    for (s32 i = 0; i < ARRAY_COUNT(expected_tiles); ++i) {
+        tile_walk_next(&walk);
+
+        REQUIRE(v2i_eq(walk.tile, expected_tiles[i]));
+        REQUIRE(abs_f32(walk.fraction - expected_fractions[i]) < 0.0001f);
+    }
+
+    tile_walk_next(&walk);
+    REQUIRE(walk.fraction > 1.0f);
+
+    // Straight lines never step along the other axis
+    walk = tile_walk_begin(origin, v2(0.0f, -2.0f * TILE_SIZE));
+    tile_walk_next(&walk);
+    REQUIRE(v2i_eq(walk.tile, v2i(0, -1)));
+    REQUIRE(abs_f32(walk.fraction - 0.25f) < 0.0001f);
+}
+
+#define QUERY_BENCHMARK_CASTS_PER_FRAME 2000
+
+// A frame's worth of casts from projectiles and agents, against the area queries that
+// callers had to filter by hand before
+BENCHMARK_CASE(world_casts_per_frame)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    LinearArena scratch = la_create(default_allocator, MB(1));
+    World *world = create_query_test_world(&arena);
+
+    RNGState rng = {0};
+    rng_initialize(&rng, 1);
+    rng_set_global_state(&rng);
+
+    Rectangle map_area = {{0, 0}, {TEST_MAP_TILES * TILE_SIZE, TEST_MAP_TILES * TILE_SIZE}};
+
+    for (s32 i = 1; i < MAX_ENTITIES; ++i) {
+        EntityID id = {i, 1};
+        Rectangle area = {rng_position_in_rect(map_area), {32, 32}};
+        QuadTree *qt = (i % 2) ? &world->quad_tree : &world->resting_quad_tree;
+
+        add_query_test_entity(world, qt, id, area, &arena);
+    }
+
+    Vector2 *origins = la_allocate_array(&arena, Vector2, QUERY_BENCHMARK_CASTS_PER_FRAME);
+    Vector2 *targets = la_allocate_array(&arena, Vector2, QUERY_BENCHMARK_CASTS_PER_FRAME);
+
+    for (s32 i = 0; i < QUERY_BENCHMARK_CASTS_PER_FRAME; ++i) {
+        origins[i] = rng_position_in_rect(map_area);
+        targets[i] = rng_position_in_rect(map_area);
+    }
+
+    ssize hit_count = 0;
+
+    BENCHMARK_LOOP("2000 area queries over the ray bounds", 200) {
+        for (s32 i = 0; i < QUERY_BENCHMARK_CASTS_PER_FRAME; ++i) {
+            la_reset(&scratch);
+            Vector2 min = {MIN(origins[i].x, targets[i].x), MIN(origins[i].y, targets[i].y)};
+            Vector2 max = {MAX(origins[i].x, targets[i].x), MAX(origins[i].y, targets[i].y)};
+            Rectangle bounds = {min, v2_sub(max, min)};
+            EntityIDList entities = world_get_entities_in_area(world, bounds, &scratch);
+            hit_count += !list_is_empty(&entities);
+        }
+    }
+
+    WorldCastParams closest_params = {.max_hits = 1};
+
+    BENCHMARK_LOOP("2000 ray casts, closest hit", 200) {
+        for (s32 i = 0; i < QUERY_BENCHMARK_CASTS_PER_FRAME; ++i) {
+            la_reset(&scratch);
+            WorldCastResult result = world_ray_cast(world, origins[i], targets[i], closest_params,
+                &scratch);
+            hit_count += result.hit_count;
+        }
+    }
+
+    WorldCastParams all_params = {.ignore_walls = true};
+
+    BENCHMARK_LOOP("2000 ray casts, all hits through walls", 200) {
+        for (s32 i = 0; i < QUERY_BENCHMARK_CASTS_PER_FRAME; ++i) {
+            la_reset(&scratch);
+            WorldCastResult result = world_ray_cast(world, origins[i], targets[i], all_params,
+                &scratch);
+            hit_count += result.hit_count;
+        }
+    }
+
+    BENCHMARK_LOOP("2000 swept 16x16 rect casts", 200) {
+        for (s32 i = 0; i < QUERY_BENCHMARK_CASTS_PER_FRAME; ++i) {
+            la_reset(&scratch);
+            Rectangle rect = {origins[i], {16, 16}};
+            Vector2 movement = v2_sub(targets[i], origins[i]);
+            WorldCastResult result = world_rect_cast(world, rect, movement, closest_params,
+                &scratch);
+            hit_count += result.hit_count;
+        }
+    }
+
+    BENCHMARK_LOOP("2000 clear path checks", 200) {
+        for (s32 i = 0; i < QUERY_BENCHMARK_CASTS_PER_FRAME; ++i) {
+            hit_count += world_has_clear_path(world, origins[i], targets[i]);
+        }
+    }
+
+    REQUIRE(hit_count > 0);
+
+    la_destroy(&scratch);
+    la_destroy(&arena);
+}
@@ -0,0 +1,453 @@
+#include <string.h>
+
+#include "base/linear_arena.h"
+#include "renderer/frontend/render_batch.h"
+#include "test_macros.h"
+
+#define FULL_RENDER_BATCH_ENTRY_COUNT 4096
+
+// Small deterministic generator so the tests don't depend on the global random state
+static u64 next_render_test_random(u64 *state)
+{
+    *state = *state * 6364136223846793005ull + 1442695040888963407ull;
+
+    u64 result = *state >> 11;
+    return result;
+}
+
+// The command offsets are used to record the original position of each entry
+static void require_sorted_and_stable(RenderBatch *rb)
+{
+    for (ssize i = 1; i < rb->entry_count; ++i) {
+        RenderEntry a = rb->entries[i - 1];
+        RenderEntry b = rb->entries[i];
+
+        REQUIRE(a.key <= b.key);
+
+        if (a.key == b.key) {
+            REQUIRE(a.command_offset < b.command_offset);
+        }
+    }
+}
+
+static void fill_render_test_batch(RenderBatch *rb, ssize count, u64 key_mask, u64 seed)
+{
+    u64 state = seed;
+
+    if (rb->entry_capacity < count) {
+        rb->entries = la_allocate_array(rb->arena, RenderEntry, count);
+        rb->entry_capacity = count;
+    }
+
+    rb->entry_count = count;
+
+    for (ssize i = 0; i < count; ++i) {
+        rb->entries[i].key = next_render_test_random(&state) & key_mask;
+        rb->entries[i].command_offset = i + 1;
+    }
+}
+
+TEST_CASE(sort_render_entries_full_batch_random_keys)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    RenderBatch *rb = la_allocate_item(&arena, RenderBatch);
+    rb->arena = &arena;
+
+    fill_render_test_batch(rb, FULL_RENDER_BATCH_ENTRY_COUNT, ~0ull, 1);
+    sort_render_entries(rb, &arena);
+
+    REQUIRE(rb->entry_count == FULL_RENDER_BATCH_ENTRY_COUNT);
+    require_sorted_and_stable(rb);
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(sort_render_entries_is_stable_with_few_distinct_keys)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    RenderBatch *rb = la_allocate_item(&arena, RenderBatch);
+    rb->arena = &arena;
+
+    // Only a couple of bytes differ, like real keys where most entries share a layer and shader
+    u64 mask = 0x0300000000000f00ull;
+    fill_render_test_batch(rb, FULL_RENDER_BATCH_ENTRY_COUNT, mask, 2);
+    sort_render_entries(rb, &arena);
+
+    require_sorted_and_stable(rb);
+
+    // All keys equal, nothing should move
+    fill_render_test_batch(rb, 100, 0, 3);
+    sort_render_entries(rb, &arena);
+
+    for (ssize i = 0; i < rb->entry_count; ++i) {
+        REQUIRE(rb->entries[i].command_offset == i + 1);
+    }
+
+    // Odd number of passes, so the result ends up in the scratch buffer and is copied back
+    rb->entry_count = 3;
+    rb->entries[0].key = 0x030000;
+    rb->entries[1].key = 0x010000;
+    rb->entries[2].key = 0x020000;
+    sort_render_entries(rb, &arena);
+
+    REQUIRE(rb->entries[0].key == 0x010000);
+    REQUIRE(rb->entries[1].key == 0x020000);
+    REQUIRE(rb->entries[2].key == 0x030000);
+
+    la_destroy(&arena);
+}
+
+// Every run sorts a copy of the same unsorted entries, the copy is included in the time
+BENCHMARK_CASE(sort_render_entries_of_full_batch)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    LinearArena scratch = la_create(default_allocator, MB(1));
+    RenderBatch *rb = la_allocate_item(&arena, RenderBatch);
+    rb->arena = &arena;
+
+    u64 masks[] = {~0ull, 0x0300000000000f00ull};
+    const char *labels[] = {"4096 entries, random keys", "4096 entries, few distinct keys"};
+
+    for (s32 i = 0; i < ARRAY_COUNT(masks); ++i) {
+        fill_render_test_batch(rb, FULL_RENDER_BATCH_ENTRY_COUNT, masks[i], 1);
+        RenderEntry *unsorted = la_copy_array(&arena, rb->entries, rb->entry_count);
+
+        BENCHMARK_LOOP(labels[i], 2000) {
+            la_reset(&scratch);
+            memcpy(rb->entries, unsorted, (usize)rb->entry_count * sizeof(*rb->entries));
+            sort_render_entries(rb, &scratch);
+        }
+
+        require_sorted_and_stable(rb);
+    }
+
+    la_destroy(&scratch);
+    la_destroy(&arena);
+}
+
+TEST_CASE(render_batch_grows_past_initial_capacity)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    RenderBatchList list = {0};
+
+    // Well past the old fixed limit of 4096 entries
+    ssize count = 10000;
+
+    // Wide enough that none of the entries are culled
+    Vector2i viewport = v2i((s32)count + 1, 600);
+    Camera camera = create_screenspace_camera(viewport);
+    RenderBatch *rb = push_new_render_batch(&list, camera, viewport, Y_IS_DOWN,
+        FRAME_BUFFER_OVERLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+
+    for (ssize i = 0; i < count; ++i) {
+        Rectangle rect = {{(f32)i, 0.0f}, {1.0f, 1.0f}};
+        RenderEntry *entry = draw_rectangle(rb, rect, RGBA32_WHITE, zero_struct(ShaderHandle),
+            RENDER_LAYER_DEFAULT);
+
+        REQUIRE(entry);
+    }
+
+    REQUIRE(rb->entry_count == count);
+    REQUIRE(rb->entry_capacity >= count);
+
+    // Entries recorded before a resize are kept intact
+    for (ssize i = 0; i < count; ++i) {
+        RectangleCmd *cmd = (RectangleCmd *)render_entry_command(rb, &rb->entries[i]);
+        REQUIRE(cmd->rect.position.x == (f32)i);
+    }
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(render_commands_and_setup_commands_are_stored_inline)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    RenderBatchList list = {0};
+
+    // Enough commands with setup commands to move the command buffer a few times
+    ssize count = 2000;
+
+    // Wide enough that none of the entries are culled
+    Vector2i viewport = v2i((s32)count + 1, 600);
+    Camera camera = create_screenspace_camera(viewport);
+    RenderBatch *rb = push_new_render_batch(&list, camera, viewport, Y_IS_DOWN,
+        FRAME_BUFFER_OVERLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+
+    for (ssize i = 0; i < count; ++i) {
+        RenderEntry *entry = draw_circle(rb, v2((f32)i, 0.0f), RGBA32_WHITE, 10.0f,
+            zero_struct(ShaderHandle), RENDER_LAYER_DEFAULT);
+
+        set_vec4_uniform(rb, entry, str_lit("u_origin"), (Vector4){(f32)i, 1.0f, 2.0f, 3.0f});
+        set_f32_uniform(rb, entry, str_lit("u_radius"), (f32)i * 2.0f);
+    }
+
+    REQUIRE(rb->command_capacity > RENDER_BATCH_INITIAL_COMMAND_CAPACITY);
+
+    ssize expected_offset = 0;
+
+    for (ssize i = 0; i < count; ++i) {
+        RenderEntry *entry = &rb->entries[i];
+        REQUIRE(entry->command_offset == expected_offset);
+        REQUIRE(entry->command_offset % RENDER_COMMAND_ALIGNMENT == 0);
+
+        CircleCmd *cmd = (CircleCmd *)render_entry_command(rb, entry);
+        REQUIRE(cmd->header.kind == RENDER_COMMAND_ENUM_NAME(CircleCmd));
+        REQUIRE(cmd->position.x == (f32)i);
+        REQUIRE(cmd->header.setup_command_count == 2);
+
+        byte *setup_ptr = (byte *)cmd + cmd->header.setup_commands_offset;
+
+        SetupCmdUniformVec4 *origin = (SetupCmdUniformVec4 *)setup_ptr;
+        REQUIRE(origin->header.kind == RENDER_SETUP_COMMAND_ENUM_NAME(SetupCmdUniformVec4));
+        REQUIRE(origin->value.x == (f32)i);
+        REQUIRE(str_equal(origin->header.uniform_name, str_lit("u_origin")));
+
+        SetupCmdUniformFloat *radius = (SetupCmdUniformFloat *)(setup_ptr + origin->header.size);
+        REQUIRE(radius->header.kind == RENDER_SETUP_COMMAND_ENUM_NAME(SetupCmdUniformFloat));
+        REQUIRE(radius->value == (f32)i * 2.0f);
+
+        // The next command starts right after the last setup command
+        REQUIRE((byte *)radius + radius->header.size == (byte *)cmd + cmd->header.size);
+        expected_offset += cmd->header.size;
+    }
+
+    REQUIRE(expected_offset == rb->command_size);
+
+    la_destroy(&arena);
+}
+
+#define RECORD_BENCHMARK_DRAW_COUNT 4000
+
+// Half of the draws carry two uniforms, like lights used to
+BENCHMARK_CASE(record_draws_into_render_batch)
+{
+    LinearArena arena = la_create(default_allocator, MB(8));
+    Vector2i viewport = v2i(800, 600);
+    Camera camera = create_screenspace_camera(viewport);
+    ssize entry_count = 0;
+
+    BENCHMARK_LOOP("4000 draws, 2000 with uniforms", 2000) {
+        la_reset(&arena);
+        RenderBatchList list = {0};
+        RenderBatch *rb = push_new_render_batch(&list, camera, viewport, Y_IS_DOWN,
+            FRAME_BUFFER_OVERLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+
+        for (s32 i = 0; i < RECORD_BENCHMARK_DRAW_COUNT; ++i) {
+            Vector2 position = {(f32)(i % 80) * 10.0f, (f32)(i / 80) * 10.0f};
+
+            if (i % 2 == 0) {
+                Rectangle rect = {position, {8.0f, 8.0f}};
+                draw_rectangle(rb, rect, RGBA32_WHITE, zero_struct(ShaderHandle), RENDER_LAYER_DEFAULT);
+            } else {
+                RenderEntry *entry = draw_circle(rb, position, RGBA32_WHITE, 4.0f,
+                    zero_struct(ShaderHandle), RENDER_LAYER_DEFAULT);
+
+                set_vec4_uniform(rb, entry, str_lit("u_origin"), (Vector4){position.x, position.y, 0.0f, 1.0f});
+                set_f32_uniform(rb, entry, str_lit("u_radius"), 4.0f);
+            }
+        }
+
+        entry_count += rb->entry_count;
+    }
+
+    REQUIRE(entry_count > 0);
+
+    la_destroy(&arena);
+}
+
+#define PARTIAL_RENDER_TEST_PART_COUNT 5
+
+// The x position records the position of the draw in the serial order
+static void record_render_test_draw(RenderBatch *rb, ssize index)
+{
+    u64 state = (u64)index;
+    u64 random = next_render_test_random(&state);
+
+    // Few distinct y positions and layers, so lots of entries share keys
+    Rectangle rect = {{(f32)index, (f32)(random % 4) * 16.0f}, {1.0f, 1.0f}};
+    RenderLayer layer = (RenderLayer)((random >> 8) % 3);
+
+    draw_rectangle(rb, rect, RGBA32_WHITE, zero_struct(ShaderHandle), layer);
+}
+
+TEST_CASE(merged_partial_render_batches_match_serial_recording)
+{
+    LinearArena arena = la_create(default_allocator, MB(4));
+    LinearArena part_arenas[PARTIAL_RENDER_TEST_PART_COUNT];
+
+    for (ssize i = 0; i < ARRAY_COUNT(part_arenas); ++i) {
+        part_arenas[i] = la_create(default_allocator, KB(64));
+    }
+
+    ssize count = 3000;
+
+    // Wide enough that none of the entries are culled
+    Vector2i viewport = v2i((s32)count + 1, 600);
+    RenderBatchList list = {0};
+    Camera camera = create_screenspace_camera(viewport);
+
+    RenderBatch *serial = push_new_render_batch(&list, camera, viewport, Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+    RenderBatch *merged = push_new_render_batch(&list, camera, viewport, Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+    ssize recorded_before_parts = 200;
+    ssize recorded_after_parts = 2700;
+
+    // Uneven split, one of the parts is left empty
+    ssize part_ends[PARTIAL_RENDER_TEST_PART_COUNT] = {700, 700, 1900, 2000, recorded_after_parts};
+
+    for (ssize i = 0; i < count; ++i) {
+        record_render_test_draw(serial, i);
+    }
+
+    for (ssize i = 0; i < recorded_before_parts; ++i) {
+        record_render_test_draw(merged, i);
+    }
+
+    RenderBatch parts[PARTIAL_RENDER_TEST_PART_COUNT];
+    RenderBatch *part_ptrs[PARTIAL_RENDER_TEST_PART_COUNT];
+    ssize part_begin = recorded_before_parts;
+
+    for (ssize i = 0; i < PARTIAL_RENDER_TEST_PART_COUNT; ++i) {
+        parts[i] = create_partial_render_batch(merged, &part_arenas[i]);
+        part_ptrs[i] = &parts[i];
+
+        for (ssize j = part_begin; j < part_ends[i]; ++j) {
+            record_render_test_draw(&parts[i], j);
+        }
+
+        sort_render_entries(&parts[i], &part_arenas[i]);
+        part_begin = part_ends[i];
+    }
+
+    merge_partial_render_batches(merged, part_ptrs, PARTIAL_RENDER_TEST_PART_COUNT, &arena);
+
+    // The parts can be thrown away once merged
+    for (ssize i = 0; i < ARRAY_COUNT(part_arenas); ++i) {
+        la_destroy(&part_arenas[i]);
+    }
+
+    for (ssize i = recorded_after_parts; i < count; ++i) {
+        record_render_test_draw(merged, i);
+    }
+
+    sort_render_entries(serial, &arena);
+    sort_render_entries(merged, &arena);
+
+    REQUIRE(merged->entry_count == count);
+    REQUIRE(merged->entry_count == serial->entry_count);
+
+    for (ssize i = 0; i < serial->entry_count; ++i) {
+        RectangleCmd *expected = (RectangleCmd *)render_entry_command(serial, &serial->entries[i]);
+        RectangleCmd *actual = (RectangleCmd *)render_entry_command(merged, &merged->entries[i]);
+
+        REQUIRE(merged->entries[i].key == serial->entries[i].key);
+        REQUIRE(rect_eq(actual->rect, expected->rect));
+    }
+
+    la_destroy(&arena);
+}
+
+TEST_CASE(draws_outside_the_camera_are_culled)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    LinearArena part_arena = la_create(default_allocator, KB(64));
+    RenderBatchList list = {0};
+
+    // Sees the area from (0, 0) to (200, 100)
+    Camera camera = {.position = {100.0f, 50.0f}, .zoom = 1.0f};
+    RenderBatch *rb = push_new_render_batch(&list, camera, v2i(400, 200), Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+    ShaderHandle shader = zero_struct(ShaderHandle);
+
+    REQUIRE(rect_eq(rb->cull_area, (Rectangle){{0.0f, 0.0f}, {200.0f, 100.0f}}));
+
+    // Partly visible shapes are kept
+    REQUIRE(draw_rectangle(rb, (Rectangle){{-10.0f, -10.0f}, {20.0f, 20.0f}}, RGBA32_WHITE, shader, 0));
+    REQUIRE(draw_circle(rb, v2(205.0f, 50.0f), RGBA32_WHITE, 10.0f, shader, 0));
+    REQUIRE(draw_line(rb, v2(-50.0f, 50.0f), v2(250.0f, 50.0f), RGBA32_WHITE, 2.0f, shader, 0));
+    REQUIRE(draw_light(rb, v2(100.0f, 150.0f), 60.0f, RGBA32_WHITE, shader, 0));
+
+    // A rotated sprite reaches past its unrotated rectangle
+    SpriteModifiers rotated = {.rotation = PI / 4.0f};
+    REQUIRE(draw_sprite(rb, NULL_TEXTURE, (Rectangle){{202.0f, 40.0f}, {20.0f, 20.0f}}, rotated, shader, 0));
+
+    REQUIRE(!draw_sprite(rb, NULL_TEXTURE, (Rectangle){{202.0f, 40.0f}, {20.0f, 20.0f}},
+        (SpriteModifiers){0}, shader, 0));
+    REQUIRE(!draw_rectangle(rb, (Rectangle){{300.0f, 0.0f}, {20.0f, 20.0f}}, RGBA32_WHITE, shader, 0));
+    REQUIRE(!draw_circle(rb, v2(100.0f, -20.0f), RGBA32_WHITE, 10.0f, shader, 0));
+    REQUIRE(!draw_line(rb, v2(-50.0f, -50.0f), v2(250.0f, -50.0f), RGBA32_WHITE, 2.0f, shader, 0));
+    REQUIRE(!draw_light(rb, v2(100.0f, 200.0f), 60.0f, RGBA32_WHITE, shader, 0));
+
+    Triangle triangle = {{300.0f, 0.0f}, {320.0f, 0.0f}, {310.0f, 20.0f}};
+    REQUIRE(!draw_triangle(rb, triangle, RGBA32_WHITE, shader, 0));
+
+    REQUIRE(rb->entry_count == 5);
+    REQUIRE(rb->culled_entry_count == 6);
+
+    // Partial batches cull against the area of their target, and their counts are merged
+    RenderBatch part = create_partial_render_batch(rb, &part_arena);
+    RenderBatch *part_ptr = &part;
+
+    REQUIRE(!draw_circle(&part, v2(-100.0f, 50.0f), RGBA32_WHITE, 10.0f, shader, 0));
+    REQUIRE(draw_circle(&part, v2(100.0f, 50.0f), RGBA32_WHITE, 10.0f, shader, 0));
+    sort_render_entries(&part, &part_arena);
+
+    merge_partial_render_batches(rb, &part_ptr, 1, &arena);
+
+    REQUIRE(rb->entry_count == 6);
+    REQUIRE(rb->culled_entry_count == 7);
+
+    la_destroy(&part_arena);
+    la_destroy(&arena);
+}
+
+TEST_CASE(copied_render_data_outlives_the_original)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    LinearArena game_arena = la_create(default_allocator, KB(64));
+    RenderBatchList list = {0};
+
+    Camera camera = create_screenspace_camera(v2i(800, 600));
+    RenderBatch *rb = push_new_render_batch(&list, camera, v2i(800, 600), Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+    ShaderHandle shader = zero_struct(ShaderHandle);
+
+    char text_data[] = "hello";
+    char uniform_data[] = "u_radius";
+    String text = {text_data, 5};
+    String uniform_name = {uniform_data, 8};
+
+    TriangleFan fan = {.center = v2(100.0f, 100.0f), .count = 4};
+    fan.items = la_allocate_array(&game_arena, TriangleFanElement, fan.count);
+
+    for (ssize i = 0; i < fan.count; ++i) {
+        fan.items[i] = (TriangleFanElement){v2((f32)i, 10.0f), v2((f32)i + 1.0f, 10.0f)};
+    }
+
+    RenderEntry *text_entry = draw_text(rb, text, v2(10.0f, 10.0f), RGBA32_WHITE, 12, shader,
+        zero_struct(FontHandle), 0);
+    RenderEntry *fan_entry = draw_triangle_fan(rb, fan, RGBA32_WHITE, shader, 0);
+    set_f32_uniform(rb, fan_entry, uniform_name, 1.0f);
+
+    copy_referenced_render_data(rb);
+
+    // What the game owns may change as soon as the frame has been recorded
+    text_data[0] = 'j';
+    uniform_data[0] = 'x';
+    la_reset(&game_arena);
+    memset(fan.items, 0, (usize)fan.count * sizeof(*fan.items));
+
+    TextCmd *text_cmd = (TextCmd *)render_entry_command(rb, text_entry);
+    REQUIRE(str_equal(text_cmd->text, str_lit("hello")));
+
+    TriangleFanCmd *fan_cmd = (TriangleFanCmd *)render_entry_command(rb, fan_entry);
+    REQUIRE(fan_cmd->triangle_fan.count == 4);
+    REQUIRE(fan_cmd->triangle_fan.items[3].a.x == 3.0f);
+
+    SetupCmdHeader *setup_cmd = (SetupCmdHeader *)((byte *)fan_cmd + fan_cmd->header.setup_commands_offset);
+    REQUIRE(str_equal(setup_cmd->uniform_name, str_lit("u_radius")));
+
+    la_destroy(&game_arena);
+    la_destroy(&arena);
+}
@@ -0,0 +1,368 @@
+#include <math.h>
+
+#include "base/linear_arena.h"
+#include "platform/asset_system.h"
+#include "platform/font.h"
+#include "renderer/backend/render_command_interpreter.h"
+#include "renderer/backend/renderer_backend.h"
+#include "renderer/backend/tessellation.h"
+#include "test_macros.h"
+
+/*
+  The interpreter looks up assets through the platform layer, which isn't linked into the
+  tests. The headless backend never dereferences shaders or textures. Textures from
+  INTERPRETER_TEST_ATLAS_FIRST_TEXTURE on are packed side by side on a single atlas page,
+  every other texture is its own page.
+ */
+
+#define INTERPRETER_TEST_ATLAS_PAGE          100
+#define INTERPRETER_TEST_ATLAS_FIRST_TEXTURE 200
+
+ShaderAsset *assets_get_shader(ShaderHandle handle)
+{
+    (void)handle;
+
+    return 0;
+}
+
+TextureAsset *assets_get_texture(TextureHandle handle)
+{
+    (void)handle;
+
+    return 0;
+}
+
+TextureRegion assets_get_texture_region(TextureHandle handle)
+{
+    TextureRegion result = {handle, {{0.0f, 0.0f}, {1.0f, 1.0f}}};
+
+    if (handle.id >= INTERPRETER_TEST_ATLAS_FIRST_TEXTURE) {
+        f32 slot = (f32)(handle.id - INTERPRETER_TEST_ATLAS_FIRST_TEXTURE);
+
+        result.page = (TextureHandle){INTERPRETER_TEST_ATLAS_PAGE};
+        result.uv_rect = (Rectangle){{slot * 0.25f, 0.0f}, {0.25f, 0.25f}};
+    }
+
+    return result;
+}
+
+FontAsset *assets_get_font(FontHandle handle)
+{
+    (void)handle;
+    ASSERT(false && "No fonts in headless renderer tests");
+
+    return 0;
+}
+
+TextureHandle font_get_texture_handle(FontAsset *asset)
+{
+    (void)asset;
+    ASSERT(false && "No fonts in headless renderer tests");
+
+    return NULL_TEXTURE;
+}
+
+RenderedGlyphInfo font_get_glyph_vertices(FontAsset *asset, char ch, Vector2 position, s32 font_size,
+    RGBA32 color, YDirection y_dir)
+{
+    (void)asset;
+    (void)ch;
+    (void)position;
+    (void)font_size;
+    (void)color;
+    (void)y_dir;
+    ASSERT(false && "No fonts in headless renderer tests");
+
+    return (RenderedGlyphInfo){0};
+}
+
+RenderedGlyphInfo font_get_clipped_glyph_vertices(FontAsset *asset, char ch, Vector2 position,
+    Rectangle bounds, s32 text_size, RGBA32 color, YDirection y_dir)
+{
+    (void)asset;
+    (void)ch;
+    (void)position;
+    (void)bounds;
+    (void)text_size;
+    (void)color;
+    (void)y_dir;
+    ASSERT(false && "No fonts in headless renderer tests");
+
+    return (RenderedGlyphInfo){0};
+}
+
+f32 font_get_newline_advance(FontAsset *asset, s32 text_size)
+{
+    (void)asset;
+    (void)text_size;
+    ASSERT(false && "No fonts in headless renderer tests");
+
+    return 0.0f;
+}
+
+#define INTERPRETER_TEST_LIGHT_COUNT 64
+
+static RenderBatch *push_light_test_batch(RenderBatchList *list, LinearArena *arena)
+{
+    Camera camera = create_screenspace_camera(v2i(800, 600));
+    RenderBatch *result = push_new_render_batch(list, camera, v2i(800, 600), Y_IS_UP,
+        FRAME_BUFFER_LIGHTING, RGBA32_TRANSPARENT, BLEND_FUNCTION_ADDITIVE, arena);
+
+    return result;
+}
+
+static void draw_light_test_lights(RenderBatch *rb, b32 with_uniforms, LinearArena *arena)
+{
+    ShaderHandle light_shader = {1};
+
+    TriangleFan fan = {.center = v2(0.0f, 0.0f), .count = 8};
+    fan.items = la_allocate_array(arena, TriangleFanElement, fan.count);
+
+    for (ssize i = 0; i < fan.count; ++i) {
+        fan.items[i] = (TriangleFanElement){v2((f32)i, 10.0f), v2((f32)i + 1.0f, 10.0f)};
+    }
+
+    for (s32 i = 0; i < INTERPRETER_TEST_LIGHT_COUNT; ++i) {
+        // All within the camera so none are culled
+        Vector2 origin = v2((f32)(i % 16) * 40.0f + 50.0f, (f32)(i / 16) * 100.0f + 50.0f);
+        RenderEntry *entry = 0;
+
+        if (i % 2 == 0) {
+            entry = draw_light(rb, origin, 50.0f, RGBA32_WHITE, light_shader, RENDER_LAYER_DEFAULT);
+        } else {
+            fan.center = origin;
+            entry = draw_raycasted_light(rb, origin, 50.0f, fan, RGBA32_WHITE, light_shader,
+                RENDER_LAYER_DEFAULT);
+        }
+
+        // How lights used to pass their parameters
+        if (with_uniforms) {
+            set_f32_uniform(rb, entry, str_lit("u_light_radius"), 50.0f);
+        }
+    }
+}
+
+TEST_CASE(lights_are_submitted_in_a_single_draw_call)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    RendererBackend *backend = renderer_backend_initialize(v2i(800, 600), default_allocator);
+    RenderBatchList list = {0};
+
+    RenderBatch *rb = push_light_test_batch(&list, &arena);
+    draw_light_test_lights(rb, false, &arena);
+
+    RenderStats stats = {0};
+    execute_render_commands(rb, backend, &stats, &arena);
+
+    REQUIRE(stats.draw_calls == 1);
+    REQUIRE(stats.state_flushes == 0);
+
+    // Entries with uniforms have to be flushed one by one so their uniforms don't leak
+    RenderBatch *uniform_rb = push_light_test_batch(&list, &arena);
+    draw_light_test_lights(uniform_rb, true, &arena);
+
+    RenderStats uniform_stats = {0};
+    execute_render_commands(uniform_rb, backend, &uniform_stats, &arena);
+
+    REQUIRE(uniform_stats.draw_calls == INTERPRETER_TEST_LIGHT_COUNT);
+    REQUIRE(renderer_backend_get_draw_call_count(backend) == INTERPRETER_TEST_LIGHT_COUNT + 1);
+
+    deallocate(default_allocator, backend);
+    la_destroy(&arena);
+}
+
+static RenderStats execute_two_sprite_batch(RendererBackend *backend, TextureHandle first,
+    TextureHandle second, RenderBatchList *list, LinearArena *arena)
+{
+    ShaderHandle texture_shader = {1};
+
+    Camera camera = create_screenspace_camera(v2i(800, 600));
+    RenderBatch *rb = push_new_render_batch(list, camera, v2i(800, 600), Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, arena);
+
+    draw_sprite(rb, first, (Rectangle){{100.0f, 100.0f}, {32.0f, 32.0f}}, (SpriteModifiers){0},
+        texture_shader, RENDER_LAYER_DEFAULT);
+    draw_sprite(rb, second, (Rectangle){{200.0f, 100.0f}, {32.0f, 32.0f}}, (SpriteModifiers){0},
+        texture_shader, RENDER_LAYER_DEFAULT);
+
+    RenderStats result = {0};
+    execute_render_commands(rb, backend, &result, arena);
+
+    return result;
+}
+
+TEST_CASE(sprites_on_the_same_atlas_page_share_a_draw_call)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    RendererBackend *backend = renderer_backend_initialize(v2i(800, 600), default_allocator);
+    RenderBatchList list = {0};
+
+    TextureHandle packed_a = {INTERPRETER_TEST_ATLAS_FIRST_TEXTURE};
+    TextureHandle packed_b = {INTERPRETER_TEST_ATLAS_FIRST_TEXTURE + 1};
+
+    // Switching between textures on the same page only changes the UVs, binding the page
+    // for the first sprite isn't counted as a flush
+    RenderStats packed_stats = execute_two_sprite_batch(backend, packed_a, packed_b, &list, &arena);
+
+    REQUIRE(packed_stats.draw_calls == 1);
+    REQUIRE(packed_stats.state_flushes == 0);
+    REQUIRE(packed_stats.atlas_flushes_saved == 1);
+
+    // The same sprites as separate textures need one state flush between them
+    TextureHandle unpacked_a = {2};
+    TextureHandle unpacked_b = {3};
+    RenderStats unpacked_stats = execute_two_sprite_batch(backend, unpacked_a, unpacked_b, &list, &arena);
+
+    REQUIRE(unpacked_stats.draw_calls == 2);
+    REQUIRE(unpacked_stats.state_flushes == 1);
+    REQUIRE(unpacked_stats.atlas_flushes_saved == 0);
+
+    deallocate(default_allocator, backend);
+    la_destroy(&arena);
+}
+
+TEST_CASE(clipped_lights_stay_inside_the_clip_rect)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    RendererBackend *backend = renderer_backend_initialize(v2i(800, 600), default_allocator);
+    RenderBatchList list = {0};
+    ShaderHandle light_shader = {1};
+
+    Rectangle clip_rect = {{100.0f, 100.0f}, {50.0f, 50.0f}};
+    Triangle triangle = {{80.0f, 120.0f}, {130.0f, 170.0f}, {130.0f, 80.0f}};
+
+    // The part of the triangle inside the rectangle is a hexagon of area 1440
+    ClippedTriangle clipped = triangle_clip_to_rect(triangle, clip_rect);
+    f32 twice_area = 0.0f;
+
+    REQUIRE(clipped.count == 6);
+
+    for (s32 i = 0; i < clipped.count; ++i) {
+        Vector2 point = clipped.points[i];
+        Vector2 next = clipped.points[(i + 1) % clipped.count];
+
+        REQUIRE((point.x >= 100.0f) && (point.x <= 150.0f));
+        REQUIRE((point.y >= 100.0f) && (point.y <= 150.0f));
+
+        twice_area += v2_cross(point, next);
+    }
+
+    REQUIRE(fabsf(fabsf(twice_area) - 2.0f * 1440.0f) < 0.01f);
+
+    Triangle outside = {{0.0f, 0.0f}, {10.0f, 0.0f}, {0.0f, 10.0f}};
+    REQUIRE(triangle_clip_to_rect(outside, clip_rect).count == 0);
+
+    // A clip rect around the whole light draws the same triangles as no clip rect at all
+    RenderBatch *rb = push_light_test_batch(&list, &arena);
+    Vector2 origin = v2(400.0f, 300.0f);
+    Rectangle around_light = {{300.0f, 200.0f}, {200.0f, 200.0f}};
+
+    draw_light(rb, origin, 50.0f, RGBA32_WHITE, light_shader, RENDER_LAYER_DEFAULT);
+    REQUIRE(draw_clipped_light(rb, origin, 50.0f, (TriangleFan){0}, around_light, RGBA32_WHITE,
+        light_shader, RENDER_LAYER_DEFAULT));
+
+    // Clip rects the light doesn't reach are culled
+    Rectangle far_away = {{0.0f, 0.0f}, {10.0f, 10.0f}};
+    REQUIRE(!draw_clipped_light(rb, origin, 50.0f, (TriangleFan){0}, far_away, RGBA32_WHITE,
+        light_shader, RENDER_LAYER_DEFAULT));
+
+    RenderStats stats = {0};
+    execute_render_commands(rb, backend, &stats, &arena);
+
+    REQUIRE(stats.vertices % 2 == 0);
+    ssize single_light_vertices = stats.vertices / 2;
+
+    // Clipped to a quarter, only the triangles around one quarter of the circle are left
+    RenderBatch *quarter_rb = push_light_test_batch(&list, &arena);
+    Rectangle quarter = {origin, {100.0f, 100.0f}};
+    draw_clipped_light(quarter_rb, origin, 50.0f, (TriangleFan){0}, quarter, RGBA32_WHITE,
+        light_shader, RENDER_LAYER_DEFAULT);
+
+    RenderStats quarter_stats = {0};
+    execute_render_commands(quarter_rb, backend, &quarter_stats, &arena);
+
+    REQUIRE(quarter_stats.vertices > 0);
+    REQUIRE(quarter_stats.vertices <= single_light_vertices / 4 + 3);
+
+    deallocate(default_allocator, backend);
+    la_destroy(&arena);
+}
+
+#define INTERPRETER_TEST_CIRCLE_COUNT 16
+
+TEST_CASE(circle_vertex_count_follows_screen_size)
+{
+    LinearArena arena = la_create(default_allocator, MB(1));
+    RendererBackend *backend = renderer_backend_initialize(v2i(800, 600), default_allocator);
+    RenderBatchList list = {0};
+    ShaderHandle shape_shader = {1};
+
+    Camera camera = create_screenspace_camera(v2i(800, 600));
+    RenderBatch *rb = push_new_render_batch(&list, camera, v2i(800, 600), Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+
+    for (s32 i = 0; i < INTERPRETER_TEST_CIRCLE_COUNT; ++i) {
+        draw_circle(rb, v2((f32)i * 10.0f, 0.0f), RGBA32_WHITE, 3.0f, shape_shader, RENDER_LAYER_DEFAULT);
+    }
+
+    RenderStats small_stats = {0};
+    execute_render_commands(rb, backend, &small_stats, &arena);
+
+    // Every circle used to be 64 segments of 3 vertices regardless of size
+    ssize old_vertex_count = INTERPRETER_TEST_CIRCLE_COUNT * 64 * 3;
+    REQUIRE(small_stats.vertices == INTERPRETER_TEST_CIRCLE_COUNT * CIRCLE_LOD_MIN_SEGMENTS * 3);
+    REQUIRE(small_stats.vertices * 8 == old_vertex_count);
+
+    RenderBatch *large_rb = push_new_render_batch(&list, camera, v2i(800, 600), Y_IS_UP,
+        FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+
+    for (s32 i = 0; i < INTERPRETER_TEST_CIRCLE_COUNT; ++i) {
+        draw_circle(large_rb, v2(400.0f, 300.0f), RGBA32_WHITE, 250.0f, shape_shader, RENDER_LAYER_DEFAULT);
+    }
+
+    RenderStats large_stats = {0};
+    execute_render_commands(large_rb, backend, &large_stats, &arena);
+
+    REQUIRE(large_stats.vertices == old_vertex_count);
+
+    deallocate(default_allocator, backend);
+    la_destroy(&arena);
+}
+
+#define CIRCLE_BENCHMARK_COUNT 500
+
+// Screen radii of 3 and 250 pixels, the smallest and largest level of detail
+BENCHMARK_CASE(circles_recorded_and_executed)
+{
+    LinearArena arena = la_create(default_allocator, MB(8));
+    RendererBackend *backend = renderer_backend_initialize(v2i(800, 600), default_allocator);
+    Camera camera = create_screenspace_camera(v2i(800, 600));
+    ShaderHandle shape_shader = {1};
+
+    f32 radii[] = {3.0f, 250.0f};
+    const char *labels[] = {"500 circles, radius 3", "500 circles, radius 250"};
+    ssize draw_call_count = 0;
+
+    for (s32 i = 0; i < ARRAY_COUNT(radii); ++i) {
+        BENCHMARK_LOOP(labels[i], 1000) {
+            la_reset(&arena);
+            RenderBatchList list = {0};
+            RenderBatch *rb = push_new_render_batch(&list, camera, v2i(800, 600), Y_IS_UP,
+                FRAME_BUFFER_GAMEPLAY, RGBA32_TRANSPARENT, BLEND_FUNCTION_MULTIPLICATIVE, &arena);
+
+            for (s32 j = 0; j < CIRCLE_BENCHMARK_COUNT; ++j) {
+                Vector2 position = {(f32)(j % 25) * 32.0f, (f32)(j / 25) * 30.0f};
+                draw_circle(rb, position, RGBA32_WHITE, radii[i], shape_shader, RENDER_LAYER_DEFAULT);
+            }
+
+            RenderStats stats = {0};
+            execute_render_commands(rb, backend, &stats, &arena);
+            draw_call_count += stats.draw_calls;
+        }
+    }
+
+    REQUIRE(draw_call_count > 0);
+
+    deallocate(default_allocator, backend);
+    la_destroy(&arena);
+}
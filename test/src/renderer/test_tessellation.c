@@ -0,0 +1,83 @@
+#include <math.h>
+
+#include "renderer/backend/tessellation.h"
+#include "test_macros.h"
+
+static b32 tessellation_vertices_match(Vertex a, Vertex b)
+{
+    b32 result = (fabsf(a.position.x - b.position.x) < 0.0001f)
+        && (fabsf(a.position.y - b.position.y) < 0.0001f)
+        && v2_eq(a.uv, b.uv);
+
+    return result;
+}
+
+static b32 tessellation_quads_match(RectangleVertices a, RectangleVertices b)
+{
+    b32 result = tessellation_vertices_match(a.top_left, b.top_left)
+        && tessellation_vertices_match(a.top_right, b.top_right)
+        && tessellation_vertices_match(a.bottom_right, b.bottom_right)
+        && tessellation_vertices_match(a.bottom_left, b.bottom_left);
+
+    return result;
+}
+
+TEST_CASE(unit_circle_detail_follows_screen_radius)
+{
+    REQUIRE(get_unit_circle(0.0f).segment_count == CIRCLE_LOD_MIN_SEGMENTS);
+    REQUIRE(get_unit_circle(4.0f).segment_count == CIRCLE_LOD_MIN_SEGMENTS);
+    REQUIRE(get_unit_circle(20.0f).segment_count == 16);
+    REQUIRE(get_unit_circle(80.0f).segment_count == 32);
+    REQUIRE(get_unit_circle(500.0f).segment_count == CIRCLE_LOD_MAX_SEGMENTS);
+    REQUIRE(get_unit_circle(100000.0f).segment_count == CIRCLE_LOD_MAX_SEGMENTS);
+
+    for (f32 radius = 1.0f; radius < 1000.0f; radius *= 2.0f) {
+        REQUIRE(get_unit_circle(radius).segment_count <= get_unit_circle(radius * 2.0f).segment_count);
+    }
+
+    UnitCircle circle = get_unit_circle(500.0f);
+
+    for (s32 i = 0; i <= circle.segment_count; ++i) {
+        REQUIRE(fabsf(v2_mag(circle.points[i]) - 1.0f) < 0.0001f);
+    }
+
+    REQUIRE(v2_eq(circle.points[0], circle.points[circle.segment_count]));
+}
+
+TEST_CASE(outlined_rectangle_edges_match_separate_lines)
+{
+    Rectangle rect = {{10.0f, 20.0f}, {30.0f, 15.0f}};
+    f32 thick = 2.0f;
+
+    OutlinedRectangleVertices outline = get_outlined_rectangle_vertices(rect, thick, RGBA32_WHITE);
+
+    Vector2 tl = rect_top_left(rect);
+    Vector2 tr = rect_top_right(rect);
+    Vector2 br = rect_bottom_right(rect);
+    Vector2 bl = rect_bottom_left(rect);
+
+    // How the edges were built before, with one normalized line per edge
+    RectangleVertices lines[4] = {
+        get_line_vertices(tl, v2_sub(tr, v2(thick, 0.0f)), thick, RGBA32_WHITE),
+        get_line_vertices(tr, v2_add(br, v2(0.0f, thick)), thick, RGBA32_WHITE),
+        get_line_vertices(br, v2_add(bl, v2(thick, 0.0f)), thick, RGBA32_WHITE),
+        get_line_vertices(bl, v2_sub(tl, v2(0.0f, thick)), thick, RGBA32_WHITE),
+    };
+
+    for (s32 i = 0; i < ARRAY_COUNT(lines); ++i) {
+        REQUIRE(tessellation_quads_match(outline.edges[i], lines[i]));
+    }
+}
+
+TEST_CASE(line_vertices)
+{
+    RectangleVertices line = get_line_vertices(v2(0.0f, 0.0f), v2(10.0f, 0.0f), 2.0f, RGBA32_WHITE);
+
+    REQUIRE(v2_eq(line.top_left.position, v2(-1.0f, 1.0f)));
+    REQUIRE(v2_eq(line.top_right.position, v2(11.0f, 1.0f)));
+    REQUIRE(v2_eq(line.bottom_right.position, v2(11.0f, -1.0f)));
+    REQUIRE(v2_eq(line.bottom_left.position, v2(-1.0f, -1.0f)));
+
+    REQUIRE(v2_eq(line.top_left.uv, v2(0.0f, 1.0f)));
+    REQUIRE(v2_eq(line.bottom_right.uv, v2(1.0f, 0.0f)));
+}